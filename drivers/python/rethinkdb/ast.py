@@ -478,8 +478,8 @@ class RqlQuery(object):
     def change_at(self, *args):
         return ChangeAt(self, *args)
 
-    def sample(self, *args):
-        return Sample(self, *args)
+    def sample(self, *args, **kwargs):
+        return Sample(self, *args, **kwargs)
 
     # Time support
 
@@ -12,8 +12,12 @@
 
 #include <algorithm>
 #include <functional>
+#include <map>
+#include <utility>
+#include <vector>
 
 #include "arch/types.hpp"
+#include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/io/disk/filestat.hpp"
@@ -21,10 +25,13 @@
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
+#include "arch/timing.hpp"
 #include "backtrace.hpp"
+#include "concurrency/cond_var.hpp"
 #include "config/args.hpp"
 #include "do_on_thread.hpp"
 #include "logger.hpp"
+#include "perfmon/perfmon.hpp"
 #include "utils.hpp"
 
 void verify_aligned_file_access(DEBUG_VAR int64_t file_size, DEBUG_VAR int64_t offset,
@@ -52,7 +59,11 @@ public:
         accounter(batch_factor),
         backend_stats(stats, "backend", accounter.producer),
         backend(queue, backend_stats.producer, max_concurrent_io_requests),
-        outstanding_txn(0)
+        outstanding_txn(0),
+        group_commit_running(false),
+        group_commit_round_sampler(secs_to_ticks(1), true),
+        group_commit_round_membership(stats, &group_commit_round_sampler,
+                                      "group_commit_round_size")
     {
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
@@ -105,7 +116,28 @@ public:
         threadnum_t calling_thread = get_thread_id();
 
         action_t *a = new action_t(calling_thread, cb);
-        a->make_write(fd, buf, count, offset, wrap_in_datasyncs);
+        /* Writes that must be wrapped in datasyncs get their datasyncs from the group
+        commit instead of running their own. */
+        a->make_write(fd, buf, count, offset, false);
+        a->account = static_cast<accounting_diskmgr_t::account_t *>(account);
+
+        if (wrap_in_datasyncs) {
+            do_on_thread(home_thread(),
+                         std::bind(&linux_disk_manager_t::submit_group_commit_write,
+                                   this, a));
+        } else {
+            do_on_thread(home_thread(),
+                         std::bind(&linux_disk_manager_t::submit_action_to_stack_stats,
+                                   this, a));
+        }
+    }
+
+    void submit_discard(fd_t fd, int64_t offset, int64_t length,
+                        void *account, linux_iocallback_t *cb) {
+        threadnum_t calling_thread = get_thread_id();
+
+        action_t *a = new action_t(calling_thread, cb);
+        a->make_discard(fd, offset, length);
         a->account = static_cast<accounting_diskmgr_t::account_t *>(account);
 
         do_on_thread(home_thread(),
@@ -175,6 +207,133 @@ public:
     }
 
 private:
+    /* Writes that have to be wrapped in datasyncs are the commit points of the
+    serializers (in practice, metablock writes). Every table has its own file, so if
+    each of them ran its own datasyncs, a server with many tables taking hard-durability
+    writes would issue a pair of datasyncs per table per commit. Instead the commits of
+    all files go through a single group commit: while one round is running, new commits
+    line up for the next round. A round syncs each of its files once, performs all of
+    its writes, and then syncs each file once more, and all of its commits complete
+    together. */
+    class group_commit_waiter_t : public linux_iocallback_t, public cond_t {
+    public:
+        explicit group_commit_waiter_t(size_t n) : errsv(0), remaining(n) {
+            if (remaining == 0) {
+                pulse();
+            }
+        }
+        void on_io_complete() {
+            finish();
+        }
+        void on_io_failure(int _errsv, int64_t, int64_t) {
+            errsv = _errsv;
+            finish();
+        }
+        int errsv;
+    private:
+        void finish() {
+            guarantee(remaining > 0);
+            --remaining;
+            if (remaining == 0) {
+                pulse();
+            }
+        }
+        size_t remaining;
+    };
+
+    void submit_group_commit_write(action_t *a) {
+        assert_thread();
+        ++outstanding_txn;
+        group_commit_queue.push_back(a);
+        if (!group_commit_running) {
+            group_commit_running = true;
+            coro_t::spawn_sometime(
+                std::bind(&linux_disk_manager_t::run_group_commits, this));
+        }
+    }
+
+    /* Datasyncs every file in `fds` once, and sets `*errsv_out` if that fails. The
+    accounts are only used to queue the syncs. The datasyncs of different files run
+    concurrently. */
+    void group_commit_sync(
+            const std::map<fd_t, accounting_diskmgr_t::account_t *> &fds,
+            int *errsv_out) {
+        group_commit_waiter_t waiter(fds.size());
+        for (const auto &pair : fds) {
+            action_t *s = new action_t(home_thread(), &waiter);
+            s->make_datasync(pair.first);
+            s->account = pair.second;
+            submit_action_to_stack_stats(s);
+        }
+        waiter.wait_lazily_unordered();
+        if (waiter.errsv != 0) {
+            *errsv_out = waiter.errsv;
+        }
+    }
+
+    void run_group_commits() {
+        assert_thread();
+        for (;;) {
+            if (DISK_GROUP_COMMIT_WINDOW_MS > 0) {
+                nap(DISK_GROUP_COMMIT_WINDOW_MS);
+            }
+
+            std::vector<action_t *> round;
+            round.swap(group_commit_queue);
+            group_commit_round_sampler.record(round.size());
+
+            std::map<fd_t, accounting_diskmgr_t::account_t *> fds;
+            std::vector<std::pair<threadnum_t, linux_iocallback_t *> > callbacks;
+            std::vector<std::pair<int64_t, int64_t> > ranges;
+            for (action_t *a : round) {
+                fds.insert(std::make_pair(a->get_fd(), a->account));
+                callbacks.push_back(std::make_pair(a->cb_thread, a->cb));
+                ranges.push_back(std::make_pair(a->get_offset(), a->get_count()));
+            }
+
+            int errsv = 0;
+            group_commit_sync(fds, &errsv);
+            if (errsv == 0) {
+                group_commit_waiter_t waiter(round.size());
+                for (action_t *a : round) {
+                    a->cb_thread = home_thread();
+                    a->cb = &waiter;
+                    submit_action_to_stack_stats(a);
+                }
+                waiter.wait_lazily_unordered();
+                errsv = waiter.errsv;
+            } else {
+                for (action_t *a : round) {
+                    delete a;
+                }
+            }
+            if (errsv == 0) {
+                group_commit_sync(fds, &errsv);
+            }
+
+            /* Once the callbacks have been delivered, the files (and this disk manager)
+            may go away at any time unless there are more commits waiting. */
+            const bool more = !group_commit_queue.empty();
+            group_commit_running = more;
+            outstanding_txn -= round.size();
+            for (size_t i = 0; i < callbacks.size(); ++i) {
+                if (errsv == 0) {
+                    do_on_thread(callbacks[i].first,
+                                 std::bind(&linux_iocallback_t::on_io_complete,
+                                           callbacks[i].second));
+                } else {
+                    do_on_thread(callbacks[i].first,
+                                 std::bind(&linux_iocallback_t::on_io_failure,
+                                           callbacks[i].second, errsv,
+                                           ranges[i].first, ranges[i].second));
+                }
+            }
+            if (!more) {
+                return;
+            }
+        }
+    }
+
     /* These fields describe the entire IO stack. At the top level, we allocate a new
     action_t object for each operation and record its callback. Then it passes through
     the conflict resolver, which enforces ordering constraints between IO operations by
@@ -199,6 +358,11 @@ private:
 
     intptr_t outstanding_txn;
 
+    std::vector<action_t *> group_commit_queue;
+    bool group_commit_running;
+    perfmon_sampler_t group_commit_round_sampler;
+    perfmon_membership_t group_commit_round_membership;
+
     DISABLE_COPYING(linux_disk_manager_t);
 };
 
@@ -272,6 +436,35 @@ void linux_file_t::set_file_size_at_least(int64_t size) {
     }
 }
 
+void linux_file_t::discard(int64_t offset, int64_t length) {
+    assert_thread();
+    rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
+    guarantee(offset >= 0 && length >= 0 && offset + length <= file_size);
+
+    struct discard_callback_t : public linux_iocallback_t {
+        void on_io_complete() {
+            delete this;
+        }
+
+        void on_io_failure(int errsv, int64_t offset, int64_t count) {
+            /* Not every filesystem supports punching holes, and the space still gets
+            reused by the serializer if it doesn't, so this isn't a problem. */
+            if (errsv != EOPNOTSUPP && errsv != ENOSYS) {
+                logWRN("Failed to release %" PRIi64 " bytes at offset %" PRIi64 " of "
+                       "a database file to the filesystem (%s).",
+                       count, offset, errno_string(errsv).c_str());
+            }
+            delete this;
+        }
+
+        auto_drainer_t::lock_t lock;
+    };
+    discard_callback_t *discard_callback = new discard_callback_t();
+    discard_callback->lock = file_size_ops_drainer.lock();
+    diskmgr->submit_discard(fd.get(), offset, length, default_account->get_account(),
+                            discard_callback);
+}
+
 void linux_file_t::read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *callback) {
     rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
     verify_aligned_file_access(file_size, offset, length, buf);
@@ -583,6 +776,26 @@ int perform_datasync(fd_t fd) {
 #endif  // __MACH__
 }
 
+int perform_punch_hole(fd_t fd, int64_t offset, int64_t length) {
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+
+    int res;
+    do {
+        res = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length);
+    } while (res == -1 && get_errno() == EINTR);
+    return res == -1 ? get_errno() : 0;
+
+#else
+
+    (void) fd;
+    (void) offset;
+    (void) length;
+    return EOPNOTSUPP;
+
+#endif
+}
+
+
 MUST_USE int fsync_parent_directory(const char *path) {
     // Locate the parent directory
     char absolute_path[PATH_MAX];
@@ -78,6 +78,10 @@ public:
     that gets truncated anymore. */
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size);
+    /* Punches a hole into the file where the platform supports that. Like resize
+    operations, it doesn't wait for other operations on the range to finish; it's
+    ordered with respect to other operations on the same range by the disk manager. */
+    void discard(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *cb);
     void write_async(int64_t offset, size_t length, const void *buf, file_account_t *account, linux_iocallback_t *cb,
@@ -138,6 +142,10 @@ void verify_aligned_file_access(int64_t file_size, int64_t offset, size_t length
 // Makes blocking syscalls.  Upon error, returns the errno value.
 int perform_datasync(fd_t fd);
 
+// Deallocates the given range of the file without changing its size.  Makes blocking
+// syscalls.  Upon error, returns the errno value.
+int perform_punch_hole(fd_t fd, int64_t offset, int64_t length);
+
 // Calls fsync() on the parent directory of the given path.
 // Returns the errno value in case of an error and 0 otherwise.
 MUST_USE int fsync_parent_directory(const char *path);
@@ -206,8 +206,9 @@ void conflict_resolving_diskmgr_t::done(accounting_diskmgr_action_t *payload) {
                     /* We were the last thing it was waiting on */
 
                     /* If the waiter is a read, and the range it was supposed to read is a subrange of
-                    our range, then we can just fill its buffer directly instead of going to disk. */
-                    if (waiter->get_is_read() &&
+                    our range, then we can just fill its buffer directly instead of going to disk.
+                    (Discards don't have a buffer to fill it from.) */
+                    if (waiter->get_is_read() && !action->get_is_discard() &&
                             waiter->get_offset() >= action->get_offset() &&
                             waiter->get_offset() + waiter->get_count() <= action->get_offset() + action->get_count() ) {
 
@@ -165,6 +165,14 @@ void pool_diskmgr_t::action_t::run() {
             return;
         }
     } break;
+    case ACTION_DISCARD: {
+        int errcode = perform_punch_hole(fd, offset, buf_and_count.iov_len);
+        io_result = errcode == 0 ? static_cast<int64_t>(buf_and_count.iov_len) : -errcode;
+    } break;
+    case ACTION_DATASYNC: {
+        int errcode = perform_datasync(fd);
+        io_result = -errcode;
+    } break;
     case ACTION_READ:
     case ACTION_WRITE: {
         // Copy the io vectors because perform_read_write will modify them
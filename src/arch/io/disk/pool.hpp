@@ -63,6 +63,26 @@ struct pool_diskmgr_action_t
     }
 #endif
 
+    void make_discard(fd_t _fd, int64_t _offset, int64_t _length) {
+        type = ACTION_DISCARD;
+        wrap_in_datasyncs = false;
+        fd = _fd;
+        /* The length goes into `buf_and_count` so that the conflict resolver orders
+        the discard with respect to other operations on the same range. */
+        buf_and_count.iov_base = NULL;
+        buf_and_count.iov_len = _length;
+        offset = _offset;
+    }
+
+    void make_datasync(fd_t _fd) {
+        type = ACTION_DATASYNC;
+        wrap_in_datasyncs = false;
+        fd = _fd;
+        buf_and_count.iov_base = NULL;
+        buf_and_count.iov_len = 0;
+        offset = 0;
+    }
+
     void make_read(fd_t _fd, void *_buf, size_t _count, int64_t _offset) {
         type = ACTION_READ;
         wrap_in_datasyncs = false;
@@ -74,6 +94,7 @@ struct pool_diskmgr_action_t
 
     bool get_is_write() const { return type == ACTION_WRITE; }
     bool get_is_resize() const { return type == ACTION_RESIZE; }
+    bool get_is_discard() const { return type == ACTION_DISCARD; }
     bool get_is_read() const { return type == ACTION_READ; }
     fd_t get_fd() const { return fd; }
     void get_bufs(iovec **iovecs_out, size_t *iovecs_len_out) {
@@ -99,12 +120,14 @@ private:
     friend class pool_diskmgr_t;
     pool_diskmgr_t *parent;
 
-    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
+    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE, ACTION_DISCARD,
+                        ACTION_DATASYNC};
     action_type_t type;
     bool wrap_in_datasyncs;
     fd_t fd;
 
-    // Either type is ACTION_RESIZE, or buf_and_count.iov_base is used, or iovecs
+    // Either type is ACTION_RESIZE, ACTION_DISCARD or ACTION_DATASYNC, or
+    // buf_and_count.iov_base is used, or iovecs
     // is used (for writev).  If iovecs is used, then buf_and_count.iov_len is the
     // sum of the iovecs' iov_len fields.  Currently readv is not supported, but if
     // you need it, it should be easy to add.
@@ -0,0 +1,345 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "arch/runtime/coro_sampler.hpp"
+
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime_utils.hpp"
+#include "backtrace.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rethinkdb_backtrace.hpp"
+
+#if defined(__linux__) && defined(SIGEV_THREAD_ID)
+#define CORO_SAMPLER_SUPPORTED 1
+// See `timer_signal_provider.cc`
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+int coro_sampler_t::sample_rate_hz = 0;
+
+namespace {
+
+struct raw_sample_t {
+    const std::type_info *spawn_site;
+    int num_frames;
+    void *frames[CORO_SAMPLER_BACKTRACE_DEPTH];
+};
+
+struct site_profile_t {
+    site_profile_t() : cpu_samples(0), waits(0), wait_ticks(0) { }
+
+    void merge(const site_profile_t &other) {
+        cpu_samples += other.cpu_samples;
+        waits += other.waits;
+        wait_ticks += other.wait_ticks;
+        for (const auto &pair : other.backtraces) {
+            backtraces[pair.first] += pair.second;
+        }
+    }
+
+    uint64_t cpu_samples;
+    uint64_t waits;
+    ticks_t wait_ticks;
+    std::map<std::vector<void *>, uint64_t> backtraces;
+};
+
+/* The `spawn_site` is `nullptr` for samples taken outside of any coroutine, e.g. in
+the event loop. */
+typedef std::map<const std::type_info *, site_profile_t> profile_t;
+
+struct thread_sampler_t {
+    thread_sampler_t() : write_index(0), read_index(0), dropped_samples(0) { }
+
+    /* The buffer is written by the signal handler and read by `drain()`, both on the
+    same thread, so all we need to make sure of is that the signal handler only
+    publishes a sample after writing it. */
+    raw_sample_t buffer[CORO_SAMPLER_BUFFER_SIZE];
+    volatile uint64_t write_index;
+    volatile uint64_t read_index;
+    volatile uint64_t dropped_samples;
+
+    // Only accessed outside of the signal handler
+    profile_t profile;
+
+#ifdef CORO_SAMPLER_SUPPORTED
+    timer_t timer;
+#endif
+
+    void drain() {
+        const uint64_t end = write_index;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        for (uint64_t i = read_index; i < end; ++i) {
+            const raw_sample_t &sample = buffer[i % CORO_SAMPLER_BUFFER_SIZE];
+            site_profile_t *site = &profile[sample.spawn_site];
+            ++site->cpu_samples;
+            ++site->backtraces[std::vector<void *>(sample.frames,
+                                                   sample.frames + sample.num_frames)];
+        }
+        std::atomic_signal_fence(std::memory_order_release);
+        read_index = end;
+    }
+};
+
+// Allocated by `start_on_thread()` if the sampler is enabled, `nullptr` otherwise.
+thread_sampler_t *thread_samplers[MAX_THREADS];
+
+thread_sampler_t *get_thread_sampler() {
+    const int thread = get_thread_id().threadnum;
+    return thread >= 0 ? thread_samplers[thread] : nullptr;
+}
+
+#ifdef CORO_SAMPLER_SUPPORTED
+void coro_sampler_signal_handler(UNUSED int signum, UNUSED siginfo_t *siginfo,
+                                 UNUSED void *uctx) {
+    thread_sampler_t *sampler = get_thread_sampler();
+    if (sampler == nullptr) {
+        return;
+    }
+    if (sampler->write_index - sampler->read_index >= CORO_SAMPLER_BUFFER_SIZE) {
+        sampler->dropped_samples = sampler->dropped_samples + 1;
+        return;
+    }
+    raw_sample_t *sample =
+        &sampler->buffer[sampler->write_index % CORO_SAMPLER_BUFFER_SIZE];
+    coro_t *coro = coro_t::self();
+    sample->spawn_site = coro != nullptr ? coro->get_spawn_site() : nullptr;
+
+    // We strip the signal handler and the signal trampoline from the backtrace
+    const int frames_to_strip = 2 + NUM_FRAMES_INSIDE_RETHINKDB_BACKTRACE;
+    void *frames[CORO_SAMPLER_BACKTRACE_DEPTH + frames_to_strip];
+    int num_frames = std::max(0,
+        rethinkdb_backtrace(frames, CORO_SAMPLER_BACKTRACE_DEPTH + frames_to_strip)
+        - frames_to_strip);
+    memcpy(sample->frames, frames + frames_to_strip, num_frames * sizeof(void *));
+    sample->num_frames = num_frames;
+
+    std::atomic_signal_fence(std::memory_order_release);
+    sampler->write_index = sampler->write_index + 1;
+}
+#endif
+
+/* The `coro_profile` perfmon drains each thread's samples when it visits the thread and
+then reports the combined profile. */
+class coro_profile_perfmon_t : public perfmon_t {
+public:
+    void *begin_stats() {
+        return new thread_stats_t[get_num_threads()];
+    }
+
+    void visit_stats(void *data) {
+        thread_sampler_t *sampler = get_thread_sampler();
+        if (sampler != nullptr) {
+            sampler->drain();
+            thread_stats_t *stats =
+                &static_cast<thread_stats_t *>(data)[get_thread_id().threadnum];
+            stats->profile = sampler->profile;
+            stats->dropped_samples = sampler->dropped_samples;
+        }
+    }
+
+    ql::datum_t end_stats(void *data) {
+        std::unique_ptr<thread_stats_t[]> stats(static_cast<thread_stats_t *>(data));
+
+        profile_t combined;
+        uint64_t dropped_samples = 0;
+        for (int i = 0; i < get_num_threads(); ++i) {
+            for (const auto &pair : stats[i].profile) {
+                combined[pair.first].merge(pair.second);
+            }
+            dropped_samples += stats[i].dropped_samples;
+        }
+
+        // Busiest spawn sites first
+        std::vector<std::pair<const std::type_info *, const site_profile_t *> > sites;
+        for (const auto &pair : combined) {
+            sites.push_back(std::make_pair(pair.first, &pair.second));
+        }
+        std::sort(sites.begin(), sites.end(),
+            [](const std::pair<const std::type_info *, const site_profile_t *> &a,
+               const std::pair<const std::type_info *, const site_profile_t *> &b) {
+                return a.second->cpu_samples > b.second->cpu_samples;
+            });
+
+        ql::datum_array_builder_t sites_builder(ql::configured_limits_t::unlimited);
+        for (const auto &site : sites) {
+            sites_builder.add(site_to_datum(site.first, *site.second));
+        }
+
+        const int rate = coro_sampler_t::get_sample_rate();
+        ql::datum_object_builder_t builder;
+        builder.overwrite("enabled", ql::datum_t::boolean(rate > 0));
+        builder.overwrite("sample_rate_hz", ql::datum_t(static_cast<double>(rate)));
+        builder.overwrite("dropped_samples",
+            ql::datum_t(static_cast<double>(dropped_samples)));
+        builder.overwrite("sites", std::move(sites_builder).to_datum());
+        return std::move(builder).to_datum();
+    }
+
+private:
+    struct thread_stats_t {
+        thread_stats_t() : dropped_samples(0) { }
+        profile_t profile;
+        uint64_t dropped_samples;
+    };
+
+    static ql::datum_t site_to_datum(const std::type_info *spawn_site,
+                                     const site_profile_t &site) {
+        ql::datum_object_builder_t builder;
+        std::string name = "(scheduler)";
+        if (spawn_site != nullptr) {
+            try {
+                name = demangle_cpp_name(spawn_site->name());
+            } catch (const demangle_failed_exc_t &) {
+                name = spawn_site->name();
+            }
+        }
+        builder.overwrite("spawn_site", ql::datum_t(datum_string_t(name)));
+        builder.overwrite("cpu_samples",
+            ql::datum_t(static_cast<double>(site.cpu_samples)));
+        builder.overwrite("cpu_secs", ql::datum_t(
+            static_cast<double>(site.cpu_samples) / coro_sampler_t::get_sample_rate()));
+        builder.overwrite("waits", ql::datum_t(static_cast<double>(site.waits)));
+        builder.overwrite("wait_secs", ql::datum_t(ticks_to_secs(site.wait_ticks)));
+
+        std::vector<std::pair<uint64_t, const std::vector<void *> *> > backtraces;
+        for (const auto &pair : site.backtraces) {
+            backtraces.push_back(std::make_pair(pair.second, &pair.first));
+        }
+        const size_t num_backtraces =
+            std::min<size_t>(backtraces.size(), CORO_SAMPLER_MAX_BACKTRACES_PER_SITE);
+        std::partial_sort(backtraces.begin(), backtraces.begin() + num_backtraces,
+                          backtraces.end(),
+            [](const std::pair<uint64_t, const std::vector<void *> *> &a,
+               const std::pair<uint64_t, const std::vector<void *> *> &b) {
+                return a.first > b.first;
+            });
+
+        ql::datum_array_builder_t backtraces_builder(ql::configured_limits_t::unlimited);
+        for (size_t i = 0; i < num_backtraces; ++i) {
+            ql::datum_array_builder_t frames_builder(ql::configured_limits_t::unlimited);
+            for (void *addr : *backtraces[i].second) {
+                frames_builder.add(ql::datum_t(datum_string_t(describe_frame(addr))));
+            }
+            ql::datum_object_builder_t backtrace_builder;
+            backtrace_builder.overwrite("samples",
+                ql::datum_t(static_cast<double>(backtraces[i].first)));
+            backtrace_builder.overwrite("frames", std::move(frames_builder).to_datum());
+            backtraces_builder.add(std::move(backtrace_builder).to_datum());
+        }
+        builder.overwrite("backtraces", std::move(backtraces_builder).to_datum());
+        return std::move(builder).to_datum();
+    }
+
+    static std::string describe_frame(void *addr) {
+        backtrace_frame_t frame(addr);
+        frame.initialize_symbols();
+        std::string name;
+        try {
+            name = frame.get_demangled_name();
+        } catch (const demangle_failed_exc_t &) {
+            name = frame.get_name().empty() ? "?" : frame.get_name();
+        }
+        return strprintf("%p %s", frame.get_addr(), name.c_str());
+    }
+};
+
+struct pm_coro_profile_t {
+    pm_coro_profile_t()
+        : membership(&get_global_perfmon_collection(), &perfmon, "coro_profile") { }
+    coro_profile_perfmon_t perfmon;
+    perfmon_membership_t membership;
+};
+
+}  // namespace
+
+void coro_sampler_t::set_sample_rate(int hz) {
+    guarantee(hz >= 0);
+#ifdef CORO_SAMPLER_SUPPORTED
+    sample_rate_hz = hz;
+#else
+    if (hz > 0) {
+        logWRN("The coroutine sampler is not supported on this platform.");
+    }
+#endif
+}
+
+void coro_sampler_t::start_on_thread() {
+    // Registers the perfmon the first time we get here, so that the profile table
+    // shows that sampling is off even if it is.
+    static pm_coro_profile_t pm_coro_profile;
+
+#ifdef CORO_SAMPLER_SUPPORTED
+    if (!is_enabled()) {
+        return;
+    }
+    const int thread = get_thread_id().threadnum;
+    guarantee(thread >= 0 && thread_samplers[thread] == nullptr);
+    thread_sampler_t *sampler = new thread_sampler_t();
+
+    // `backtrace()` loads libgcc the first time it's called, which we don't want to
+    // happen inside of the signal handler.
+    void *dummy_frames[1];
+    rethinkdb_backtrace(dummy_frames, 1);
+
+    struct sigaction sa = make_sa_sigaction(SA_SIGINFO | SA_RESTART | SA_ONSTACK,
+                                            &coro_sampler_signal_handler);
+    int res = sigaction(SIGPROF, &sa, nullptr);
+    guarantee_err(res == 0, "Could not install the coro sampler's signal handler");
+
+    struct sigevent evp;
+    memset(&evp, 0, sizeof(evp));
+    evp.sigev_signo = SIGPROF;
+    evp.sigev_notify = SIGEV_THREAD_ID;
+    evp.sigev_notify_thread_id = _gettid();
+    res = timer_create(CLOCK_THREAD_CPUTIME_ID, &evp, &sampler->timer);
+    guarantee_err(res == 0, "Could not create the coro sampler's timer");
+
+    thread_samplers[thread] = sampler;
+
+    const int64_t interval_nanos = BILLION / sample_rate_hz;
+    itimerspec spec;
+    spec.it_value.tv_sec = spec.it_interval.tv_sec = interval_nanos / BILLION;
+    spec.it_value.tv_nsec = spec.it_interval.tv_nsec = interval_nanos % BILLION;
+    res = timer_settime(sampler->timer, 0, &spec, nullptr);
+    guarantee_err(res == 0, "Could not arm the coro sampler's timer");
+#endif
+}
+
+void coro_sampler_t::stop_on_thread() {
+#ifdef CORO_SAMPLER_SUPPORTED
+    const int thread = get_thread_id().threadnum;
+    thread_sampler_t *sampler = thread_samplers[thread];
+    if (sampler == nullptr) {
+        return;
+    }
+    int res = timer_delete(sampler->timer);
+    guarantee_err(res == 0, "timer_delete failed");
+    // A signal from the timer might still be pending, so we leave the handler installed
+    // and just make it ignore this thread from now on.
+    thread_samplers[thread] = nullptr;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    delete sampler;
+#endif
+}
+
+void coro_sampler_t::record_wait(const std::type_info *spawn_site, ticks_t ticks) {
+    thread_sampler_t *sampler = get_thread_sampler();
+    if (sampler != nullptr) {
+        site_profile_t *site = &sampler->profile[spawn_site];
+        ++site->waits;
+        site->wait_ticks += ticks;
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CORO_SAMPLER_HPP_
+#define ARCH_RUNTIME_CORO_SAMPLER_HPP_
+
+#include <typeinfo>
+
+#include "time.hpp"
+
+/* Depth of the backtraces recorded by the coro sampler. */
+#define CORO_SAMPLER_BACKTRACE_DEPTH            16
+
+/* How many samples each thread can buffer before they are aggregated. Samples are
+aggregated whenever someone reads the `coro_profile` perfmon; samples that don't fit
+into the buffer until then are dropped (and counted). */
+#define CORO_SAMPLER_BUFFER_SIZE                1024
+
+/* How many of the most frequent backtraces are reported for each spawn site. */
+#define CORO_SAMPLER_MAX_BACKTRACES_PER_SITE    5
+
+/*
+ * The `coro_sampler_t` is a sampling profiler for coroutines. Unlike the
+ * `coro_profiler_t` it is always compiled in, and it's off unless the server is
+ * started with `--coro-sample-rate`.
+ *
+ * When it's on, each thread of the thread pool has a timer that delivers `SIGPROF`
+ * `rate` times per second of CPU time the thread uses. The signal handler notes which
+ * coroutine was running, identified by the type of the callable it was spawned with
+ * (its "spawn site"), and a short backtrace into a per-thread buffer. In addition,
+ * `coro_t::wait()` reports how long each coroutine spent waiting.
+ *
+ * The samples are aggregated per spawn site on each thread when the `coro_profile`
+ * perfmon is read, which is what the `rethinkdb._debug_profile` table does. The
+ * profile covers everything since the server started.
+ *
+ * When it's off, the only cost is checking `is_enabled()` in `coro_t::wait()`.
+ */
+class coro_sampler_t {
+public:
+    // Must be called before the thread pool starts. A rate of 0 turns sampling off.
+    static void set_sample_rate(int hz);
+    static int get_sample_rate() { return sample_rate_hz; }
+    static bool is_enabled() { return sample_rate_hz > 0; }
+
+    // Called by each thread of the thread pool when it starts and before it stops.
+    static void start_on_thread();
+    static void stop_on_thread();
+
+    // Called when a coroutine that was spawned at `spawn_site` is resumed after it
+    // spent `ticks` waiting.
+    static void record_wait(const std::type_info *spawn_site, ticks_t ticks);
+
+private:
+    static int sample_rate_hz;
+};
+
+#endif /* ARCH_RUNTIME_CORO_SAMPLER_HPP_ */
@@ -13,6 +13,7 @@
 
 #include "arch/runtime/context_switching.hpp"
 #include "arch/runtime/coro_profiler.hpp"
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "config/args.hpp"
@@ -131,7 +132,10 @@ coro_t::coro_t() :
     stack(&coro_t::run, coro_stack_size),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
-    waiting_(false)
+    waiting_(false),
+    spawn_site(NULL),
+    running_time_counter(NULL),
+    running_since(0)
 #ifndef NDEBUG
     , selfname_number(get_thread_id().threadnum + MAX_THREADS *
           // The comma here is the comma operator, to implement the semantics
@@ -254,6 +258,13 @@ void coro_t::wait() {   /* class method */
     rassert(!self()->waiting_);
     self()->waiting_ = true;
 
+    const ticks_t wait_start =
+        coro_sampler_t::is_enabled() || self()->running_time_counter != NULL
+            ? get_ticks() : 0;
+    if (self()->running_time_counter != NULL) {
+        *self()->running_time_counter += wait_start - self()->running_since;
+    }
+
     PROFILER_CORO_YIELD(1);
     if (TLS_get_cglobals()->prev_coro) {
         context_switch(&self()->stack.context, &TLS_get_cglobals()->prev_coro->stack.context);
@@ -262,11 +273,40 @@ void coro_t::wait() {   /* class method */
     }
     PROFILER_CORO_RESUME;
 
+    if (wait_start != 0) {
+        const ticks_t now = get_ticks();
+        if (coro_sampler_t::is_enabled()) {
+            coro_sampler_t::record_wait(self()->spawn_site, now - wait_start);
+        }
+        self()->running_since = now;
+    }
+
     rassert(self());
     rassert(self()->waiting_);
     self()->waiting_ = false;
 }
 
+coro_t::running_time_counter_t::running_time_counter_t(ticks_t *counter)
+    : coro(coro_t::self()) {
+    rassert(coro != NULL, "Not in a coroutine context");
+    rassert(coro->running_time_counter == NULL);
+    coro->running_time_counter = counter;
+    coro->running_since = get_ticks();
+}
+
+coro_t::running_time_counter_t::~running_time_counter_t() {
+    rassert(coro == coro_t::self());
+    *coro->running_time_counter += get_ticks() - coro->running_since;
+    coro->running_time_counter = NULL;
+}
+
+ticks_t coro_t::last_resumed_ticks() {  /* class method */
+    coro_t *coro = self();
+    return coro != NULL && coro->running_time_counter != NULL
+        ? coro->running_since
+        : 0;
+}
+
 void coro_t::yield() {  /* class method */
     rassert(self(), "Not in a coroutine context");
     self()->notify_sometime();
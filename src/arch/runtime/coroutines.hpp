@@ -2,6 +2,7 @@
 #ifndef ARCH_RUNTIME_COROUTINES_HPP_
 #define ARCH_RUNTIME_COROUTINES_HPP_
 
+#include <typeinfo>
 #ifndef NDEBUG
 #include <string>
 #endif
@@ -133,6 +134,11 @@ public:
     const std::string& get_coroutine_type() { return coroutine_type; }
 #endif
 
+    // Identifies where the coroutine was spawned by the type of the callable it runs.
+    // This is used by the `coro_sampler_t`, and unlike `get_coroutine_type()` it's also
+    // available in release mode.
+    const std::type_info *get_spawn_site() const { return spawn_site; }
+
     static void set_coroutine_stack_size(size_t size);
 
     coro_stack_t *get_stack();
@@ -144,6 +150,22 @@ public:
         return linux_thread_message_t::get_priority();
     }
 
+    /* While a `running_time_counter_t` exists, the time that the coroutine which
+    created it spends running (as opposed to waiting) is added to `*counter`. Only
+    one can exist per coroutine at a time. */
+    class running_time_counter_t {
+    public:
+        explicit running_time_counter_t(ticks_t *counter);
+        ~running_time_counter_t();
+    private:
+        coro_t *coro;
+        DISABLE_COPYING(running_time_counter_t);
+    };
+
+    /* Returns when the current coroutine last started running again after waiting,
+    if a `running_time_counter_t` exists for it, and 0 otherwise. */
+    static ticks_t last_resumed_ticks();
+
     /* Copies the backtrace from the time of spawning the coroutine into
     `buffer_out`, which has to be allocated before calling the function.
     `size` must contain the maximum number of entries to store.
@@ -172,6 +194,8 @@ private:
         coro->parse_coroutine_type(__PRETTY_FUNCTION__);
 #endif
         coro->grab_spawn_backtrace();
+        coro->spawn_site = &typeid(Callable);
+        coro->running_time_counter = NULL;
         coro->action_wrapper.reset(std::forward<Callable>(action));
 
         // If we were called from a coroutine, the new coroutine inherits our
@@ -209,6 +233,12 @@ private:
 
     callable_action_wrapper_t action_wrapper;
 
+    const std::type_info *spawn_site;
+
+    // See `running_time_counter_t`.
+    ticks_t *running_time_counter;
+    ticks_t running_since;
+
 #ifndef NDEBUG
     int64_t selfname_number;
     std::string coroutine_type;
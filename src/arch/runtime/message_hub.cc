@@ -8,6 +8,7 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "logger.hpp"
+#include "perfmon/perfmon.hpp"
 #include "utils.hpp"
 
 // Set this to 1 if you would like some "unordered" messages to be unordered.
@@ -104,6 +105,36 @@ void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
     }
 }
 
+namespace {
+struct pm_scheduler_t {
+    pm_scheduler_t()
+        : longest_slice(secs_to_ticks(1)),
+          long_slices(secs_to_ticks(1)),
+          membership(&get_global_perfmon_collection(), &collection, "scheduler"),
+          stat_membership(&collection,
+              &longest_slice, "longest_slice_usecs",
+              &long_slices, "long_slices_per_sec") { }
+    perfmon_collection_t collection;
+    perfmon_thread_max_t longest_slice;
+    perfmon_rate_monitor_t long_slices;
+    perfmon_membership_t membership;
+    perfmon_multi_membership_t stat_membership;
+};
+
+pm_scheduler_t *get_pm_scheduler() {
+    static pm_scheduler_t pm_scheduler;
+    return &pm_scheduler;
+}
+}  // namespace
+
+perfmon_thread_max_t *pm_scheduler_singleton_t::longest_slice() {
+    return &get_pm_scheduler()->longest_slice;
+}
+
+perfmon_rate_monitor_t *pm_scheduler_singleton_t::long_slices() {
+    return &get_pm_scheduler()->long_slices;
+}
+
 linux_message_hub_t::msg_list_t &linux_message_hub_t::get_priority_msg_list(int priority) {
     rassert(priority >= MESSAGE_SCHEDULER_MIN_PRIORITY);
     rassert(priority <= MESSAGE_SCHEDULER_MAX_PRIORITY);
@@ -133,6 +164,10 @@ void linux_message_hub_t::on_event(int events) {
     const size_t effective_granularity = std::min(total_pending_msgs,
                                                   static_cast<size_t>(MESSAGE_SCHEDULER_GRANULARITY));
 
+    // The thread can't get back to its event loop until this pass is over, so we
+    // time the pass rather than each message, which would cost a clock read each.
+    const ticks_t slice_start = get_ticks();
+
     // Process a certain number of messages from each priority
     for (int current_priority = MESSAGE_SCHEDULER_MAX_PRIORITY;
          current_priority >= MESSAGE_SCHEDULER_MIN_PRIORITY; --current_priority) {
@@ -168,6 +203,13 @@ void linux_message_hub_t::on_event(int events) {
         }
     }
 
+    const ticks_t slice_end = get_ticks();
+    const double slice_usecs = (slice_end - slice_start) / 1000.0;
+    pm_scheduler_singleton_t::longest_slice()->record(slice_usecs, slice_end);
+    if (slice_usecs > MESSAGE_SCHEDULER_LONG_SLICE_USECS) {
+        pm_scheduler_singleton_t::long_slices()->record();
+    }
+
     // We might have left some messages unprocessed.
     // Check if that is the case, and if yes, make sure we are called again.
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
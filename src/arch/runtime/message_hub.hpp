@@ -11,6 +11,7 @@
 #include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "perfmon/types.hpp"
 #include "threading.hpp"
 
 
@@ -21,6 +22,16 @@
 
 class linux_thread_pool_t;
 
+// Scheduler stats. Like `pm_eventloop_singleton_t`, these are initialized on first use
+// because a static perfmon membership would race with the coroutine globals.
+// `longest_slice()` reports, for each thread, the longest time a pass over the queued
+// messages kept the thread from getting back to its event loop. This is how we find
+// coroutines that hog a thread without yielding.
+struct pm_scheduler_singleton_t {
+    static perfmon_thread_max_t *longest_slice();
+    static perfmon_rate_monitor_t *long_slices();
+};
+
 /* There is one message hub per thread, NOT one message hub for the entire program.
 
 Each message hub stores messages that are going from that message hub's home thread to
@@ -0,0 +1,142 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "arch/runtime/numa.hpp"
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+
+#include "arch/runtime/runtime_utils.hpp"
+#include "errors.hpp"
+
+numa_topology_t::numa_topology_t(const std::vector<std::vector<int> > &node_cpus) {
+    for (const auto &cpus : node_cpus) {
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+}
+
+bool parse_cpu_list(const std::string &str, std::vector<int> *cpus_out) {
+    cpus_out->clear();
+    const char *p = str.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus_out->push_back(static_cast<int>(cpu));
+        }
+        if (*p == ',') {
+            ++p;
+        } else if (*p != '\0' && *p != '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef __linux__
+static bool read_node_cpus(int node, std::vector<int> *cpus_out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    char buf[4096];
+    bool ok = fgets(buf, sizeof(buf), f) != NULL && parse_cpu_list(buf, cpus_out);
+    fclose(f);
+    return ok;
+}
+#endif
+
+numa_topology_t numa_topology_t::detect() {
+    std::vector<std::vector<int> > node_cpus;
+
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    // Node numbers don't have to be contiguous, so we list the directory instead of
+    // counting up from zero.
+    std::map<int, std::vector<int> > by_node;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            int node;
+            char trailing;
+            if (sscanf(entry->d_name, "node%d%c", &node, &trailing) != 1) {
+                continue;
+            }
+            std::vector<int> cpus;
+            if (!read_node_cpus(node, &cpus)) {
+                by_node.clear();
+                break;
+            }
+            std::vector<int> usable;
+            for (int cpu : cpus) {
+                if (!have_allowed || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    usable.push_back(cpu);
+                }
+            }
+            by_node[node] = usable;
+        }
+        closedir(dir);
+    }
+    for (const auto &pair : by_node) {
+        node_cpus.push_back(pair.second);
+    }
+#endif
+
+    numa_topology_t topology(node_cpus);
+    if (topology.num_nodes() == 0) {
+        std::vector<int> all_cpus;
+        for (int cpu = 0; cpu < get_cpu_count(); ++cpu) {
+            all_cpus.push_back(cpu);
+        }
+        topology.nodes.push_back(all_cpus);
+    }
+    return topology;
+}
+
+std::vector<size_t> numa_topology_t::assign_threads(int n_threads) const {
+    guarantee(!nodes.empty());
+    int64_t total_cpus = 0;
+    std::vector<int64_t> node_end;
+    for (const auto &cpus : nodes) {
+        total_cpus += cpus.size();
+        node_end.push_back(total_cpus);
+    }
+
+    // Thread `i` is placed at position `i * total_cpus / n_threads` along the CPUs of
+    // all nodes, so each node gets a share of the threads proportional to its size.
+    std::vector<size_t> result;
+    size_t node = 0;
+    for (int i = 0; i < n_threads; ++i) {
+        int64_t position = static_cast<int64_t>(i) * total_cpus / n_threads;
+        while (position >= node_end[node]) {
+            ++node;
+        }
+        result.push_back(node);
+    }
+    return result;
+}
@@ -0,0 +1,38 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_NUMA_HPP_
+#define ARCH_RUNTIME_NUMA_HPP_
+
+#include <string>
+#include <vector>
+
+/* `numa_topology_t` describes which CPUs belong to which NUMA node. The thread pool
+uses it to keep each of its threads on a single node, so that the memory a thread
+touches first (and hence the memory the kernel allocates for it) is local to the CPUs
+that thread runs on. */
+
+class numa_topology_t {
+public:
+    // Each entry is the list of CPUs of one node. Nodes without CPUs are dropped.
+    explicit numa_topology_t(const std::vector<std::vector<int> > &node_cpus);
+
+    // Reads the topology from `/sys/devices/system/node`, restricted to the CPUs the
+    // process is allowed to run on. Falls back to a single node containing all CPUs
+    // if the topology isn't available.
+    static numa_topology_t detect();
+
+    size_t num_nodes() const { return nodes.size(); }
+    const std::vector<int> &cpus_of_node(size_t node) const { return nodes[node]; }
+
+    // Splits `n_threads` threads into contiguous blocks, one per node, with sizes
+    // proportional to the number of CPUs of each node. Returns the node of each
+    // thread.
+    std::vector<size_t> assign_threads(int n_threads) const;
+
+private:
+    std::vector<std::vector<int> > nodes;
+};
+
+// Parses a Linux CPU list such as "0-3,8,10-11". Returns false if it's malformed.
+bool parse_cpu_list(const std::string &str, std::vector<int> *cpus_out);
+
+#endif  // ARCH_RUNTIME_NUMA_HPP_
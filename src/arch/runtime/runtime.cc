@@ -20,6 +20,16 @@ int get_num_threads() {
     return linux_thread_pool_t::get_thread_pool()->n_threads;
 }
 
+int get_num_numa_nodes() {
+    return linux_thread_pool_t::get_thread_pool()->get_num_numa_nodes();
+}
+
+int get_thread_numa_node(threadnum_t thread) {
+    assert_good_thread_id(thread);
+    return linux_thread_pool_t::get_thread_pool()->get_thread_numa_node(
+        thread.threadnum);
+}
+
 #ifndef NDEBUG
 void assert_good_thread_id(threadnum_t thread) {
     rassert(thread.threadnum >= 0, "(thread = %" PRIi32 ")", thread.threadnum);
@@ -11,6 +11,11 @@ threadnum_t get_thread_id();
 
 int get_num_threads();
 
+// The thread pool keeps each thread on a single NUMA node; threads on the same node
+// share local memory.
+int get_num_numa_nodes();
+int get_thread_numa_node(threadnum_t thread);
+
 #ifndef NDEBUG
 void assert_good_thread_id(threadnum_t thread);
 #else
@@ -10,6 +10,7 @@
 #include "arch/barrier.hpp"
 #include "arch/os_signal.hpp"
 #include "arch/io/timer_provider.hpp"
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "errors.hpp"
@@ -50,11 +51,14 @@ linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affini
       interrupt_message(NULL),
       generic_blocker_pool(NULL),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      do_set_affinity(_do_set_affinity),
+      numa_topology(numa_topology_t::detect())
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
 
+    thread_numa_nodes = numa_topology.assign_threads(n_threads);
+
     int res;
 
     res = pthread_cond_init(&shutdown_cond, NULL);
@@ -95,6 +99,9 @@ void *linux_thread_pool_t::start_thread(void *arg) {
         guarantee_err(res == 0, "Could not remove SIGSEGV from sigmask");
         res = sigdelset(&sigmask, SIGBUS);
         guarantee_err(res == 0, "Could not remove SIGBUS from sigmask");
+        // `SIGPROF` is used by the `coro_sampler_t`
+        res = sigdelset(&sigmask, SIGPROF);
+        guarantee_err(res == 0, "Could not remove SIGPROF from sigmask");
 
         res = pthread_sigmask(SIG_SETMASK, &sigmask, NULL);
         guarantee_xerr(res == 0, res, "Could not block signal");
@@ -138,6 +145,8 @@ void *linux_thread_pool_t::start_thread(void *arg) {
 
 #endif  // VALGRIND
 
+        coro_sampler_t::start_on_thread();
+
         // First thread should initialize generic_blocker_pool before the start barrier
         if (tdata->initial_message) {
             rassert(tdata->thread_pool->generic_blocker_pool == NULL, "generic_blocker_pool already initialized");
@@ -165,6 +174,8 @@ void *linux_thread_pool_t::start_thread(void *arg) {
         // needed to access.
         tdata->barrier->wait();
 
+        coro_sampler_t::stop_on_thread();
+
 #ifndef VALGRIND
         free(signal_stack.ss_sp);
 #endif
@@ -189,6 +200,45 @@ void linux_thread_pool_t::enable_coroutine_summary() {
 }
 #endif
 
+void linux_thread_pool_t::set_thread_affinity(int thread) {
+    // On Apple, the thread affinity API has awful documentation, so we don't even bother.
+#ifdef _GNU_SOURCE
+    if (!do_set_affinity && numa_topology.num_nodes() == 1) {
+        // Leave it to the scheduler.
+        return;
+    }
+    const size_t node = thread_numa_nodes[thread];
+    const std::vector<int> &node_cpus = numa_topology.cpus_of_node(node);
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (do_set_affinity) {
+        // Distribute the node's threads evenly among the node's CPUs
+        int index_in_node = 0;
+        for (int i = 0; i < thread; ++i) {
+            if (thread_numa_nodes[i] == node) {
+                ++index_in_node;
+            }
+        }
+        CPU_SET(node_cpus[index_in_node % node_cpus.size()], &mask);
+    } else {
+        for (int cpu : node_cpus) {
+            CPU_SET(cpu, &mask);
+        }
+    }
+    int res = pthread_setaffinity_np(pthreads[thread], sizeof(cpu_set_t), &mask);
+    if (do_set_affinity) {
+        guarantee_xerr(res == 0, res, "Could not set thread affinity");
+    } else if (res != 0) {
+        // Running on the wrong node only costs performance.
+        logWRN("Could not restrict thread %d to NUMA node %zu: %s",
+               thread, node, errno_string(res).c_str());
+    }
+#else
+    (void)thread;
+#endif
+}
+
 void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_message) {
     do_shutdown = false;
 
@@ -206,18 +256,7 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         int res = pthread_create(&pthreads[i], NULL, &start_thread, tdata);
         guarantee_xerr(res == 0, res, "Could not create thread");
 
-        if (do_set_affinity) {
-            // On Apple, the thread affinity API has awful documentation, so we don't even bother.
-#ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
-            cpu_set_t mask;
-            CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
-            res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
-            guarantee_xerr(res == 0, res, "Could not set thread affinity");
-#endif
-        }
+        set_thread_affinity(i);
     }
 
     // Mark the main thread (for use in assertions etc.)
@@ -6,11 +6,13 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "config/args.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/system_event.hpp"
 #include "arch/runtime/message_hub.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
@@ -93,6 +95,11 @@ public:
     int n_threads;
     bool do_set_affinity;
 
+    // Threads are distributed over the NUMA nodes in contiguous blocks; on machines
+    // with more than one node, each thread is restricted to the CPUs of its node.
+    int get_num_numa_nodes() const { return numa_topology.num_nodes(); }
+    int get_thread_numa_node(int thread) const { return thread_numa_nodes[thread]; }
+
     // Non-inlinable getters and setters for the thread local variables.
     // See thread_local.hpp for an explanation of why these must not be
     // inlined.
@@ -111,6 +118,13 @@ private:
     // The event queue for the thread we are currently in (same as &thread_pool->threads[thread_id])
     static __thread linux_thread_t *thread;
 
+    // Restricts the thread to the CPUs of its NUMA node, or to a single CPU of its
+    // node if `do_set_affinity` is set.
+    void set_thread_affinity(int thread);
+
+    numa_topology_t numa_topology;
+    std::vector<size_t> thread_numa_nodes;
+
     DISABLE_COPYING(linux_thread_pool_t);
 };
 
@@ -126,6 +126,10 @@ public:
     virtual int64_t get_file_size() = 0;
     virtual void set_file_size(int64_t size) = 0;
     virtual void set_file_size_at_least(int64_t size) = 0;
+    /* Tells the filesystem that the contents of the given range are no longer needed,
+    so that it can release the space. Reading the range afterwards returns zeroes. This
+    is only a hint; it's fine for an implementation to ignore it. */
+    virtual void discard(int64_t offset, int64_t length) = 0;
 
     virtual void read_async(int64_t offset, size_t length, void *buf,
                             file_account_t *account, linux_iocallback_t *cb) = 0;
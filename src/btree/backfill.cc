@@ -1,21 +1,25 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/backfill.hpp"
 
+#include <array>
+
 #include "arch/runtime/coroutines.hpp"
 #include "btree/depth_first_traversal.hpp"
 #include "btree/leaf_node.hpp"
 #include "concurrency/pmap.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "utils.hpp"
 
 /* `MAX_CONCURRENT_VALUE_LOADS` is the maximum number of coroutines we'll use for loading
 values from the leaf nodes. */
 static const int MAX_CONCURRENT_VALUE_LOADS = 16;
 
-RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(backfill_pre_item_t, range);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(backfill_content_hash_t, seed0, seed1, digest);
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(backfill_pre_item_t, range, content_hash);
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(backfill_item_t::pair_t, key, recency, value);
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(backfill_item_t,
-    range, pairs, min_deletion_timestamp);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(backfill_item_t,
+    range, pairs, min_deletion_timestamp, recency_only);
 
 void backfill_item_t::mask_in_place(const key_range_t &m) {
     range = range.intersection(m);
@@ -28,6 +32,108 @@ void backfill_item_t::mask_in_place(const key_range_t &m) {
     pairs = std::move(new_pairs);
 }
 
+/* `content_hasher_t` computes a `backfill_content_hash_t` using SipHash-2-4. Call
+`add_pair()` for every live key-value pair in the range, in lexicographical order. Each
+key and value is length-prefixed so that different sequences of pairs can't produce the
+same byte stream. */
+class content_hasher_t {
+public:
+    /* Uses this process's seeds; see `get_local_seeds()` */
+    content_hasher_t() {
+        const uint64_t *seeds = get_local_seeds();
+        init(seeds[0], seeds[1]);
+    }
+    /* Uses the seeds from a hash that some other B-tree computed, so the result can be
+    compared with it */
+    explicit content_hasher_t(const backfill_content_hash_t &other) {
+        init(other.seed0, other.seed1);
+    }
+
+    void add_pair(const btree_key_t *key, const std::vector<char> &value) {
+        add_bytes(&key->size, sizeof(key->size));
+        add_bytes(key->contents, key->size);
+        uint64_t value_size = value.size();
+        add_bytes(&value_size, sizeof(value_size));
+        add_bytes(value.data(), value.size());
+    }
+    void add_pair(const store_key_t &key, const std::vector<char> &value) {
+        add_pair(key.btree_key(), value);
+    }
+
+    backfill_content_hash_t finish() {
+        uint64_t b = (static_cast<uint64_t>(total_size & 0xff) << 56) | tail;
+        compress(b);
+        v2 ^= 0xff;
+        for (int i = 0; i < 4; ++i) {
+            round();
+        }
+        backfill_content_hash_t res;
+        res.seed0 = seed0;
+        res.seed1 = seed1;
+        res.digest = v0 ^ v1 ^ v2 ^ v3;
+        return res;
+    }
+
+private:
+    /* The seeds are chosen once per process. They never leave the cluster, so clients
+    can't use them to construct collisions. */
+    static const uint64_t *get_local_seeds() {
+        static const std::array<uint64_t, 2> seeds = []() {
+            std::array<uint64_t, 2> s;
+            get_dev_urandom(s.data(), sizeof(uint64_t) * s.size());
+            return s;
+        }();
+        return seeds.data();
+    }
+
+    void init(uint64_t s0, uint64_t s1) {
+        seed0 = s0;
+        seed1 = s1;
+        v0 = s0 ^ 0x736f6d6570736575ull;
+        v1 = s1 ^ 0x646f72616e646f6dull;
+        v2 = s0 ^ 0x6c7967656e657261ull;
+        v3 = s1 ^ 0x7465646279746573ull;
+        tail = 0;
+        tail_size = 0;
+        total_size = 0;
+    }
+
+    void add_bytes(const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; ++i) {
+            tail |= static_cast<uint64_t>(bytes[i]) << (8 * tail_size);
+            if (++tail_size == 8) {
+                compress(tail);
+                tail = 0;
+                tail_size = 0;
+            }
+        }
+        total_size += size;
+    }
+
+    static uint64_t rotl(uint64_t x, int b) {
+        return (x << b) | (x >> (64 - b));
+    }
+    void round() {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    }
+    void compress(uint64_t m) {
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    }
+
+    uint64_t seed0, seed1;
+    uint64_t v0, v1, v2, v3;
+    uint64_t tail;
+    int tail_size;
+    uint64_t total_size;
+};
+
 /* `convert_to_right_bound()` is suitable for converting `btree_key_t *`s in the format
 of `right_incl` or `left_excl_or_null` into a `key_range_t::right_bound_t`. */
 key_range_t::right_bound_t convert_to_right_bound(const btree_key_t *rightmost_before) {
@@ -59,6 +165,7 @@ continue_bool_t btree_send_backfill_pre(
         value_sizer_t *sizer,
         const key_range_t &range,
         repli_timestamp_t reference_timestamp,
+        bool content_hashes,
         btree_backfill_pre_item_consumer_t *pre_item_consumer,
         signal_t *interruptor) {
     class callback_t : public depth_first_traversal_callback_t {
@@ -82,7 +189,7 @@ continue_bool_t btree_send_backfill_pre(
                 const counted_t<counted_buf_lock_and_read_t> &buf,
                 const btree_key_t *left_excl_or_null,
                 const btree_key_t *right_incl,
-                signal_t *,
+                signal_t *interruptor,
                 bool *skip_out) {
             *skip_out = true;
             const leaf_node_t *lnode = static_cast<const leaf_node_t *>(
@@ -94,13 +201,36 @@ continue_bool_t btree_send_backfill_pre(
                 */
                 backfill_pre_item_t pre_item;
                 pre_item.range = convert_to_key_range(left_excl_or_null, right_incl);
+                if (!content_hashes) {
+                    return pre_item_consumer->on_pre_item(std::move(pre_item));
+                }
+                std::vector<std::pair<const btree_key_t *, const void *> > entries;
+                leaf::visit_entries(
+                    sizer, lnode, buf->lock.get_recency(),
+                    [&](const btree_key_t *key, repli_timestamp_t,
+                            const void *value_or_null) -> continue_bool_t {
+                        if (pre_item.range.contains_key(key)) {
+                            entries.push_back(std::make_pair(key, value_or_null));
+                        }
+                        return continue_bool_t::CONTINUE;
+                    });
+                std::sort(entries.begin(), entries.end(),
+                    [](const std::pair<const btree_key_t *, const void *> &e1,
+                            const std::pair<const btree_key_t *, const void *> &e2) {
+                        return btree_key_cmp(e1.first, e2.first) < 0;
+                    });
+                content_hasher_t hasher;
+                for (const auto &entry : entries) {
+                    hash_entry(buf, entry.first, entry.second, &hasher, interruptor);
+                }
+                pre_item.content_hash = hasher.finish();
                 return pre_item_consumer->on_pre_item(std::move(pre_item));
             } else {
-                std::vector<const btree_key_t *> keys;
+                std::vector<std::pair<const btree_key_t *, const void *> > keys;
                 leaf::visit_entries(
                     sizer, lnode, buf->lock.get_recency(),
                     [&](const btree_key_t *key, repli_timestamp_t timestamp,
-                            const void *) -> continue_bool_t {
+                            const void *value_or_null) -> continue_bool_t {
                         if ((left_excl_or_null != nullptr &&
                                     btree_key_cmp(key, left_excl_or_null) <= 0)
                                 || btree_key_cmp(key, right_incl) > 0) {
@@ -114,16 +244,22 @@ continue_bool_t btree_send_backfill_pre(
                         if (timestamp <= reference_timestamp) {
                             return continue_bool_t::ABORT;
                         }
-                        keys.push_back(key);
+                        keys.push_back(std::make_pair(key, value_or_null));
                         return continue_bool_t::CONTINUE;
                     });
                 std::sort(keys.begin(), keys.end(),
-                    [](const btree_key_t *k1, const btree_key_t *k2) {
-                        return btree_key_cmp(k1, k2) < 0;
+                    [](const std::pair<const btree_key_t *, const void *> &k1,
+                            const std::pair<const btree_key_t *, const void *> &k2) {
+                        return btree_key_cmp(k1.first, k2.first) < 0;
                     });
-                for (const btree_key_t *key : keys) {
+                for (const auto &key : keys) {
                     backfill_pre_item_t pre_item;
-                    pre_item.range = key_range_t(key);
+                    pre_item.range = key_range_t(key.first);
+                    if (content_hashes) {
+                        content_hasher_t hasher;
+                        hash_entry(buf, key.first, key.second, &hasher, interruptor);
+                        pre_item.content_hash = hasher.finish();
+                    }
                     if (continue_bool_t::ABORT ==
                             pre_item_consumer->on_pre_item(std::move(pre_item))) {
                         return continue_bool_t::ABORT;
@@ -146,12 +282,30 @@ continue_bool_t btree_send_backfill_pre(
                     convert_to_right_bound(right_incl));
         }
 
+        /* `hash_entry()` adds a leaf node entry to `hasher`. Deletion entries are
+        skipped because the content hash only covers live values. */
+        void hash_entry(
+                const counted_t<counted_buf_lock_and_read_t> &buf,
+                const btree_key_t *key,
+                const void *value_or_null,
+                content_hasher_t *hasher,
+                signal_t *interruptor) {
+            if (value_or_null != nullptr) {
+                std::vector<char> value;
+                pre_item_consumer->copy_value(
+                    buf_parent_t(&buf->lock), value_or_null, interruptor, &value);
+                hasher->add_pair(key, value);
+            }
+        }
+
         btree_backfill_pre_item_consumer_t *pre_item_consumer;
         repli_timestamp_t reference_timestamp;
+        bool content_hashes;
         value_sizer_t *sizer;
     } callback;
     callback.pre_item_consumer = pre_item_consumer;
     callback.reference_timestamp = reference_timestamp;
+    callback.content_hashes = content_hashes;
     callback.sizer = sizer;
     return btree_depth_first_traversal(superblock, range, &callback, access_t::read,
         FORWARD, release_superblock, interruptor);
@@ -176,16 +330,22 @@ public:
     will contain a pointer into `buf_read.get_data_read()` which can be used to actually
     load the value. The pointer is stored in the `std::vector<char>` that would normally
     be supposed to store the value. This is kind of a hack, but it will work and it's
-    localized to these two types. */
+    localized to these two types.
+
+    If `expected_hash` is set, it's the `content_hash` of a pre-item whose range is
+    exactly `item.range`. Once the values are loaded, if they hash to the same value,
+    then the values are dropped from the item and it's marked `recency_only`, because
+    the backfill destination already has the same contents. */
     void on_item(
             backfill_item_t &&item,
             const counted_t<counted_buf_lock_and_read_t> &buf,
+            const boost::optional<backfill_content_hash_t> &expected_hash,
             signal_t *interruptor) {
         new_semaphore_acq_t sem_acq(&semaphore, item.pairs.size());
         wait_interruptible(sem_acq.acquisition_signal(), interruptor);
         coro_t::spawn_sometime(std::bind(
             &backfill_item_loader_t::handle_item, this,
-            std::move(item), buf, std::move(sem_acq),
+            std::move(item), buf, expected_hash, std::move(sem_acq),
             fifo_source.enter_write(), drainer.lock()));
     }
 
@@ -213,6 +373,7 @@ private:
             to handle that. */
             backfill_item_t &item,   // NOLINT runtime/references
             const counted_t<counted_buf_lock_and_read_t> &buf,
+            const boost::optional<backfill_content_hash_t> &expected_hash,
             const new_semaphore_acq_t &,
             fifo_enforcer_write_token_t token,
             auto_drainer_t::lock_t keepalive) {
@@ -241,6 +402,16 @@ private:
             if (abort_cond->is_pulsed()) {
                 return;
             }
+            if (static_cast<bool>(expected_hash) && matches(item, *expected_hash)) {
+                /* The destination already has these values, but it still needs our
+                timestamps for them. */
+                for (backfill_item_t::pair_t &pair : item.pairs) {
+                    if (static_cast<bool>(pair.value)) {
+                        pair.value = std::vector<char>();
+                    }
+                }
+                item.recency_only = true;
+            }
             if (continue_bool_t::ABORT == item_consumer->on_item(std::move(item))) {
                 abort_cond->pulse();
             }
@@ -249,6 +420,17 @@ private:
         }
     }
 
+    static bool matches(
+            const backfill_item_t &item, const backfill_content_hash_t &expected) {
+        content_hasher_t hasher(expected);
+        for (const backfill_item_t::pair_t &pair : item.pairs) {
+            if (static_cast<bool>(pair.value)) {
+                hasher.add_pair(pair.key, *pair.value);
+            }
+        }
+        return hasher.finish().digest == expected.digest;
+    }
+
     void handle_empty_range(
             const key_range_t::right_bound_t &threshold,
             const new_semaphore_acq_t &,
@@ -327,11 +509,16 @@ private:
             key_range_t subrange;
             subrange.left = cursor.key();
             std::list<backfill_item_t> items_from_pre;
+            pre_item_hashes_t pre_item_hashes;
             continue_bool_t cont = pre_item_producer->consume_range(
                 &cursor, right_bound,
                 [&](const backfill_pre_item_t &pre_item) {
                     items_from_pre.push_back(backfill_item_t());
                     items_from_pre.back().range = pre_item.range;
+                    if (static_cast<bool>(pre_item.content_hash)) {
+                        pre_item_hashes.insert(std::make_pair(
+                            pre_item.range.left, *pre_item.content_hash));
+                    }
                 });
             if (cont == continue_bool_t::ABORT) {
                 return continue_bool_t::ABORT;
@@ -339,7 +526,8 @@ private:
             subrange.right = cursor;
             rassert(!subrange.is_empty());
             handle_pre_leaf_subrange(
-                buf, subrange, std::move(items_from_pre), interruptor);
+                buf, subrange, std::move(items_from_pre), std::move(pre_item_hashes),
+                interruptor);
             if (abort_cond->is_pulsed()) {
                 return continue_bool_t::ABORT;
             }
@@ -347,6 +535,21 @@ private:
         return continue_bool_t::CONTINUE;
     }
 
+    /* `pre_item_hashes_t` maps the left edge of each pre-item to the pre-item's
+    `content_hash`, for pre-items that have one. */
+    typedef std::map<store_key_t, backfill_content_hash_t> pre_item_hashes_t;
+
+    /* `expected_hash()` returns the hash for an item whose range is exactly the range of
+    one of the pre-items in `pre_item_hashes`. */
+    static boost::optional<backfill_content_hash_t> expected_hash(
+            const pre_item_hashes_t &pre_item_hashes, const backfill_item_t &item) {
+        auto it = pre_item_hashes.find(item.range.left);
+        if (it == pre_item_hashes.end()) {
+            return boost::none;
+        }
+        return boost::make_optional(it->second);
+    }
+
     /* `handle_pre_leaf_subrange()` creates backfill items for the given subrange of the
     given leaf, for which the pre-items are already available. The pre-items are
     delivered in the form of a `std::list<backfill_item_t>` where each item's range is
@@ -356,6 +559,7 @@ private:
             const counted_t<counted_buf_lock_and_read_t> &buf,
             const key_range_t &subrange,
             std::list<backfill_item_t> &&items_from_pre,
+            pre_item_hashes_t &&pre_item_hashes,
             signal_t *interruptor) {
         const leaf_node_t *lnode = static_cast<const leaf_node_t *>(
             buf->read->get_data_read());
@@ -402,9 +606,16 @@ private:
                     return p1.key < p2.key;
                 });
 
+            /* If a single pre-item covers exactly the same range, then we can skip the
+            item if the destination already has the same contents. */
+            boost::optional<backfill_content_hash_t> hash;
+            if (items_from_pre.size() == 1 && items_from_pre.front().range == subrange) {
+                hash = expected_hash(pre_item_hashes, items_from_pre.front());
+            }
+
             /* Note that `on_item()` may block, which will limit the rate at which we
             traverse the B-tree. */
-            loader->on_item(std::move(item), buf, interruptor);
+            loader->on_item(std::move(item), buf, hash, interruptor);
 
         } else {
             /* Attach `min_deletion_timestamp` to `items_from_pre`, because it hasn't
@@ -412,6 +623,10 @@ private:
             some of them might fall partially outside of `subrange`. */
             for (backfill_item_t &i : items_from_pre) {
                 rassert(subrange.overlaps(i.range));
+                if (!subrange.is_superset(i.range)) {
+                    /* The hash covers parts of the pre-item outside of this leaf */
+                    pre_item_hashes.erase(i.range.left);
+                }
                 i.range = i.range.intersection(subrange);
                 i.min_deletion_timestamp = min_deletion_timestamp;
             }
@@ -515,7 +730,9 @@ private:
 
             /* Send the results to the loader */
             for (backfill_item_t &i : items_from_pre) {
-                loader->on_item(std::move(i), buf, interruptor);
+                boost::optional<backfill_content_hash_t> hash =
+                    expected_hash(pre_item_hashes, i);
+                loader->on_item(std::move(i), buf, hash, interruptor);
             }
             loader->on_empty_range(subrange.right, interruptor);
         }
@@ -533,19 +750,26 @@ private:
         key_range_t::right_bound_t end = convert_to_right_bound(right_incl);
         while (cursor != end) {
             std::vector<backfill_item_t> items;
+            pre_item_hashes_t pre_item_hashes;
             continue_bool_t cont = pre_item_producer->consume_range(
                 &cursor, end,
                 [&](const backfill_pre_item_t &pre_item) {
                     items.resize(items.size() + 1);
                     items.back().range = pre_item.range;
                     items.back().min_deletion_timestamp = repli_timestamp_t::distant_past;
+                    if (static_cast<bool>(pre_item.content_hash)) {
+                        pre_item_hashes.insert(std::make_pair(
+                            pre_item.range.left, *pre_item.content_hash));
+                    }
                 });
             if (cont == continue_bool_t::ABORT) {
                 return continue_bool_t::ABORT;
             }
             for (backfill_item_t &i : items) {
-                loader->on_item(
-                    std::move(i), counted_t<counted_buf_lock_and_read_t>(), interruptor);
+                boost::optional<backfill_content_hash_t> hash =
+                    expected_hash(pre_item_hashes, i);
+                loader->on_item(std::move(i), counted_t<counted_buf_lock_and_read_t>(),
+                    hash, interruptor);
             }
             loader->on_empty_range(cursor, interruptor);
         }
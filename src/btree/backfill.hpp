@@ -20,6 +20,18 @@ class buf_parent_t;
 class superblock_t;
 class value_sizer_t;
 
+/* `backfill_content_hash_t` is a fingerprint of the live key-value pairs in some range
+of a B-tree. Deletion entries and timestamps are ignored, so two ranges with the same
+hash are equivalent for the purposes of a backfill even if they got there by different
+histories. The hash is keyed by `seed0` and `seed1`, which are chosen at random by the
+B-tree that computed it, so users can't deliberately construct colliding documents. */
+class backfill_content_hash_t {
+public:
+    uint64_t seed0, seed1;
+    uint64_t digest;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_content_hash_t);
+
 /* `backfill_pre_item_t` describes a range of keys which have changed on the backfill
 destination since the source and destination diverged. The backfill destination sends
 pre items to the backfill source so that the source knows to re-transmit the values of
@@ -33,9 +45,21 @@ public:
         return sizeof(backfill_pre_item_t);
     }
     void mask_in_place(const key_range_t &m) {
-        range = range.intersection(m);
+        key_range_t new_range = range.intersection(m);
+        if (new_range != range) {
+            /* The hash describes the entire original range, so it's useless now */
+            content_hash = boost::none;
+        }
+        range = new_range;
     }
     key_range_t range;
+
+    /* If `content_hash` is set, it describes the contents of `range` on the backfill
+    destination. If the source's contents of `range` hash to the same value, then the
+    two sides already agree and the source only sends a `recency_only` item. This
+    keeps the backfill after a short divergence close to the size of the actual delta,
+    instead of the size of everything either side touched. */
+    boost::optional<backfill_content_hash_t> content_hash;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_pre_item_t);
 
@@ -45,6 +69,8 @@ other B-tree into a state equivalent to that of the B-tree that the `backfill_it
 came from. */
 class backfill_item_t {
 public:
+    backfill_item_t() : recency_only(false) { }
+
     class pair_t {
     public:
         store_key_t key;
@@ -91,6 +117,14 @@ public:
     std::vector<pair_t> pairs;
     repli_timestamp_t min_deletion_timestamp;
 
+    /* If `recency_only` is true, the backfill destination already has the same live
+    keys and values in `range` as the source, because the content hashes matched. The
+    pairs for live keys then have an empty value, which stands for the value that the
+    destination already has; the destination only updates their recency, so that later
+    backfills see the same timestamps as on the source. Deletion entries are sent and
+    applied as usual. */
+    bool recency_only;
+
     /* TODO: For single-key items, this is not very memory-efficient, because we store
     the key in three places: in `pairs[0].key`, in `range.left`, and in `range.right.key`
     minus one. Consider wrapping `range` in a `scoped_ptr_t`, which is left empty for a
@@ -110,7 +144,11 @@ If `on_pre_item()` or `on_empty_range()` returns `ABORT`, then no more calls wil
 generated and `btree_send_backfill_pre()` will return `ABORT`. Otherwise,
 `btree_send_backfill_pre()` will continue until it reaches the end of `range` and then
 return `CONTINUE`. The final call to `on_pre_item()` or `on_empty_range()` is guaranteed
-to end exactly on `range.right`. */
+to end exactly on `range.right`.
+
+If `content_hashes` is true, every pre-item carries a `content_hash`. This requires
+loading every value in the pre-items' ranges, so it's only worth it if the backfill source
+is likely to have the same contents for many of the pre-items. */
 
 class btree_backfill_pre_item_consumer_t {
 public:
@@ -119,6 +157,15 @@ public:
     virtual continue_bool_t on_pre_item(backfill_pre_item_t &&item) THROWS_NOTHING = 0;
     virtual continue_bool_t on_empty_range(const key_range_t::right_bound_t &threshold)
         THROWS_NOTHING = 0;
+
+    /* `copy_value()` has the same semantics as in `btree_backfill_item_consumer_t`.
+    `btree_send_backfill_pre()` uses it to compute each pre-item's `content_hash`, if
+    `content_hashes` is true. */
+    virtual void copy_value(
+        buf_parent_t buf_parent,
+        const void *value_in_leaf_node,
+        signal_t *interruptor,
+        std::vector<char> *value_out) = 0;
 protected:
     virtual ~btree_backfill_pre_item_consumer_t() { }
 };
@@ -129,6 +176,7 @@ continue_bool_t btree_send_backfill_pre(
     value_sizer_t *sizer,
     const key_range_t &range,
     repli_timestamp_t reference_timestamp,
+    bool content_hashes,
     btree_backfill_pre_item_consumer_t *pre_item_consumer,
     signal_t *interruptor);
 
@@ -54,6 +54,22 @@ public:
         return continue_bool_t::CONTINUE;
     }
 
+    continue_bool_t handle_pre_leaf(
+            const counted_t<counted_buf_lock_and_read_t> &buf,
+            const btree_key_t *left_excl_or_null,
+            const btree_key_t *right_incl,
+            signal_t *,
+            bool *skip_out) {
+        cb_->handle_pre_leaf(buf, left_excl_or_null, right_incl, skip_out);
+        if (*skip_out) {
+            // A skipped leaf doesn't reach `handle_pair()`, so it doesn't get the
+            // chance to yield there.
+            maybe_yield();
+        }
+        return failure_cond_->is_pulsed()
+            ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
+    }
+
     void handle_pair_coro(scoped_key_value_t *fragile_keyvalue,
                           semaphore_acq_t *fragile_acq,
                           fifo_enforcer_write_token_t token,
@@ -88,14 +104,7 @@ public:
         // values at once.
         semaphore_acq_t acq(&semaphore_);
 
-        // Yield occasionally so we don't hog the thread if everything is in
-        // memory and `cb->handle_pair()` doesn't block.
-        if (yield_counter == concurrent_traversal::yield_interval) {
-            coro_t::yield();
-            yield_counter = 0;
-        } else {
-            ++yield_counter;
-        }
+        maybe_yield();
 
         coro_t::spawn_now_dangerously(
             std::bind(&concurrent_traversal_adapter_t::handle_pair_coro,
@@ -113,6 +122,17 @@ public:
 private:
     friend class concurrent_traversal_fifo_enforcer_signal_t;
 
+    // Yield occasionally so we don't hog the thread if everything is in memory and
+    // the callback doesn't block.
+    void maybe_yield() {
+        if (yield_counter == concurrent_traversal::yield_interval) {
+            coro_t::yield();
+            yield_counter = 0;
+        } else {
+            ++yield_counter;
+        }
+    }
+
     adjustable_semaphore_t semaphore_;
 
     fifo_enforcer_source_t source_;
@@ -127,7 +147,8 @@ private:
     // the query.
     cond_t *failure_cond_;
 
-    // Counted up every time handle_pair() runs so we can yield occasionally.
+    // Counted up every time handle_pair() runs or a leaf is skipped, so we can yield
+    // occasionally.
     int yield_counter;
 
     // We don't use the drainer's drain signal, we use failure_cond_
@@ -40,6 +40,20 @@ public:
         *skip_out = false;
     }
 
+    /* Called on every leaf node before its pairs are passed to `handle_pair()`. If it
+    sets `*skip_out` to `true`, none of the leaf's pairs will be passed to
+    `handle_pair()`. Unlike `handle_pair()` this is called synchronously from the
+    traversal, so it mustn't block; it's meant for callbacks that can deal with a whole
+    leaf at once without loading any values. As with `filter_range()`, the traversal
+    can't be aborted from here. */
+    virtual void handle_pre_leaf(
+            UNUSED const counted_t<counted_buf_lock_and_read_t> &buf,
+            UNUSED const btree_key_t *left_excl_or_null,
+            UNUSED const btree_key_t *right_incl,
+            bool *skip_out) {
+        *skip_out = false;
+    }
+
     // Passes a keyvalue and a callback.  waiter.wait_interruptible() must be called to
     // begin the region of "exclusive access", which only handle_pair implementation
     // can enters at a time.  (This should happen after loading the value from disk
@@ -0,0 +1,123 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "btree/key_filter.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+// The finalizer of MurmurHash3, which spreads every input bit over the whole output.
+static uint64_t mix_hash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// We can't use `hash_region_hasher()`, because all the keys of a store have hashes in
+// the same small range.
+static uint64_t hash_key(const btree_key_t *key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < key->size; ++i) {
+        h ^= key->contents[i];
+        h *= 0x100000001b3ULL;
+    }
+    return mix_hash(h);
+}
+
+bloom_filter_t::bloom_filter_t(size_t capacity, size_t bits_per_key)
+    : num_bits_(std::max<size_t>(capacity * bits_per_key, 64)),
+      num_hashes_(std::min(std::max(static_cast<int>(round(bits_per_key * M_LN2)), 1),
+                           16)),
+      capacity_(capacity),
+      num_keys_(0) {
+    words_.resize((num_bits_ + 63) / 64, 0);
+    num_bits_ = words_.size() * 64;
+}
+
+/* Each key sets `num_hashes_` bits, which are picked by double hashing. */
+bool bloom_filter_t::insert(const btree_key_t *key) {
+    const uint64_t h1 = hash_key(key);
+    const uint64_t h2 = mix_hash(h1) | 1;
+    bool set_new_bit = false;
+    for (int i = 0; i < num_hashes_; ++i) {
+        const uint64_t bit = (h1 + i * h2) % num_bits_;
+        const uint64_t mask = uint64_t(1) << (bit % 64);
+        if ((words_[bit / 64] & mask) == 0) {
+            words_[bit / 64] |= mask;
+            set_new_bit = true;
+        }
+    }
+    if (set_new_bit) {
+        ++num_keys_;
+    }
+    return set_new_bit;
+}
+
+bool bloom_filter_t::may_contain(const btree_key_t *key) const {
+    const uint64_t h1 = hash_key(key);
+    const uint64_t h2 = mix_hash(h1) | 1;
+    for (int i = 0; i < num_hashes_; ++i) {
+        const uint64_t bit = (h1 + i * h2) % num_bits_;
+        if ((words_[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+btree_key_filter_t::btree_key_filter_t() { }
+
+btree_key_filter_t::~btree_key_filter_t() { }
+
+bool btree_key_filter_t::may_contain(const btree_key_t *key) const {
+    assert_thread();
+    return !filter_.has() || filter_->may_contain(key);
+}
+
+void btree_key_filter_t::insert(const btree_key_t *key) {
+    assert_thread();
+    if (filter_.has()) {
+        filter_->insert(key);
+    }
+    if (rebuilding_.has()) {
+        rebuilding_->insert(key);
+    }
+}
+
+bool btree_key_filter_t::needs_rebuild() const {
+    assert_thread();
+    return !rebuilding_.has()
+        && (!filter_.has() || filter_->num_keys() > filter_->capacity());
+}
+
+void btree_key_filter_t::start_rebuild(size_t bits_per_key) {
+    assert_thread();
+    guarantee(!rebuilding_.has());
+    guarantee(bits_per_key > 0);
+    // Leave room for the tree to double before the next rebuild. On the first
+    // rebuild we don't know the size of the tree yet, so the new filter may well end
+    // up full, and the rebuild after it will have the right size.
+    const size_t num_keys = filter_.has() ? filter_->num_keys() : 0;
+    rebuilding_.init(
+        new bloom_filter_t(std::max(2 * num_keys, MIN_CAPACITY), bits_per_key));
+}
+
+void btree_key_filter_t::insert_rebuilt(const btree_key_t *key) {
+    assert_thread();
+    guarantee(rebuilding_.has());
+    rebuilding_->insert(key);
+}
+
+void btree_key_filter_t::finish_rebuild() {
+    assert_thread();
+    guarantee(rebuilding_.has());
+    filter_ = std::move(rebuilding_);
+}
+
+void btree_key_filter_t::abort_rebuild() {
+    assert_thread();
+    guarantee(rebuilding_.has());
+    rebuilding_.reset();
+}
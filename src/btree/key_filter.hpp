@@ -0,0 +1,87 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BTREE_KEY_FILTER_HPP_
+#define BTREE_KEY_FILTER_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "containers/scoped.hpp"
+#include "threading.hpp"
+
+/* `bloom_filter_t` is a Bloom filter over B-tree keys. It answers "maybe" for every key
+that was inserted, and "no" for most keys that weren't. */
+class bloom_filter_t {
+public:
+    /* Sized so that up to `capacity` keys can be inserted with a low rate of false
+    positives. More keys can be inserted, but the rate goes up quickly. */
+    bloom_filter_t(size_t capacity, size_t bits_per_key);
+
+    /* Returns `true` if the key set any bits that weren't set before, i.e. if the
+    filter didn't already answer "maybe" for it. */
+    bool insert(const btree_key_t *key);
+    bool may_contain(const btree_key_t *key) const;
+
+    /* The number of insertions that set new bits. Inserting a key again doesn't count,
+    so this is close to the number of distinct keys. */
+    size_t num_keys() const { return num_keys_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t num_bits_;
+    int num_hashes_;
+    size_t capacity_;
+    size_t num_keys_;
+
+    DISABLE_COPYING(bloom_filter_t);
+};
+
+/* `btree_key_filter_t` holds the Bloom filter for one B-tree, so that lookups of keys
+that aren't in the tree can be answered without acquiring any blocks. It only lives in
+memory, so it starts out empty and is filled by a scan over the tree's keys; until the
+first scan is done, `may_contain()` answers "maybe" for everything.
+
+Every key written to the tree must be passed to `insert()` before the write releases
+the superblock, and lookups must hold the superblock before they call `may_contain()`.
+That way a lookup never misses a write that comes before it.
+
+Keys are never removed, so after enough writes the filter is too full to be useful and
+`needs_rebuild()` returns `true`. The old filter stays in use while the new one is being
+built. Keys inserted during a rebuild go into both filters, so the new filter is
+complete as long as the scan visits every key that's in the tree for the whole time it
+runs. */
+class btree_key_filter_t : public home_thread_mixin_debug_only_t {
+public:
+    btree_key_filter_t();
+    ~btree_key_filter_t();
+
+    /* Returns `false` only if `key` is certainly not in the tree. */
+    bool may_contain(const btree_key_t *key) const;
+
+    void insert(const btree_key_t *key);
+
+    /* Returns `true` if there is no filter yet or it's full, and no rebuild is running
+    already. */
+    bool needs_rebuild() const;
+
+    /* The scan over the tree may only start after `start_rebuild()` returns. It passes
+    each key it finds to `insert_rebuilt()`. */
+    void start_rebuild(size_t bits_per_key);
+    void insert_rebuilt(const btree_key_t *key);
+    void finish_rebuild();
+    void abort_rebuild();
+
+private:
+    /* We make filters for at least this many keys, so that a small tree isn't
+    rebuilt over and over while it grows. */
+    static const size_t MIN_CAPACITY = 4096;
+
+    scoped_ptr_t<bloom_filter_t> filter_;
+    scoped_ptr_t<bloom_filter_t> rebuilding_;
+
+    DISABLE_COPYING(btree_key_filter_t);
+};
+
+#endif  // BTREE_KEY_FILTER_HPP_
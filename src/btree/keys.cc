@@ -20,6 +20,30 @@ int sized_strcmp(const uint8_t *str1, int len1, const uint8_t *str2, int len2) {
     return res;
 }
 
+void shorten_separator(btree_key_t *left_inout, const btree_key_t *right) {
+    rassert(btree_key_cmp(left_inout, right) < 0);
+    int common = 0;
+    while (common < left_inout->size && common < right->size
+           && left_inout->contents[common] == right->contents[common]) {
+        ++common;
+    }
+    // Look for the first position from which we can take the next byte value and
+    // drop the rest of `left`. At `common` that's only possible if the result stays
+    // below `right`; after `common` it always is.
+    for (int i = common; i < left_inout->size - 1; ++i) {
+        const uint8_t c = left_inout->contents[i];
+        if (c == 0xFF) {
+            continue;
+        }
+        if (i == common && c + 1 == right->contents[i] && right->size == i + 1) {
+            continue;
+        }
+        left_inout->contents[i] = c + 1;
+        left_inout->size = i + 1;
+        return;
+    }
+}
+
 bool unescaped_str_to_key(const char *str, int len, store_key_t *buf) {
     if (len <= MAX_KEY_SIZE) {
         memcpy(buf->contents(), str, len);
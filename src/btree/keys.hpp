@@ -204,6 +204,11 @@ std::string key_to_debug_str(const store_key_t &key);
 
 std::string key_to_debug_str(const btree_key_t *key);
 
+/* Shortens `*left_inout` to the shortest key `k` with `left <= k < right`, if that's
+shorter than `left`. `left` must sort before `right`. Internal nodes use this to keep
+the keys that separate their children short. */
+void shorten_separator(btree_key_t *left_inout, const btree_key_t *right);
+
 /* `key_range_t` represents a contiguous set of keys. */
 class key_range_t {
 public:
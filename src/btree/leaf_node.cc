@@ -1017,6 +1017,28 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
     keycpy(median_out, entry_key(get_entry(node, node->pair_offsets[s - 1])));
 }
 
+bool is_append(const leaf_node_t *node, const btree_key_t *key) {
+    return node->num_pairs > 0
+        && btree_key_cmp(
+            key,
+            entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1]))) > 0;
+}
+
+void split_for_append(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode,
+                      btree_key_t *median_out) {
+    rassert(node->num_pairs > 0);
+    init(sizer, rnode);
+    keycpy(median_out,
+           entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])));
+}
+
+const btree_key_t *min_entry_key(const leaf_node_t *node) {
+    if (node->num_pairs == 0) {
+        return NULL;
+    }
+    return entry_key(get_entry(node, node->pair_offsets[0]));
+}
+
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
     rassert(left != right);
 
@@ -130,6 +130,22 @@ bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node);
 void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
            btree_key_t *median_out);
 
+/* Returns `true` if `key` sorts after every entry in `node`, including deletion
+entries. When a node fills up with keys that are only ever appended to it (say, keys
+that end in a timestamp), it's split with `split_for_append()` rather than `split()`,
+so that it stays full instead of being left half empty forever. */
+bool is_append(const leaf_node_t *node, const btree_key_t *key);
+
+/* Leaves all entries in `node` and makes `sibling` an empty node for the appended key.
+`sibling` is underfull until enough keys are appended to it; we don't level it with
+`node` on insertion, since that would undo the split. */
+void split_for_append(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
+                      btree_key_t *median_out);
+
+/* Returns the smallest key of any entry in `node`, including deletion entries, or
+`NULL` if `node` is empty. */
+const btree_key_t *min_entry_key(const leaf_node_t *node);
+
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right);
 
 // The pointers in `moved_values_out` point to positions in `node` and
@@ -109,10 +109,32 @@ void check_and_handle_split(value_sizer_t *sizer,
     {
         buf_write_t buf_write(buf);
         buf_write_t rbuf_write(&rbuf);
-        node::split(sizer,
-                    static_cast<node_t *>(buf_write.get_data_write()),
-                    static_cast<node_t *>(rbuf_write.get_data_write()),
-                    median);
+        node_t *lnode = static_cast<node_t *>(buf_write.get_data_write());
+        node_t *rnode = static_cast<node_t *>(rbuf_write.get_data_write());
+        if (node::is_leaf(lnode)) {
+            leaf_node_t *leaf_node = reinterpret_cast<leaf_node_t *>(lnode);
+            leaf_node_t *leaf_rnode = reinterpret_cast<leaf_node_t *>(rnode);
+            if (leaf::is_append(leaf_node, key)) {
+                leaf::split_for_append(sizer, leaf_node, leaf_rnode, median);
+            } else {
+                leaf::split(sizer, leaf_node, leaf_rnode, median);
+            }
+
+            // The parent only needs a key that sorts between the two nodes, which
+            // is usually much shorter than the last key of the left node. The
+            // key we're inserting will go on the right if it's larger than
+            // `median`, so the shortened key must stay below it as well.
+            const btree_key_t *right_min = leaf::min_entry_key(leaf_rnode);
+            if (btree_key_cmp(key, median) > 0
+                && (right_min == NULL || btree_key_cmp(key, right_min) < 0)) {
+                right_min = key;
+            }
+            if (right_min != NULL) {
+                shorten_separator(median, right_min);
+            }
+        } else {
+            node::split(sizer, lnode, rnode, median);
+        }
 
         // We must detach all entries that we have removed from `buf`.
         buf_read_t rbuf_read(&rbuf);
@@ -642,9 +664,13 @@ void apply_keyvalue_change(
     }
 
     // Check to see if the leaf is underfull (following a change in
-    // size or a deletion, and merge/level if it is.
-    check_and_handle_underfull(sizer, &kv_loc->buf, &kv_loc->last_buf,
-                               kv_loc->superblock, key, balancing_detacher);
+    // size or a deletion, and merge/level if it is. Inserting a new key only makes
+    // the leaf larger. It can still be underfull if it was split off for appends
+    // (see `leaf::split_for_append()`), but leveling it now would undo that.
+    if (population_change != 1) {
+        check_and_handle_underfull(sizer, &kv_loc->buf, &kv_loc->last_buf,
+                                   kv_loc->superblock, key, balancing_detacher);
+    }
 
     // Modify the stats block.  The stats block is detached from the rest of the
     // btree, we don't keep a consistent view of it, so we pass the txn as its
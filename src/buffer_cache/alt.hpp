@@ -54,6 +54,14 @@ public:
     // might consider supporting a mem_cap paremeter.
     cache_account_t create_cache_account(int priority);
 
+    // See page_cache_t::hot_block_ids() and page_cache_t::start_warm_up().
+    std::vector<block_id_t> hot_block_ids(size_t max_count) {
+        return page_cache_.hot_block_ids(max_count);
+    }
+    void start_warm_up(std::vector<block_id_t> block_ids) {
+        page_cache_.start_warm_up(std::move(block_ids));
+    }
+
 private:
     friend class txn_t;
     friend class buf_read_t;
@@ -55,6 +55,7 @@ void evicter_t::update_memory_limit(uint64_t new_memory_limit,
 
     if (!read_ahead_ok) {
         page_cache_->have_read_ahead_cb_destroyed();
+        page_cache_->stop_warm_up();
     }
 
     bytes_loaded_counter_ -= bytes_loaded_accounted_for;
@@ -52,6 +52,9 @@ public:
         return ++access_time_counter_;
     }
 
+    // The access time of the most recently accessed page.
+    uint64_t current_access_time() const { return access_time_counter_; }
+
     uint64_t memory_limit() const;
     uint64_t access_count() const;
     int64_t get_bytes_loaded() const;
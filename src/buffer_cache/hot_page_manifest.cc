@@ -0,0 +1,97 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "buffer_cache/hot_page_manifest.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "arch/io/io_utils.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "utils.hpp"
+
+// Changing the format only requires changing the magic: a manifest we can't read is
+// ignored.
+static const char hot_page_manifest_magic[] = "rethinkdb hot pages v1\n";
+
+std::string hot_page_manifest_path(const std::string &table_file_path) {
+    return table_file_path + ".hot";
+}
+
+bool read_hot_page_manifest(const std::string &path, hot_page_manifest_t *out) {
+    std::string contents;
+    if (!blocking_read_file(path.c_str(), &contents)) {
+        return false;
+    }
+    const size_t magic_size = strlen(hot_page_manifest_magic);
+    if (contents.compare(0, magic_size, hot_page_manifest_magic) != 0) {
+        return false;
+    }
+
+    const int64_t size = contents.size();
+    string_read_stream_t stream(std::move(contents), magic_size);
+    hot_page_manifest_t manifest;
+    archive_result_t res
+        = deserialize<cluster_version_t::LATEST_DISK>(&stream, &manifest);
+    if (bad(res)) {
+        return false;
+    }
+    // Anything after the manifest means that the file isn't what we wrote.
+    std::string rest;
+    int64_t offset;
+    stream.swap(&rest, &offset);
+    if (offset != size) {
+        return false;
+    }
+
+    *out = std::move(manifest);
+    return true;
+}
+
+bool write_hot_page_manifest(const std::string &path,
+                             const hot_page_manifest_t &manifest) {
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, manifest);
+    vector_stream_t stream;
+    stream.reserve(wm.size());
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+
+    // We write a temporary file and rename it, so that a crash can't leave a
+    // half-written manifest behind.
+    const std::string temp_path = path + ".tmp";
+    scoped_fd_t fd;
+    do {
+        res = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    } while (res == -1 && get_errno() == EINTR);
+    if (res == -1) {
+        return false;
+    }
+    fd.reset(res);
+
+    std::string contents(hot_page_manifest_magic);
+    contents.append(stream.vector().begin(), stream.vector().end());
+    size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t n = write(fd.get(), contents.data() + written, contents.size() - written);
+        if (n == -1 && get_errno() == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            fd.reset();
+            unlink(temp_path.c_str());
+            return false;
+        }
+        written += n;
+    }
+    fd.reset();
+
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
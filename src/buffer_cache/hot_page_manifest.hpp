@@ -0,0 +1,26 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_HOT_PAGE_MANIFEST_HPP_
+#define BUFFER_CACHE_HOT_PAGE_MANIFEST_HPP_
+
+#include <string>
+#include <vector>
+
+#include "serializer/types.hpp"
+
+/* The hot page manifest of a table lists, for each of the table's caches, the ids of
+the blocks that were loaded in it, most recently used first.  It's saved next to the
+table's file from time to time and when the table is unloaded, and it's used to warm
+up the caches when the table is loaded again (see `page_cache_t::start_warm_up()`).
+
+The manifest is only a hint.  If it's missing, out of date or damaged, the caches just
+start out cold. */
+typedef std::vector<std::vector<block_id_t> > hot_page_manifest_t;
+
+std::string hot_page_manifest_path(const std::string &table_file_path);
+
+// These make blocking syscalls.  They return false on failure.
+bool read_hot_page_manifest(const std::string &path, hot_page_manifest_t *out);
+bool write_hot_page_manifest(const std::string &path,
+                             const hot_page_manifest_t &manifest);
+
+#endif  // BUFFER_CACHE_HOT_PAGE_MANIFEST_HPP_
@@ -10,6 +10,7 @@
 #include "arch/runtime/runtime_utils.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "do_on_thread.hpp"
 #include "serializer/serializer.hpp"
@@ -93,10 +94,10 @@ void page_read_ahead_cb_t::destroy_self() {
 
 void page_cache_t::consider_evicting_current_page(block_id_t block_id) {
     ASSERT_NO_CORO_WAITING;
-    // We can't do anything until read-ahead is done, because it uses the existence
-    // of a current_page_t entry to figure out whether the read-ahead page could be
-    // out of date.
-    if (read_ahead_cb_ != NULL) {
+    // We can't do anything until read-ahead and warm-up are done, because they use
+    // the existence of a current_page_t entry to figure out whether the page they
+    // read could be out of date.
+    if (current_page_eviction_suspended()) {
         return;
     }
 
@@ -183,6 +184,148 @@ void page_cache_t::read_ahead_cb_is_destroyed() {
     read_ahead_cb_existence_.reset();
 }
 
+std::vector<block_id_t> page_cache_t::hot_block_ids(size_t max_count) {
+    assert_thread();
+    // Access times wrap around, so we sort by how long ago the page was accessed.
+    std::vector<std::pair<uint64_t, block_id_t> > pages;
+    for (block_id_t id = 0; id < current_pages_.size(); ++id) {
+        if (id % 1024 == 1023) {
+            coro_t::yield();
+            if (id >= current_pages_.size()) {
+                break;
+            }
+        }
+        current_page_t *current_page = current_pages_.get_sparsely(id);
+        if (current_page == NULL || !current_page->page_.has()) {
+            continue;
+        }
+        page_t *page = current_page->page_.get_page_for_read();
+        if (page->is_loaded()) {
+            pages.push_back(std::make_pair(
+                evicter_.current_access_time() - page->access_time(), id));
+        }
+    }
+
+    const size_t count = std::min(max_count, pages.size());
+    std::partial_sort(pages.begin(), pages.begin() + count, pages.end());
+    std::vector<block_id_t> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ret.push_back(pages[i].second);
+    }
+    return ret;
+}
+
+void page_cache_t::start_warm_up(std::vector<block_id_t> block_ids) {
+    assert_thread();
+    guarantee(!warm_up_active_);
+    if (block_ids.empty()) {
+        return;
+    }
+    warm_up_active_ = true;
+    coro_t::spawn_sometime(std::bind(&page_cache_t::do_warm_up,
+                                     this,
+                                     std::move(block_ids),
+                                     drainer_->lock()));
+}
+
+void page_cache_t::stop_warm_up() {
+    assert_thread();
+    if (warm_up_active_) {
+        warm_up_stopping_ = true;
+    }
+}
+
+void page_cache_t::do_warm_up(page_cache_t *page_cache,
+                              const std::vector<block_id_t> &block_ids,
+                              auto_drainer_t::lock_t lock) {
+    struct loaded_block_t {
+        block_id_t block_id;
+        counted_t<standard_block_token_t> token;
+        buf_ptr_t buf;
+    };
+
+    serializer_t *const serializer = page_cache->serializer_;
+    scoped_ptr_t<file_account_t> io_account;
+    {
+        on_thread_t thread_switcher(serializer->home_thread());
+        io_account.init(serializer->make_io_account(CACHE_WARM_UP_IO_PRIORITY));
+    }
+
+    for (size_t i = 0; i < block_ids.size(); i += CACHE_WARM_UP_BATCH_BLOCKS) {
+        if (lock.get_drain_signal()->is_pulsed() || page_cache->warm_up_stopping_) {
+            break;
+        }
+
+        std::vector<block_id_t> batch;
+        const size_t end = std::min<size_t>(block_ids.size(),
+                                            i + CACHE_WARM_UP_BATCH_BLOCKS);
+        for (size_t j = i; j < end; ++j) {
+            const block_id_t id = block_ids[j];
+            if (id >= page_cache->current_pages_.size()
+                || page_cache->current_pages_.get_sparsely(id) == NULL) {
+                batch.push_back(id);
+            }
+        }
+
+        std::vector<loaded_block_t> loaded;
+        {
+            on_thread_t thread_switcher(serializer->home_thread());
+            for (block_id_t id : batch) {
+                counted_t<standard_block_token_t> token = serializer->index_read(id);
+                if (token.has()) {
+                    loaded.push_back(loaded_block_t{id, std::move(token), buf_ptr_t()});
+                }
+            }
+            // Reading the blocks in the order they're stored in lets the disk (or
+            // the OS) merge adjacent reads, which it can't do for the random order
+            // in which queries would fault them in.
+            std::sort(loaded.begin(), loaded.end(),
+                      [](const loaded_block_t &a, const loaded_block_t &b) {
+                          return a.token->offset() < b.token->offset();
+                      });
+            pmap(loaded.size(), [&](size_t k) {
+                loaded[k].buf = serializer->block_read(loaded[k].token,
+                                                       io_account.get());
+            });
+        }
+
+        for (auto &&block : loaded) {
+            page_cache->add_warm_up_buf(block.block_id,
+                                        std::move(block.buf),
+                                        block.token);
+        }
+    }
+
+    {
+        on_thread_t thread_switcher(serializer->home_thread());
+        io_account.reset();
+    }
+
+    page_cache->warm_up_active_ = false;
+    page_cache->warm_up_stopping_ = false;
+    if (!page_cache->current_page_eviction_suspended()) {
+        consider_evicting_all_current_pages(page_cache, std::move(lock));
+    }
+}
+
+void page_cache_t::add_warm_up_buf(block_id_t block_id,
+                                   buf_ptr_t buf,
+                                   const counted_t<standard_block_token_t> &token) {
+    assert_thread();
+    rassert(warm_up_active_);
+
+    resize_current_pages_to_id(block_id);
+    // As with read-ahead, the block can't have been modified since we read it unless
+    // a current_page_t was created for it, because no current_page_t is destroyed
+    // while the warm-up is running.
+    if (current_pages_[block_id] != NULL) {
+        return;
+    }
+
+    current_pages_[block_id] = new current_page_t(block_id, std::move(buf), token, this);
+}
+
 class page_cache_index_write_sink_t {
 public:
     // When sink is acquired, we get in line for mutex_ right away and release the
@@ -199,6 +342,8 @@ page_cache_t::page_cache_t(serializer_t *serializer,
       free_list_(serializer),
       evicter_(),
       read_ahead_cb_(NULL),
+      warm_up_active_(false),
+      warm_up_stopping_(false),
       drainer_(make_scoped<auto_drainer_t>()) {
 
     const bool start_read_ahead = balancer->read_ahead_ok_at_start();
@@ -351,6 +351,19 @@ public:
 
     void have_read_ahead_cb_destroyed();
 
+    // Returns the ids of the blocks that are loaded in the cache, most recently
+    // accessed first, but no more than `max_count` of them.  This yields, so blocks
+    // that are evicted in the meantime may be left out.
+    std::vector<block_id_t> hot_block_ids(size_t max_count);
+
+    // Loads the given blocks into the cache in the background, until they're all
+    // loaded or the cache balancer stops read-ahead because the caches are full.  The
+    // ids should be ordered by how much we want them, for example a list returned by
+    // hot_block_ids() before a restart.  Ids of blocks that don't exist anymore are
+    // skipped.
+    void start_warm_up(std::vector<block_id_t> block_ids);
+    void stop_warm_up();
+
     evicter_t &evicter() { return evicter_; }
 
     auto_drainer_t::lock_t drainer_lock() { return drainer_->lock(); }
@@ -364,6 +377,20 @@ private:
 
     void read_ahead_cb_is_destroyed();
 
+    static void do_warm_up(page_cache_t *page_cache,
+                           const std::vector<block_id_t> &block_ids,
+                           auto_drainer_t::lock_t lock);
+    void add_warm_up_buf(block_id_t block_id,
+                         buf_ptr_t buf,
+                         const counted_t<standard_block_token_t> &token);
+
+    // Read-ahead and warm-up use the absence of a current_page_t to tell that a
+    // block hasn't been modified since they read it, so we must not destroy any
+    // current_page_t while one of them is running.
+    bool current_page_eviction_suspended() const {
+        return read_ahead_cb_ != NULL || warm_up_active_;
+    }
+
 
     current_page_t *internal_page_for_new_chosen(block_id_t block_id);
 
@@ -455,6 +482,11 @@ private:
     // destroyed and all possible read-ahead operations have completed.
     auto_drainer_t::lock_t read_ahead_cb_existence_;
 
+    // True while a warm-up started by start_warm_up() is running, and true once it
+    // has been asked to stop after its current batch.
+    bool warm_up_active_;
+    bool warm_up_stopping_;
+
     scoped_ptr_t<auto_drainer_t> drainer_;
 
     DISABLE_COPYING(page_cache_t);
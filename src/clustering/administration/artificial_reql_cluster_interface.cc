@@ -356,6 +356,19 @@ bool artificial_reql_cluster_interface_t::sindex_list(
         db, table, interruptor, error_out, configs_and_statuses_out);
 }
 
+bool artificial_reql_cluster_interface_t::sindex_list_ready(
+        counted_t<const ql::db_t> db,
+        const name_string_t &table,
+        signal_t *interruptor,
+        std::string *error_out,
+        std::map<std::string, sindex_config_t> *configs_out) {
+    if (db->name == database) {
+        configs_out->clear();
+        return true;
+    }
+    return next->sindex_list_ready(db, table, interruptor, error_out, configs_out);
+}
+
 admin_artificial_tables_t::admin_artificial_tables_t(
         real_reql_cluster_interface_t *_next_reql_cluster_interface,
         boost::shared_ptr< semilattice_readwrite_view_t<
@@ -462,6 +475,13 @@ admin_artificial_tables_t::admin_artificial_tables_t(
     backends[name_string_t::guarantee_valid("_debug_scratch")] =
         std::make_pair(debug_scratch_backend.get(), debug_scratch_backend.get());
 
+    debug_profile_backend.init(new debug_profile_artificial_table_backend_t(
+        _directory_map_view,
+        _server_config_client,
+        _mailbox_manager));
+    backends[name_string_t::guarantee_valid("_debug_profile")] =
+        std::make_pair(debug_profile_backend.get(), debug_profile_backend.get());
+
     debug_stats_backend.init(new debug_stats_artificial_table_backend_t(
         _directory_map_view,
         _server_config_client,
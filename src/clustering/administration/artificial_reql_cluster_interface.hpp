@@ -10,6 +10,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/servers/server_config.hpp"
 #include "clustering/administration/servers/server_status.hpp"
+#include "clustering/administration/stats/debug_profile_backend.hpp"
 #include "clustering/administration/stats/debug_stats_backend.hpp"
 #include "clustering/administration/stats/stats_backend.hpp"
 #include "clustering/administration/tables/db_config.hpp"
@@ -180,6 +181,12 @@ public:
             std::string *error_out,
             std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
                 *configs_and_statuses_out);
+    bool sindex_list_ready(
+            counted_t<const ql::db_t> db,
+            const name_string_t &table,
+            signal_t *interruptor,
+            std::string *error_out,
+            std::map<std::string, sindex_config_t> *configs_out);
 
 private:
     name_string_t database;
@@ -228,6 +235,7 @@ public:
     scoped_ptr_t<table_status_artificial_table_backend_t> table_status_backend[2];
 
     scoped_ptr_t<in_memory_artificial_table_backend_t> debug_scratch_backend;
+    scoped_ptr_t<debug_profile_artificial_table_backend_t> debug_profile_backend;
     scoped_ptr_t<debug_stats_artificial_table_backend_t> debug_stats_backend;
     scoped_ptr_t<debug_table_status_artificial_table_backend_t>
         debug_table_status_backend;
@@ -94,12 +94,19 @@ void jobs_manager_t::on_get_job_reports(
                     auto render = pprint::render_as_javascript(
                         pair.second->original_query->query());
 
+                    const ql::query_resources_t &resources =
+                        *pair.second->resources;
                     query_job_reports_inner.emplace_back(
                         pair.second->job_id,
                         time - std::min(pair.second->start_time, time),
                         server_id,
                         query_cache->get_client_addr_port(),
-                        pretty_print(printed_query_columns, render));
+                        pretty_print(printed_query_columns, render),
+                        query_priority_to_string(pair.second->priority),
+                        ticks_to_secs(resources.cpu_ticks),
+                        resources.rows_scanned,
+                        resources.bytes_read,
+                        resources.bytes_held);
                 }
             }
         }
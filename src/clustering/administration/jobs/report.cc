@@ -219,17 +219,31 @@ RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
     progress_denominator);
 
 query_job_report_t::query_job_report_t()
-    : job_report_base_t<query_job_report_t>() { }
+    : job_report_base_t<query_job_report_t>(),
+      cpu_duration(0),
+      rows_scanned(0),
+      bytes_read(0),
+      bytes_held(0) { }
 
 query_job_report_t::query_job_report_t(
         uuid_u const &_id,
         double _duration,
         server_id_t const &_server_id,
         ip_and_port_t const &_client_addr_port,
-        std::string const &_query)
+        std::string const &_query,
+        std::string const &_priority,
+        double _cpu_duration,
+        uint64_t _rows_scanned,
+        uint64_t _bytes_read,
+        uint64_t _bytes_held)
     : job_report_base_t<query_job_report_t>("query", _id, _duration, _server_id),
       client_addr_port(_client_addr_port),
-      query(_query) { }
+      query(_query),
+      priority(_priority),
+      cpu_duration(_cpu_duration),
+      rows_scanned(_rows_scanned),
+      bytes_read(_bytes_read),
+      bytes_held(_bytes_held) { }
 
 void query_job_report_t::merge_derived(query_job_report_t const &) { }
 
@@ -244,9 +258,18 @@ bool query_job_report_t::info_derived(
     info_builder_out->overwrite("client_port",
         convert_port_to_datum(client_addr_port.port().value()));
     info_builder_out->overwrite("query", convert_string_to_datum(query));
+    info_builder_out->overwrite("priority", convert_string_to_datum(priority));
+    info_builder_out->overwrite("cpu_sec", ql::datum_t(cpu_duration));
+    info_builder_out->overwrite("rows_scanned",
+        ql::datum_t(static_cast<double>(rows_scanned)));
+    info_builder_out->overwrite("bytes_read",
+        ql::datum_t(static_cast<double>(bytes_read)));
+    info_builder_out->overwrite("bytes_held",
+        ql::datum_t(static_cast<double>(bytes_held)));
 
     return true;
 }
 
-RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(
-    query_job_report_t, type, id, duration, servers, client_addr_port, query);
+RDB_IMPL_SERIALIZABLE_11_FOR_CLUSTER(
+    query_job_report_t, type, id, duration, servers, client_addr_port, query,
+    priority, cpu_duration, rows_scanned, bytes_read, bytes_held);
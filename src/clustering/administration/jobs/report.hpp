@@ -138,7 +138,12 @@ public:
             double duration,
             server_id_t const &server_id,
             ip_and_port_t const &client_addr_port,
-            std::string const &query);
+            std::string const &query,
+            std::string const &priority,
+            double cpu_duration,
+            uint64_t rows_scanned,
+            uint64_t bytes_read,
+            uint64_t bytes_held);
 
     void merge_derived(query_job_report_t const &job_report);
 
@@ -151,6 +156,11 @@ public:
 
     ip_and_port_t client_addr_port;
     std::string query;
+    std::string priority;
+    double cpu_duration;
+    uint64_t rows_scanned;
+    uint64_t bytes_read;
+    uint64_t bytes_held;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(query_job_report_t);
 
@@ -26,6 +26,7 @@
 
 #include "arch/io/disk.hpp"
 #include "arch/os_signal.hpp"
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/starter.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "clustering/administration/main/cache_size.hpp"
@@ -1097,6 +1098,22 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              options::OPTIONAL_REPEAT));
     help.add("--canonical-address addr", "address that other rethinkdb instances will use to connect to us, can be specified multiple times");
 
+    options_out->push_back(options::option_t(options::names_t("--no-cluster-compression"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--no-cluster-compression", "don't compress large messages, such as backfill data, that this server sends to other servers");
+
+    options_out->push_back(options::option_t(options::names_t("--backfill-content-hashes"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--backfill-content-hashes", "when this server catches up on a table, send hashes of the documents it changed so that documents that are already up to date aren't sent again (requires reading those documents)");
+
+    options_out->push_back(options::option_t(options::names_t("--punch-holes"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--punch-holes", "give the space of table file extents that are likely to stay unused back to the filesystem");
+
+    options_out->push_back(options::option_t(options::names_t("--no-file-compaction"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--no-file-compaction", "don't move data out of the end of mostly empty table files so that they can be shrunk");
+
     return help;
 }
 
@@ -1106,6 +1123,10 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--coro-sample-rate"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--coro-sample-rate hz", "sample running coroutines this many times per second of CPU time on each core and report the profile in `rethinkdb._debug_profile` (0 to disable)");
     return help;
 }
 
@@ -1120,6 +1141,102 @@ MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t>
     return true;
 }
 
+MUST_USE bool parse_coro_sample_rate_option(
+        const std::map<std::string, options::values_t> &opts) {
+    int rate = get_single_int(opts, "--coro-sample-rate");
+    if (rate < 0 || rate > 10000) {
+        fprintf(stderr, "ERROR: the coroutine sample rate must be between 0 and 10000\n");
+        return false;
+    }
+    coro_sampler_t::set_sample_rate(rate);
+    return true;
+}
+
+options::help_section_t get_rebalance_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Rebalancing options");
+    options_out->push_back(options::option_t(options::names_t("--auto-rebalance"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--auto-rebalance", "move the split points of tables whose load is concentrated on one shard");
+    options_out->push_back(options::option_t(options::names_t("--auto-rebalance-threshold"),
+                                             options::OPTIONAL,
+                                             "1.5"));
+    help.add("--auto-rebalance-threshold ratio", "only rebalance a table when its busiest shard gets this many times its fair share of the load");
+    options_out->push_back(options::option_t(options::names_t("--auto-rebalance-interval"),
+                                             options::OPTIONAL,
+                                             "600"));
+    help.add("--auto-rebalance-interval seconds", "the minimum time between two automatic rebalances of the same table");
+    return help;
+}
+
+auto_rebalance_config_t parse_auto_rebalance_options(
+        const std::map<std::string, options::values_t> &opts) {
+    auto_rebalance_config_t config;
+    config.enabled = exists_option(opts, "--auto-rebalance");
+
+    const std::string threshold_opt = get_single_option(opts, "--auto-rebalance-threshold");
+    char *end;
+    config.imbalance_threshold = strtod(threshold_opt.c_str(), &end);
+    if (threshold_opt.empty() || *end != '\0' || !(config.imbalance_threshold > 1.0)) {
+        throw std::runtime_error(strprintf(
+            "ERROR: auto-rebalance-threshold should be a number greater than 1, got '%s'",
+            threshold_opt.c_str()));
+    }
+
+    config.min_interval_secs = get_single_int(opts, "--auto-rebalance-interval");
+    if (config.min_interval_secs < 0) {
+        throw std::runtime_error(
+            "ERROR: auto-rebalance-interval should not be negative");
+    }
+    return config;
+}
+
+options::help_section_t get_query_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Query options");
+    options_out->push_back(options::option_t(options::names_t("--max-running-queries"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--max-running-queries n", "the maximum number of queries this server runs at the same time; further queries wait until one finishes (0 for no limit)");
+    options_out->push_back(options::option_t(options::names_t("--max-queued-queries"),
+                                             options::OPTIONAL,
+                                             "1024"));
+    help.add("--max-queued-queries n", "reject new queries while this many queries are waiting to run");
+    options_out->push_back(options::option_t(options::names_t("--hedge-outdated-reads"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--hedge-outdated-reads", "send outdated reads that take longer than usual to a second replica as well, and use the first answer");
+    options_out->push_back(options::option_t(options::names_t("--lookup-filter-bits"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--lookup-filter-bits n", "keep an in-memory filter with n bits per key for each index, so that lookups of keys that don't exist don't have to read from the index (0 to disable)");
+    return help;
+}
+
+query_admission_config_t parse_query_admission_options(
+        const std::map<std::string, options::values_t> &opts) {
+    query_admission_config_t config;
+    const int max_running = get_single_int(opts, "--max-running-queries");
+    if (max_running < 0) {
+        throw std::runtime_error(
+            "ERROR: max-running-queries should not be negative");
+    }
+    config.max_running_queries = max_running;
+    const int max_queued = get_single_int(opts, "--max-queued-queries");
+    if (max_queued < 0) {
+        throw std::runtime_error(
+            "ERROR: max-queued-queries should not be negative");
+    }
+    config.max_queued_queries = max_queued;
+    return config;
+}
+
+size_t parse_lookup_filter_bits(const std::map<std::string, options::values_t> &opts) {
+    const int bits = get_single_int(opts, "--lookup-filter-bits");
+    if (bits < 0 || bits > 64) {
+        throw std::runtime_error(
+            "ERROR: lookup-filter-bits should be between 0 and 64");
+    }
+    return bits;
+}
+
 options::help_section_t get_service_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Service options");
     options_out->push_back(options::option_t(options::names_t("--pid-file"),
@@ -1170,6 +1287,8 @@ void get_rethinkdb_serve_options(std::vector<options::help_section_t> *help_out,
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_rebalance_options(options_out));
+    help_out->push_back(get_query_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1181,6 +1300,7 @@ void get_rethinkdb_proxy_options(std::vector<options::help_section_t> *help_out,
                                  std::vector<options::option_t> *options_out) {
     help_out->push_back(get_network_options(true, options_out));
     help_out->push_back(get_web_options(options_out));
+    help_out->push_back(get_query_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1195,6 +1315,8 @@ void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_rebalance_options(options_out));
+    help_out->push_back(get_query_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1424,6 +1546,10 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        if (!parse_coro_sample_rate_option(opts)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -1464,6 +1590,14 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 std::move(web_path),
                                 do_update_checking,
                                 address_ports,
+                                !exists_option(opts, "--no-cluster-compression"),
+                                parse_auto_rebalance_options(opts),
+                                parse_query_admission_options(opts),
+                                exists_option(opts, "--hedge-outdated-reads"),
+                                parse_lookup_filter_bits(opts),
+                                exists_option(opts, "--backfill-content-hashes"),
+                                exists_option(opts, "--punch-holes"),
+                                !exists_option(opts, "--no-file-compaction"),
                                 get_optional_option(opts, "--config-file"),
                                 std::vector<std::string>(argv, argv + argc));
 
@@ -1548,6 +1682,14 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 std::move(web_path),
                                 update_check_t::do_not_perform,
                                 address_ports,
+                                !exists_option(opts, "--no-cluster-compression"),
+                                auto_rebalance_config_t(),
+                                parse_query_admission_options(opts),
+                                exists_option(opts, "--hedge-outdated-reads"),
+                                parse_lookup_filter_bits(opts),
+                                exists_option(opts, "--backfill-content-hashes"),
+                                exists_option(opts, "--punch-holes"),
+                                !exists_option(opts, "--no-file-compaction"),
                                 get_optional_option(opts, "--config-file"),
                                 std::vector<std::string>(argv, argv + argc));
 
@@ -1655,6 +1797,10 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        if (!parse_coro_sample_rate_option(opts)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -1715,6 +1861,14 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 std::move(web_path),
                                 do_update_checking,
                                 address_ports,
+                                !exists_option(opts, "--no-cluster-compression"),
+                                parse_auto_rebalance_options(opts),
+                                parse_query_admission_options(opts),
+                                exists_option(opts, "--hedge-outdated-reads"),
+                                parse_lookup_filter_bits(opts),
+                                exists_option(opts, "--backfill-content-hashes"),
+                                exists_option(opts, "--punch-holes"),
+                                !exists_option(opts, "--no-file-compaction"),
                                 get_optional_option(opts, "--config-file"),
                                 std::vector<std::string>(argv, argv + argc));
 
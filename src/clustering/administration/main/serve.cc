@@ -113,7 +113,8 @@ bool do_serve(io_backender_t *io_backender,
 
         connectivity_cluster_t connectivity_cluster;
 
-        mailbox_manager_t mailbox_manager(&connectivity_cluster, 'M');
+        mailbox_manager_t mailbox_manager(&connectivity_cluster, 'M',
+            serve_info.cluster_compression);
 
         semilattice_manager_t<cluster_semilattice_metadata_t>
             semilattice_manager_cluster(&connectivity_cluster, 'S', cluster_metadata);
@@ -198,7 +199,13 @@ bool do_serve(io_backender_t *io_backender,
                               NULL,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              serve_info.query_admission,
+                              serve_info.hedge_outdated_reads,
+                              serve_info.lookup_filter_bits,
+                              serve_info.backfill_content_hashes,
+                              serve_info.punch_holes,
+                              serve_info.compact_files);
         {
             /* Extract a subview of the directory with all the table meta manager
             business cards. */
@@ -483,6 +490,13 @@ bool do_serve(io_backender_t *io_backender,
                             &rdb_ctx, uname, &table_meta_client, &server_config_client));
                     }
 
+                    scoped_ptr_t<auto_rebalancer_t> auto_rebalancer;
+                    if (i_am_a_server && serve_info.auto_rebalance.enabled) {
+                        auto_rebalancer.init(new auto_rebalancer_t(
+                            serve_info.auto_rebalance, server_id,
+                            &real_reql_cluster_interface, &table_meta_client));
+                    }
+
                     stop_cond->wait_lazily_unordered();
 
                     if (stop_cond->get_source_signo() == SIGINT) {
@@ -10,7 +10,9 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/persist/file.hpp"
 #include "clustering/administration/main/version_check.hpp"
+#include "clustering/administration/tables/auto_rebalance.hpp"
 #include "arch/address.hpp"
+#include "rdb_protocol/query_admission.hpp"
 
 class os_signal_cond_t;
 
@@ -94,6 +96,14 @@ public:
                  std::string &&_web_assets,
                  update_check_t _do_version_checking,
                  service_address_ports_t _ports,
+                 bool _cluster_compression,
+                 const auto_rebalance_config_t &_auto_rebalance,
+                 const query_admission_config_t &_query_admission,
+                 bool _hedge_outdated_reads,
+                 size_t _lookup_filter_bits,
+                 bool _backfill_content_hashes,
+                 bool _punch_holes,
+                 bool _compact_files,
                  boost::optional<std::string> _config_file,
                  std::vector<std::string> &&_argv) :
         joins(std::move(_joins)),
@@ -101,6 +111,14 @@ public:
         web_assets(std::move(_web_assets)),
         do_version_checking(_do_version_checking),
         ports(_ports),
+        cluster_compression(_cluster_compression),
+        auto_rebalance(_auto_rebalance),
+        query_admission(_query_admission),
+        hedge_outdated_reads(_hedge_outdated_reads),
+        lookup_filter_bits(_lookup_filter_bits),
+        backfill_content_hashes(_backfill_content_hashes),
+        punch_holes(_punch_holes),
+        compact_files(_compact_files),
         config_file(_config_file),
         argv(std::move(_argv))
     { }
@@ -115,6 +133,24 @@ public:
     std::string web_assets;
     update_check_t do_version_checking;
     service_address_ports_t ports;
+    /* If `cluster_compression` is false, we don't compress large cluster messages
+    before sending them to other servers. */
+    bool cluster_compression;
+    /* Whether and how eagerly to move split points when a table's load is skewed. */
+    auto_rebalance_config_t auto_rebalance;
+    /* How many queries may run at the same time, and how many may wait. */
+    query_admission_config_t query_admission;
+    /* Whether slow outdated reads are also sent to a second replica. */
+    bool hedge_outdated_reads;
+    /* Bits per key for the filters that let lookups skip keys that don't exist, or
+    zero for no filters. */
+    size_t lookup_filter_bits;
+    /* Whether this server sends content hashes when it receives a backfill. */
+    bool backfill_content_hashes;
+    /* Whether table files give unused space back to the filesystem, and whether they
+    are compacted so that they can be shrunk. */
+    bool punch_holes;
+    bool compact_files;
     boost::optional<std::string> config_file;
     /* The original arguments, so we can display them in `server_status`. All the
     argument parsing has already been completed at this point. */
@@ -4,6 +4,11 @@
 #include <algorithm>
 #include <array>
 
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/timing.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/hot_page_manifest.hpp"
 #include "clustering/administration/issues/outdated_index.hpp"
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
@@ -32,6 +37,8 @@ public:
                 namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
             > *real_multistores) :
         branch_history_manager(std::move(bhm)),
+        manifest_path(hot_page_manifest_path(path.permanent_path())),
+        saving_manifest(false),
         map_insertion_sentry(
             real_multistores, table_id, std::make_pair(this, drainer.lock()))
     {
@@ -60,8 +67,13 @@ public:
         // TODO: Could we handle failure when loading the serializer?  Right
         // now, we don't.
 
+        standard_serializer_t::dynamic_config_t dynamic_config;
+        if (rdb_context != nullptr) {
+            dynamic_config.punch_holes = rdb_context->punch_holes;
+            dynamic_config.compact_file = rdb_context->compact_files;
+        }
         scoped_ptr_t<serializer_t> inner_serializer(new standard_serializer_t(
-            standard_serializer_t::dynamic_config_t(),
+            dynamic_config,
             &file_opener,
             perfmon_collection_serializers));
         serializer.init(new merger_serializer_t(
@@ -119,10 +131,29 @@ public:
 
         if (create) {
             file_opener.move_serializer_file_to_permanent_location();
+        } else {
+            start_warm_up();
         }
+
+        manifest_drainer.init(new auto_drainer_t);
+        manifest_timer.init(new repeating_timer_t(HOT_PAGE_MANIFEST_INTERVAL_MS,
+            [this]() {
+                auto_drainer_t::lock_t lock = manifest_drainer->lock();
+                coro_t::spawn_sometime([this, lock]() {
+                    save_hot_page_manifest();
+                });
+            }));
     }
 
     ~real_multistore_ptr_t() {
+        if (manifest_drainer.has()) {
+            on_thread_t thread_switcher(serializer->home_thread());
+            manifest_timer.reset();
+            manifest_drainer.reset();
+            // Save the manifest one last time, so that the caches can be warmed up
+            // with what they held right before a restart.
+            save_hot_page_manifest();
+        }
         pmap(CPU_SHARDING_FACTOR, [this](int ix) {
             if (stores[ix].has()) {
                 on_thread_t thread_switcher(stores[ix]->home_thread());
@@ -163,11 +194,53 @@ public:
     }
 
 private:
+    /* Reads the hot page manifest that was saved before the table was last unloaded,
+    and starts warming up each store's cache with it. */
+    void start_warm_up() {
+        hot_page_manifest_t manifest;
+        bool ok;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            ok = read_hot_page_manifest(manifest_path, &manifest);
+        });
+        if (!ok || manifest.size() != CPU_SHARDING_FACTOR) {
+            return;
+        }
+        pmap(CPU_SHARDING_FACTOR, [&](int ix) {
+            on_thread_t thread_switcher(stores[ix]->home_thread());
+            stores[ix]->cache->start_warm_up(std::move(manifest[ix]));
+        });
+    }
+
+    void save_hot_page_manifest() {
+        if (saving_manifest) {
+            return;
+        }
+        assignment_sentry_t<bool> saving_sentry(&saving_manifest, true);
+        hot_page_manifest_t manifest(CPU_SHARDING_FACTOR);
+        pmap(CPU_SHARDING_FACTOR, [&](int ix) {
+            on_thread_t thread_switcher(stores[ix]->home_thread());
+            manifest[ix] = stores[ix]->cache->hot_block_ids(HOT_PAGE_MANIFEST_MAX_BLOCKS);
+        });
+        bool ok;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            ok = write_hot_page_manifest(manifest_path, manifest);
+        });
+        if (!ok) {
+            logWRN("Failed to write the hot page manifest %s.", manifest_path.c_str());
+        }
+    }
+
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
     scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
 
+    // These live on the serializer's thread.
+    const std::string manifest_path;
+    bool saving_manifest;
+    scoped_ptr_t<auto_drainer_t> manifest_drainer;
+    scoped_ptr_t<repeating_timer_t> manifest_timer;
+
     auto_drainer_t drainer;
     map_insertion_sentry_t<
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
@@ -218,11 +291,9 @@ void real_table_persistence_interface_t::load_multistore(
     scoped_ptr_t<real_branch_history_manager_t> bhm(
         new real_branch_history_manager_t(table_id, metadata_file, interruptor));
 
-    threadnum_t serializer_thread = pick_thread();
+    threadnum_t serializer_thread(0);
     std::vector<threadnum_t> store_threads;
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-        store_threads.push_back(pick_thread());
-    }
+    pick_threads(&serializer_thread, &store_threads);
 
     multistore_ptr_out->init(new real_multistore_ptr_t(
         table_id,
@@ -261,6 +332,10 @@ void real_table_persistence_interface_t::destroy_multistore(
     guarantee_err(res == 0 || get_errno() == ENOENT,
                   "unlink failed for file %s", filepath.c_str());
 
+    // The hot page manifest is only a hint, so we don't care if this fails.
+    std::string manifest_path = hot_page_manifest_path(filepath);
+    ::unlink(manifest_path.c_str());
+
     real_branch_history_manager_t::erase(table_id, metadata_file, interruptor);
 }
 
@@ -269,9 +344,41 @@ serializer_filepath_t real_table_persistence_interface_t::file_name_for(
     return serializer_filepath_t(base_path, uuid_to_str(table_id));
 }
 
-threadnum_t real_table_persistence_interface_t::pick_thread() {
-    thread_counter = (thread_counter + 1) % get_num_db_threads();
-    return threadnum_t(thread_counter);
+void real_table_persistence_interface_t::pick_threads(
+        threadnum_t *serializer_thread_out,
+        std::vector<threadnum_t> *store_threads_out) {
+    /* We try to put the serializer and all CPU shards of a table on the same NUMA
+    node. The cache pages of a store are allocated either on the store's thread or,
+    when they are read from disk, on the serializer's thread, so this keeps them in
+    memory that is local to the store that uses them. Tables are rotated over the
+    nodes. If the node doesn't have a thread for each CPU shard, we spread the table
+    over all threads instead, because the shards would contend for CPU otherwise. */
+    std::vector<threadnum_t> candidates;
+    const int num_nodes = get_num_numa_nodes();
+    if (num_nodes > 1) {
+        node_counter = (node_counter + 1) % num_nodes;
+        for (int thread = 0; thread < get_num_db_threads(); ++thread) {
+            if (get_thread_numa_node(threadnum_t(thread)) == node_counter) {
+                candidates.push_back(threadnum_t(thread));
+            }
+        }
+        if (candidates.size() < CPU_SHARDING_FACTOR) {
+            candidates.clear();
+        }
+    }
+    if (candidates.empty()) {
+        for (int thread = 0; thread < get_num_db_threads(); ++thread) {
+            candidates.push_back(threadnum_t(thread));
+        }
+    }
+
+    thread_counter = (thread_counter + 1) % candidates.size();
+    *serializer_thread_out = candidates[thread_counter];
+    store_threads_out->clear();
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        thread_counter = (thread_counter + 1) % candidates.size();
+        store_threads_out->push_back(candidates[thread_counter]);
+    }
 }
 
 bool real_table_persistence_interface_t::is_gc_active() const {
@@ -26,7 +26,8 @@ public:
         outdated_index_issue_tracker(_outdated_index_issue_tracker),
         rdb_context(_rdb_context),
         metadata_file(_metadata_file),
-        thread_counter(0)
+        thread_counter(0),
+        node_counter(0)
         { }
 
     void read_all_metadata(
@@ -61,7 +62,9 @@ public:
 
 private:
     serializer_filepath_t file_name_for(const namespace_id_t &table_id);
-    threadnum_t pick_thread();
+    void pick_threads(
+        threadnum_t *serializer_thread_out,
+        std::vector<threadnum_t> *store_threads_out);
 
     io_backender_t * const io_backender;
     cache_balancer_t * const cache_balancer;
@@ -74,8 +77,10 @@ private:
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
     > real_multistores;
 
-    /* `pick_thread()` uses this to distribute objects evenly over threads */
+    /* `pick_threads()` uses these to distribute tables evenly over NUMA nodes and
+    threads */
     int thread_counter;
+    int node_counter;
 };
 
 #endif /* CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_ */
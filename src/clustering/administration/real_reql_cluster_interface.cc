@@ -18,6 +18,7 @@
 #include "rpc/semilattice/view/field.hpp"
 
 #define NAMESPACE_INTERFACE_EXPIRATION_MS (60 * 1000)
+#define READY_SINDEXES_REFRESH_MS (5 * 1000)
 
 real_reql_cluster_interface_t::real_reql_cluster_interface_t(
         mailbox_manager_t *_mailbox_manager,
@@ -1170,6 +1171,86 @@ bool real_reql_cluster_interface_t::sindex_list(
       CATCH_OP_ERRORS(db->name, table_name, error_out, "", "")
 }
 
+bool real_reql_cluster_interface_t::sindex_list_ready(
+        counted_t<const ql::db_t> db,
+        const name_string_t &table_name,
+        signal_t *,
+        std::string *error_out,
+        std::map<std::string, sindex_config_t> *configs_out) {
+    guarantee(db->name != name_string_t::guarantee_valid("rethinkdb"),
+        "real_reql_cluster_interface_t should never get queries for system tables");
+    try {
+        on_thread_t thread_switcher(home_thread());
+        namespace_id_t table_id;
+        table_meta_client->find(db->id, table_name, &table_id);
+        ready_sindexes_t *ready = &ready_sindexes[table_id];
+        if (!ready->refreshing && current_microtime() >= ready->refreshed
+                + static_cast<microtime_t>(READY_SINDEXES_REFRESH_MS) * THOUSAND) {
+            ready->refreshing = true;
+            coro_t::spawn_sometime(std::bind(
+                &real_reql_cluster_interface_t::refresh_ready_sindexes,
+                this, table_id, drainer.lock()));
+        }
+        *configs_out = ready->configs;
+        return true;
+    } CATCH_NAME_ERRORS(db->name, table_name, error_out)
+}
+
+void real_reql_cluster_interface_t::refresh_ready_sindexes(
+        const namespace_id_t &table_id,
+        auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    try {
+        table_config_and_shards_t config;
+        table_meta_client->get_config(
+            table_id, keepalive.get_drain_signal(), &config);
+        const std::map<std::string, sindex_config_t> &sindexes =
+            config.config.sindexes;
+        std::map<std::string, std::pair<sindex_config_t, sindex_status_t> > statuses;
+        table_meta_client->get_status(
+            table_id, keepalive.get_drain_signal(), &statuses,
+            nullptr, nullptr, nullptr);
+
+        std::map<std::string, sindex_config_t> configs;
+        for (const auto &pair : statuses) {
+            auto it = sindexes.find(pair.first);
+            if (pair.second.second.ready
+                    && !pair.second.second.outdated
+                    && it != sindexes.end()
+                    && it->second == pair.second.first) {
+                configs[pair.first] = pair.second.first;
+            }
+        }
+        auto it = ready_sindexes.find(table_id);
+        if (it != ready_sindexes.end()) {
+            it->second.configs = std::move(configs);
+        }
+    } catch (const interrupted_exc_t &) {
+        return;
+    } catch (const no_such_table_exc_t &) {
+        /* The table is removed below. */
+    } catch (const failed_table_op_exc_t &) {
+        /* We'll try again next time. */
+    } catch (const maybe_failed_table_op_exc_t &) {
+        /* We'll try again next time. */
+    }
+
+    auto it = ready_sindexes.find(table_id);
+    if (it != ready_sindexes.end()) {
+        it->second.refreshing = false;
+        it->second.refreshed = current_microtime();
+    }
+
+    /* Forget the tables that were dropped, including this one if it was. */
+    for (auto jt = ready_sindexes.begin(); jt != ready_sindexes.end();) {
+        if (!jt->second.refreshing && !table_meta_client->exists(jt->first)) {
+            ready_sindexes.erase(jt++);
+        } else {
+            ++jt;
+        }
+    }
+}
+
 /* Checks that divisor is indeed a divisor of multiple. */
 template <class T>
 bool is_joined(const T &multiple, const T &divisor) {
@@ -9,10 +9,12 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/namespace_interface_repository.hpp"
 #include "clustering/administration/tables/generate_config.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
 #include "concurrency/watchable.hpp"
 #include "rdb_protocol/context.hpp"
 #include "rpc/semilattice/view.hpp"
+#include "time.hpp"
 
 class admin_artificial_tables_t;
 class artificial_table_backend_t;
@@ -170,6 +172,12 @@ public:
             std::string *error_out,
             std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
                 *configs_and_statuses_out);
+    bool sindex_list_ready(
+            counted_t<const ql::db_t> db,
+            const name_string_t &table,
+            signal_t *interruptor,
+            std::string *error_out,
+            std::map<std::string, sindex_config_t> *configs_out);
 
     /* `calculate_split_points_with_distribution` needs access to the underlying
     `namespace_interface_t` and `table_meta_client_t`. */
@@ -197,6 +205,25 @@ private:
     ql::changefeed::client_t changefeed_client;
     server_config_client_t *server_config_client;
 
+    /* What `sindex_list_ready()` returns for a table: the indexes that were ready when
+    we last asked the servers, with their configs. It's refreshed in the background
+    once it's older than `READY_SINDEXES_REFRESH_MS`, so it may be out of date; callers
+    must cope with an index that isn't ready after all. Entries for dropped tables are
+    removed by the refresh. Only accessed on the home thread. */
+    struct ready_sindexes_t {
+        ready_sindexes_t() : refreshed(0), refreshing(false) { }
+        std::map<std::string, sindex_config_t> configs;
+        microtime_t refreshed;
+        bool refreshing;
+    };
+    std::map<namespace_id_t, ready_sindexes_t> ready_sindexes;
+
+    void refresh_ready_sindexes(
+            const namespace_id_t &table_id,
+            auto_drainer_t::lock_t keepalive);
+
+    auto_drainer_t drainer;
+
     void wait_for_metadata_to_propagate(const cluster_semilattice_metadata_t &metadata,
                                         signal_t *interruptor);
 
@@ -0,0 +1,60 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_STATS_DEBUG_PROFILE_BACKEND_HPP_
+#define CLUSTERING_ADMINISTRATION_STATS_DEBUG_PROFILE_BACKEND_HPP_
+
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/shared_ptr.hpp>
+
+#include "clustering/administration/metadata.hpp"
+#include "clustering/administration/servers/server_common.hpp"
+#include "clustering/administration/servers/server_metadata.hpp"
+#include "clustering/administration/stats/stat_manager.hpp"
+#include "rdb_protocol/artificial_table/backend.hpp"
+#include "rpc/semilattice/view.hpp"
+
+class server_config_client_t;
+
+/* `debug_profile_artificial_table_backend_t` implements the `rethinkdb._debug_profile`
+table. It has one row per connected server with the profile collected by that server's
+`coro_sampler_t`, which it fetches through the `coro_profile` perfmon. */
+class debug_profile_artificial_table_backend_t :
+    public common_server_artificial_table_backend_t
+{
+public:
+    debug_profile_artificial_table_backend_t(
+            watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory,
+            server_config_client_t *_server_config_client,
+            mailbox_manager_t *_mailbox_manager);
+    ~debug_profile_artificial_table_backend_t();
+
+    bool write_row(
+            ql::datum_t primary_key,
+            bool pkey_was_autogenerated,
+            ql::datum_t *new_value_inout,
+            signal_t *interruptor_on_caller,
+            std::string *error_out);
+
+private:
+    bool format_row(
+            server_id_t const & server_id,
+            peer_id_t const & peer_id,
+            cluster_directory_metadata_t const & metadata,
+            signal_t *interruptor_on_home,
+            ql::datum_t *row_out,
+            std::string *error_out);
+
+    bool profile_for_server(
+            const server_id_t &server_id,
+            signal_t *interruptor_on_home,
+            ql::datum_t *profile_out,
+            std::string *error_out);
+
+    watchable_map_t<peer_id_t, cluster_directory_metadata_t> *directory_view;
+    mailbox_manager_t *mailbox_manager;
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_STATS_DEBUG_PROFILE_BACKEND_HPP_ */
+
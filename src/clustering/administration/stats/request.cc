@@ -4,6 +4,7 @@
 #include "clustering/administration/datum_adapter.hpp"
 #include "clustering/administration/servers/config_client.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
+#include "perfmon/perfmon.hpp"
 
 const char *cluster_stats_request_t::cluster_request_type = "cluster";
 const char *server_stats_request_t::server_request_type = "server";
@@ -31,10 +32,17 @@ const char *table_server_stats_request_t::table_server_request_type = "table_ser
     (BUILDER).overwrite(#NAME, ql::datum_t( \
         (STATS).accumulate_server(SERVER, &parsed_stats_t::table_stats_t::NAME)));
 
+// Latency histograms show up as `NAME_ms` objects with the percentiles
+#define ADD_LATENCY_STAT(BUILDER, HISTOGRAM, NAME) \
+    (BUILDER).overwrite(#NAME "_ms", \
+        perfmon_latency_histogram_t::percentiles_to_datum(HISTOGRAM))
+
 parsed_stats_t::server_stats_t::server_stats_t() :
     responsive(false),
     queries_per_sec(0), queries_total(0),
-    client_connections(0), clients_active(0) { }
+    client_connections(0), clients_active(0),
+    cluster_uncompressed_bytes(0), cluster_compressed_bytes(0),
+    cluster_compress_usecs(0), cluster_decompress_usecs(0) { }
 
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
@@ -65,6 +73,8 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "cluster_compression") {
+                store_cluster_compression_stats(perf_pair.second, &serv_stats);
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -101,6 +111,20 @@ void parsed_stats_t::add_perfmon_value(const ql::datum_t &perf,
     }
 }
 
+void parsed_stats_t::add_perfmon_histogram(const ql::datum_t &perf,
+                                           const std::string &key,
+                                           latency_histogram_t *histogram_out) {
+    ql::datum_t v = perf.get_field(key.c_str(), ql::throw_bool_t::NOTHROW);
+    if (v.has()) {
+        r_sanity_check(v.get_type() == ql::datum_t::R_OBJECT);
+        ql::datum_t buckets = v.get_field("buckets", ql::throw_bool_t::NOTHROW);
+        // Servers running an older version don't report the buckets
+        if (buckets.has()) {
+            histogram_out->merge_buckets_datum(buckets);
+        }
+    }
+}
+
 void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                                         table_stats_t *stats_out) {
     r_sanity_check(shard_perf.get_type() == ql::datum_t::R_OBJECT);
@@ -108,6 +132,10 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
         std::pair<datum_string_t, ql::datum_t> pair = shard_perf.get_pair(i);
         if (pair.first.to_std().find("shard_") == 0) {
             r_sanity_check(pair.second.get_type() == ql::datum_t::R_OBJECT);
+            add_perfmon_histogram(pair.second, "read_latency",
+                                  &stats_out->read_latency);
+            add_perfmon_histogram(pair.second, "write_latency",
+                                  &stats_out->write_latency);
             for (size_t j = 0; j < pair.second.obj_size(); ++j) {
                 std::pair<datum_string_t, ql::datum_t> sub_pair = pair.second.get_pair(j);
                 std::string key = sub_pair.first.to_std();
@@ -166,6 +194,19 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+    add_perfmon_histogram(qe_perf, "query_latency", &stats_out->query_latency);
+}
+
+void parsed_stats_t::store_cluster_compression_stats(const ql::datum_t &cc_perf,
+                                                     server_stats_t *stats_out) {
+    r_sanity_check(cc_perf.get_type() == ql::datum_t::R_OBJECT);
+    store_perfmon_value(cc_perf, "uncompressed_bytes",
+                        &stats_out->cluster_uncompressed_bytes);
+    store_perfmon_value(cc_perf, "compressed_bytes",
+                        &stats_out->cluster_compressed_bytes);
+    store_perfmon_value(cc_perf, "compress_usecs", &stats_out->cluster_compress_usecs);
+    store_perfmon_value(cc_perf, "decompress_usecs",
+                        &stats_out->cluster_decompress_usecs);
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -229,6 +270,51 @@ double parsed_stats_t::accumulate_server(const server_id_t &server_id,
     return res;
 }
 
+latency_histogram_t parsed_stats_t::merge_histograms(
+        latency_histogram_t server_stats_t::*field) const {
+    latency_histogram_t res;
+    for (auto const &pair : servers) {
+        res.merge(pair.second.*field);
+    }
+    return res;
+}
+
+latency_histogram_t parsed_stats_t::merge_histograms(
+        latency_histogram_t table_stats_t::*field) const {
+    latency_histogram_t res;
+    for (auto const &server_pair : servers) {
+        for (auto const &table_pair : server_pair.second.tables) {
+            res.merge(table_pair.second.*field);
+        }
+    }
+    return res;
+}
+
+latency_histogram_t parsed_stats_t::merge_table_histograms(
+        const namespace_id_t &table_id,
+        latency_histogram_t table_stats_t::*field) const {
+    latency_histogram_t res;
+    for (auto const &server_pair : servers) {
+        auto const &table_it = server_pair.second.tables.find(table_id);
+        if (table_it != server_pair.second.tables.end()) {
+            res.merge(table_it->second.*field);
+        }
+    }
+    return res;
+}
+
+latency_histogram_t parsed_stats_t::merge_server_histograms(
+        const server_id_t &server_id,
+        latency_histogram_t table_stats_t::*field) const {
+    latency_histogram_t res;
+    auto const server_it = servers.find(server_id);
+    r_sanity_check(server_it != servers.end());
+    for (auto const &table_pair : server_it->second.tables) {
+        res.merge(table_pair.second.*field);
+    }
+    return res;
+}
+
 bool add_table_fields(const namespace_id_t &table_id,
                       const cluster_semilattice_metadata_t &metadata,
                       table_meta_client_t *table_meta_client,
@@ -285,7 +371,8 @@ cluster_stats_request_t::cluster_stats_request_t() { }
 std::set<std::vector<std::string> > cluster_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine" },
-          {".*", "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" } });
+          {".*", "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" },
+          {".*", "serializers", "shard_[0-9]+", "(read|write)_latency" } });
 }
 
 std::vector<peer_id_t> cluster_stats_request_t::get_peers(
@@ -311,6 +398,15 @@ bool cluster_stats_request_t::to_datum(const parsed_stats_t &stats,
     ADD_CLUSTER_SERVER_STAT(qe_builder, stats, clients_active);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, read_docs_per_sec);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, written_docs_per_sec);
+    ADD_LATENCY_STAT(qe_builder,
+        stats.merge_histograms(&parsed_stats_t::server_stats_t::query_latency),
+        query_latency);
+    ADD_LATENCY_STAT(qe_builder,
+        stats.merge_histograms(&parsed_stats_t::table_stats_t::read_latency),
+        read_latency);
+    ADD_LATENCY_STAT(qe_builder,
+        stats.merge_histograms(&parsed_stats_t::table_stats_t::write_latency),
+        write_latency);
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
     *result_out = std::move(row_builder).to_datum();
@@ -343,7 +439,8 @@ table_stats_request_t::table_stats_request_t(const namespace_id_t &_table_id) :
 
 std::set<std::vector<std::string> > table_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >({
-        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" }
+        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" },
+        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "(read|write)_latency" }
         });
 }
 
@@ -373,6 +470,14 @@ bool table_stats_request_t::to_datum(const parsed_stats_t &stats,
     ql::datum_object_builder_t qe_builder;
     ADD_TABLE_STAT(qe_builder, stats, table_id, read_docs_per_sec);
     ADD_TABLE_STAT(qe_builder, stats, table_id, written_docs_per_sec);
+    ADD_LATENCY_STAT(qe_builder,
+        stats.merge_table_histograms(table_id,
+                                     &parsed_stats_t::table_stats_t::read_latency),
+        read_latency);
+    ADD_LATENCY_STAT(qe_builder,
+        stats.merge_table_histograms(table_id,
+                                     &parsed_stats_t::table_stats_t::write_latency),
+        write_latency);
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
     *result_out = std::move(row_builder).to_datum();
@@ -406,7 +511,9 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
-          {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
+          {"cluster_compression"},
+          {".*", "serializers", "shard_[0-9]+", "btree-.*" },
+          {".*", "serializers", "shard_[0-9]+", "(read|write)_latency" } });
 }
 
 std::vector<peer_id_t> server_stats_request_t::get_peers(
@@ -455,7 +562,34 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
+        ADD_LATENCY_STAT(qe_builder, server_stats.query_latency, query_latency);
+        ADD_LATENCY_STAT(qe_builder,
+            stats.merge_server_histograms(server_id,
+                                          &parsed_stats_t::table_stats_t::read_latency),
+            read_latency);
+        ADD_LATENCY_STAT(qe_builder,
+            stats.merge_server_histograms(server_id,
+                                          &parsed_stats_t::table_stats_t::write_latency),
+            write_latency);
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
+
+        /* `compression_ratio` is only meaningful once something has actually been
+        compressed, so it's `null` until then. */
+        ql::datum_object_builder_t cc_builder;
+        cc_builder.overwrite("uncompressed_bytes_total",
+            ql::datum_t(server_stats.cluster_uncompressed_bytes));
+        cc_builder.overwrite("compressed_bytes_total",
+            ql::datum_t(server_stats.cluster_compressed_bytes));
+        cc_builder.overwrite("compression_ratio",
+            server_stats.cluster_compressed_bytes > 0
+                ? ql::datum_t(server_stats.cluster_uncompressed_bytes /
+                              server_stats.cluster_compressed_bytes)
+                : ql::datum_t::null());
+        cc_builder.overwrite("compress_cpu_usecs_total",
+            ql::datum_t(server_stats.cluster_compress_usecs));
+        cc_builder.overwrite("decompress_cpu_usecs_total",
+            ql::datum_t(server_stats.cluster_decompress_usecs));
+        row_builder.overwrite("cluster_compression", std::move(cc_builder).to_datum());
     }
     *result_out = std::move(row_builder).to_datum();
     return true;
@@ -548,6 +682,8 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(qe_builder, table_stats, read_docs_total);
         ADD_STAT(qe_builder, table_stats, written_docs_per_sec);
         ADD_STAT(qe_builder, table_stats, written_docs_total);
+        ADD_LATENCY_STAT(qe_builder, table_stats.read_latency, read_latency);
+        ADD_LATENCY_STAT(qe_builder, table_stats.write_latency, write_latency);
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
@@ -9,6 +9,7 @@
 
 #include "clustering/administration/metadata.hpp"
 #include "containers/uuid.hpp"
+#include "perfmon/latency_histogram.hpp"
 #include "rdb_protocol/datum.hpp"
 
 class server_config_client_t;
@@ -36,6 +37,8 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+        latency_histogram_t read_latency;
+        latency_histogram_t write_latency;
     };
 
     struct server_stats_t {
@@ -46,6 +49,11 @@ public:
         double queries_total;
         double client_connections;
         double clients_active;
+        double cluster_uncompressed_bytes;
+        double cluster_compressed_bytes;
+        double cluster_compress_usecs;
+        double cluster_decompress_usecs;
+        latency_histogram_t query_latency;
 
         std::map<namespace_id_t, table_stats_t> tables;
     };
@@ -66,6 +74,19 @@ public:
     double accumulate_server(const server_id_t &server_id,
                              double table_stats_t::*field) const;
 
+    // Latency histograms are merged rather than summed, but otherwise these work like
+    // the corresponding `accumulate` functions.
+    latency_histogram_t merge_histograms(
+            latency_histogram_t server_stats_t::*field) const;
+    latency_histogram_t merge_histograms(
+            latency_histogram_t table_stats_t::*field) const;
+    latency_histogram_t merge_table_histograms(
+            const namespace_id_t &table_id,
+            latency_histogram_t table_stats_t::*field) const;
+    latency_histogram_t merge_server_histograms(
+            const server_id_t &server_id,
+            latency_histogram_t table_stats_t::*field) const;
+
     std::map<server_id_t, server_stats_t> servers;
 
 private:
@@ -81,6 +102,11 @@ private:
                              const std::string &key,
                              double *value_out);
 
+    // Merges the buckets of a `perfmon_latency_histogram_t` into `histogram_out`.
+    void add_perfmon_histogram(const ql::datum_t &perf,
+                               const std::string &key,
+                               latency_histogram_t *histogram_out);
+
     void store_shard_values(const ql::datum_t &shard_perf,
                             table_stats_t *stats_out);
 
@@ -90,6 +116,9 @@ private:
     void store_query_engine_stats(const ql::datum_t &qe_perf,
                                   server_stats_t *stats_out);
 
+    void store_cluster_compression_stats(const ql::datum_t &cc_perf,
+                                         server_stats_t *stats_out);
+
     void store_table_stats(const namespace_id_t &table_id,
                            const ql::datum_t &table_perf,
                            server_stats_t *stats_out);
@@ -0,0 +1,107 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/tables/auto_rebalance.hpp"
+
+#include "clustering/administration/real_reql_cluster_interface.hpp"
+#include "clustering/administration/tables/split_points.hpp"
+#include "clustering/table_manager/table_meta_client.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+
+auto_rebalancer_t::auto_rebalancer_t(
+        const auto_rebalance_config_t &_config,
+        const server_id_t &_server_id,
+        real_reql_cluster_interface_t *_reql_cluster_interface,
+        table_meta_client_t *_table_meta_client) :
+    config(_config),
+    server_id(_server_id),
+    reql_cluster_interface(_reql_cluster_interface),
+    table_meta_client(_table_meta_client),
+    check_in_progress(false),
+    timer(CHECK_INTERVAL_MS, this) { }
+
+void auto_rebalancer_t::on_ring() {
+    /* A single check can take a while if the cluster is slow to respond; don't pile up
+    checks behind it. */
+    if (!check_in_progress) {
+        check_in_progress = true;
+        coro_t::spawn_sometime(std::bind(&auto_rebalancer_t::check_tables,
+                                         this, drainer.lock()));
+    }
+}
+
+void auto_rebalancer_t::check_tables(auto_drainer_t::lock_t keepalive) {
+    std::map<namespace_id_t, table_basic_config_t> tables;
+    table_meta_client->list_names(&tables);
+    for (const auto &pair : tables) {
+        try {
+            /* Rebalancing moves data around, so we only start one per round. */
+            if (check_table(pair.first, keepalive.get_drain_signal())) {
+                break;
+            }
+        } catch (const interrupted_exc_t &) {
+            break;
+        } catch (const no_such_table_exc_t &) {
+            /* The table was dropped while we were looking at it. */
+        } catch (const failed_table_op_exc_t &) {
+            /* We'll try again next time. */
+        } catch (const maybe_failed_table_op_exc_t &) {
+            /* We'll try again next time. */
+        }
+    }
+    check_in_progress = false;
+}
+
+bool auto_rebalancer_t::check_table(
+        const namespace_id_t &table_id, signal_t *interruptor) {
+    auto it = last_rebalance.find(table_id);
+    if (it != last_rebalance.end() &&
+            current_microtime() < it->second
+                + static_cast<microtime_t>(config.min_interval_secs) * MILLION) {
+        return false;
+    }
+
+    table_config_and_shards_t config_and_shards;
+    table_meta_client->get_config(table_id, interruptor, &config_and_shards);
+    if (config_and_shards.config.shards.size() <= 1 ||
+            config_and_shards.config.shards[0].primary_replica != server_id) {
+        return false;
+    }
+
+    std::map<store_key_t, int64_t> counts, heat;
+    fetch_distribution(table_id, reql_cluster_interface, interruptor, &counts, &heat);
+    int64_t total_heat = 0;
+    for (const auto &pair : heat) {
+        total_heat += pair.second;
+    }
+    if (total_heat < MIN_TOTAL_HEAT) {
+        return false;
+    }
+
+    double old_imbalance =
+        calculate_shard_load_imbalance(heat, config_and_shards.shard_scheme);
+    if (old_imbalance < config.imbalance_threshold) {
+        return false;
+    }
+
+    table_shard_scheme_t new_scheme;
+    if (!calculate_split_points_with_load(counts, heat,
+            config_and_shards.config.shards.size(), LOAD_WEIGHT, &new_scheme)) {
+        return false;
+    }
+
+    /* Only move the split points if that gets us a good part of the way towards an even
+    load. Otherwise noise in the samples could make us shuffle data back and forth. */
+    double new_imbalance = calculate_shard_load_imbalance(heat, new_scheme);
+    if (old_imbalance < new_imbalance * (1.0 + (config.imbalance_threshold - 1.0) / 2)) {
+        return false;
+    }
+
+    config_and_shards.shard_scheme = new_scheme;
+    table_meta_client->set_config(table_id, config_and_shards, interruptor);
+    last_rebalance[table_id] = current_microtime();
+
+    logNTC("Automatically rebalanced table %s; the busiest shard's share of the load "
+           "went from %.2f to an estimated %.2f times the average.\n",
+           uuid_to_str(table_id).c_str(), old_imbalance, new_imbalance);
+    return true;
+}
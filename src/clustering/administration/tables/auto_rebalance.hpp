@@ -0,0 +1,73 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_TABLES_AUTO_REBALANCE_HPP_
+#define CLUSTERING_ADMINISTRATION_TABLES_AUTO_REBALANCE_HPP_
+
+#include <map>
+
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/uuid.hpp"
+#include "time.hpp"
+
+class real_reql_cluster_interface_t;
+class table_meta_client_t;
+
+/* `auto_rebalance_config_t` holds the command-line settings for `auto_rebalancer_t`. */
+class auto_rebalance_config_t {
+public:
+    auto_rebalance_config_t() :
+        enabled(false), imbalance_threshold(1.5), min_interval_secs(600) { }
+
+    bool enabled;
+    /* A table is only rebalanced if its busiest shard gets at least
+    `imbalance_threshold` times its fair share of the load. */
+    double imbalance_threshold;
+    /* The minimum time between two automatic rebalances of the same table. */
+    int64_t min_interval_secs;
+};
+
+/* `auto_rebalancer_t` periodically looks at the key heat that the stores sample (see
+`key_heat_sampler_t`) and moves the split points of tables whose load is badly skewed
+towards one shard. It does the same thing as `r.table(...).rebalance()`, except that it
+weighs the key space by load instead of by document count alone.
+
+Every server that runs an `auto_rebalancer_t` looks at every table, but only the server
+that is the primary replica for a table's first shard acts on it, so that two servers
+never reconfigure the same table at once. */
+class auto_rebalancer_t : private repeating_timer_callback_t {
+public:
+    auto_rebalancer_t(
+        const auto_rebalance_config_t &_config,
+        const server_id_t &_server_id,
+        real_reql_cluster_interface_t *_reql_cluster_interface,
+        table_meta_client_t *_table_meta_client);
+
+private:
+    static const int64_t CHECK_INTERVAL_MS = 60 * 1000;
+    /* Tables that see fewer sampled accesses than this aren't worth rebalancing. */
+    static const int64_t MIN_TOTAL_HEAT = 1000;
+    /* How much the new split points favor load over document counts. */
+    static constexpr double LOAD_WEIGHT = 0.75;
+
+    void on_ring();
+    void check_tables(auto_drainer_t::lock_t keepalive);
+
+    /* Returns `true` if it changed the table's split points. */
+    bool check_table(const namespace_id_t &table_id, signal_t *interruptor);
+
+    const auto_rebalance_config_t config;
+    const server_id_t server_id;
+    real_reql_cluster_interface_t *const reql_cluster_interface;
+    table_meta_client_t *const table_meta_client;
+
+    bool check_in_progress;
+    /* When each table was last rebalanced, in `current_microtime()` units. */
+    std::map<namespace_id_t, microtime_t> last_rebalance;
+
+    auto_drainer_t drainer;
+    repeating_timer_t timer;
+
+    DISABLE_COPYING(auto_rebalancer_t);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_TABLES_AUTO_REBALANCE_HPP_ */
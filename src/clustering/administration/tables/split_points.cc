@@ -1,5 +1,7 @@
 #include "clustering/administration/tables/split_points.hpp"
 
+#include <algorithm>
+
 #include "clustering/administration/real_reql_cluster_interface.hpp"
 #include "math.hpp"   /* for `clamp()` */
 #include "rdb_protocol/real_table.hpp"
@@ -89,7 +91,8 @@ void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *heat_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     namespace_interface_access_t ns_if_access =
         reql_cluster_interface->get_namespace_repo()->get_namespace_interface(
@@ -108,8 +111,12 @@ void fetch_distribution(
         /* If `get_name()` didn't throw, the table exists but is inaccessible */
         throw failed_table_op_exc_t();
     }
-    *counts_out = std::move(
-        boost::get<distribution_read_response_t>(resp.response).key_counts);
+    distribution_read_response_t *dist_resp =
+        boost::get<distribution_read_response_t>(&resp.response);
+    *counts_out = std::move(dist_resp->key_counts);
+    if (heat_out != nullptr) {
+        *heat_out = std::move(dist_resp->key_heat);
+    }
 }
 
 bool calculate_split_points_with_distribution(
@@ -151,6 +158,67 @@ bool calculate_split_points_with_distribution(
     return true;
 }
 
+bool calculate_split_points_with_load(
+        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &heat,
+        size_t num_shards,
+        double load_weight,
+        table_shard_scheme_t *split_points_out) {
+    rassert(load_weight >= 0 && load_weight <= 1);
+    int64_t total_count = 0, total_heat = 0;
+    for (auto const &pair : counts) {
+        total_count += pair.second;
+    }
+    for (auto const &pair : heat) {
+        total_heat += pair.second;
+    }
+    if (total_heat == 0) {
+        return calculate_split_points_with_distribution(
+            counts, num_shards, split_points_out);
+    }
+
+    /* Normalize both inputs so that `load_weight` means the same thing regardless of
+    how many documents there are and how busy the table is, then merge them into a
+    single distribution. The heat of a key is attributed to the range that starts at
+    that key, which is close enough for picking split points. */
+    static const double scale = 1 << 20;
+    std::map<store_key_t, int64_t> weights;
+    if (total_count > 0) {
+        for (auto const &pair : counts) {
+            weights[pair.first] += static_cast<int64_t>(
+                scale * (1 - load_weight) * pair.second / total_count);
+        }
+    }
+    for (auto const &pair : heat) {
+        weights[pair.first] += static_cast<int64_t>(
+            scale * load_weight * pair.second / total_heat);
+    }
+    return calculate_split_points_with_distribution(
+        weights, num_shards, split_points_out);
+}
+
+double calculate_shard_load_imbalance(
+        const std::map<store_key_t, int64_t> &heat,
+        const table_shard_scheme_t &split_points) {
+    std::vector<int64_t> loads(split_points.num_shards(), 0);
+    int64_t total_heat = 0;
+    for (auto const &pair : heat) {
+        /* Each split point is the first key of the next shard */
+        size_t shard = std::upper_bound(
+                split_points.split_points.begin(),
+                split_points.split_points.end(),
+                pair.first)
+            - split_points.split_points.begin();
+        loads[shard] += pair.second;
+        total_heat += pair.second;
+    }
+    if (total_heat == 0) {
+        return 1.0;
+    }
+    int64_t max_load = *std::max_element(loads.begin(), loads.end());
+    return max_load / (static_cast<double>(total_heat) / loads.size());
+}
+
 store_key_t key_for_uuid(uint64_t first_8_bytes) {
     uuid_u uuid;
     bzero(uuid.data(), uuid_u::static_size());
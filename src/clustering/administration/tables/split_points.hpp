@@ -14,12 +14,15 @@ class real_reql_cluster_interface_t;
 class signal_t;
 class table_shard_scheme_t;
 
-/* `fetch_distribution` fetches the distribution information from the database. */
+/* `fetch_distribution` fetches the distribution information from the database. If
+`heat_out` isn't null, it's filled with the recently accessed keys sampled by the stores
+and estimates of how often each of them was accessed. */
 void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *heat_out = nullptr)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t);
 
 /* `calculate_split_points_with_distribution` generates a set of split points that are
@@ -31,6 +34,24 @@ bool calculate_split_points_with_distribution(
         size_t num_shards,
         table_shard_scheme_t *split_points_out);
 
+/* `calculate_split_points_with_load` is like `calculate_split_points_with_distribution`,
+but it weighs each part of the key space by a mix of how many documents it holds and how
+often it's accessed, using both outputs of `fetch_distribution()`. `load_weight` goes
+from 0 (only consider document counts) to 1 (only consider load). */
+bool calculate_split_points_with_load(
+        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &heat,
+        size_t num_shards,
+        double load_weight,
+        table_shard_scheme_t *split_points_out);
+
+/* `calculate_shard_load_imbalance` returns how many times its fair share of the load the
+busiest shard of `split_points` gets, according to `heat`. 1.0 means the load is spread
+perfectly evenly. */
+double calculate_shard_load_imbalance(
+        const std::map<store_key_t, int64_t> &heat,
+        const table_shard_scheme_t &split_points);
+
 /* `calculate_split_points_for_uuids` generates a set of split points that will divide
 the range of UUIDs evenly. */
 void calculate_split_points_for_uuids(
@@ -0,0 +1,59 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "clustering/query_routing/replica_load.hpp"
+
+#include <algorithm>
+
+#include "errors.hpp"
+
+const size_t replica_load_t::max_recent_latencies = 64;
+const size_t replica_load_t::min_hedge_samples = 16;
+const double replica_load_t::ewma_weight = 0.2;
+
+replica_load_t::replica_load_t()
+    : in_flight(0), ewma_latency(0), has_latency(false), next_latency(0) { }
+
+void replica_load_t::start_read() {
+    ++in_flight;
+}
+
+void replica_load_t::finish_read(ticks_t latency) {
+    guarantee(in_flight > 0);
+    --in_flight;
+    add_sample(latency);
+}
+
+void replica_load_t::abandon_read(ticks_t elapsed) {
+    guarantee(in_flight > 0);
+    --in_flight;
+    add_sample(elapsed);
+}
+
+double replica_load_t::cost() const {
+    return ewma_latency * (in_flight + 1);
+}
+
+bool replica_load_t::get_hedge_delay(ticks_t *delay_out) const {
+    if (recent_latencies.size() < min_hedge_samples) {
+        return false;
+    }
+    std::vector<ticks_t> sorted = recent_latencies;
+    size_t index = (sorted.size() * 95) / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    *delay_out = sorted[index];
+    return true;
+}
+
+void replica_load_t::add_sample(ticks_t latency) {
+    if (has_latency) {
+        ewma_latency += ewma_weight * (static_cast<double>(latency) - ewma_latency);
+    } else {
+        ewma_latency = latency;
+        has_latency = true;
+    }
+    if (recent_latencies.size() < max_recent_latencies) {
+        recent_latencies.push_back(latency);
+    } else {
+        recent_latencies[next_latency] = latency;
+        next_latency = (next_latency + 1) % max_recent_latencies;
+    }
+}
@@ -0,0 +1,54 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_QUERY_ROUTING_REPLICA_LOAD_HPP_
+#define CLUSTERING_QUERY_ROUTING_REPLICA_LOAD_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "time.hpp"
+
+/* `replica_load_t` keeps track of how quickly a replica has been answering the
+outdated reads that `table_query_client_t` sends it, and how many are still
+outstanding. It's used to steer reads away from slow or busy replicas, and to decide
+when a read has taken long enough that it's worth sending it to a second replica. */
+class replica_load_t {
+public:
+    replica_load_t();
+
+    // Called when a read is sent to the replica.
+    void start_read();
+    // Called when the replica answers a read after `latency`.
+    void finish_read(ticks_t latency);
+    // Called when we stop waiting for a read, e.g. because another replica answered
+    // it first. `elapsed` is a lower bound on how long the replica would have taken.
+    void abandon_read(ticks_t elapsed);
+
+    uint64_t num_in_flight() const { return in_flight; }
+
+    /* An estimate of how long a new read would take, in ticks: the average latency
+    multiplied by the number of reads it would have to share the replica with. A
+    replica that hasn't answered any reads yet costs nothing, so that it gets tried. */
+    double cost() const;
+
+    /* Sets `*delay_out` to the 95th percentile of recent latencies and returns true,
+    or returns false if there haven't been enough reads to tell. */
+    bool get_hedge_delay(ticks_t *delay_out) const;
+
+private:
+    void add_sample(ticks_t latency);
+
+    static const size_t max_recent_latencies;
+    static const size_t min_hedge_samples;
+    static const double ewma_weight;
+
+    uint64_t in_flight;
+    double ewma_latency;
+    bool has_latency;
+
+    // A ring buffer of the most recent latencies.
+    std::vector<ticks_t> recent_latencies;
+    size_t next_latency;
+};
+
+#endif  // CLUSTERING_QUERY_ROUTING_REPLICA_LOAD_HPP_
@@ -1,8 +1,10 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/query_routing/table_query_client.hpp"
 
+#include <algorithm>
 #include <functional>
 
+#include "arch/timing.hpp"
 #include "clustering/query_routing/primary_query_client.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable.hpp"
@@ -263,30 +265,42 @@ void table_query_client_t::dispatch_outdated_read(
     [&](const region_t &region, const std::set<relationship_t *> &rels) {
         if (op.shard(region, &new_op_info->sharded_op)) {
             std::vector<relationship_t *> potential_relationships;
-            relationship_t *chosen_relationship = NULL;
+            relationship_t *local_relationship = nullptr;
             for (auto jt = rels.begin(); jt != rels.end(); ++jt) {
                 if ((*jt)->direct_bcard != nullptr) {
+                    potential_relationships.push_back(*jt);
                     if ((*jt)->is_local) {
-                        chosen_relationship = *jt;
-                        break;
-                    } else {
-                        potential_relationships.push_back(*jt);
+                        local_relationship = *jt;
                     }
                 }
             }
-            if (!chosen_relationship && !potential_relationships.empty()) {
-                chosen_relationship
-                    = potential_relationships[
-                        distributor_rng.randint(potential_relationships.size())];
-            }
-            if (!chosen_relationship) {
+            if (potential_relationships.empty()) {
                 /* Don't bother looking for masters; if there are no direct
                    readers, there won't be any masters either. */
                 throw cannot_perform_query_exc_t("no replica is available");
             }
-            new_op_info->direct_bcard = chosen_relationship->direct_bcard;
+            relationship_t *chosen_relationship = choose_outdated_replica(
+                potential_relationships, local_relationship);
+            new_op_info->relationship = chosen_relationship;
             new_op_info->keepalive = auto_drainer_t::lock_t(
                 &chosen_relationship->drainer);
+
+            /* The hedge goes to the cheapest of the other replicas. */
+            new_op_info->hedge_relationship = nullptr;
+            if (ctx->hedge_outdated_reads) {
+                for (relationship_t *rel : potential_relationships) {
+                    if (rel != chosen_relationship
+                        && (new_op_info->hedge_relationship == nullptr
+                            || rel->load.cost()
+                               < new_op_info->hedge_relationship->load.cost())) {
+                        new_op_info->hedge_relationship = rel;
+                    }
+                }
+                if (new_op_info->hedge_relationship != nullptr) {
+                    new_op_info->hedge_keepalive = auto_drainer_t::lock_t(
+                        &new_op_info->hedge_relationship->drainer);
+                }
+            }
             replicas_to_contact.push_back(std::move(new_op_info));
             new_op_info.init(new outdated_read_info_t());
         }
@@ -309,6 +323,65 @@ void table_query_client_t::dispatch_outdated_read(
     op.unshard(results.data(), results.size(), response, ctx, interruptor);
 }
 
+table_query_client_t::relationship_t *table_query_client_t::choose_outdated_replica(
+        const std::vector<relationship_t *> &candidates,
+        relationship_t *local) {
+    guarantee(!candidates.empty());
+    if (candidates.size() == 1) {
+        return candidates[0];
+    }
+    relationship_t *first;
+    relationship_t *second;
+    if (local != nullptr) {
+        first = local;
+        do {
+            second = candidates[distributor_rng.randint(candidates.size())];
+        } while (second == local);
+    } else {
+        size_t i = distributor_rng.randint(candidates.size());
+        size_t j = distributor_rng.randint(candidates.size() - 1);
+        if (j >= i) {
+            ++j;
+        }
+        first = candidates[i];
+        second = candidates[j];
+    }
+    return second->load.cost() < first->load.cost() ? second : first;
+}
+
+table_query_client_t::outdated_read_attempt_t::outdated_read_attempt_t(
+        mailbox_manager_t *mailbox_manager,
+        relationship_t *_relationship,
+        const read_t &read,
+        read_response_t *response_out,
+        cond_t *done)
+    : relationship(_relationship),
+      start_time(get_ticks()),
+      answered(false),
+      mailbox(mailbox_manager,
+        [this, response_out, done](signal_t *, const read_response_t &res) {
+            answered = true;
+            relationship->load.finish_read(get_ticks() - start_time);
+            if (!done->is_pulsed()) {
+                *response_out = res;
+                done->pulse();
+            }
+        }) {
+    relationship->load.start_read();
+    send(mailbox_manager,
+        relationship->direct_bcard->read_mailbox,
+        read,
+        mailbox.get_address());
+}
+
+table_query_client_t::outdated_read_attempt_t::~outdated_read_attempt_t() {
+    // Stop accepting the answer first, so that it can't arrive after we've given up.
+    mailbox.begin_shutdown();
+    if (!answered) {
+        relationship->load.abandon_read(get_ticks() - start_time);
+    }
+}
+
 void table_query_client_t::perform_outdated_read(
         std::vector<scoped_ptr_t<outdated_read_info_t> > *replicas_to_contact,
         std::vector<read_response_t> *results,
@@ -319,21 +392,48 @@ void table_query_client_t::perform_outdated_read(
 
     try {
         cond_t done;
-        mailbox_t<void(read_response_t)> cont(mailbox_manager,
-            [&](signal_t *, const read_response_t &res) {
-                results->at(i) = res;
-                done.pulse();
-            });
+        outdated_read_attempt_t first_attempt(mailbox_manager,
+            replica_to_contact->relationship, replica_to_contact->sharded_op,
+            &results->at(i), &done);
+        wait_any_t first_waiter(
+            replica_to_contact->keepalive.get_drain_signal(), &done);
+
+        /* If the replica takes longer than it usually does, we send the read to a
+        second replica as well and use whichever answer comes first. */
+        scoped_ptr_t<outdated_read_attempt_t> hedge_attempt;
+        ticks_t hedge_delay;
+        if (replica_to_contact->hedge_relationship != nullptr
+            && replica_to_contact->relationship->load.get_hedge_delay(&hedge_delay)) {
+            signal_timer_t timer;
+            timer.start(std::max<int64_t>(
+                1, static_cast<int64_t>(ticks_to_secs(hedge_delay) * 1000)));
+            wait_any_t hedge_waiter(&first_waiter, &timer);
+            wait_interruptible(&hedge_waiter, interruptor);
+            if (!first_waiter.is_pulsed()) {
+                hedge_attempt.init(new outdated_read_attempt_t(mailbox_manager,
+                    replica_to_contact->hedge_relationship,
+                    replica_to_contact->sharded_op, &results->at(i), &done));
+            }
+        }
 
-        send(mailbox_manager,
-            replica_to_contact->direct_bcard->read_mailbox,
-            replica_to_contact->sharded_op,
-            cont.get_address());
-        wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
-        wait_interruptible(&waiter, interruptor);
+        if (hedge_attempt.has()) {
+            signal_t *first_lost = replica_to_contact->keepalive.get_drain_signal();
+            signal_t *hedge_lost =
+                replica_to_contact->hedge_keepalive.get_drain_signal();
+            wait_any_t waiter(&done, first_lost, hedge_lost);
+            wait_interruptible(&waiter, interruptor);
+            if (!done.is_pulsed()) {
+                /* One of the replicas went away, but the other may still answer. */
+                wait_any_t other_waiter(
+                    &done, first_lost->is_pulsed() ? hedge_lost : first_lost);
+                wait_interruptible(&other_waiter, interruptor);
+            }
+        } else {
+            wait_interruptible(&first_waiter, interruptor);
+        }
         if (!done.is_pulsed()) {
-            /* `wait_interruptible()` returned because
-            `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
+            /* `wait_interruptible()` returned because the keepalives' drain signals
+            were pulsed */
             failures->at(i).assign("lost contact with replica");
         }
     } catch (const interrupted_exc_t &) {
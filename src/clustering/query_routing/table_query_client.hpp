@@ -10,6 +10,7 @@
 #include <set>
 
 #include "clustering/query_routing/metadata.hpp"
+#include "clustering/query_routing/replica_load.hpp"
 #include "containers/clone_ptr.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable_map.hpp"
@@ -54,6 +55,8 @@ private:
         region_t region;
         primary_query_client_t *primary_client;
         const direct_query_bcard_t *direct_bcard;
+        /* How quickly the replica has been answering our outdated reads. */
+        replica_load_t load;
         auto_drainer_t drainer;
     };
 
@@ -73,8 +76,31 @@ private:
     class outdated_read_info_t {
     public:
         read_t sharded_op;
-        const direct_query_bcard_t *direct_bcard;
+        relationship_t *relationship;
         auto_drainer_t::lock_t keepalive;
+        /* If hedged reads are on, the replica that gets a second copy of the read if
+        the first one takes unusually long, or `nullptr`. */
+        relationship_t *hedge_relationship;
+        auto_drainer_t::lock_t hedge_keepalive;
+    };
+
+    /* Sends an outdated read to one replica and records how long the replica takes
+    to answer in its `replica_load_t`. Pulses `done` when the answer arrives, unless
+    it was already pulsed by another copy of the same read. */
+    class outdated_read_attempt_t {
+    public:
+        outdated_read_attempt_t(mailbox_manager_t *mailbox_manager,
+                                relationship_t *relationship,
+                                const read_t &read,
+                                read_response_t *response_out,
+                                cond_t *done);
+        ~outdated_read_attempt_t();
+    private:
+        relationship_t *const relationship;
+        const ticks_t start_time;
+        bool answered;
+        mailbox_t<void(read_response_t)> mailbox;
+        DISABLE_COPYING(outdated_read_attempt_t);
     };
 
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
@@ -109,6 +135,14 @@ private:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
 
+    /* Picks the replica to send an outdated read to out of `candidates`, which must
+    not be empty. A local replica is compared against one other random candidate,
+    otherwise two random candidates are compared, and the one with the lower
+    `replica_load_t::cost()` wins. */
+    relationship_t *choose_outdated_replica(
+            const std::vector<relationship_t *> &candidates,
+            relationship_t *local);
+
     void perform_outdated_read(
             std::vector<scoped_ptr_t<outdated_read_info_t> > *direct_readers_to_contact,
             std::vector<read_response_t> *results,
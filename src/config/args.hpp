@@ -51,6 +51,12 @@
 // useful.
 #define DEFAULT_IO_BATCH_FACTOR                   1
 
+// How long the disk manager waits for more commits to line up before it starts a
+// group commit round (see `linux_disk_manager_t`). Commits that arrive while a round is
+// running always wait for the next round, so even at 0 the datasyncs of concurrent
+// commits are shared.
+#define DISK_GROUP_COMMIT_WINDOW_MS               0
+
 // I/O priority of index writes in the log serializer
 #define INDEX_WRITE_IO_PRIORITY                   128
 
@@ -68,6 +74,22 @@
 // perspective) if they are soft-durability or noreply writes.
 #define CACHE_READS_IO_PRIORITY                   (512 / CPU_SHARDING_FACTOR)
 
+// After a restart, each cache reads the blocks that were hot before the restart in
+// the background.  Those reads use this lower priority so that they don't slow down
+// the queries that are already running.
+#define CACHE_WARM_UP_IO_PRIORITY                 (CACHE_READS_IO_PRIORITY / 8)
+
+// How many blocks the cache warm-up reads at a time.  The reads of a batch are issued
+// in the order of the blocks' offsets in the file.
+#define CACHE_WARM_UP_BATCH_BLOCKS                256
+
+// How often each table saves the ids of the blocks in its caches to its hot page
+// manifest, which is used to warm up the caches after a restart.
+#define HOT_PAGE_MANIFEST_INTERVAL_MS             (5 * 60 * 1000)
+
+// The maximum number of block ids the hot page manifest stores for each CPU shard.
+#define HOT_PAGE_MANIFEST_MAX_BLOCKS              (1024 * 1024)
+
 // The cache priority to use for secondary index post construction
 // 100 = same priority as all other read operations in the cache together.
 // 0 = minimal priority
@@ -206,6 +228,11 @@
 // 2^(MESSAGE_SCHEDULER_MAX_PRIORITY - MESSAGE_SCHEDULER_MIN_PRIORITY + 1)
 #define MESSAGE_SCHEDULER_GRANULARITY           32
 
+// Passes over the queued messages (usually coroutines running until they yield) that
+// keep the message hub busy for longer than this are counted in the `scheduler`
+// perfmon as long slices.
+#define MESSAGE_SCHEDULER_LONG_SLICE_USECS      10000
+
 // Priorities for specific tasks
 #define CORO_PRIORITY_SINDEX_CONSTRUCTION       (-2)
 #define CORO_PRIORITY_BACKFILL_SENDER           (-2)
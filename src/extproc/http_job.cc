@@ -7,6 +7,8 @@
 #include <re2/re2.h>
 
 #include <limits>
+#include <map>
+#include <vector>
 
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/stl_types.hpp"
@@ -15,9 +17,15 @@
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
 #include "rdb_protocol/env.hpp"
+#include "time.hpp"
 
 #define RETHINKDB_USER_AGENT (SOFTWARE_NAME_STRING "/" RETHINKDB_VERSION)
 
+// How many idle easy handles, and how many open connections, a worker process keeps
+// around for reuse by later requests.
+#define MAX_IDLE_CURL_HANDLES 16
+#define MAX_CACHED_CONNECTIONS 32
+
 void parse_header(const std::string &header,
                   http_result_t *res_out);
 
@@ -37,8 +45,9 @@ void jsonp_to_datum(const std::string &jsonp,
                     attach_json_to_error_t attach_json,
                     http_result_t *res_out);
 
-void perform_http(http_opts_t *opts,
-                  http_result_t *res_out);
+void perform_http_batch(std::vector<http_opts_t> *opts,
+                        size_t max_concurrency,
+                        std::vector<http_result_t> *results_out);
 
 class curl_exc_t : public std::exception {
 public:
@@ -51,23 +60,78 @@ public:
     const std::string error_string;
 };
 
-class scoped_curl_handle_t {
+// Keeps curl state alive across jobs in the same worker process, so that
+// consecutive requests can reuse TCP and TLS connections, DNS lookups and TLS
+// sessions.  Every transfer runs through the shared multi handle, which owns the
+// connection cache.  Like the parser singletons below, this is created on demand
+// at most once per extproc and is cleaned up when the extproc exits.
+class curl_pool_t {
 public:
-    scoped_curl_handle_t() :
-        curl_handle(curl_easy_init()) {
+    static curl_pool_t *get() {
+        if (instance == NULL) {
+            instance = new curl_pool_t();
+        }
+        return instance;
     }
 
-    ~scoped_curl_handle_t() {
-        curl_easy_cleanup(curl_handle);
+    CURLM *multi() {
+        return multi_handle;
     }
 
-    CURL *get() {
-        return curl_handle;
+    CURL *acquire() {
+        if (!idle_handles.empty()) {
+            CURL *handle = idle_handles.back();
+            idle_handles.pop_back();
+            return handle;
+        }
+
+        CURL *handle = curl_easy_init();
+        if (handle == NULL) {
+            throw curl_exc_t("initialization");
+        }
+        CURLcode curl_res = curl_easy_setopt(handle, CURLOPT_SHARE, share_handle);
+        if (curl_res != CURLE_OK) {
+            curl_easy_cleanup(handle);
+            throw curl_exc_t(strprintf("set option SHARE, '%s'",
+                                       curl_easy_strerror(curl_res)));
+        }
+        return handle;
+    }
+
+    // Cookies must not leak from one query to another, so they are wiped before a
+    // handle is reused.  Live connections survive `curl_easy_reset`.
+    void release(CURL *handle) {
+        if (idle_handles.size() >= MAX_IDLE_CURL_HANDLES) {
+            curl_easy_cleanup(handle);
+            return;
+        }
+        curl_easy_setopt(handle, CURLOPT_COOKIELIST, "ALL");
+        curl_easy_reset(handle);
+        curl_easy_setopt(handle, CURLOPT_SHARE, share_handle);
+        idle_handles.push_back(handle);
     }
 
 private:
-    CURL *curl_handle;
+    curl_pool_t() :
+        share_handle(curl_share_init()),
+        multi_handle(curl_multi_init()) {
+        if (share_handle == NULL || multi_handle == NULL) {
+            throw curl_exc_t("initialization of the connection pool");
+        }
+        // The worker is single-threaded, so the share needs no locking callbacks.
+        curl_share_setopt(share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_multi_setopt(multi_handle, CURLMOPT_MAXCONNECTS,
+                          static_cast<long>(MAX_CACHED_CONNECTIONS)); // NOLINT(runtime/int)
+    }
+
+    static curl_pool_t *instance;
+
+    CURLSH *share_handle;
+    CURLM *multi_handle;
+    std::vector<CURL *> idle_handles;
 };
+curl_pool_t *curl_pool_t::instance = NULL;
 
 // Used for adding headers, which cannot be freed until after the request is done
 class scoped_curl_slist_t {
@@ -116,6 +180,13 @@ public:
         return std::move(body_data);
     }
 
+    // Discards anything received by a failed attempt, and rewinds the data to send.
+    void reset_for_retry() {
+        send_data_offset = 0;
+        body_data.clear();
+        header_data.clear();
+    }
+
     scoped_curl_slist_t header;
 
 private:
@@ -182,8 +253,31 @@ http_job_t::http_job_t(extproc_pool_t *pool, signal_t *interruptor) :
 
 void http_job_t::http(const http_opts_t &opts,
                       http_result_t *res_out) {
+    std::vector<http_result_t> results;
+    run_requests(&opts, 1, 1, &results);
+    *res_out = std::move(results[0]);
+}
+
+void http_job_t::http_batch(const std::vector<http_opts_t> &opts,
+                            size_t max_concurrency,
+                            std::vector<http_result_t> *res_out) {
+    run_requests(opts.data(), opts.size(), max_concurrency, res_out);
+}
+
+void http_job_t::run_requests(const http_opts_t *opts,
+                              size_t num_requests,
+                              size_t max_concurrency,
+                              std::vector<http_result_t> *res_out) {
+    guarantee(max_concurrency > 0);
     write_message_t msg;
-    serialize<cluster_version_t::LATEST_OVERALL>(&msg, opts);
+    serialize<cluster_version_t::LATEST_OVERALL>(&msg,
+        static_cast<uint64_t>(max_concurrency));
+    // This matches the serialization format of a `std::vector<http_opts_t>`, which
+    // is what the worker reads.
+    serialize_varint_uint64(&msg, num_requests);
+    for (size_t i = 0; i < num_requests; ++i) {
+        serialize<cluster_version_t::LATEST_OVERALL>(&msg, opts[i]);
+    }
     {
         int res = send_write_message(extproc_job.write_stream(), &msg);
         if (res != 0) {
@@ -198,6 +292,9 @@ void http_job_t::http(const http_opts_t &opts,
         throw extproc_worker_exc_t(strprintf("failed to deserialize result from worker "
                                              "(%s)", archive_result_as_str(res)));
     }
+    if (res_out->size() != num_requests) {
+        throw extproc_worker_exc_t("wrong number of results from worker");
+    }
 }
 
 void http_job_t::worker_error() {
@@ -206,16 +303,22 @@ void http_job_t::worker_error() {
 
 bool http_job_t::worker_fn(read_stream_t *stream_in, write_stream_t *stream_out) {
     static bool curl_initialized(false);
-    http_opts_t opts;
+    uint64_t max_concurrency;
+    std::vector<http_opts_t> opts;
     {
         archive_result_t res
-            = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &opts);
+            = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in,
+                                                             &max_concurrency);
+        if (bad(res) || max_concurrency == 0) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &opts);
         if (bad(res)) { return false; }
     }
 
-    http_result_t result;
-    result.header = ql::datum_t::null();
-    result.body = ql::datum_t::null();
+    std::vector<http_result_t> results(opts.size());
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        it->header = ql::datum_t::null();
+        it->body = ql::datum_t::null();
+    }
 
     CURLcode curl_res = CURLE_OK;
     if (!curl_initialized) {
@@ -225,19 +328,25 @@ bool http_job_t::worker_fn(read_stream_t *stream_in, write_stream_t *stream_out)
 
     if (curl_res == CURLE_OK) {
         try {
-            perform_http(&opts, &result);
+            perform_http_batch(&opts, max_concurrency, &results);
         } catch (const std::exception &ex) {
-            result.error.assign(ex.what());
+            for (auto it = results.begin(); it != results.end(); ++it) {
+                it->error.assign(ex.what());
+            }
         } catch (...) {
-            result.error.assign("unknown error");
+            for (auto it = results.begin(); it != results.end(); ++it) {
+                it->error.assign("unknown error");
+            }
         }
     } else {
-        result.error.assign("global initialization");
+        for (auto it = results.begin(); it != results.end(); ++it) {
+            it->error.assign("global initialization");
+        }
         curl_initialized = false;
     }
 
     write_message_t msg;
-    serialize<cluster_version_t::LATEST_OVERALL>(&msg, result);
+    serialize<cluster_version_t::LATEST_OVERALL>(&msg, results);
     int res = send_write_message(stream_out, &msg);
     if (res != 0) { return false; }
 
@@ -534,64 +643,36 @@ void set_default_opts(CURL *curl_handle,
     }
 }
 
-// TODO: implement streaming API support
-void perform_http(http_opts_t *opts, http_result_t *res_out) {
-    scoped_curl_handle_t curl_handle;
-    curl_data_t curl_data;
-
-    if (curl_handle.get() == NULL) {
-        res_out->error.assign("initialization");
-        return;
-    }
-
-    set_default_opts(curl_handle.get(), opts->proxy, curl_data);
-    transfer_opts(opts, curl_handle.get(), &curl_data);
-
-    CURLcode curl_res = CURLE_OK;
-    long response_code = 0; // NOLINT(runtime/int)
-    for (uint64_t attempts = 0; attempts < opts->attempts; ++attempts) {
-        // Do the HTTP operation, then check for errors
-        curl_res = curl_easy_perform(curl_handle.get());
-
-        if (curl_res == CURLE_SEND_ERROR ||
-            curl_res == CURLE_RECV_ERROR ||
-            curl_res == CURLE_COULDNT_CONNECT) {
-            // Could be a temporary error, try again
-            continue;
-        } else if (curl_res != CURLE_OK) {
-            res_out->error.assign(curl_easy_strerror(curl_res));
-            return;
-        }
-
-        curl_res = curl_easy_getinfo(curl_handle.get(),
-                                     CURLINFO_RESPONSE_CODE,
-                                     &response_code);
-
-        // Break on success, retry on temporary error
-        if (curl_res != CURLE_OK ||
-            // Error codes that may be resolved by retrying
-            (response_code != 408 &&
-             response_code != 500 &&
-             response_code != 502 &&
-             response_code != 503 &&
-             response_code != 504)) {
-            break;
-        }
-    }
+std::string timeout_error(uint64_t timeout_ms) {
+    return strprintf("timed out after %" PRIu64 ".%03" PRIu64 " seconds",
+                     timeout_ms / 1000, timeout_ms % 1000);
+}
 
-    std::string body_data(curl_data.steal_body_data());
-    std::string header_data(curl_data.steal_header_data());
+// Turns the outcome of a transfer's last attempt into the result sent back to the
+// main process.
+void handle_http_response(http_opts_t *opts,
+                          CURL *curl_handle,
+                          curl_data_t *curl_data,
+                          CURLcode curl_res,
+                          http_result_t *res_out) {
+    std::string body_data(curl_data->steal_body_data());
+    std::string header_data(curl_data->steal_header_data());
     truncate_header_data(&header_data);
 
-    if (opts->attempts == 0) {
-        res_out->error.assign("could not perform, no attempts allowed");
-    } else if (curl_res == CURLE_SEND_ERROR) {
+    long response_code = 0; // NOLINT(runtime/int)
+    if (curl_res == CURLE_SEND_ERROR) {
         res_out->error.assign("error when sending data");
     } else if (curl_res == CURLE_RECV_ERROR) {
         res_out->error.assign("error when receiving data");
     } else if (curl_res == CURLE_COULDNT_CONNECT) {
         res_out->error.assign("could not connect to server");
+    } else if (curl_res == CURLE_OPERATION_TIMEDOUT) {
+        res_out->error = timeout_error(opts->timeout_ms);
     } else if (curl_res != CURLE_OK) {
+        res_out->error.assign(curl_easy_strerror(curl_res));
+    } else if ((curl_res = curl_easy_getinfo(curl_handle,
+                                             CURLINFO_RESPONSE_CODE,
+                                             &response_code)) != CURLE_OK) {
         res_out->error = strprintf("reading response code, '%s'",
                                    curl_easy_strerror(curl_res));
     } else if (response_code < 200 || response_code >= 300) {
@@ -604,7 +685,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
         res_out->error = strprintf("status code %ld", response_code);
     } else {
         parse_header(header_data, res_out);
-        save_cookies(curl_handle.get(), res_out);
+        save_cookies(curl_handle, res_out);
 
         // If this was a HEAD request, we should not be handling data, just return R_NULL
         // so the user knows the request succeeded
@@ -620,7 +701,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
             {
                 std::string content_type;
                 char *content_type_buffer = NULL;
-                curl_easy_getinfo(curl_handle.get(),
+                curl_easy_getinfo(curl_handle,
                                   CURLINFO_CONTENT_TYPE,
                                   &content_type_buffer);
 
@@ -684,6 +765,216 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
     }
 }
 
+// A single request from a batch, along with the state of its current attempt.
+class http_transfer_t {
+public:
+    http_transfer_t(http_opts_t *_opts, http_result_t *_res_out) :
+        opts(_opts), res_out(_res_out), curl_handle(NULL), attempts_made(0),
+        deadline(0) { }
+
+    http_opts_t *opts;
+    http_result_t *res_out;
+    CURL *curl_handle;
+    curl_data_t curl_data;
+    uint64_t attempts_made;
+    microtime_t deadline;
+
+private:
+    DISABLE_COPYING(http_transfer_t);
+};
+
+// Runs the requests of a batch through the shared multi handle, with at most
+// `max_concurrency` of them in flight at once.  Any transfer still active when
+// this is destroyed (because of an error) is detached from the multi handle, so
+// it doesn't leak into the next job serviced by this worker.
+class http_batch_t {
+public:
+    http_batch_t(curl_pool_t *_pool, size_t _max_concurrency) :
+        pool(_pool), max_concurrency(_max_concurrency) { }
+
+    ~http_batch_t() {
+        for (auto it = active.begin(); it != active.end(); ++it) {
+            curl_multi_remove_handle(pool->multi(), it->first);
+            curl_easy_cleanup(it->first);
+        }
+    }
+
+    void run(std::vector<http_opts_t> *opts, std::vector<http_result_t> *results_out);
+
+private:
+    // Starts the first attempt of a transfer; errors are stored in its result.
+    void start(http_transfer_t *transfer);
+    // Adds the transfer to the multi handle for another attempt.  Returns false
+    // (having filled in the result) if the transfer is out of time.
+    bool add_attempt(http_transfer_t *transfer);
+    bool should_retry(http_transfer_t *transfer, CURLcode curl_res);
+    void finish(http_transfer_t *transfer, CURLcode curl_res);
+
+    curl_pool_t *pool;
+    size_t max_concurrency;
+    std::map<CURL *, http_transfer_t *> active;
+};
+
+void http_batch_t::run(std::vector<http_opts_t> *opts,
+                       std::vector<http_result_t> *results_out) {
+    guarantee(opts->size() == results_out->size());
+    std::vector<scoped_ptr_t<http_transfer_t> > transfers;
+    transfers.reserve(opts->size());
+    for (size_t i = 0; i < opts->size(); ++i) {
+        transfers.push_back(make_scoped<http_transfer_t>(&(*opts)[i],
+                                                         &(*results_out)[i]));
+    }
+
+    size_t next_transfer = 0;
+    while (next_transfer < transfers.size() || !active.empty()) {
+        while (next_transfer < transfers.size() && active.size() < max_concurrency) {
+            start(transfers[next_transfer].get());
+            ++next_transfer;
+        }
+
+        if (active.empty()) {
+            continue;
+        }
+
+        int still_running;
+        CURLMcode multi_res = curl_multi_perform(pool->multi(), &still_running);
+        if (multi_res != CURLM_OK) {
+            throw curl_exc_t(strprintf("perform, '%s'", curl_multi_strerror(multi_res)));
+        }
+
+        int msgs_left;
+        CURLMsg *msg;
+        while ((msg = curl_multi_info_read(pool->multi(), &msgs_left)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *curl_handle = msg->easy_handle;
+            CURLcode curl_res = msg->data.result;
+            auto it = active.find(curl_handle);
+            guarantee(it != active.end());
+            http_transfer_t *transfer = it->second;
+            curl_multi_remove_handle(pool->multi(), curl_handle);
+            active.erase(it);
+
+            if (should_retry(transfer, curl_res)) {
+                transfer->curl_data.reset_for_retry();
+                // Like in `start`, a failure to add the attempt is this transfer's
+                // error, and its handle goes back to the pool below.
+                try {
+                    if (add_attempt(transfer)) {
+                        continue;
+                    }
+                } catch (const std::exception &ex) {
+                    transfer->res_out->error.assign(ex.what());
+                }
+            } else {
+                finish(transfer, curl_res);
+            }
+            pool->release(transfer->curl_handle);
+            transfer->curl_handle = NULL;
+        }
+
+        if (!active.empty()) {
+            multi_res = curl_multi_wait(pool->multi(), NULL, 0, 100, NULL);
+            if (multi_res != CURLM_OK) {
+                throw curl_exc_t(strprintf("wait, '%s'", curl_multi_strerror(multi_res)));
+            }
+        }
+    }
+}
+
+void http_batch_t::start(http_transfer_t *transfer) {
+    if (transfer->opts->attempts == 0) {
+        transfer->res_out->error.assign("could not perform, no attempts allowed");
+        return;
+    }
+
+    // The timeout starts once the request leaves the queue
+    transfer->deadline = current_microtime() + transfer->opts->timeout_ms * 1000;
+
+    try {
+        transfer->curl_handle = pool->acquire();
+        set_default_opts(transfer->curl_handle, transfer->opts->proxy,
+                         transfer->curl_data);
+        transfer_opts(transfer->opts, transfer->curl_handle, &transfer->curl_data);
+        if (add_attempt(transfer)) {
+            return;
+        }
+    } catch (const std::exception &ex) {
+        transfer->res_out->error.assign(ex.what());
+    }
+
+    if (transfer->curl_handle != NULL) {
+        pool->release(transfer->curl_handle);
+        transfer->curl_handle = NULL;
+    }
+}
+
+bool http_batch_t::add_attempt(http_transfer_t *transfer) {
+    microtime_t now = current_microtime();
+    if (now >= transfer->deadline) {
+        transfer->res_out->error = timeout_error(transfer->opts->timeout_ms);
+        return false;
+    }
+
+    // The timeout covers all attempts, so each one only gets what is left of it
+    long remaining_ms = (transfer->deadline - now + 999) / 1000; // NOLINT(runtime/int)
+    exc_setopt(transfer->curl_handle, CURLOPT_TIMEOUT_MS, remaining_ms, "TIMEOUT");
+
+    CURLMcode multi_res = curl_multi_add_handle(pool->multi(), transfer->curl_handle);
+    if (multi_res != CURLM_OK) {
+        throw curl_exc_t(strprintf("add handle, '%s'", curl_multi_strerror(multi_res)));
+    }
+    active[transfer->curl_handle] = transfer;
+    ++transfer->attempts_made;
+    return true;
+}
+
+bool http_batch_t::should_retry(http_transfer_t *transfer, CURLcode curl_res) {
+    if (transfer->attempts_made >= transfer->opts->attempts) {
+        return false;
+    }
+
+    if (curl_res == CURLE_SEND_ERROR ||
+        curl_res == CURLE_RECV_ERROR ||
+        curl_res == CURLE_COULDNT_CONNECT) {
+        // Could be a temporary error, try again
+        return true;
+    } else if (curl_res != CURLE_OK) {
+        return false;
+    }
+
+    long response_code = 0; // NOLINT(runtime/int)
+    curl_res = curl_easy_getinfo(transfer->curl_handle,
+                                 CURLINFO_RESPONSE_CODE,
+                                 &response_code);
+
+    // Error codes that may be resolved by retrying
+    return curl_res == CURLE_OK &&
+        (response_code == 408 ||
+         response_code == 500 ||
+         response_code == 502 ||
+         response_code == 503 ||
+         response_code == 504);
+}
+
+void http_batch_t::finish(http_transfer_t *transfer, CURLcode curl_res) {
+    try {
+        handle_http_response(transfer->opts, transfer->curl_handle,
+                             &transfer->curl_data, curl_res, transfer->res_out);
+    } catch (const std::exception &ex) {
+        transfer->res_out->error.assign(ex.what());
+    }
+}
+
+// TODO: implement streaming API support
+void perform_http_batch(std::vector<http_opts_t> *opts,
+                        size_t max_concurrency,
+                        std::vector<http_result_t> *results_out) {
+    http_batch_t batch(curl_pool_t::get(), max_concurrency);
+    batch.run(opts, results_out);
+}
+
 class header_parser_singleton_t {
 public:
     static ql::datum_t parse(const std::string &header);
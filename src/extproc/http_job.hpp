@@ -2,6 +2,8 @@
 #ifndef EXTPROC_HTTP_JOB_HPP_
 #define EXTPROC_HTTP_JOB_HPP_
 
+#include <vector>
+
 #include "errors.hpp"
 
 #include "extproc/extproc_pool.hpp"
@@ -16,10 +18,22 @@ public:
 
     void http(const http_opts_t &opts, http_result_t *res_out);
 
+    // Performs all the requests in a single round trip to the worker, which runs
+    // up to `max_concurrency` of them at a time.  `res_out` gets one result per
+    // request, in the same order as `opts`.
+    void http_batch(const std::vector<http_opts_t> &opts,
+                    size_t max_concurrency,
+                    std::vector<http_result_t> *res_out);
+
     // Marks the extproc worker as errored to simplify cleanup later
     void worker_error();
 
 private:
+    void run_requests(const http_opts_t *opts,
+                      size_t num_requests,
+                      size_t max_concurrency,
+                      std::vector<http_result_t> *res_out);
+
     static bool worker_fn(read_stream_t *stream_in, write_stream_t *stream_out);
 
     extproc_job_t extproc_job;
@@ -97,3 +97,41 @@ void http_runner_t::http(const http_opts_t &opts,
         throw;
     }
 }
+
+void http_runner_t::http_batch(const std::vector<http_opts_t> &opts,
+                               std::vector<http_result_t> *res_out,
+                               signal_t *interruptor) {
+    // The worker times out each request on its own, this is only a backstop in
+    // case the worker hangs.  Allow for every request running one after another.
+    uint64_t total_timeout_ms = 0;
+    for (auto it = opts.begin(); it != opts.end(); ++it) {
+        total_timeout_ms += it->timeout_ms;
+    }
+
+    signal_timer_t timeout;
+    wait_any_t combined_interruptor(interruptor, &timeout);
+    http_job_t job(pool, &combined_interruptor);
+
+    assert_thread();
+    timeout.start(total_timeout_ms);
+
+    try {
+        job.http_batch(opts, HTTP_BATCH_MAX_CONCURRENCY, res_out);
+    } catch (const interrupted_exc_t &ex) {
+        if (!timeout.is_pulsed()) {
+            throw;
+        }
+        res_out->clear();
+        res_out->resize(opts.size());
+        for (size_t i = 0; i < opts.size(); ++i) {
+            (*res_out)[i].error =
+                strprintf("timed out after %" PRIu64 ".%03" PRIu64 " seconds",
+                          opts[i].timeout_ms / 1000, opts[i].timeout_ms % 1000);
+        }
+    } catch (...) {
+        // This will mark the worker as errored so we don't try to re-sync with it
+        //  on the next line (since we're in a catch statement, we aren't allowed)
+        job.worker_error();
+        throw;
+    }
+}
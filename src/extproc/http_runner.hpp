@@ -123,6 +123,9 @@ RDB_DECLARE_SERIALIZABLE(http_opts_t);
 RDB_DECLARE_SERIALIZABLE(http_opts_t::http_auth_t);
 
 
+// The number of requests from a single batch that a worker runs at once.
+const size_t HTTP_BATCH_MAX_CONCURRENCY = 8;
+
 // A handle to a running "HTTP fetcher" job.
 class http_runner_t : public home_thread_mixin_t {
 public:
@@ -132,6 +135,13 @@ public:
               http_result_t *res_out,
               signal_t *interruptor);
 
+    // Sends all the requests to one worker, which performs up to
+    // `HTTP_BATCH_MAX_CONCURRENCY` of them concurrently.  Each request's timeout is
+    // enforced by the worker; `res_out` gets one result per request, in order.
+    void http_batch(const std::vector<http_opts_t> &opts,
+                    std::vector<http_result_t> *res_out,
+                    signal_t *interruptor);
+
 private:
     extproc_pool_t *pool;
 
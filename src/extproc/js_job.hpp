@@ -24,6 +24,14 @@ public:
 
     js_result_t eval(const std::string &source);
     js_result_t call(js_id_t id, const std::vector<ql::datum_t> &args);
+
+    // Sends one request asking the worker to call `id` once for each element of
+    // `args_list`.  The worker replies with one result per row, in order, as soon
+    // as each row finishes; they must be collected with `read_call_result`.
+    void send_call_batch(js_id_t id,
+                         const std::vector<std::vector<ql::datum_t> > &args_list);
+    js_result_t read_call_result();
+
     void release(js_id_t id);
     void exit();
 
@@ -219,6 +219,68 @@ js_result_t js_runner_t::call(const std::string &source,
     return result;
 }
 
+std::vector<js_result_t> js_runner_t::call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_list,
+        const req_config_t &config) {
+    assert_thread();
+    guarantee(job_data.has());
+
+    std::vector<js_result_t> results;
+    if (args_list.empty()) {
+        return results;
+    }
+
+    // This will retrieve the function from the cache if it's there, or re-eval it
+    js_result_t fn_result = eval(source, config);
+    js_id_t *fn_id = boost::get<js_id_t>(&fn_result);
+    guarantee(fn_id != NULL);
+
+    results.reserve(args_list.size());
+    bool is_timeout = false;
+    try {
+        object_buffer_t<js_timeout_t::sentry_t> sentry;
+        try {
+            job_data->js_job.send_call_batch(*fn_id, args_list);
+            for (size_t i = 0; i < args_list.size(); ++i) {
+                // Restart the timer for every row, since the worker sends each
+                // row's result back as soon as it has it.
+                sentry.create(&job_data->js_timeout, config.timeout_ms);
+                results.push_back(job_data->js_job.read_call_result());
+                sentry.reset();
+            }
+        } catch (...) {
+            // This inner try-catch block deals with cleanup after an exception, but due
+            // to this we must store whether we triggered the timeout signal.
+            is_timeout = job_data->js_timeout.get_signal()->is_pulsed();
+
+            // Sentry must be destroyed before the js_timeout
+            sentry.reset();
+            // This will mark the worker as errored so we don't try to re-sync with it
+            //  on the next line (since we're in a catch statement, we aren't allowed)
+            job_data->js_job.worker_error();
+            job_data.reset();
+
+            throw;
+        }
+    } catch (interrupted_exc_t const &e) {
+        // This outer try-catch block explicitly checks whether it was an
+        // `interrupted_exc_t`, and if so deals with the timeout if set.
+        if (is_timeout) {
+            results.push_back(strprintf(
+                "JavaScript query `%s` timed out after %" PRIu64 ".%03" PRIu64 " seconds.",
+                source.c_str(), config.timeout_ms / 1000, config.timeout_ms % 1000));
+            return results;
+        } else {
+            throw;
+        }
+    }
+
+    // Unlike `call`, we don't cache function ids returned by individual rows;
+    // `js_func_t` rejects them anyway.
+    return results;
+}
+
 void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     guarantee(job_data.has());
     guarantee(id != INVALID_ID);
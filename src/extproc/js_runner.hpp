@@ -58,6 +58,15 @@ public:
                      const std::vector<ql::datum_t> &args,
                      const req_config_t &config);
 
+    // Calls a previously compiled function once for each element of `args_list`,
+    // sending the whole batch to the worker process in a single request.  The
+    // timeout applies to each row separately.  If a row times out, its result is
+    // the timeout error and no results are returned for the rows after it.
+    std::vector<js_result_t> call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_list,
+        const req_config_t &config);
+
 private:
     static const size_t CACHE_SIZE;
 
@@ -0,0 +1,104 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "perfmon/latency_histogram.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+const int latency_histogram_t::SUB_BUCKET_BITS;
+const uint64_t latency_histogram_t::SUB_BUCKETS;
+const int latency_histogram_t::MAX_VALUE_BITS;
+const size_t latency_histogram_t::NUM_BUCKETS;
+
+size_t latency_histogram_t::bucket_for_value(uint64_t usecs) {
+    if (usecs < SUB_BUCKETS) {
+        return usecs;
+    }
+    if (usecs >= (static_cast<uint64_t>(1) << MAX_VALUE_BITS)) {
+        return NUM_BUCKETS - 1;
+    }
+    const int msb = 63 - __builtin_clzll(usecs);
+    const int shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((usecs >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t latency_histogram_t::bucket_max_value(size_t bucket) {
+    rassert(bucket < NUM_BUCKETS);
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    const int shift = bucket / SUB_BUCKETS - 1;
+    const uint64_t sub_bucket = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+void latency_histogram_t::add(size_t bucket, uint64_t n) {
+    rassert(bucket < NUM_BUCKETS);
+    if (buckets.empty()) {
+        buckets.resize(NUM_BUCKETS, 0);
+    }
+    buckets[bucket] += n;
+    total += n;
+}
+
+void latency_histogram_t::record(uint64_t usecs) {
+    add(bucket_for_value(usecs), 1);
+}
+
+void latency_histogram_t::merge(const latency_histogram_t &other) {
+    if (other.total == 0) {
+        return;
+    }
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        if (other.buckets[i] != 0) {
+            add(i, other.buckets[i]);
+        }
+    }
+}
+
+void latency_histogram_t::clear() {
+    if (total != 0) {
+        std::fill(buckets.begin(), buckets.end(), 0);
+        total = 0;
+    }
+}
+
+uint64_t latency_histogram_t::percentile(double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, ceil(q * total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_max_value(i);
+        }
+    }
+    unreachable();
+}
+
+ql::datum_t latency_histogram_t::buckets_to_datum() const {
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] != 0) {
+            builder.add(ql::datum_t(std::vector<ql::datum_t>{
+                    ql::datum_t(static_cast<double>(i)),
+                    ql::datum_t(static_cast<double>(buckets[i]))},
+                ql::configured_limits_t::unlimited));
+        }
+    }
+    return std::move(builder).to_datum();
+}
+
+void latency_histogram_t::merge_buckets_datum(const ql::datum_t &datum) {
+    r_sanity_check(datum.get_type() == ql::datum_t::R_ARRAY);
+    for (size_t i = 0; i < datum.arr_size(); ++i) {
+        ql::datum_t pair = datum.get(i);
+        r_sanity_check(pair.get_type() == ql::datum_t::R_ARRAY && pair.arr_size() == 2);
+        const double bucket = pair.get(0).as_num();
+        const double n = pair.get(1).as_num();
+        r_sanity_check(bucket >= 0 && bucket < NUM_BUCKETS && n >= 0);
+        add(static_cast<size_t>(bucket), static_cast<uint64_t>(n));
+    }
+}
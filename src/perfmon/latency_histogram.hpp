@@ -0,0 +1,54 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef PERFMON_LATENCY_HISTOGRAM_HPP_
+#define PERFMON_LATENCY_HISTOGRAM_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+
+/* `latency_histogram_t` counts durations (in microseconds) in logarithmic buckets, in
+ * the style of HdrHistogram: every power of two is split into `SUB_BUCKETS` linear
+ * sub-buckets, so a percentile read from it is off by at most 1/SUB_BUCKETS of the
+ * true value. Histograms are merged by adding up their buckets, which unlike averages
+ * or percentiles is exact, so we can combine histograms from different threads,
+ * shards and servers. */
+class latency_histogram_t {
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // Durations of 2^MAX_VALUE_BITS microseconds (a bit over an hour) or more all end
+    // up in the last bucket.
+    static const int MAX_VALUE_BITS = 32;
+    static const size_t NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    latency_histogram_t() : total(0) { }
+
+    void record(uint64_t usecs);
+    void merge(const latency_histogram_t &other);
+    void clear();
+
+    uint64_t count() const { return total; }
+    // Returns the largest duration (in microseconds) that falls into the same bucket as
+    // the value at quantile `q`, or 0 if the histogram is empty.
+    uint64_t percentile(double q) const;
+
+    // Only the non-empty buckets are included, as `[bucket, count]` pairs.
+    ql::datum_t buckets_to_datum() const;
+    // Adds the buckets produced by `buckets_to_datum()` to this histogram.
+    void merge_buckets_datum(const ql::datum_t &datum);
+
+    static size_t bucket_for_value(uint64_t usecs);
+    static uint64_t bucket_max_value(size_t bucket);
+
+private:
+    void add(size_t bucket, uint64_t count);
+
+    // Empty until the first value is recorded, because most histograms on most threads
+    // never see any values.
+    std::vector<uint64_t> buckets;
+    uint64_t total;
+};
+
+#endif  // PERFMON_LATENCY_HISTOGRAM_HPP_
@@ -301,6 +301,141 @@ ql::datum_t perfmon_rate_monitor_t::output_stat(const double &stat) {
     return ql::datum_t(stat / ticks_to_secs(length));
 }
 
+/* perfmon_thread_max_t */
+
+perfmon_thread_max_t::perfmon_thread_max_t(ticks_t _length)
+    : perfmon_perthread_t<double, std::vector<double> >(), length(_length)
+{
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread_data[i].value.current_interval = get_ticks() / length;
+    }
+}
+
+void perfmon_thread_max_t::update(ticks_t now) {
+    int interval = now / length;
+    rassert(get_thread_id().threadnum >= 0);
+    thread_info_t &thread = thread_data[get_thread_id().threadnum].value;
+
+    if (thread.current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread.current_interval + 1 == interval) {
+        /* We're one step behind */
+        thread.last_max = thread.current_max;
+        thread.current_max = 0;
+        thread.current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread.last_max = thread.current_max = 0;
+        thread.current_interval = interval;
+    }
+}
+
+void perfmon_thread_max_t::record(double value, ticks_t now) {
+    update(now);
+    thread_info_t &thread = thread_data[get_thread_id().threadnum].value;
+    thread.current_max = std::max(thread.current_max, value);
+}
+
+void perfmon_thread_max_t::get_thread_stat(double *stat) {
+    update(get_ticks());
+    /* Unlike `perfmon_sampler_t` we include the current interval, so that a thread
+    that is stuck right now shows up without waiting for the interval to end. */
+    thread_info_t &thread = thread_data[get_thread_id().threadnum].value;
+    *stat = std::max(thread.current_max, thread.last_max);
+}
+
+std::vector<double> perfmon_thread_max_t::combine_stats(const double *stats) {
+    return std::vector<double>(stats, stats + get_num_threads());
+}
+
+ql::datum_t perfmon_thread_max_t::output_stat(const std::vector<double> &stats) {
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (double v : stats) {
+        builder.add(ql::datum_t(v));
+    }
+    return std::move(builder).to_datum();
+}
+
+/* perfmon_latency_histogram_t */
+
+perfmon_latency_histogram_t::perfmon_latency_histogram_t(ticks_t _length)
+    : perfmon_perthread_t<latency_histogram_t>(), length(_length)
+{
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread_data[i].value.current_interval = get_ticks() / length;
+    }
+}
+
+void perfmon_latency_histogram_t::update(ticks_t now) {
+    int interval = now / length;
+    rassert(get_thread_id().threadnum >= 0);
+    thread_info_t &thread = thread_data[get_thread_id().threadnum].value;
+
+    if (thread.current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread.current_interval + 1 == interval) {
+        /* We're one step behind */
+        std::swap(thread.last, thread.current);
+        thread.current.clear();
+        thread.current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread.last.clear();
+        thread.current.clear();
+        thread.current_interval = interval;
+    }
+}
+
+void perfmon_latency_histogram_t::record(uint64_t usecs) {
+    update(get_ticks());
+    thread_data[get_thread_id().threadnum].value.current.record(usecs);
+}
+
+void perfmon_latency_histogram_t::record_since(ticks_t start) {
+    ticks_t now = get_ticks();
+    update(now);
+    uint64_t usecs = now > start ? (now - start) / 1000 : 0;
+    thread_data[get_thread_id().threadnum].value.current.record(usecs);
+}
+
+void perfmon_latency_histogram_t::get_thread_stat(latency_histogram_t *stat) {
+    update(get_ticks());
+    /* Like `perfmon_thread_max_t` we include the current interval, because tail
+    latencies need a lot of samples to mean anything. */
+    thread_info_t &thread = thread_data[get_thread_id().threadnum].value;
+    *stat = thread.last;
+    stat->merge(thread.current);
+}
+
+latency_histogram_t perfmon_latency_histogram_t::combine_stats(
+        const latency_histogram_t *stats) {
+    latency_histogram_t combined;
+    for (int i = 0; i < get_num_threads(); i++) {
+        combined.merge(stats[i]);
+    }
+    return combined;
+}
+
+ql::datum_t perfmon_latency_histogram_t::percentiles_to_datum(
+        const latency_histogram_t &histogram) {
+    ql::datum_object_builder_t builder;
+    const std::pair<const char *, double> percentiles[] = {
+        {"p50", 0.5}, {"p99", 0.99}, {"p999", 0.999} };
+    for (const auto &p : percentiles) {
+        builder.overwrite(p.first, histogram.count() == 0
+            ? ql::datum_t::null()
+            : ql::datum_t(histogram.percentile(p.second) / 1000.0));
+    }
+    return std::move(builder).to_datum();
+}
+
+ql::datum_t perfmon_latency_histogram_t::output_stat(const latency_histogram_t &stat) {
+    ql::datum_object_builder_t builder(percentiles_to_datum(stat));
+    builder.overwrite(stat_count, ql::datum_t(static_cast<double>(stat.count())));
+    builder.overwrite("buckets", stat.buckets_to_datum());
+    return std::move(builder).to_datum();
+}
+
 perfmon_duration_sampler_t::perfmon_duration_sampler_t(ticks_t length, bool _ignore_global_full_perfmon)
     : stat(), active(), total(), recent(length, true),
       active_membership(&stat, &active, "active_count"),
@@ -13,11 +13,13 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "concurrency/cache_line_padded.hpp"
 #include "config/args.hpp"
 #include "perfmon/types.hpp"
 #include "perfmon/core.hpp"
+#include "perfmon/latency_histogram.hpp"
 #include "time.hpp"
 
 // Some arch/runtime declarations.
@@ -215,6 +217,67 @@ public:
     void record(double value = 1.0);
 };
 
+/* `perfmon_thread_max_t` keeps track of the largest value recorded on each thread
+ * over the last `length` ticks. Unlike the other perfmons it doesn't combine the
+ * threads' values, but reports them as an array indexed by thread number, because
+ * it's meant for finding out which thread something bad is happening on.
+ */
+class perfmon_thread_max_t : public perfmon_perthread_t<double, std::vector<double> > {
+private:
+    struct thread_info_t {
+        double current_max, last_max;
+        int current_interval;
+
+        thread_info_t() : current_max(0), last_max(0), current_interval(0) { }
+    };
+
+    cache_line_padded_t<thread_info_t> thread_data[MAX_THREADS];
+    void update(ticks_t now);
+    ticks_t length;
+
+    void get_thread_stat(double *);
+    std::vector<double> combine_stats(const double *);
+    ql::datum_t output_stat(const std::vector<double> &);
+public:
+    explicit perfmon_thread_max_t(ticks_t length);
+    // `now` must be the current value of `get_ticks()`. Callers on hot paths usually
+    // have it at hand already, so we don't read the clock again here.
+    void record(double value, ticks_t now);
+};
+
+/* `perfmon_latency_histogram_t` records durations into a `latency_histogram_t` per
+ * thread and reports the count and the 50th, 99th and 99.9th percentiles (in
+ * milliseconds) over the last one to two `length` intervals. Recording a value only
+ * touches the calling thread's histogram, so it doesn't need any locks; the threads'
+ * histograms are only merged when the stats are read. It also reports the raw buckets,
+ * so that whoever reads the stats can merge histograms from several sources. */
+class perfmon_latency_histogram_t : public perfmon_perthread_t<latency_histogram_t> {
+private:
+    struct thread_info_t {
+        latency_histogram_t current, last;
+        int current_interval;
+
+        thread_info_t() : current_interval(0) { }
+    };
+
+    cache_line_padded_t<thread_info_t> thread_data[MAX_THREADS];
+    void update(ticks_t now);
+    ticks_t length;
+
+    void get_thread_stat(latency_histogram_t *);
+    latency_histogram_t combine_stats(const latency_histogram_t *);
+    ql::datum_t output_stat(const latency_histogram_t &);
+public:
+    explicit perfmon_latency_histogram_t(ticks_t length);
+    // `start` is the value of `get_ticks()` when the operation started.
+    void record_since(ticks_t start);
+    void record(uint64_t usecs);
+
+    // Returns an object with the percentiles we report (in milliseconds), which are
+    // `null` if `histogram` is empty.
+    static ql::datum_t percentiles_to_datum(const latency_histogram_t &histogram);
+};
+
 /* perfmon_duration_sampler_t is a perfmon_t that monitors events that have a
  * starting and ending time. When something starts, call begin(); when
  * something ends, call end() with the same value as begin. It will produce
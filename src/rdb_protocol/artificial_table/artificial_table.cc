@@ -2,6 +2,7 @@
 #include "rdb_protocol/artificial_table/artificial_table.hpp"
 
 #include "rdb_protocol/artificial_table/backend.hpp"
+#include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/table_common.hpp"
@@ -78,6 +79,22 @@ counted_t<ql::datum_stream_t> artificial_table_t::read_all(
     return stream;
 }
 
+counted_t<ql::datum_stream_t> artificial_table_t::read_all_keys(
+        ql::env_t *env,
+        const std::string &sindex,
+        ql::backtrace_id_t bt,
+        const std::string &table_name,
+        const std::vector<ql::datum_t> &keys,
+        read_mode_t read_mode) {
+    std::vector<counted_t<ql::datum_stream_t> > streams;
+    for (const auto &key : keys) {
+        streams.push_back(read_all(env, sindex, bt, table_name,
+                                   ql::datum_range_t(key), sorting_t::UNORDERED,
+                                   read_mode));
+    }
+    return make_counted<ql::union_datum_stream_t>(env, std::move(streams), bt);
+}
+
 counted_t<ql::datum_stream_t> artificial_table_t::read_changes(
     ql::env_t *env,
     counted_t<ql::datum_stream_t> maybe_src,
@@ -1,10 +1,13 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/btree.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
+#include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "errors.hpp"
@@ -12,6 +15,7 @@
 
 #include "btree/concurrent_traversal.hpp"
 #include "btree/get_distribution.hpp"
+#include "btree/internal_node.hpp"
 #include "btree/operations.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/reql_specific.hpp"
@@ -88,9 +92,43 @@ void detach_rdb_value(buf_parent_t parent, const void *value) {
     blob.detach_subtrees(parent);
 }
 
+store_key_t sindex_key_filter_key(
+        const ql::datum_t &value, ql::skey_version_t skey_version) {
+    std::string res = key_to_unescaped_str(
+        value.truncated_secondary(skey_version, ql::extrema_ok_t::NOT_OK));
+    // Index keys have a terminating null byte after the secondary part, unless it was
+    // truncated.
+    if (skey_version == ql::skey_version_t::post_1_16
+        && res.size() < ql::datum_t::max_trunc_size(skey_version)) {
+        res.push_back('\0');
+    }
+    return store_key_t(res);
+}
+
+store_key_t sindex_key_filter_key(const store_key_t &sindex_key) {
+    return store_key_t(ql::datum_t::extract_truncated_secondary(
+        key_to_unescaped_str(sindex_key)));
+}
+
+/* Writes insert their keys into the key filter before they release the superblock, so
+we wait for the superblock before we ask the filter. */
+static bool key_filter_may_contain(btree_slice_t *slice,
+                                   superblock_t *superblock,
+                                   const store_key_t &key) {
+    // This waits until we hold the superblock.
+    superblock->get_root_block_id();
+    return slice->key_filter.may_contain(key.btree_key());
+}
+
 void rdb_get(const store_key_t &store_key, btree_slice_t *slice,
              superblock_t *superblock, point_read_response_t *response,
              profile::trace_t *trace) {
+    if (!key_filter_may_contain(slice, superblock, store_key)) {
+        superblock->release();
+        response->data = ql::datum_t::null();
+        return;
+    }
+
     keyvalue_location_t kv_location;
     rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
     find_keyvalue_location_for_read(&sizer, superblock,
@@ -221,6 +259,8 @@ batched_replace_response_t rdb_replace_and_return_superblock(
     const store_key_t &key = *info.key;
 
     try {
+        // Deletions are inserted too, which costs us nothing but a false positive.
+        info.btree->slice->key_filter.insert(info.key->btree_key());
         keyvalue_location_t kv_location;
         rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size());
         find_keyvalue_location_for_write(&sizer, info.superblock,
@@ -449,6 +489,7 @@ void rdb_set(const store_key_t &key,
              rdb_modification_info_t *mod_info,
              profile::trace_t *trace,
              promise_t<superblock_t *> *pass_back_superblock) {
+    slice->key_filter.insert(key.btree_key());
     keyvalue_location_t kv_location;
     rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
     find_keyvalue_location_for_write(&sizer, superblock, key.btree_key(), timestamp,
@@ -513,6 +554,25 @@ void rdb_delete(const store_key_t &key, btree_slice_t *slice,
     response->result = (exists ? point_delete_result_t::DELETED : point_delete_result_t::MISSING);
 }
 
+void rdb_set_recency(const store_key_t &key,
+                     repli_timestamp_t timestamp,
+                     superblock_t *superblock,
+                     const deletion_context_t *deletion_context,
+                     promise_t<superblock_t *> *pass_back_superblock) {
+    keyvalue_location_t kv_location;
+    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+    find_keyvalue_location_for_write(&sizer, superblock, key.btree_key(), timestamp,
+            deletion_context->balancing_detacher(), &kv_location, nullptr,
+            pass_back_superblock);
+    if (kv_location.value.has()) {
+        /* Writing back the same value only rewrites its blob reference in the leaf
+        node, together with the new timestamp. */
+        null_key_modification_callback_t null_cb;
+        apply_keyvalue_change(&sizer, &kv_location, key.btree_key(), timestamp,
+            deletion_context->balancing_detacher(), &null_cb);
+    }
+}
+
 void rdb_value_deleter_t::delete_value(buf_parent_t parent, const void *value) const {
     // To not destroy constness, we operate on a copy of the value
     rdb_value_sizer_t sizer(parent.cache()->max_block_size());
@@ -534,12 +594,16 @@ public:
                        reql_version_t wire_func_reql_version,
                        ql::map_wire_func_t wire_func, sindex_multi_bool_t _multi)
         : pkey_range(_pkey_range), range(_range),
+          inner_range(range.to_inner_sindex_keyrange(
+              ql::skey_version_from_reql_version(wire_func_reql_version))),
           func_reql_version(wire_func_reql_version),
           func(wire_func.compile_wire_func()), multi(_multi) { }
 private:
     friend class rget_cb_t;
     const key_range_t pkey_range;
     const ql::datum_range_t range;
+    // Entries with keys in here are in `range` without evaluating `func`.
+    const key_range_t inner_range;
     const reql_version_t func_reql_version;
     const counted_t<const ql::func_t> func;
     const sindex_multi_bool_t multi;
@@ -595,16 +659,45 @@ public:
               boost::optional<rget_sindex_data_t> &&_sindex,
               const key_range_t &range);
 
+    virtual void handle_pre_leaf(
+        const counted_t<counted_buf_lock_and_read_t> &buf,
+        const btree_key_t *left_excl_or_null,
+        const btree_key_t *right_incl,
+        bool *skip_out);
     virtual continue_bool_t handle_pair(
         scoped_key_value_t &&keyvalue,
         concurrent_traversal_fifo_enforcer_signal_t waiter)
         THROWS_ONLY(interrupted_exc_t);
     void finish() THROWS_ONLY(interrupted_exc_t);
+
+    // Used by `get_all` reads, which run the same callback over several ranges.  If
+    // `keys` is set, only rows whose secondary index value is in it are read, and each
+    // is read as many times as its key appears.  Primary key ranges hold a single key.
+    void set_get_all_keys(const std::map<ql::datum_t, uint64_t> *keys) {
+        get_all_keys = keys;
+    }
+    // True once the batch is full or there was an error.
+    bool is_done() const {
+        return bad_init
+            || boost::get<ql::exc_t>(&io.response->result) != NULL
+            || job.accumulator->should_send_batch();
+    }
 private:
+    uint64_t get_all_copies(const ql::datum_t &sindex_val) const;
+    bool counts_key_only(const btree_key_t *key) const;
+
     const rget_io_data_t io; // How do get data in/out.
     job_data_t job; // What to do next (stateful).
     const boost::optional<rget_sindex_data_t> sindex; // Optional sindex information.
 
+    // True if every row just increments a `count`, so that we can count whole leaves
+    // in `handle_pre_leaf()` rather than visiting each key in `handle_pair()`. On a
+    // secondary index that only works for keys that are certainly in range, see
+    // `counts_key_only()`.
+    const bool count_leaves;
+
+    const std::map<ql::datum_t, uint64_t> *get_all_keys;
+
     // State for internal bookkeeping.
     bool bad_init;
     scoped_ptr_t<profile::disabler_t> disabler;
@@ -618,6 +711,9 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
     : io(std::move(_io)),
       job(std::move(_job)),
       sindex(std::move(_sindex)),
+      count_leaves(job.transformers.empty()
+                   && job.accumulator->accepts_row_counts()),
+      get_all_keys(nullptr),
       bad_init(false) {
     io.response->last_key = !reversed(job.sorting)
         ? range.left
@@ -634,6 +730,91 @@ void rget_cb_t::finish() THROWS_ONLY(interrupted_exc_t) {
     }
 }
 
+// Returns how many times a row should be read, or zero if it isn't one of the keys of
+// a `get_all` read.
+uint64_t rget_cb_t::get_all_copies(const ql::datum_t &sindex_val) const {
+    if (get_all_keys == nullptr) {
+        return 1;
+    }
+    if (!sindex) {
+        guarantee(get_all_keys->size() == 1);
+        return get_all_keys->begin()->second;
+    }
+    auto it = get_all_keys->find(sindex_val);
+    return it == get_all_keys->end() ? 0 : it->second;
+}
+
+// Returns true if the row for `key` can be counted without loading it.  On a secondary
+// index, we'd normally evaluate the index function on the row to find out whether it's
+// in range, since its key may have been truncated.
+bool rget_cb_t::counts_key_only(const btree_key_t *key) const {
+    if (!count_leaves) {
+        return false;
+    }
+    if (!sindex) {
+        return true;
+    }
+    // A `get_all` needs the index value of every row to match it against its keys.
+    return get_all_keys == nullptr && sindex->inner_range.contains_key(key);
+}
+
+void rget_cb_t::handle_pre_leaf(
+        const counted_t<counted_buf_lock_and_read_t> &buf,
+        const btree_key_t *left_excl_or_null,
+        const btree_key_t *right_incl,
+        bool *skip_out) {
+    *skip_out = false;
+    if (!count_leaves
+        || bad_init
+        || boost::get<ql::exc_t>(&io.response->result) != NULL) {
+        return;
+    }
+
+    // Primary keys can't be truncated and there's nothing to evaluate, so every live
+    // key in the leaf's part of the range is exactly one row.  The same goes for index
+    // entries in the inner range; if there are others, we visit the leaf's rows one
+    // at a time instead.
+    const leaf_node_t *node =
+        static_cast<const leaf_node_t *>(buf->read->get_data_read());
+    const btree_key_t *first_key = nullptr;
+    const btree_key_t *last_key = nullptr;
+    uint64_t count = 0;
+    for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
+        const btree_key_t *key = (*it).first;
+        if (left_excl_or_null != nullptr && btree_key_cmp(key, left_excl_or_null) <= 0) {
+            continue;
+        }
+        if (btree_key_cmp(key, right_incl) > 0) {
+            break;
+        }
+        if (!counts_key_only(key)) {
+            return;
+        }
+        if (sindex && !sindex->pkey_range.contains_key(
+                ql::datum_t::extract_primary(store_key_t(key)))) {
+            continue;
+        }
+        if (first_key == nullptr) {
+            first_key = key;
+        }
+        last_key = key;
+        ++count;
+    }
+
+    if (count > 0) {
+        store_key_t key(!reversed(job.sorting) ? last_key : first_key);
+        if ((io.response->last_key < key && !reversed(job.sorting)) ||
+            (io.response->last_key > key && reversed(job.sorting))) {
+            io.response->last_key = key;
+        }
+        io.slice->stats.pm_keys_read.record(count);
+        io.slice->stats.pm_total_keys_read += count;
+        io.response->rows_scanned += count;
+        job.accumulator->add_row_count(count * get_all_copies(ql::datum_t()));
+    }
+    *skip_out = true;
+}
+
 // Handle a keyvalue pair.  Returns whether or not we're done early.
 continue_bool_t rget_cb_t::handle_pair(
     scoped_key_value_t &&keyvalue,
@@ -658,8 +839,13 @@ continue_bool_t rget_cb_t::handle_pair(
     // Count stats whether or not we deserialize the value
     io.slice->stats.pm_keys_read.record();
     io.slice->stats.pm_total_keys_read += 1;
-    // We only load the value if we actually use it (`count` does not).
-    if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
+    io.response->rows_scanned += 1;
+    // We only load the value if we actually use it (`count` does not, unless it needs
+    // the index value).
+    const bool key_only = counts_key_only(keyvalue.key());
+    if (!key_only) {
+        io.response->bytes_read +=
+            static_cast<const rdb_value_t *>(keyvalue.value())->value_size();
         val = row.get();
     } else {
         row.reset();
@@ -676,8 +862,8 @@ continue_bool_t rget_cb_t::handle_pair(
         }
 
         // Check whether we're out of sindex range.
-        ql::datum_t sindex_val; // NULL if no sindex.
-        if (sindex) {
+        ql::datum_t sindex_val; // NULL if no sindex or if we're only counting keys.
+        if (sindex && !key_only) {
             // Secondary index functions are deterministic (so no need for an
             // rdb_context_t) and evaluated in a pristine environment (without global
             // optargs).
@@ -696,9 +882,13 @@ continue_bool_t rget_cb_t::handle_pair(
                 return continue_bool_t::CONTINUE;
             }
         }
+        const uint64_t copies = get_all_copies(sindex_val);
+        if (copies == 0) {
+            return continue_bool_t::CONTINUE;
+        }
 
         ql::groups_t data;
-        data = {{ql::datum_t(), ql::datums_t{val}}};
+        data = {{ql::datum_t(), ql::datums_t(copies, val)}};
 
         for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
             (**it)(job.env, &data, sindex_val);
@@ -723,6 +913,128 @@ continue_bool_t rget_cb_t::handle_pair(
     }
 }
 
+// Follows one random path from the root to a leaf and picks a random row in `range`
+// from that leaf.  `*estimate_out` is set to the product of the number of choices
+// made along the way, which is an unbiased estimate of the number of rows in `range`.
+// Returns false if the leaf had no rows in `range`.
+static bool random_descent(
+        superblock_t *superblock,
+        const key_range_t &range,
+        signal_t *interruptor,
+        store_key_t *key_out,
+        ql::datum_t *val_out,
+        uint64_t *value_size_out,
+        double *estimate_out) {
+    *estimate_out = 0;
+    block_id_t root_block_id = superblock->get_root_block_id();
+    if (root_block_id == NULL_BLOCK_ID) {
+        return false;
+    }
+    double estimate = 1;
+    buf_lock_t lock(superblock->expose_buf(), root_block_id, access_t::read);
+    for (;;) {
+        wait_interruptible(lock.read_acq_signal(), interruptor);
+        block_id_t child_id;
+        {
+            buf_read_t read(&lock);
+            const node_t *node = static_cast<const node_t *>(read.get_data_read());
+            if (node::is_internal(node)) {
+                const internal_node_t *inode =
+                    reinterpret_cast<const internal_node_t *>(node);
+                int start_index =
+                    internal_node::get_offset_index(inode, range.left.btree_key());
+                int end_index;
+                if (range.right.unbounded) {
+                    end_index = inode->npairs;
+                } else {
+                    store_key_t r = range.right.key();
+                    r.decrement();
+                    end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
+                }
+                if (end_index <= start_index) {
+                    return false;
+                }
+                estimate *= end_index - start_index;
+                child_id = internal_node::get_pair_by_index(
+                    inode, start_index + randint(end_index - start_index))->lnode;
+            } else {
+                const leaf_node_t *lnode = reinterpret_cast<const leaf_node_t *>(node);
+                std::vector<std::pair<const btree_key_t *, const void *> > rows;
+                for (auto it = leaf::inclusive_lower_bound(range.left.btree_key(), *lnode);
+                     it != leaf::end(*lnode); ++it) {
+                    if (!range.right.unbounded &&
+                        btree_key_cmp((*it).first, range.right.key().btree_key()) >= 0) {
+                        break;
+                    }
+                    rows.push_back(*it);
+                }
+                if (rows.empty()) {
+                    return false;
+                }
+                const auto &row = rows[randsize(rows.size())];
+                const rdb_value_t *value = static_cast<const rdb_value_t *>(row.second);
+                *key_out = store_key_t(row.first);
+                *val_out = get_data(value, buf_parent_t(&lock));
+                *value_size_out = value->value_size();
+                *estimate_out = estimate * rows.size();
+                return true;
+            }
+        }
+        buf_lock_t child(&lock, child_id, access_t::read);
+        lock.swap(child);
+    }
+}
+
+static void rdb_sample_slice(
+        btree_slice_t *slice,
+        const key_range_t &range,
+        superblock_t *superblock,
+        ql::env_t *ql_env,
+        uint64_t n,
+        rget_read_response_t *response,
+        release_superblock_t release_superblock) {
+    r_sanity_check(boost::get<ql::exc_t>(&response->result) == NULL);
+    profile::starter_t starter("Sample rows by random descent.", ql_env->trace);
+
+    // Paths end at rows we already have, or at leaves with no rows in the range, so
+    // we allow a few more descents than rows.
+    const uint64_t max_descents = 4 * n;
+    std::map<store_key_t, ql::datum_t> rows;
+    double estimate_sum = 0;
+    uint64_t descents = 0;
+    while (rows.size() < n && descents < max_descents) {
+        store_key_t key;
+        ql::datum_t val;
+        uint64_t value_size;
+        double estimate;
+        ++descents;
+        if (random_descent(superblock, range, ql_env->interruptor,
+                           &key, &val, &value_size, &estimate)) {
+            estimate_sum += estimate;
+            slice->stats.pm_keys_read.record();
+            slice->stats.pm_total_keys_read += 1;
+            response->rows_scanned += 1;
+            response->bytes_read += value_size;
+            rows.insert(std::make_pair(key, val));
+        }
+    }
+    if (release_superblock == release_superblock_t::RELEASE) {
+        superblock->release();
+    }
+
+    ql::grouped_t<ql::reservoir_t> result;
+    if (!rows.empty()) {
+        ql::reservoir_t *reservoir = &result[ql::datum_t()];
+        reservoir->seen = std::max<uint64_t>(
+            rows.size(), static_cast<uint64_t>(estimate_sum / descents));
+        for (auto &&pair : rows) {
+            reservoir->rows.push_back(std::move(pair.second));
+        }
+    }
+    response->result = std::move(result);
+    response->last_key = !range.right.unbounded ? range.right.key() : store_key_t::max();
+}
+
 // TODO: Having two functions which are 99% the same sucks.
 void rdb_rget_slice(
         btree_slice_t *slice,
@@ -736,6 +1048,14 @@ void rdb_rget_slice(
         rget_read_response_t *response,
         release_superblock_t release_superblock) {
 
+    const ql::sample_wire_func_t *sample =
+        terminal ? boost::get<ql::sample_wire_func_t>(&*terminal) : nullptr;
+    if (sample != nullptr && sample->approximate && transforms.empty()) {
+        rdb_sample_slice(slice, range, superblock, ql_env, sample->n, response,
+                         release_superblock);
+        return;
+    }
+
     r_sanity_check(boost::get<ql::exc_t>(&response->result) == NULL);
     profile::starter_t starter("Do range scan on primary index.", ql_env->trace);
     rget_cb_t callback(
@@ -785,9 +1105,154 @@ void rdb_rget_secondary_slice(
     callback.finish();
 }
 
+// Runs `callback` over each of `traversals` in key order under the same superblock, until
+// the batch is full.  The superblock is released by the last traversal, or by the
+// caller if we stop early.
+static void run_get_all_traversals(
+        superblock_t *superblock,
+        const std::vector<std::pair<key_range_t, std::map<ql::datum_t, uint64_t> > >
+            &traversals,
+        rget_cb_t *callback) {
+    if (traversals.empty()) {
+        // The key filter may have ruled out every key.
+        superblock->release();
+    }
+    for (size_t i = 0; i < traversals.size(); ++i) {
+        callback->set_get_all_keys(&traversals[i].second);
+        btree_concurrent_traversal(
+            superblock, traversals[i].first, callback, direction_t::FORWARD,
+            i + 1 == traversals.size()
+                ? release_superblock_t::RELEASE
+                : release_superblock_t::KEEP);
+        if (callback->is_done()) {
+            break;
+        }
+    }
+    callback->finish();
+}
+
+void rdb_get_all_slice(
+        btree_slice_t *slice,
+        const key_range_t &range,
+        const std::map<ql::datum_t, uint64_t> &keys,
+        superblock_t *superblock,
+        ql::env_t *ql_env,
+        const ql::batchspec_t &batchspec,
+        const std::vector<transform_variant_t> &transforms,
+        const boost::optional<terminal_variant_t> &terminal,
+        rget_read_response_t *response) {
+    r_sanity_check(boost::get<ql::exc_t>(&response->result) == NULL);
+    profile::starter_t starter("Do multi-key read on primary index.", ql_env->trace);
+
+    std::map<store_key_t, std::map<ql::datum_t, uint64_t> > by_store_key;
+    for (const auto &pair : keys) {
+        store_key_t key(pair.first.print_primary());
+        if (range.contains_key(key)
+            && key_filter_may_contain(slice, superblock, key)) {
+            by_store_key[key].insert(pair);
+        }
+    }
+    std::vector<std::pair<key_range_t, std::map<ql::datum_t, uint64_t> > > traversals;
+    traversals.reserve(by_store_key.size());
+    for (auto &&pair : by_store_key) {
+        traversals.push_back(std::make_pair(
+            key_range_t(key_range_t::closed, pair.first,
+                        key_range_t::closed, pair.first),
+            std::move(pair.second)));
+    }
+
+    rget_cb_t callback(
+        rget_io_data_t(response, slice),
+        job_data_t(ql_env, batchspec, transforms, terminal, sorting_t::UNORDERED),
+        boost::optional<rget_sindex_data_t>(),
+        range);
+    run_get_all_traversals(superblock, traversals, &callback);
+}
+
+void rdb_get_all_secondary_slice(
+        btree_slice_t *slice,
+        const std::map<ql::datum_t, uint64_t> &keys,
+        const key_range_t &sindex_range,
+        sindex_superblock_t *superblock,
+        ql::env_t *ql_env,
+        const ql::batchspec_t &batchspec,
+        const std::vector<transform_variant_t> &transforms,
+        const boost::optional<terminal_variant_t> &terminal,
+        const key_range_t &pk_range,
+        const sindex_disk_info_t &sindex_info,
+        rget_read_response_t *response) {
+    r_sanity_check(boost::get<ql::exc_t>(&response->result) == NULL);
+    guarantee(sindex_info.geo == sindex_geo_bool_t::REGULAR);
+    profile::starter_t starter("Do multi-key read on secondary index.", ql_env->trace);
+
+    const reql_version_t sindex_func_reql_version =
+        sindex_info.mapping_version_info.latest_compatible_reql_version;
+    const ql::skey_version_t skey_version =
+        ql::skey_version_from_reql_version(sindex_func_reql_version);
+
+    // Long keys are truncated in the index, so different keys can share a range.  We
+    // merge overlapping ranges into one traversal that looks for all of their keys,
+    // so that no row is read twice and the ranges stay in key order for paging.
+    std::vector<std::pair<key_range_t, std::pair<ql::datum_t, uint64_t> > > ranges;
+    ranges.reserve(keys.size());
+    try {
+        for (const auto &pair : keys) {
+            key_range_t range =
+                ql::datum_range_t(pair.first).to_sindex_keyrange(skey_version);
+            if (pair.first.get_type() != ql::datum_t::MINVAL
+                && pair.first.get_type() != ql::datum_t::MAXVAL
+                && !key_filter_may_contain(
+                    slice, superblock,
+                    sindex_key_filter_key(pair.first, skey_version))) {
+                continue;
+            }
+            ranges.push_back(std::make_pair(range, pair));
+        }
+    } catch (const ql::datum_exc_t &e) {
+        response->result = ql::exc_t(e, ql::backtrace_id_t::empty());
+        return;
+    }
+    std::sort(ranges.begin(), ranges.end(),
+        [](const std::pair<key_range_t, std::pair<ql::datum_t, uint64_t> > &a,
+           const std::pair<key_range_t, std::pair<ql::datum_t, uint64_t> > &b) {
+            return a.first.left < b.first.left;
+        });
+    std::vector<std::pair<key_range_t, std::map<ql::datum_t, uint64_t> > > traversals;
+    for (const auto &pair : ranges) {
+        if (!traversals.empty() && traversals.back().first.overlaps(pair.first)) {
+            if (traversals.back().first.right < pair.first.right) {
+                traversals.back().first.right = pair.first.right;
+            }
+        } else {
+            traversals.push_back(std::make_pair(
+                pair.first, std::map<ql::datum_t, uint64_t>()));
+        }
+        traversals.back().second.insert(pair.second);
+    }
+    // Clip the traversals to the part of the index that's left to read.
+    std::vector<std::pair<key_range_t, std::map<ql::datum_t, uint64_t> > > clipped;
+    clipped.reserve(traversals.size());
+    for (auto &&traversal : traversals) {
+        key_range_t clipped_range = traversal.first.intersection(sindex_range);
+        if (!clipped_range.is_empty()) {
+            clipped.push_back(
+                std::make_pair(clipped_range, std::move(traversal.second)));
+        }
+    }
+
+    rget_cb_t callback(
+        rget_io_data_t(response, slice),
+        job_data_t(ql_env, batchspec, transforms, terminal, sorting_t::UNORDERED),
+        rget_sindex_data_t(pk_range, ql::datum_range_t::universe(),
+                           sindex_func_reql_version, sindex_info.mapping,
+                           sindex_info.multi),
+        sindex_range);
+    run_get_all_traversals(superblock, clipped, &callback);
+}
+
 void rdb_get_intersecting_slice(
         btree_slice_t *slice,
-        const ql::datum_t &query_geometry,
+        const counted_t<const prepared_geometry_t> &query,
         const region_t &sindex_region,
         sindex_superblock_t *superblock,
         ql::env_t *ql_env,
@@ -797,7 +1262,7 @@ void rdb_get_intersecting_slice(
         const key_range_t &pk_range,
         const sindex_disk_info_t &sindex_info,
         rget_read_response_t *response) {
-    guarantee(query_geometry.has());
+    guarantee(query.has());
 
     guarantee(sindex_info.geo == sindex_geo_bool_t::GEO);
     profile::starter_t starter("Do intersection scan on geospatial index.", ql_env->trace);
@@ -809,7 +1274,7 @@ void rdb_get_intersecting_slice(
         geo_job_data_t(ql_env, batchspec, transforms, terminal),
         geo_sindex_data_t(pk_range, sindex_info.mapping, sindex_func_reql_version,
                           sindex_info.multi),
-        query_geometry,
+        query,
         sindex_region.inner,
         response);
     btree_concurrent_traversal(
@@ -837,43 +1302,16 @@ void rdb_get_nearest_slice(
     const reql_version_t sindex_func_reql_version =
         sindex_info.mapping_version_info.latest_compatible_reql_version;
 
-    // TODO (daniel): Instead of calling this multiple times until we are done,
-    //   results should be streamed lazily. Also, even if we don't do that,
-    //   the copying of the result we do here is bad.
-    nearest_traversal_state_t state(center, max_results, max_dist, geo_system);
-    response->results_or_error = nearest_geo_read_response_t::result_t();
-    do {
-        nearest_geo_read_response_t partial_response;
-        try {
-            nearest_traversal_cb_t callback(
-                slice,
-                geo_sindex_data_t(pk_range, sindex_info.mapping,
-                                  sindex_func_reql_version, sindex_info.multi),
-                ql_env,
-                &state);
-            btree_concurrent_traversal(
-                superblock, key_range_t::universe(), &callback,
-                direction_t::FORWARD,
-                release_superblock_t::KEEP);
-            callback.finish(&partial_response);
-        } catch (const geo_exception_t &e) {
-            partial_response.results_or_error =
-                ql::exc_t(ql::base_exc_t::GENERIC, e.what(),
-                          ql::backtrace_id_t::empty());
-        }
-        if (boost::get<ql::exc_t>(&partial_response.results_or_error)) {
-            response->results_or_error = partial_response.results_or_error;
-            return;
-        } else {
-            auto partial_res = boost::get<nearest_geo_read_response_t::result_t>(
-                &partial_response.results_or_error);
-            guarantee(partial_res != NULL);
-            auto full_res = boost::get<nearest_geo_read_response_t::result_t>(
-                &response->results_or_error);
-            std::move(partial_res->begin(), partial_res->end(),
-                      std::back_inserter(*full_res));
-        }
-    } while (state.proceed_to_next_batch() == continue_bool_t::CONTINUE);
+    nearest_traversal_t traversal(
+        slice,
+        geo_sindex_data_t(pk_range, sindex_info.mapping, sindex_func_reql_version,
+                          sindex_info.multi),
+        ql_env,
+        center,
+        max_results,
+        max_dist,
+        geo_system);
+    traversal.run(superblock, response);
 }
 
 void rdb_distribution_get(int max_depth,
@@ -1410,6 +1848,10 @@ void rdb_update_single_sindex(
                     });
             }
             for (auto it = keys.begin(); it != keys.end(); ++it) {
+                if (sindex_info.geo == sindex_geo_bool_t::REGULAR) {
+                    sindex->btree->key_filter.insert(
+                        sindex_key_filter_key(it->first).btree_key());
+                }
                 promise_t<superblock_t *> return_superblock_local;
                 {
                     keyvalue_location_t kv_location;
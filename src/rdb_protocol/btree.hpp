@@ -58,6 +58,14 @@ struct rdb_modification_info_t;
 struct rdb_modification_report_t;
 class rdb_modification_report_cb_t;
 
+/* The key filter of a secondary index holds the secondary part of each of its keys,
+truncated the same way whatever the primary key is, so that `get_all` can look a value
+up without knowing the primary keys that go with it. The first version throws if
+`value` can't be in an index. */
+store_key_t sindex_key_filter_key(
+    const ql::datum_t &value, ql::skey_version_t skey_version);
+store_key_t sindex_key_filter_key(const store_key_t &sindex_key);
+
 void rdb_get(
     const store_key_t &key,
     btree_slice_t *slice,
@@ -134,6 +142,15 @@ void rdb_delete(const store_key_t &key, btree_slice_t *slice, repli_timestamp_t
                 profile::trace_t *trace,
                 promise_t<superblock_t *> *pass_back_superblock = nullptr);
 
+/* Sets the recency of an existing key to `timestamp` without changing its value. This
+is used by backfills when the backfill destination already has the right value. Does
+nothing if the key doesn't exist. */
+void rdb_set_recency(const store_key_t &key,
+                     repli_timestamp_t timestamp,
+                     superblock_t *superblock,
+                     const deletion_context_t *deletion_context,
+                     promise_t<superblock_t *> *pass_back_superblock = nullptr);
+
 void rdb_rget_slice(
     btree_slice_t *slice,
     const key_range_t &range,
@@ -161,9 +178,37 @@ void rdb_rget_secondary_slice(
     rget_read_response_t *response,
     release_superblock_t release_superblock);
 
+/* `rdb_get_all_slice` and `rdb_get_all_secondary_slice` serve `get_all_read_t`.  They
+read the rows for each of `keys` in key order, skipping the keys outside of `range` (or
+`sindex_range`, which is the part of the index left to read), and return the rows for a
+key once for each time it appears in `keys`. */
+void rdb_get_all_slice(
+    btree_slice_t *slice,
+    const key_range_t &range,
+    const std::map<ql::datum_t, uint64_t> &keys,
+    superblock_t *superblock,
+    ql::env_t *ql_env,
+    const ql::batchspec_t &batchspec,
+    const std::vector<ql::transform_variant_t> &transforms,
+    const boost::optional<ql::terminal_variant_t> &terminal,
+    rget_read_response_t *response);
+
+void rdb_get_all_secondary_slice(
+    btree_slice_t *slice,
+    const std::map<ql::datum_t, uint64_t> &keys,
+    const key_range_t &sindex_range,
+    sindex_superblock_t *superblock,
+    ql::env_t *ql_env,
+    const ql::batchspec_t &batchspec,
+    const std::vector<ql::transform_variant_t> &transforms,
+    const boost::optional<ql::terminal_variant_t> &terminal,
+    const key_range_t &pk_range,
+    const sindex_disk_info_t &sindex_info,
+    rget_read_response_t *response);
+
 void rdb_get_intersecting_slice(
     btree_slice_t *slice,
-    const ql::datum_t &query_geometry,
+    const counted_t<const prepared_geometry_t> &query,
     const region_t &sindex_region,
     sindex_superblock_t *superblock,
     ql::env_t *ql_env,
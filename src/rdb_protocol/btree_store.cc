@@ -93,6 +93,11 @@ store_t::store_t(const region_t &region,
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      read_latency(secs_to_ticks(10)),
+      write_latency(secs_to_ticks(10)),
+      latency_membership(&perfmon_collection,
+          &read_latency, "read_latency",
+          &write_latency, "write_latency"),
       ctx(_ctx),
       changefeed_server((ctx == NULL || ctx->manager == NULL)
                         ? NULL
@@ -187,6 +192,7 @@ void store_t::read(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    const ticks_t start_time = get_ticks();
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> superblock;
 
@@ -196,6 +202,7 @@ void store_t::read(
     DEBUG_ONLY_CODE(metainfo->visit(
         superblock.get(), metainfo_checker.region, metainfo_checker.callback));
     protocol_read(read, response, superblock.get(), interruptor);
+    read_latency.record_since(start_time);
 }
 
 void store_t::write(
@@ -210,6 +217,7 @@ void store_t::write(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    const ticks_t start_time = get_ticks();
 
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> real_superblock;
@@ -220,6 +228,7 @@ void store_t::write(
         real_superblock.get(), metainfo_checker.region, metainfo_checker.callback));
     metainfo->update(real_superblock.get(), new_metainfo);
     protocol_write(write, response, timestamp, &real_superblock, interruptor);
+    write_latency.record_since(start_time);
 }
 
 void store_t::reset_data(
@@ -840,6 +849,118 @@ void store_t::clear_sindex(
     }
 }
 
+void store_t::maybe_rebuild_key_filter(const boost::optional<uuid_u> &sindex_id) {
+    assert_thread();
+    if (ctx == NULL || ctx->lookup_filter_bits == 0) {
+        return;
+    }
+    btree_slice_t *slice = sindex_id ? get_sindex_slice(*sindex_id) : btree.get();
+    if (slice->key_filter.needs_rebuild()) {
+        // This has to happen before the scan acquires the superblock, so that the new
+        // filter gets every key that's inserted after the scan has passed it.
+        slice->key_filter.start_rebuild(ctx->lookup_filter_bits);
+        coro_t::spawn_sometime(std::bind(&store_t::rebuild_key_filter,
+                                         this,
+                                         sindex_id,
+                                         drainer.lock()));
+    }
+}
+
+class key_filter_rebuild_cb_t : public depth_first_traversal_callback_t {
+public:
+    explicit key_filter_rebuild_cb_t(bool _is_sindex) : is_sindex(_is_sindex) { }
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, signal_t *) {
+        last_key.assign(keyvalue.key());
+        filter_keys.push_back(
+            is_sindex ? sindex_key_filter_key(last_key) : last_key);
+        return filter_keys.size() >= CHUNK_SIZE
+            ? continue_bool_t::ABORT
+            : continue_bool_t::CONTINUE;
+    }
+    static const size_t CHUNK_SIZE = 1000;
+    const bool is_sindex;
+    store_key_t last_key;
+    std::vector<store_key_t> filter_keys;
+};
+
+void store_t::rebuild_key_filter(
+        boost::optional<uuid_u> sindex_id,
+        auto_drainer_t::lock_t store_keepalive)
+        THROWS_NOTHING {
+    // The secondary index may be dropped while we're waiting for blocks, so we look
+    // the slice up again whenever we need it.
+    auto get_slice = [&]() -> btree_slice_t * {
+        if (!sindex_id) {
+            return btree.get();
+        }
+        auto it = secondary_index_slices.find(*sindex_id);
+        return it == secondary_index_slices.end() ? NULL : it->second.get();
+    };
+
+    try {
+        key_range_t range = key_range_t::universe();
+        for (;;) {
+            key_filter_rebuild_cb_t cb(static_cast<bool>(sindex_id));
+            bool reached_end;
+            {
+                read_token_t token;
+                new_read_token(&token);
+                scoped_ptr_t<txn_t> txn;
+                scoped_ptr_t<real_superblock_t> superblock;
+                acquire_superblock_for_read(&token, &txn, &superblock,
+                                            store_keepalive.get_drain_signal(), false);
+                if (sindex_id) {
+                    buf_lock_t sindex_block(superblock->expose_buf(),
+                                            superblock->get_sindex_block_id(),
+                                            access_t::read);
+                    superblock->release();
+                    secondary_index_t sindex;
+                    if (!::get_secondary_index(&sindex_block, *sindex_id, &sindex)
+                        || sindex.being_deleted) {
+                        break;
+                    }
+                    sindex_superblock_t sindex_superblock(
+                        buf_lock_t(&sindex_block, sindex.superblock, access_t::read));
+                    sindex_block.reset_buf_lock();
+                    reached_end = continue_bool_t::CONTINUE
+                        == btree_depth_first_traversal(
+                            &sindex_superblock, range, &cb, access_t::read,
+                            direction_t::FORWARD, release_superblock_t::RELEASE,
+                            store_keepalive.get_drain_signal());
+                } else {
+                    reached_end = continue_bool_t::CONTINUE
+                        == btree_depth_first_traversal(
+                            superblock.get(), range, &cb, access_t::read,
+                            direction_t::FORWARD, release_superblock_t::RELEASE,
+                            store_keepalive.get_drain_signal());
+                }
+            }
+
+            btree_slice_t *slice = get_slice();
+            if (slice == NULL) {
+                return;
+            }
+            for (const store_key_t &key : cb.filter_keys) {
+                slice->key_filter.insert_rebuilt(key.btree_key());
+            }
+            if (!reached_end) {
+                range.left = cb.last_key;
+                reached_end = !range.left.increment();
+            }
+            if (reached_end) {
+                slice->key_filter.finish_rebuild();
+                return;
+            }
+        }
+        // The index is being dropped.
+        if (btree_slice_t *slice = get_slice()) {
+            slice->key_filter.abort_rebuild();
+        }
+    } catch (const interrupted_exc_t &) {
+        // The store is being destroyed, and the filter with it.
+    }
+}
+
 bool secondary_indexes_are_equivalent(const std::vector<char> &left,
                                       const std::vector<char> &right) {
     sindex_disk_info_t sindex_info_left;
@@ -48,14 +48,25 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      query_latency(secs_to_ticks(10)),
+      query_latency_membership(&qe_stats_collection,
+                               &query_latency, "query_latency"),
+      queries_rejected_membership(&qe_stats_collection,
+                                  &queries_rejected, "queries_rejected") { }
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
-      stats(&get_global_perfmon_collection()) { }
+      hedge_outdated_reads(false),
+      lookup_filter_bits(0),
+      backfill_content_hashes(false),
+      punch_holes(false),
+      compact_files(true),
+      stats(&get_global_perfmon_collection()),
+      admission_controllers(query_admission_config_t()) { }
 
 rdb_context_t::rdb_context_t(
         extproc_pool_t *_extproc_pool,
@@ -64,7 +75,13 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
-      stats(&get_global_perfmon_collection()) { }
+      hedge_outdated_reads(false),
+      lookup_filter_bits(0),
+      backfill_content_hashes(false),
+      punch_holes(false),
+      compact_files(true),
+      stats(&get_global_perfmon_collection()),
+      admission_controllers(query_admission_config_t()) { }
 
 rdb_context_t::rdb_context_t(
         extproc_pool_t *_extproc_pool,
@@ -73,13 +90,25 @@ rdb_context_t::rdb_context_t(
         boost::shared_ptr< semilattice_readwrite_view_t<auth_semilattice_metadata_t> >
             _auth_metadata,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        const query_admission_config_t &admission_config,
+        bool _hedge_outdated_reads,
+        size_t _lookup_filter_bits,
+        bool _backfill_content_hashes,
+        bool _punch_holes,
+        bool _compact_files)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       auth_metadata(_auth_metadata),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
-      stats(global_stats)
+      hedge_outdated_reads(_hedge_outdated_reads),
+      lookup_filter_bits(_lookup_filter_bits),
+      backfill_content_hashes(_backfill_content_hashes),
+      punch_holes(_punch_holes),
+      compact_files(_compact_files),
+      stats(global_stats),
+      admission_controllers(admission_config)
 { }
 
 rdb_context_t::~rdb_context_t() { }
@@ -87,3 +116,7 @@ rdb_context_t::~rdb_context_t() { }
 std::set<ql::query_cache_t *> *rdb_context_t::get_query_caches_for_this_thread() {
     return query_caches.get();
 }
+
+query_admission_controller_t *rdb_context_t::get_admission_controller_for_this_thread() {
+    return admission_controllers.get();
+}
@@ -23,6 +23,7 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/geo/distances.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
+#include "rdb_protocol/query_admission.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/wire_func.hpp"
 
@@ -139,6 +140,15 @@ public:
         const ql::datum_range_t &range,
         sorting_t sorting,
         read_mode_t read_mode) = 0;
+    /* Returns the rows with any of `keys` in `sindex`, in no particular order. A key
+    that appears more than once returns its rows that many times. */
+    virtual counted_t<ql::datum_stream_t> read_all_keys(
+        ql::env_t *env,
+        const std::string &sindex,
+        ql::backtrace_id_t bt,
+        const std::string &table_name,
+        const std::vector<ql::datum_t> &keys,
+        read_mode_t read_mode) = 0;
     virtual counted_t<ql::datum_stream_t> read_changes(
         ql::env_t *env,
         counted_t<ql::datum_stream_t> maybe_src,
@@ -328,6 +338,17 @@ public:
             std::string *error_out,
             std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
                 *configs_and_statuses_out) = 0;
+    /* `sindex_list_ready()` returns the configs of the table's indexes that were ready
+    and up-to-date when it last asked the servers. Unlike `sindex_list()`, it doesn't
+    wait for the servers, so it's cheap enough to call while evaluating a query; but an
+    index it returns may have been dropped or may not be ready everywhere, so reads from
+    it must be able to fall back on something else. */
+    virtual bool sindex_list_ready(
+            counted_t<const ql::db_t> db,
+            const name_string_t &table,
+            signal_t *interruptor,
+            std::string *error_out,
+            std::map<std::string, sindex_config_t> *configs_out) = 0;
 
 protected:
     virtual ~reql_cluster_interface_t() { }   // silence compiler warnings
@@ -351,7 +372,13 @@ public:
                     semilattice_readwrite_view_t<
                         auth_semilattice_metadata_t> > _auth_metadata,
                   perfmon_collection_t *global_stats,
-                  const std::string &_reql_http_proxy);
+                  const std::string &_reql_http_proxy,
+                  const query_admission_config_t &admission_config,
+                  bool _hedge_outdated_reads,
+                  size_t _lookup_filter_bits,
+                  bool _backfill_content_hashes,
+                  bool _punch_holes,
+                  bool _compact_files);
 
     ~rdb_context_t();
 
@@ -365,6 +392,23 @@ public:
 
     const std::string reql_http_proxy;
 
+    /* If true, outdated reads that take unusually long are also sent to a second
+    replica, and the first answer is used. */
+    const bool hedge_outdated_reads;
+
+    /* If not zero, every store keeps a filter with this many bits per key for each of
+    its B-trees, so that lookups of keys that don't exist can skip the B-tree. */
+    const size_t lookup_filter_bits;
+
+    /* If true, stores that catch up on a table send hashes of their data to the
+    backfill source, so that data they already have isn't sent again. */
+    const bool backfill_content_hashes;
+
+    /* Passed on to the serializers of the table files; see
+    `log_serializer_dynamic_config_t`. */
+    const bool punch_holes;
+    const bool compact_files;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -379,14 +423,20 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        perfmon_latency_histogram_t query_latency;
+        perfmon_membership_t query_latency_membership;
+        perfmon_counter_t queries_rejected;
+        perfmon_membership_t queries_rejected_membership;
     private:
         DISABLE_COPYING(stats_t);
     } stats;
 
     std::set<ql::query_cache_t *> *get_query_caches_for_this_thread();
+    query_admission_controller_t *get_admission_controller_for_this_thread();
 
 private:
     one_per_thread_t<std::set<ql::query_cache_t *> > query_caches;
+    one_per_thread_t<query_admission_controller_t> admission_controllers;
 
 private:
     DISABLE_COPYING(rdb_context_t);
@@ -2168,6 +2168,25 @@ key_range_t datum_range_t::to_sindex_keyrange(skey_version_t skey_version) const
         store_key_t(right_bound.truncated_secondary(skey_version, extrema_ok_t::OK)));
 }
 
+key_range_t datum_range_t::to_inner_sindex_keyrange(
+        skey_version_t skey_version) const {
+    r_sanity_check(left_bound.has() && right_bound.has());
+    // `to_sindex_keyrange` has to find every entry in a range, so every entry with a
+    // value of at most `left_bound` sorts before the end of the range it returns for
+    // `left_bound` alone, and every entry with a value of at least `right_bound` sorts
+    // at or after the start of the one for `right_bound`.
+    key_range_t above_left =
+        datum_range_t(left_bound).to_sindex_keyrange(skey_version);
+    key_range_t below_right =
+        datum_range_t(right_bound).to_sindex_keyrange(skey_version);
+    if (above_left.right.unbounded
+        || below_right.left <= above_left.right.key()) {
+        return key_range_t::empty();
+    }
+    return key_range_t(key_range_t::closed, above_left.right.key(),
+                       key_range_t::open, below_right.left);
+}
+
 datum_range_t datum_range_t::with_left_bound(datum_t d, key_range_t::bound_t type) {
     r_sanity_check(d.has() && right_bound.has());
     return datum_range_t(d, type, right_bound, right_bound_type);
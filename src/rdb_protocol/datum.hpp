@@ -445,6 +445,10 @@ public:
     // truncated sindexes.
     key_range_t to_primary_keyrange() const;
     key_range_t to_sindex_keyrange(skey_version_t skey_version) const;
+    // The index entries in this range have values strictly between the bounds, so
+    // they're in the datum range no matter how their keys were truncated. Entries
+    // outside of it may or may not be in the datum range.
+    key_range_t to_inner_sindex_keyrange(skey_version_t skey_version) const;
 
     datum_range_t with_left_bound(datum_t d, key_range_t::bound_t type);
     datum_range_t with_right_bound(datum_t d, key_range_t::bound_t type);
@@ -31,7 +31,12 @@ rget_response_reader_t::rget_response_reader_t(
       readgen(std::move(_readgen)),
       last_read_start(store_key_t::min()),
       active_range(readgen->original_keyrange()),
-      items_index(0) { }
+      items_index(0),
+      items_bytes(0) { }
+
+rget_response_reader_t::~rget_response_reader_t() {
+    release_items_bytes();
+}
 
 void rget_response_reader_t::add_transformation(transform_variant_t &&tv) {
     r_sanity_check(!started);
@@ -131,6 +136,7 @@ std::vector<datum_t> rget_response_reader_t::next_batch(env_t *env,
         items_index = 0;
         std::vector<rget_item_t> tmp;
         tmp.swap(items);
+        release_items_bytes();
     }
 
     shards_exhausted = (res.size() == 0) ? true : shards_exhausted;
@@ -145,6 +151,15 @@ struct last_read_start_visitor_t : public boost::static_visitor<store_key_t> {
     store_key_t operator()(const intersecting_geo_read_t &geo) const {
         return geo.sindex.region ? geo.sindex.region->inner.left : store_key_t::min();
     }
+    store_key_t operator()(const get_all_read_t &get_all) const {
+        if (get_all.sindex_id) {
+            return get_all.sindex_region
+                ? get_all.sindex_region->inner.left
+                : store_key_t::min();
+        } else {
+            return get_all.region.inner.left;
+        }
+    }
     store_key_t operator()(const rget_read_t &rget) const {
         if (rget.sindex) {
             return rget.sindex->region
@@ -165,6 +180,10 @@ rget_read_response_t rget_response_reader_t::do_read(env_t *env, const read_t &r
     table->read_with_profile(env, read, &res);
     auto rget_res = boost::get<rget_read_response_t>(&res.response);
     r_sanity_check(rget_res != NULL);
+    if (query_resources_t *resources = env->query_resources()) {
+        resources->rows_scanned += rget_res->rows_scanned;
+        resources->bytes_read += rget_res->bytes_read;
+    }
     if (auto e = boost::get<exc_t>(&rget_res->result)) {
         throw *e;
     }
@@ -172,6 +191,26 @@ rget_read_response_t rget_response_reader_t::do_read(env_t *env, const read_t &r
     return std::move(*rget_res);
 }
 
+void rget_response_reader_t::hold_items_bytes(env_t *env, uint64_t bytes) {
+    query_resources_t *resources = env->query_resources();
+    if (resources == NULL) {
+        return;
+    }
+    if (items_resources.get() != resources) {
+        release_items_bytes();
+        items_resources.reset(resources);
+    }
+    items_bytes += bytes;
+    resources->bytes_held += bytes;
+}
+
+void rget_response_reader_t::release_items_bytes() {
+    if (items_resources.has()) {
+        items_resources->bytes_held -= items_bytes;
+    }
+    items_bytes = 0;
+}
+
 rget_reader_t::rget_reader_t(
     const counted_t<real_table_t> &_table,
     scoped_ptr_t<readgen_t> &&_readgen)
@@ -198,6 +237,7 @@ rget_reader_t::do_range_read(env_t *env, const read_t &read) {
     auto *rr = boost::get<rget_read_t>(&read.read);
     r_sanity_check(rr);
     rget_read_response_t res = do_read(env, read);
+    hold_items_bytes(env, res.bytes_read);
 
     key_range_t rng;
     if (rr->sindex) {
@@ -253,6 +293,7 @@ bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
     started = true;
     if (items_index >= items.size() && !shards_exhausted) { // read some more
         items_index = 0;
+        release_items_bytes();
         // `active_range` is guaranteed to be full after the `do_range_read`,
         // because `do_range_read` is responsible for updating the active range.
         items = do_range_read(
@@ -369,6 +410,82 @@ std::vector<rget_item_t> intersecting_reader_t::do_intersecting_read(
     return groups_to_batch(gs->get_underlying_map());
 }
 
+get_all_reader_t::get_all_reader_t(
+    const counted_t<real_table_t> &_table,
+    scoped_ptr_t<readgen_t> &&_readgen)
+    : rget_response_reader_t(_table, std::move(_readgen)) { }
+
+void get_all_reader_t::accumulate_all(env_t *env, eager_acc_t *acc) {
+    r_sanity_check(!started);
+    started = true;
+    batchspec_t batchspec = batchspec_t::all();
+    read_t read = readgen->next_read(active_range, stamp, transforms, batchspec);
+    rget_read_response_t resp = do_read(env, std::move(read));
+
+    r_sanity_check(resp.last_key == store_key_t::max());
+    r_sanity_check(!resp.truncated);
+    shards_exhausted = true;
+
+    acc->add_res(env, &resp.result);
+}
+
+bool get_all_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
+    started = true;
+    while (items_index >= items.size() && !shards_exhausted) { // read some more
+        items_index = 0;
+        release_items_bytes();
+        items = do_get_all_read(
+            env, readgen->next_read(active_range, stamp, transforms, batchspec));
+    }
+    return items_index < items.size();
+}
+
+std::vector<rget_item_t> get_all_reader_t::do_get_all_read(
+        env_t *env, const read_t &read) {
+    auto *gr = boost::get<get_all_read_t>(&read.read);
+    r_sanity_check(gr);
+    rget_read_response_t res = do_read(env, read);
+    hold_items_bytes(env, res.bytes_read);
+
+    key_range_t rng;
+    if (gr->sindex_id) {
+        if (skey_version) {
+            r_sanity_check(res.skey_version == *skey_version);
+        } else {
+            skey_version = res.skey_version;
+        }
+        if (!active_range) {
+            r_sanity_check(!gr->sindex_region);
+            active_range = rng = readgen->sindex_keyrange(res.skey_version);
+        } else {
+            r_sanity_check(gr->sindex_region);
+            rng = gr->sindex_region->inner;
+        }
+    } else {
+        rng = gr->region.inner;
+    }
+
+    // We need to do some adjustments to the last considered key so that we
+    // update the range correctly in the case where we're reading a subportion
+    // of the total range.
+    store_key_t *key = &res.last_key;
+    if (*key == store_key_t::max()) {
+        if (!rng.right.unbounded) {
+            *key = rng.right.key();
+            bool b = key->decrement();
+            r_sanity_check(b);
+        }
+    }
+
+    r_sanity_check(active_range);
+    shards_exhausted = readgen->update_range(&*active_range, res.last_key);
+    grouped_t<stream_t> *gs = boost::get<grouped_t<stream_t> >(&res.result);
+
+    // groups_to_batch asserts that underlying_map has 0 or 1 elements, so it is
+    // correct to declare that the order doesn't matter.
+    return groups_to_batch(gs->get_underlying_map());
+}
+
 readgen_t::readgen_t(
     const std::map<std::string, wire_func_t> &_global_optargs,
     std::string _table_name,
@@ -786,6 +903,147 @@ boost::optional<std::string> intersecting_readgen_t::sindex_name() const {
     return sindex;
 }
 
+get_all_readgen_t::get_all_readgen_t(
+    const std::map<std::string, wire_func_t> &global_optargs,
+    std::string table_name,
+    boost::optional<std::string> _sindex,
+    std::map<datum_t, uint64_t> _keys,
+    profile_bool_t _profile,
+    read_mode_t _read_mode)
+    : readgen_t(global_optargs, std::move(table_name),
+                _profile, _read_mode, sorting_t::UNORDERED),
+      sindex(std::move(_sindex)),
+      keys(std::move(_keys)) { }
+
+scoped_ptr_t<readgen_t> get_all_readgen_t::make(
+    env_t *env,
+    std::string table_name,
+    read_mode_t read_mode,
+    boost::optional<std::string> sindex,
+    const std::vector<datum_t> &keys) {
+    std::map<datum_t, uint64_t> key_counts;
+    for (const auto &key : keys) {
+        key_counts[key] += 1;
+    }
+    return scoped_ptr_t<readgen_t>(
+        new get_all_readgen_t(
+            env->get_all_optargs(),
+            std::move(table_name),
+            std::move(sindex),
+            std::move(key_counts),
+            env->profile(),
+            read_mode));
+}
+
+read_t get_all_readgen_t::next_read(
+    const boost::optional<key_range_t> &active_range,
+    boost::optional<changefeed_stamp_t> stamp,
+    std::vector<transform_variant_t> transforms,
+    const batchspec_t &batchspec) const {
+    r_sanity_check(!stamp);
+    return read_t(next_read_impl(active_range, std::move(transforms), batchspec),
+                  profile,
+                  read_mode);
+}
+
+read_t get_all_readgen_t::terminal_read(
+    const std::vector<transform_variant_t> &transforms,
+    const terminal_variant_t &_terminal,
+    const batchspec_t &batchspec) const {
+    get_all_read_t read = next_read_impl(original_keyrange(), transforms, batchspec);
+    read.terminal = _terminal;
+    return read_t(read, profile, read_mode);
+}
+
+get_all_read_t get_all_readgen_t::next_read_impl(
+    const boost::optional<key_range_t> &active_range,
+    std::vector<transform_variant_t> transforms,
+    const batchspec_t &batchspec) const {
+    if (sindex) {
+        // Like `sindex_readgen_t`, the first read lets the shards compute the range,
+        // since it depends on the secondary index's key version.
+        boost::optional<region_t> sindex_region;
+        if (active_range) {
+            sindex_region = region_t(*active_range);
+        }
+        return get_all_read_t(
+            region_t::universe(),
+            keys,
+            global_optargs,
+            table_name,
+            batchspec,
+            std::move(transforms),
+            boost::optional<terminal_variant_t>(),
+            boost::optional<std::string>(sindex),
+            std::move(sindex_region));
+    } else {
+        r_sanity_check(active_range);
+        return get_all_read_t(
+            region_t(*active_range),
+            keys,
+            global_optargs,
+            table_name,
+            batchspec,
+            std::move(transforms),
+            boost::optional<terminal_variant_t>(),
+            boost::optional<std::string>(),
+            boost::optional<region_t>());
+    }
+}
+
+boost::optional<read_t> get_all_readgen_t::sindex_sort_read(
+    UNUSED const key_range_t &active_range,
+    UNUSED const std::vector<rget_item_t> &items,
+    UNUSED boost::optional<changefeed_stamp_t> stamp,
+    UNUSED std::vector<transform_variant_t> transform,
+    UNUSED const batchspec_t &batchspec) const {
+    // `get_all` doesn't support sorting.
+    return boost::optional<read_t>();
+}
+
+void get_all_readgen_t::sindex_sort(UNUSED std::vector<rget_item_t> *vec) const {
+    // `get_all` doesn't support sorting.
+}
+
+boost::optional<key_range_t> get_all_readgen_t::original_keyrange() const {
+    if (sindex) {
+        return boost::none;
+    }
+    // The smallest range that holds all of the keys.  This throws if a key isn't a
+    // valid primary key.
+    r_sanity_check(!keys.empty());
+    store_key_t min_key = store_key_t::max();
+    store_key_t max_key = store_key_t::min();
+    for (const auto &pair : keys) {
+        store_key_t key(pair.first.print_primary());
+        min_key = std::min(min_key, key);
+        max_key = std::max(max_key, key);
+    }
+    return key_range_t(key_range_t::closed, min_key, key_range_t::closed, max_key);
+}
+
+key_range_t get_all_readgen_t::sindex_keyrange(skey_version_t skey_version) const {
+    r_sanity_check(sindex);
+    r_sanity_check(!keys.empty());
+    boost::optional<key_range_t> hull;
+    for (const auto &pair : keys) {
+        key_range_t range = datum_range_t(pair.first).to_sindex_keyrange(skey_version);
+        if (!hull) {
+            hull = range;
+        } else {
+            hull->left = std::min(hull->left, range.left);
+            if (hull->right < range.right) {
+                hull->right = range.right;
+            }
+        }
+    }
+    return *hull;
+}
+
+boost::optional<std::string> get_all_readgen_t::sindex_name() const {
+    return sindex;
+}
+
 bool datum_stream_t::add_stamp(changefeed_stamp_t) {
     // By default most datum streams can't stamp their responses.
     return false;
@@ -910,6 +1168,7 @@ void eager_datum_stream_t::accumulate(
     groups_t data;
     while (next_grouped_batch(env, bs, &data) == done_t::NO) {
         (*acc)(env, &data);
+        env->maybe_yield();
     }
 }
 
@@ -988,6 +1247,30 @@ bool lazy_datum_stream_t::is_infinite() const {
     return false;
 }
 
+get_all_datum_stream_t::get_all_datum_stream_t(
+    scoped_ptr_t<reader_t> &&_reader,
+    std::vector<counted_t<datum_stream_t> > &&_key_streams,
+    backtrace_id_t bt)
+    : lazy_datum_stream_t(std::move(_reader), bt),
+      key_streams(std::move(_key_streams)) { }
+
+std::vector<changespec_t> get_all_datum_stream_t::get_changespecs() {
+    std::vector<changespec_t> specs;
+    for (auto &&stream : key_streams) {
+        auto subspecs = stream->get_changespecs();
+        std::move(subspecs.begin(), subspecs.end(), std::back_inserter(specs));
+    }
+    return specs;
+}
+
+void get_all_datum_stream_t::add_transformation(transform_variant_t &&tv,
+                                                backtrace_id_t bt) {
+    for (auto &&stream : key_streams) {
+        stream->add_transformation(transform_variant_t(tv), bt);
+    }
+    lazy_datum_stream_t::add_transformation(std::move(tv), bt);
+}
+
 array_datum_stream_t::array_datum_stream_t(datum_t _arr,
                                            backtrace_id_t bt)
     : eager_datum_stream_t(bt), index(0), arr(_arr) { }
@@ -1023,6 +1306,7 @@ array_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
             break;
         }
         sampler.new_sample();
+        env->maybe_yield();
     }
     return v;
 }
@@ -1488,6 +1772,126 @@ std::vector<changespec_t> union_datum_stream_t::get_changespecs() {
     return specs;
 }
 
+// FALLBACK_DATUM_STREAM_T
+
+// Passes everything on to `acc`, noting whether there was anything.
+class note_fed_acc_t : public eager_acc_t {
+public:
+    explicit note_fed_acc_t(eager_acc_t *_acc) : acc(_acc), fed(false) { }
+    virtual void operator()(env_t *env, groups_t *groups) {
+        fed = true;
+        (*acc)(env, groups);
+    }
+    virtual void add_res(env_t *env, result_t *res) {
+        fed = true;
+        acc->add_res(env, res);
+    }
+    virtual scoped_ptr_t<val_t> finish_eager(
+        backtrace_id_t bt, bool is_grouped, const ql::configured_limits_t &limits) {
+        return acc->finish_eager(bt, is_grouped, limits);
+    }
+    bool was_fed() const { return fed; }
+private:
+    eager_acc_t *acc;
+    bool fed;
+};
+
+fallback_datum_stream_t::fallback_datum_stream_t(
+        counted_t<datum_stream_t> _source,
+        std::function<counted_t<datum_stream_t>(env_t *)> _make_fallback,
+        backtrace_id_t bt)
+    : datum_stream_t(bt),
+      source(std::move(_source)),
+      make_fallback(std::move(_make_fallback)),
+      can_fall_back(true) { }
+
+void fallback_datum_stream_t::fall_back(env_t *env) {
+    can_fall_back = false;
+    source = make_fallback(env);
+    for (const auto &pair : transforms) {
+        source->add_transformation(transform_variant_t(pair.first), pair.second);
+    }
+}
+
+std::vector<datum_t>
+fallback_datum_stream_t::next_batch_impl(env_t *env, const batchspec_t &batchspec) {
+    if (can_fall_back) {
+        try {
+            std::vector<datum_t> batch = source->next_batch(env, batchspec);
+            can_fall_back = false;
+            return batch;
+        } catch (const exc_t &) {
+            fall_back(env);
+        }
+    }
+    return source->next_batch(env, batchspec);
+}
+
+void fallback_datum_stream_t::add_transformation(transform_variant_t &&tv,
+                                                 backtrace_id_t bt) {
+    if (can_fall_back) {
+        transforms.push_back(std::make_pair(tv, bt));
+    }
+    source->add_transformation(std::move(tv), bt);
+    update_bt(bt);
+}
+
+void fallback_datum_stream_t::accumulate(
+    env_t *env, eager_acc_t *acc, const terminal_variant_t &tv) {
+    if (can_fall_back) {
+        // We can only start over if `acc` hasn't seen any of `source`'s rows.
+        note_fed_acc_t note_acc(acc);
+        try {
+            source->accumulate(env, &note_acc, tv);
+            return;
+        } catch (const exc_t &) {
+            if (note_acc.was_fed()) {
+                throw;
+            }
+            fall_back(env);
+        }
+    }
+    source->accumulate(env, acc, tv);
+}
+
+void fallback_datum_stream_t::accumulate_all(env_t *env, eager_acc_t *acc) {
+    if (can_fall_back) {
+        note_fed_acc_t note_acc(acc);
+        try {
+            source->accumulate_all(env, &note_acc);
+            return;
+        } catch (const exc_t &) {
+            if (note_acc.was_fed()) {
+                throw;
+            }
+            fall_back(env);
+        }
+    }
+    source->accumulate_all(env, acc);
+}
+
+bool fallback_datum_stream_t::is_array() const {
+    return source->is_array();
+}
+
+datum_t fallback_datum_stream_t::as_array(env_t *env) {
+    return is_array() ? source->as_array(env) : datum_t();
+}
+
+bool fallback_datum_stream_t::is_exhausted() const {
+    return batch_cache_exhausted() && source->is_exhausted();
+}
+feed_type_t fallback_datum_stream_t::cfeed_type() const {
+    return source->cfeed_type();
+}
+bool fallback_datum_stream_t::is_infinite() const {
+    return source->is_infinite();
+}
+
+std::vector<changespec_t> fallback_datum_stream_t::get_changespecs() {
+    return source->get_changespecs();
+}
+
 // RANGE_DATUM_STREAM_T
 range_datum_stream_t::range_datum_stream_t(bool _is_infinite_range,
                                            int64_t _start,
@@ -1499,7 +1903,7 @@ range_datum_stream_t::range_datum_stream_t(bool _is_infinite_range,
       stop(_stop) { }
 
 std::vector<datum_t>
-range_datum_stream_t::next_raw_batch(env_t *, const batchspec_t &batchspec) {
+range_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
     rcheck(!is_infinite_range
            || batchspec.get_batch_type() == batch_type_t::NORMAL
            || batchspec.get_batch_type() == batch_type_t::NORMAL_FIRST,
@@ -1527,6 +1931,8 @@ range_datum_stream_t::next_raw_batch(env_t *, const batchspec_t &batchspec) {
         if (batcher.should_send_batch()) {
             break;
         }
+        // Terminal batches of a big `range` can hold millions of elements.
+        env->maybe_yield();
     }
 
     return batch;
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <list>
 #include <map>
 #include <queue>
@@ -23,6 +24,7 @@
 #include "rdb_protocol/context.hpp"
 #include "rdb_protocol/math_utils.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/query_resources.hpp"
 #include "rdb_protocol/real_table.hpp"
 #include "rdb_protocol/shards.hpp"
 
@@ -329,6 +331,44 @@ private:
     auto_drainer_t drainer;
 };
 
+// Reads from `source`, which was picked as a faster way to read the same rows as the
+// stream `make_fallback` returns (e.g. an index read instead of a table scan).  If
+// the first read from `source` fails, we read from the fallback instead, so that
+// `source` only has to be a guess: its index may not be ready on the server that
+// reads it, or may have been dropped since it was picked.
+class fallback_datum_stream_t : public datum_stream_t {
+public:
+    fallback_datum_stream_t(
+        counted_t<datum_stream_t> source,
+        std::function<counted_t<datum_stream_t>(env_t *)> make_fallback,
+        backtrace_id_t bt);
+
+    virtual void add_transformation(transform_variant_t &&tv,
+                                    backtrace_id_t bt);
+    virtual void accumulate(env_t *env, eager_acc_t *acc, const terminal_variant_t &tv);
+    virtual void accumulate_all(env_t *env, eager_acc_t *acc);
+
+    virtual bool is_array() const;
+    virtual datum_t as_array(env_t *env);
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_infinite() const;
+
+private:
+    virtual std::vector<changespec_t> get_changespecs();
+    std::vector<datum_t>
+    next_batch_impl(env_t *env, const batchspec_t &batchspec);
+
+    // Replaces `source` with the fallback, with the same transformations.
+    void fall_back(env_t *env);
+
+    counted_t<datum_stream_t> source;
+    std::function<counted_t<datum_stream_t>(env_t *)> make_fallback;
+    std::vector<std::pair<transform_variant_t, backtrace_id_t> > transforms;
+    // Cleared once `source` has returned rows, or once we've fallen back.
+    bool can_fall_back;
+};
+
 class range_datum_stream_t : public eager_datum_stream_t {
 public:
     range_datum_stream_t(bool _is_infite_range,
@@ -607,6 +647,62 @@ private:
     const datum_t query_geometry;
 };
 
+// For `get_all` with more than one key.
+class get_all_readgen_t : public readgen_t {
+public:
+    static scoped_ptr_t<readgen_t> make(
+        env_t *env,
+        std::string table_name,
+        read_mode_t read_mode,
+        boost::optional<std::string> sindex,
+        const std::vector<datum_t> &keys);
+
+    virtual read_t terminal_read(
+        const std::vector<transform_variant_t> &transform,
+        const terminal_variant_t &_terminal,
+        const batchspec_t &batchspec) const;
+
+    virtual read_t next_read(
+        const boost::optional<key_range_t> &active_range,
+        boost::optional<changefeed_stamp_t> stamp,
+        std::vector<transform_variant_t> transform,
+        const batchspec_t &batchspec) const;
+
+    virtual boost::optional<read_t> sindex_sort_read(
+        const key_range_t &active_range,
+        const std::vector<rget_item_t> &items,
+        boost::optional<changefeed_stamp_t> stamp,
+        std::vector<transform_variant_t> transform,
+        const batchspec_t &batchspec) const;
+    virtual void sindex_sort(std::vector<rget_item_t> *vec) const;
+    virtual boost::optional<key_range_t> original_keyrange() const;
+    virtual key_range_t sindex_keyrange(skey_version_t skey_version) const;
+    virtual boost::optional<std::string> sindex_name() const;
+
+    virtual changefeed::keyspec_t::range_t get_range_spec(
+        std::vector<transform_variant_t>) const {
+        // `get_all_datum_stream_t` gives changefeeds one stream per key instead.
+        r_sanity_fail();
+    }
+private:
+    get_all_readgen_t(
+        const std::map<std::string, wire_func_t> &global_optargs,
+        std::string table_name,
+        boost::optional<std::string> sindex,
+        std::map<datum_t, uint64_t> keys,
+        profile_bool_t profile,
+        read_mode_t read_mode);
+
+    get_all_read_t next_read_impl(
+        const boost::optional<key_range_t> &active_range,
+        std::vector<transform_variant_t> transforms,
+        const batchspec_t &batchspec) const;
+
+    const boost::optional<std::string> sindex;
+    // Each key maps to the number of times it was given.
+    const std::map<datum_t, uint64_t> keys;
+};
+
 class reader_t {
 public:
     virtual ~reader_t() { }
@@ -629,6 +725,7 @@ public:
     rget_response_reader_t(
         const counted_t<real_table_t> &table,
         scoped_ptr_t<readgen_t> &&readgen);
+    virtual ~rget_response_reader_t();
     virtual void add_transformation(transform_variant_t &&tv);
     virtual bool add_stamp(changefeed_stamp_t stamp);
     virtual boost::optional<active_state_t> get_active_state() const;
@@ -650,6 +747,11 @@ protected:
     virtual bool load_items(env_t *env, const batchspec_t &batchspec) = 0;
     rget_read_response_t do_read(env_t *env, const read_t &read);
 
+    // Counts the bytes the shards read to produce the rows in `items` towards the
+    // query's `bytes_held`, until `release_items_bytes()` is called.
+    void hold_items_bytes(env_t *env, uint64_t bytes);
+    void release_items_bytes();
+
     counted_t<real_table_t> table;
     std::vector<transform_variant_t> transforms;
     boost::optional<changefeed_stamp_t> stamp;
@@ -664,6 +766,9 @@ protected:
     // We need this to handle the SINDEX_CONSTANT case.
     std::vector<rget_item_t> items;
     size_t items_index;
+
+    counted_t<query_resources_t> items_resources;
+    uint64_t items_bytes;
 };
 
 class rget_reader_t : public rget_response_reader_t {
@@ -704,6 +809,26 @@ private:
     std::set<store_key_t> processed_pkeys;
 };
 
+// Reads the rows of a `get_all` with more than one key with a single read per shard.
+class get_all_reader_t : public rget_response_reader_t {
+public:
+    get_all_reader_t(
+        const counted_t<real_table_t> &_table,
+        scoped_ptr_t<readgen_t> &&readgen);
+    virtual void accumulate_all(env_t *env, eager_acc_t *acc);
+
+    // Changefeeds stamp the streams for the individual keys instead.
+    virtual bool add_stamp(changefeed_stamp_t) { return false; }
+
+protected:
+    // Loads new items into the `items` field of rget_response_reader_t.
+    // Returns `true` if there's data in `items`.
+    virtual bool load_items(env_t *env, const batchspec_t &batchspec);
+
+private:
+    std::vector<rget_item_t> do_get_all_read(env_t *env, const read_t &read);
+};
+
 class lazy_datum_stream_t : public datum_stream_t {
 public:
     lazy_datum_stream_t(
@@ -726,17 +851,19 @@ public:
         return reader->get_active_state();
     }
 
-private:
+protected:
     virtual std::vector<changespec_t> get_changespecs() {
         return std::vector<changespec_t>{changespec_t(
                 reader->get_changespec(), counted_from_this())};
     }
 
+    virtual void add_transformation(transform_variant_t &&tv,
+                                    backtrace_id_t bt);
+
+private:
     std::vector<datum_t >
     next_batch_impl(env_t *env, const batchspec_t &batchspec);
 
-    virtual void add_transformation(transform_variant_t &&tv,
-                                    backtrace_id_t bt);
     virtual void accumulate(env_t *env, eager_acc_t *acc, const terminal_variant_t &tv);
     virtual void accumulate_all(env_t *env, eager_acc_t *acc);
 
@@ -749,6 +876,25 @@ private:
     scoped_ptr_t<reader_t> reader;
 };
 
+// The stream for a `get_all` with more than one key.  It reads with a
+// `get_all_reader_t`, but changefeeds see it as the union of `key_streams`, one stream
+// per key, because each key needs its own subscription and initial values.
+class get_all_datum_stream_t : public lazy_datum_stream_t {
+public:
+    get_all_datum_stream_t(
+        scoped_ptr_t<reader_t> &&_reader,
+        std::vector<counted_t<datum_stream_t> > &&_key_streams,
+        backtrace_id_t bt);
+
+private:
+    virtual std::vector<changespec_t> get_changespecs();
+    virtual void add_transformation(transform_variant_t &&tv,
+                                    backtrace_id_t bt);
+
+    // These are never read from, except by changefeeds.
+    std::vector<counted_t<datum_stream_t> > key_streams;
+};
+
 class vector_datum_stream_t : public eager_datum_stream_t {
 public:
     vector_datum_stream_t(
@@ -1,9 +1,12 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/env.hpp"
 
+#include <algorithm>
+
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
+#include "arch/runtime/coroutines.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
 #include "extproc/js_runner.hpp"
 #include "rdb_protocol/counted_term.hpp"
@@ -153,9 +156,12 @@ env_t::env_t(rdb_context_t *ctx,
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(_trace),
-      evals_since_yield_(0),
+      evals_since_clock_check_(0),
+      last_yield_ticks_(get_ticks()),
       rdb_ctx_(ctx),
-      eval_callback_(NULL) {
+      eval_callback_(NULL),
+      query_resources_(NULL),
+      evaluating_changes_source_(false) {
     rassert(ctx != NULL);
     rassert(interruptor != NULL);
 }
@@ -171,9 +177,12 @@ env_t::env_t(signal_t *_interruptor,
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(NULL),
-      evals_since_yield_(0),
+      evals_since_clock_check_(0),
+      last_yield_ticks_(get_ticks()),
       rdb_ctx_(NULL),
-      eval_callback_(NULL) {
+      eval_callback_(NULL),
+      query_resources_(NULL),
+      evaluating_changes_source_(false) {
     rassert(interruptor != NULL);
 }
 
@@ -188,12 +197,34 @@ profile_bool_t profile_bool_optarg(const protob_t<Query> &query) {
     }
 }
 
+query_priority_t query_priority_optarg(const protob_t<Query> &query) {
+    rassert(query.has());
+    query_priority_t priority = query_priority_t::NORMAL;
+    datum_t priority_arg = static_optarg("priority", query);
+    if (priority_arg.has()) {
+        rcheck_toplevel(
+            priority_arg.get_type() == datum_t::type_t::R_STR
+            && query_priority_from_string(priority_arg.as_str().to_std(), &priority),
+            base_exc_t::GENERIC,
+            "The `priority` optarg must be \"high\", \"normal\", or \"low\".");
+    }
+    return priority;
+}
+
 env_t::~env_t() { }
 
 void env_t::maybe_yield() {
-    if (++evals_since_yield_ > EVALS_BEFORE_YIELD) {
-        evals_since_yield_ = 0;
+    if (++evals_since_clock_check_ < EVALS_PER_CLOCK_CHECK) {
+        return;
+    }
+    evals_since_clock_check_ = 0;
+    // Time spent blocked doesn't count, so a query that just waited for a read
+    // doesn't yield again right away.  Queries served from the query cache track when
+    // they last stopped waiting; others just count from their last yield.
+    ticks_t slice_start = std::max(last_yield_ticks_, coro_t::last_resumed_ticks());
+    if (get_ticks() - slice_start >= EVAL_SLICE_USECS * 1000) {
         coro_t::yield();
+        last_yield_ticks_ = get_ticks();
     }
 }
 
@@ -18,6 +18,7 @@
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/val.hpp"
+#include "time.hpp"
 
 class extproc_pool_t;
 
@@ -27,6 +28,7 @@ class RE2;
 
 namespace ql {
 class datum_t;
+class query_resources_t;
 class term_t;
 
 /* If and optarg with the given key is present and is of type DATUM it will be
@@ -52,6 +54,9 @@ private:
 
 profile_bool_t profile_bool_optarg(const protob_t<Query> &query);
 
+// Reads the `priority` global optarg, which defaults to "normal".
+query_priority_t query_priority_optarg(const protob_t<Query> &query);
+
 scoped_ptr_t<profile::trace_t> maybe_make_profile_trace(profile_bool_t profile);
 
 struct regex_cache_t {
@@ -78,7 +83,10 @@ public:
 
     ~env_t();
 
-    // Will yield after EVALS_BEFORE_YIELD calls
+    // Yields if this query has been evaluating for more than `EVAL_SLICE_USECS`
+    // since the last time it yielded here or blocked, so that a single CPU-heavy query can't
+    // starve the other coroutines on its thread.  Call this from loops that can run
+    // for a long time without evaluating terms.
     void maybe_yield();
 
     extproc_pool_t *get_extproc_pool();
@@ -110,6 +118,32 @@ public:
         return global_optargs_.get_optarg(env, key);
     }
 
+    // Set for queries that are run on behalf of a client, so that table reads can
+    // account for what they cost. NULL otherwise.
+    void set_query_resources(query_resources_t *resources) {
+        query_resources_ = resources;
+    }
+    query_resources_t *query_resources() const { return query_resources_; }
+
+    // Exists while `changes` evaluates the sequence it watches.  The changefeed on a
+    // table must stay one on the whole table, so `filter` doesn't turn reads of it
+    // into index reads then.
+    class changes_source_t {
+    public:
+        explicit changes_source_t(env_t *env)
+            : env_(env), was_evaluating_(env->evaluating_changes_source_) {
+            env_->evaluating_changes_source_ = true;
+        }
+        ~changes_source_t() {
+            env_->evaluating_changes_source_ = was_evaluating_;
+        }
+    private:
+        env_t *env_;
+        bool was_evaluating_;
+        DISABLE_COPYING(changes_source_t);
+    };
+    bool evaluating_changes_source() const { return evaluating_changes_source_; }
+
     configured_limits_t limits() const { return limits_; }
 
     regex_cache_t &regex_cache() { return regex_cache_; }
@@ -145,8 +179,12 @@ public:
 
     rdb_context_t *get_rdb_ctx() { return rdb_ctx_; }
 private:
-    static const uint32_t EVALS_BEFORE_YIELD = 256;
-    uint32_t evals_since_yield_;
+    // Reading the clock isn't free, so `maybe_yield` only looks at it once every
+    // `EVALS_PER_CLOCK_CHECK` calls.
+    static const uint32_t EVALS_PER_CLOCK_CHECK = 64;
+    static const ticks_t EVAL_SLICE_USECS = 2000;
+    uint32_t evals_since_clock_check_;
+    ticks_t last_yield_ticks_;
 
     rdb_context_t *const rdb_ctx_;
 
@@ -154,6 +192,10 @@ private:
 
     eval_callback_t *eval_callback_;
 
+    query_resources_t *query_resources_;
+
+    bool evaluating_changes_source_;
+
     DISABLE_COPYING(env_t);
 };
 
@@ -32,6 +32,28 @@ scoped_ptr_t<val_t> func_t::call(env_t *env,
     return call(env, make_vector(arg1, arg2), eval_flags);
 }
 
+std::vector<datum_t> func_t::call_batch(env_t *env,
+                                        const std::vector<datum_t> &args) const {
+    std::vector<datum_t> results;
+    results.reserve(args.size());
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        results.push_back(call(env, *it)->as_datum());
+    }
+    return results;
+}
+
+std::vector<bool> func_t::filter_call_batch(
+        env_t *env,
+        const std::vector<datum_t> &args,
+        counted_t<const func_t> default_filter_val) const {
+    std::vector<bool> results;
+    results.reserve(args.size());
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        results.push_back(filter_call(env, *it, default_filter_val));
+    }
+    return results;
+}
+
 void func_t::assert_deterministic(const char *extra_msg) const {
     rcheck(is_deterministic(),
            base_exc_t::GENERIC,
@@ -74,6 +96,46 @@ scoped_ptr_t<val_t> reql_func_t::call(env_t *env,
     }
 }
 
+std::vector<datum_t> reql_func_t::call_batch(env_t *env,
+                                             const std::vector<datum_t> &args) const {
+    if (!body->can_eval_batch() || arg_names.size() > 1) {
+        return func_t::call_batch(env, args);
+    }
+
+    try {
+        std::vector<scoped_ptr_t<scope_env_t> > scope_envs;
+        std::vector<scope_env_t *> scope_env_ptrs;
+        scope_envs.reserve(args.size());
+        scope_env_ptrs.reserve(args.size());
+        for (auto it = args.begin(); it != args.end(); ++it) {
+            var_scope_t new_scope = arg_names.size() == 0
+                ? captured_scope
+                : captured_scope.with_func_arg_list(arg_names, make_vector(*it));
+            scope_envs.push_back(make_scoped<scope_env_t>(env, std::move(new_scope)));
+            scope_env_ptrs.push_back(scope_envs.back().get());
+        }
+
+        std::vector<datum_t> results;
+        results.reserve(args.size());
+        while (results.size() < args.size()) {
+            std::vector<scope_env_t *> rest(scope_env_ptrs.begin() + results.size(),
+                                            scope_env_ptrs.end());
+            std::vector<eval_batch_result_t> batch;
+            body->eval_batch(rest, &batch);
+            for (auto it = batch.begin(); it != batch.end(); ++it) {
+                if (it->exc) {
+                    std::rethrow_exception(it->exc);
+                }
+                results.push_back(std::move(it->datum));
+            }
+        }
+        return results;
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
 boost::optional<size_t> reql_func_t::arity() const {
     return arg_names.size();
 }
@@ -124,6 +186,77 @@ scoped_ptr_t<val_t> js_func_t::call(
     }
 }
 
+std::vector<js_result_t> js_func_t::js_call_batch(
+        env_t *env,
+        const std::vector<datum_t> &args) const {
+    js_runner_t::req_config_t config;
+    config.timeout_ms = js_timeout_ms;
+
+    r_sanity_check(!js_source.empty());
+    std::vector<std::vector<datum_t> > args_list;
+    args_list.reserve(args.size());
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        args_list.push_back(make_vector(*it));
+    }
+
+    try {
+        return env->get_js_runner()->call_batch(js_source, args_list, config);
+    } catch (const extproc_worker_exc_t &e) {
+        rfail(base_exc_t::GENERIC,
+              "Javascript query `%s` caused a crash in a worker process.",
+              js_source.c_str());
+    } catch (const interrupted_exc_t &e) {
+        rfail(base_exc_t::GENERIC,
+              "JavaScript query `%s` timed out after "
+              "%" PRIu64 ".%03" PRIu64 " seconds.",
+              js_source.c_str(), js_timeout_ms / 1000, js_timeout_ms % 1000);
+    }
+    unreachable();
+}
+
+datum_t js_func_t::js_result_to_datum(const js_result_t &result) const {
+    try {
+        scoped_ptr_t<val_t> val(
+            boost::apply_visitor(
+                js_result_visitor_t(js_source, js_timeout_ms, this), result));
+        return val->as_datum();
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
+std::vector<datum_t> js_func_t::call_batch(env_t *env,
+                                           const std::vector<datum_t> &args) const {
+    std::vector<js_result_t> js_results = js_call_batch(env, args);
+    std::vector<datum_t> results;
+    results.reserve(js_results.size());
+    for (auto it = js_results.begin(); it != js_results.end(); ++it) {
+        results.push_back(js_result_to_datum(*it));
+    }
+    // A short batch always ends in a timeout error, which we threw above.
+    r_sanity_check(results.size() == args.size());
+    return results;
+}
+
+std::vector<bool> js_func_t::filter_call_batch(
+        env_t *env,
+        const std::vector<datum_t> &args,
+        counted_t<const func_t> default_filter_val) const {
+    std::vector<js_result_t> js_results = js_call_batch(env, args);
+    r_sanity_check(js_results.size() <= args.size());
+    std::vector<bool> results;
+    results.reserve(js_results.size());
+    for (auto it = js_results.begin(); it != js_results.end(); ++it) {
+        results.push_back(filter_with_default(
+            env,
+            [&]() { return js_result_to_datum(*it).as_bool(); },
+            default_filter_val));
+    }
+    r_sanity_check(results.size() == args.size());
+    return results;
+}
+
 boost::optional<size_t> js_func_t::arity() const {
     return boost::none;
 }
@@ -288,13 +421,21 @@ bool js_func_t::filter_helper(env_t *env, datum_t arg) const {
 }
 
 bool func_t::filter_call(env_t *env, datum_t arg, counted_t<const func_t> default_filter_val) const {
+    return filter_with_default(env,
+                               [&]() { return filter_helper(env, arg); },
+                               default_filter_val);
+}
+
+bool func_t::filter_with_default(env_t *env,
+                                 const std::function<bool()> &predicate,
+                                 counted_t<const func_t> default_filter_val) {
     // We have to catch every exception type and save it so we can rethrow it later
     // So we don't trigger a coroutine wait in a catch statement
     std::exception_ptr saved_exception;
     base_exc_t::type_t exception_type;
 
     try {
-        return filter_helper(env, arg);
+        return predicate();
     } catch (const base_exc_t &e) {
         saved_exception = std::current_exception();
         exception_type = e.get_type();
@@ -2,6 +2,7 @@
 #ifndef RDB_PROTOCOL_FUNC_HPP_
 #define RDB_PROTOCOL_FUNC_HPP_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
@@ -49,6 +50,16 @@ public:
                      datum_t arg,
                      counted_t<const func_t> default_filter_val) const;
 
+    // Equivalent to calling the function on each element of `args` in turn (and
+    // throwing the first error encountered).  `js_func_t` overrides these so that
+    // a whole batch goes to the JavaScript worker process in one round trip.
+    virtual std::vector<datum_t> call_batch(env_t *env,
+                                            const std::vector<datum_t> &args) const;
+    virtual std::vector<bool> filter_call_batch(
+        env_t *env,
+        const std::vector<datum_t> &args,
+        counted_t<const func_t> default_filter_val) const;
+
     // These are simple, they call the vector version of call.
     scoped_ptr_t<val_t> call(env_t *env, eval_flags_t eval_flags = NO_FLAGS) const;
     scoped_ptr_t<val_t> call(env_t *env,
@@ -62,6 +73,12 @@ public:
 protected:
     explicit func_t(backtrace_id_t bt);
 
+    // Applies `filter`'s default value semantics to the errors thrown by
+    // `predicate`.
+    static bool filter_with_default(env_t *env,
+                                    const std::function<bool()> &predicate,
+                                    counted_t<const func_t> default_filter_val);
+
 private:
     virtual bool filter_helper(env_t *env, datum_t arg) const = 0;
 
@@ -81,6 +98,10 @@ public:
         const std::vector<datum_t> &args,
         eval_flags_t eval_flags) const;
 
+    // Lets the body evaluate the whole batch at once, if it knows how to.
+    std::vector<datum_t> call_batch(env_t *env,
+                                    const std::vector<datum_t> &args) const;
+
     boost::optional<size_t> arity() const;
 
     bool is_deterministic() const;
@@ -89,6 +110,10 @@ public:
 
     void visit(func_visitor_t *visitor) const;
 
+    // Used to recognize simple predicates and index functions.
+    const std::vector<sym_t> &get_arg_names() const { return arg_names; }
+    const counted_t<const term_t> &get_body() const { return body; }
+
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
@@ -118,6 +143,13 @@ public:
                              const std::vector<datum_t> &args,
                              eval_flags_t eval_flags) const;
 
+    std::vector<datum_t> call_batch(env_t *env,
+                                    const std::vector<datum_t> &args) const;
+    std::vector<bool> filter_call_batch(
+        env_t *env,
+        const std::vector<datum_t> &args,
+        counted_t<const func_t> default_filter_val) const;
+
     boost::optional<size_t> arity() const;
 
     bool is_deterministic() const;
@@ -130,6 +162,13 @@ private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
 
+    // Calls the function with each element of `args` as its single argument.
+    // The result may be shorter than `args` if a row timed out, in which case the
+    // last result is the timeout error.
+    std::vector<js_result_t> js_call_batch(env_t *env,
+                                           const std::vector<datum_t> &args) const;
+    datum_t js_result_to_datum(const js_result_t &result) const;
+
     std::string js_source;
     uint64_t js_timeout_ms;
 
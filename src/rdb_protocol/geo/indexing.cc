@@ -31,6 +31,8 @@ using ql::datum_t;
 //   (...at index creation?)
 extern const int GEO_INDEX_GOAL_GRID_CELLS = 8;
 
+extern const int QUERYING_GOAL_GRID_CELLS = GEO_INDEX_GOAL_GRID_CELLS * 2;
+
 class compute_covering_t : public s2_geo_visitor_t<scoped_ptr_t<std::vector<S2CellId> > > {
 public:
     explicit compute_covering_t(int goal_cells) {
@@ -77,6 +79,27 @@ S2CellId key_to_s2cellid(const std::string &sid) {
     return S2CellId::FromToken(sid.substr(2));
 }
 
+key_range_t s2cellid_range_to_key_range(
+        S2CellId first,
+        S2CellId last,
+        ql::skey_version_t skey_version) {
+    guarantee(first <= last);
+    std::string left = s2cellid_to_key(first);
+    // Every key for `last` starts with its hexadecimal ID, so all of them are smaller
+    // than the key for the next ID.
+    std::string right = s2cellid_to_key(S2CellId(last.id() + 1));
+    switch (skey_version) {
+        case ql::skey_version_t::pre_1_16: break;
+        case ql::skey_version_t::post_1_16:
+            left[0] |= 0x80;
+            right[0] |= 0x80;
+            break;
+        default: unreachable();
+    }
+    return key_range_t(key_range_t::closed, store_key_t(left),
+                       key_range_t::open, store_key_t(right));
+}
+
 /* Returns the S2CellId corresponding to the given key, which must be a correctly
 formatted sindex key. */
 S2CellId btree_key_to_s2cellid(const btree_key_t *key) {
@@ -248,7 +271,8 @@ geo_index_traversal_helper_t::handle_pair(
     }
 
     const S2CellId key_cell = btree_key_to_s2cellid(keyvalue.key());
-    if (any_query_cell_intersects(key_cell.range_min(), key_cell.range_max())) {
+    if (any_query_cell_intersects(key_cell.range_min(), key_cell.range_max())
+        && may_intersect_cell(key_cell)) {
         return on_candidate(std::move(keyvalue), waiter);
     } else {
         return continue_bool_t::CONTINUE;
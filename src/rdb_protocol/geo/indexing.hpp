@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "btree/concurrent_traversal.hpp"
+#include "btree/keys.hpp"
 #include "containers/counted.hpp"
 #include "rdb_protocol/geo/s2/s2cellid.h"
 
@@ -26,10 +27,24 @@ See the comments in s2regioncoverer.h for further explanation and for statistics
 on the effects of different choices of this parameter.*/
 extern const int GEO_INDEX_GOAL_GRID_CELLS;
 
+/* How many grid cells to use for querying a secondary index.
+It typically makes sense to use more grid cells (i.e. finer covering) here
+than it does for inserting data into a geo index, since there is no disk
+overhead involved here and a finer grid avoids unnecessary post-filtering. */
+extern const int QUERYING_GOAL_GRID_CELLS;
+
 std::vector<std::string> compute_index_grid_keys(
         const ql::datum_t &key,
         int goal_cells);
 
+/* Returns the range of B-tree keys under which a geospatial index stores the entries
+for all cells from `first` to `last`, inclusive. The entries of a cell and all of its
+descendants are stored under `cell.range_min()` to `cell.range_max()`. */
+key_range_t s2cellid_range_to_key_range(
+        geo::S2CellId first,
+        geo::S2CellId last,
+        ql::skey_version_t skey_version);
+
 // TODO (daniel): Support compound indexes somehow.
 class geo_index_traversal_helper_t : public concurrent_traversal_callback_t {
 public:
@@ -57,6 +72,15 @@ public:
             const btree_key_t *right_incl,
             bool *skip_out);
 
+protected:
+    /* Called with the grid cell of every pair whose cell intersects with
+    query_grid_keys, before `on_candidate()`. Implementations can return `false` to
+    skip pairs whose cell can't intersect with the query geometry, without loading
+    the document. */
+    virtual bool may_intersect_cell(UNUSED const geo::S2CellId &key_cell) {
+        return true;
+    }
+
 private:
     static bool cell_intersects_with_range(const geo::S2CellId c,
                                            const geo::S2CellId left_min,
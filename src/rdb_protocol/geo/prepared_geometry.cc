@@ -0,0 +1,95 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/geo/prepared_geometry.hpp"
+
+#include "rdb_protocol/geo/exceptions.hpp"
+#include "rdb_protocol/geo/geojson.hpp"
+#include "rdb_protocol/geo/geo_visitor.hpp"
+#include "rdb_protocol/geo/indexing.hpp"
+#include "rdb_protocol/geo/intersection.hpp"
+#include "rdb_protocol/geo/s2/s2cell.h"
+#include "rdb_protocol/geo/s2/s2polygon.h"
+#include "rdb_protocol/geo/s2/s2polyline.h"
+
+using geo::S2Cell;
+using geo::S2Point;
+using geo::S2Polygon;
+using geo::S2Polyline;
+
+template<class first_t>
+class prepared_intersection_tester_t : public s2_geo_visitor_t<bool> {
+public:
+    explicit prepared_intersection_tester_t(const first_t *first) : first_(first) { }
+
+    bool on_point(const S2Point &point) {
+        return geo_does_intersect(*first_, point);
+    }
+    bool on_line(const S2Polyline &line) {
+        return geo_does_intersect(*first_, line);
+    }
+    bool on_polygon(const S2Polygon &polygon) {
+        return geo_does_intersect(*first_, polygon);
+    }
+
+private:
+    const first_t *first_;
+};
+
+prepared_geometry_t::prepared_geometry_t(
+        const ql::datum_t &geometry, int goal_cells)
+    : geometry_(geometry),
+      grid_keys_(compute_index_grid_keys(geometry, goal_cells)) {
+    // `compute_index_grid_keys` has already rejected unsupported types.
+    datum_string_t type = geometry.get_field("type").as_str();
+    ql::datum_t coordinates = geometry.get_field("coordinates");
+    if (type == "Point") {
+        point_ = coordinates_to_s2point(coordinates);
+    } else if (type == "LineString") {
+        line_ = coordinates_to_s2polyline(coordinates);
+    } else {
+        guarantee(type == "Polygon");
+        polygon_ = coordinates_to_s2polygon(coordinates);
+    }
+}
+
+prepared_geometry_t::~prepared_geometry_t() { }
+
+bool prepared_geometry_t::may_intersect(const S2Cell &cell) const {
+    if (point_.has()) {
+        return cell.Contains(*point_);
+    } else if (line_.has()) {
+        return line_->MayIntersect(cell);
+    } else {
+        return polygon_->num_vertices() != 0 && polygon_->MayIntersect(cell);
+    }
+}
+
+bool prepared_geometry_t::intersects(const ql::datum_t &other) const {
+    if (point_.has()) {
+        prepared_intersection_tester_t<S2Point> tester(point_.get());
+        return visit_geojson(&tester, other);
+    } else if (line_.has()) {
+        prepared_intersection_tester_t<S2Polyline> tester(line_.get());
+        return visit_geojson(&tester, other);
+    } else {
+        prepared_intersection_tester_t<S2Polygon> tester(polygon_.get());
+        return visit_geojson(&tester, other);
+    }
+}
+
+geo_query_cache_t::geo_query_cache_t() : cache_(MAX_CACHED_GEOMETRIES) { }
+
+counted_t<const prepared_geometry_t> geo_query_cache_t::get(
+        const ql::datum_t &geometry, int goal_cells) {
+    assert_thread();
+    counted_t<const prepared_geometry_t> *entry =
+        &cache_[strprintf("%d:", goal_cells) + geometry.print()];
+    // Two geometries can print the same if their numbers differ only beyond the
+    // printed precision, so we don't trust the key alone.
+    if (!entry->has() || (*entry)->get_datum() != geometry) {
+        counted_t<const prepared_geometry_t> prepared =
+            make_counted<prepared_geometry_t>(geometry, goal_cells);
+        // Constructing `prepared` can't block, so `entry` is still valid.
+        *entry = prepared;
+    }
+    return *entry;
+}
@@ -0,0 +1,72 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_GEO_PREPARED_GEOMETRY_HPP_
+#define RDB_PROTOCOL_GEO_PREPARED_GEOMETRY_HPP_
+
+#include <string>
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "containers/lru_cache.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/geo/s2/util/math/vector3.h"
+#include "threading.hpp"
+
+namespace geo {
+typedef Vector3_d S2Point;
+class S2Cell;
+class S2Polyline;
+class S2Polygon;
+}
+
+/* `prepared_geometry_t` is a query geometry that has been converted to S2 once, along
+with the grid cells covering it. Geospatial index traversals use it so they don't have
+to re-parse the query geometry for every candidate they test. */
+class prepared_geometry_t : public single_threaded_countable_t<prepared_geometry_t> {
+public:
+    /* Throws `geo_exception_t` if `geometry` is not a supported GeoJSON object. */
+    prepared_geometry_t(const ql::datum_t &geometry, int goal_cells);
+    ~prepared_geometry_t();
+
+    const ql::datum_t &get_datum() const { return geometry_; }
+    const std::vector<std::string> &get_grid_keys() const { return grid_keys_; }
+
+    /* Returns `false` only if nothing inside of `cell` can intersect with the
+    geometry. */
+    bool may_intersect(const geo::S2Cell &cell) const;
+
+    /* Equivalent to `geo_does_intersect(get_datum(), other)`. */
+    bool intersects(const ql::datum_t &other) const;
+
+private:
+    ql::datum_t geometry_;
+    std::vector<std::string> grid_keys_;
+
+    // Exactly one of these is set, depending on the type of the geometry.
+    scoped_ptr_t<geo::S2Point> point_;
+    scoped_ptr_t<geo::S2Polyline> line_;
+    scoped_ptr_t<geo::S2Polygon> polygon_;
+
+    DISABLE_COPYING(prepared_geometry_t);
+};
+
+/* Every store keeps a `geo_query_cache_t` of the geometries it has recently been
+queried with, so repeated `get_intersecting` queries with the same polygon skip the
+covering and parsing. Entries are looked up by the printed geometry and then compared
+in full, so a hit always matches the query exactly. */
+class geo_query_cache_t : public home_thread_mixin_debug_only_t {
+public:
+    geo_query_cache_t();
+
+    counted_t<const prepared_geometry_t> get(
+        const ql::datum_t &geometry, int goal_cells);
+
+private:
+    static const size_t MAX_CACHED_GEOMETRIES = 64;
+
+    lru_cache_t<std::string, counted_t<const prepared_geometry_t> > cache_;
+
+    DISABLE_COPYING(geo_query_cache_t);
+};
+
+#endif  // RDB_PROTOCOL_GEO_PREPARED_GEOMETRY_HPP_
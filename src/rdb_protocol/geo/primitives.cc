@@ -46,9 +46,8 @@ lon_lat_line_t build_circle(
     return result;
 }
 
-/* WARNING: This function is used by nearest_traversal_cb_t::init_query_geometry()
- * and must provide some strict guarantees. Read the notes in that function before
- * modifying this. */
+/* WARNING: This function must provide the strict guarantees described in
+ * primitives.hpp. Read the notes there before modifying this. */
 lon_lat_line_t build_polygon_with_inradius_at_least(
         const lon_lat_point_t &center,
         double min_inradius,
@@ -83,9 +82,8 @@ lon_lat_line_t build_polygon_with_inradius_at_least(
     return build_circle(center, ex_r, num_vertices, e);
 }
 
-/* WARNING: This function is used by nearest_traversal_cb_t::init_query_geometry()
- * and must provide some strict guarantees. Read the notes in that function before
- * modifying this. */
+/* WARNING: This function must provide the strict guarantees described in
+ * primitives.hpp. Read the notes there before modifying this. */
 lon_lat_line_t build_polygon_with_exradius_at_most(
         const lon_lat_point_t &center,
         double max_exradius,
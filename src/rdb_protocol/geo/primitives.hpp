@@ -13,6 +13,20 @@ lon_lat_line_t build_circle(
         unsigned int num_vertices,
         const ellipsoid_spec_t &e);
 
+/* S2 performs intersection tests on a sphere, while our distance metric is defined
+on an ellipsoid. The following two functions still guarantee:
+
+ A polygon constructed through build_polygon_with_exradius_at_most(center, r),
+ must *not* intersect (using spherical geometry) with any point x that has
+ a distance (on any given oblate ellipsoid) dist(center, x) > r.
+
+ Similarly, a polygon constructed through
+ build_polygon_with_inradius_at_least(center, r) must intersect (using
+ spherical geometry) with *every* point x that has a distance (on any given
+ ellipsoid) dist(center, x) <= r.
+
+There is a unit test in geo_primitives.cc to verify this numerically. */
+
 // The resulting polygon has an incircle of at least min_inradius around center.
 lon_lat_line_t build_polygon_with_inradius_at_least(
         const lon_lat_point_t &center,
@@ -1,7 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/geo_traversal.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "errors.hpp"
 #include <boost/variant/get.hpp>
@@ -14,14 +16,17 @@
 #include "rdb_protocol/geo/distances.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/geojson.hpp"
-#include "rdb_protocol/geo/intersection.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
-#include "rdb_protocol/geo/primitives.hpp"
 #include "rdb_protocol/geo/s2/s2.h"
+#include "rdb_protocol/geo/s2/s2cell.h"
+#include "rdb_protocol/geo/s2/s2edgeutil.h"
 #include "rdb_protocol/geo/s2/s2latlng.h"
 #include "rdb_protocol/lazy_json.hpp"
 #include "rdb_protocol/profile.hpp"
 
+using geo::S2Cell;
+using geo::S2CellId;
+using geo::S2EdgeUtil;
 using geo::S2Point;
 using geo::S2LatLng;
 
@@ -29,26 +34,9 @@ using geo::S2LatLng;
 // document multiple times (efficiency optimization).
 const size_t MAX_PROCESSED_SET_SIZE = 10000;
 
-// How many grid cells to use for querying a secondary index.
-// It typically makes sense to use more grid cells (i.e. finer covering) here
-// than it does for inserting data into a geo index, since there is no disk
-// overhead involved here and a finer grid avoids unnecessary post-filtering.
-const int QUERYING_GOAL_GRID_CELLS = GEO_INDEX_GOAL_GRID_CELLS * 2;
-
-// The radius used for the first batch of a get_nearest traversal.
-// As a fraction of the equator's radius.
-// The current value is equivalent to a radius of 10m on earth.
-const double NEAREST_INITIAL_RADIUS_FRACTION = 10.0 / 6378137.0;
-
-// By which factor to increase the radius between nearest batches (at maximum)
-const double NEAREST_MAX_GROWTH_FACTOR = 2.0;
-
-// The desired result size of each nearest batch
-const double NEAREST_GOAL_BATCH_SIZE = 100.0;
-
-// Number of vertices used in get_nearest traversal for approximating the
-// current search range through a polygon.
-const unsigned int NEAREST_NUM_VERTICES = 8;
+// How many index entries a cell may hold for a get_nearest traversal to load all of
+// their documents, rather than looking at its children first.
+const size_t NEAREST_MAX_CELL_ENTRIES = 100;
 
 
 geo_job_data_t::geo_job_data_t(ql::env_t *_env, const ql::batchspec_t &batchspec,
@@ -84,16 +72,24 @@ geo_intersecting_cb_t::geo_intersecting_cb_t(
                                         env->trace));
 }
 
-void geo_intersecting_cb_t::init_query(const ql::datum_t &_query_geometry) {
-    query_geometry = _query_geometry;
-    geo_index_traversal_helper_t::init_query(
-        compute_index_grid_keys(_query_geometry, QUERYING_GOAL_GRID_CELLS));
+void geo_intersecting_cb_t::init_query(
+        const counted_t<const prepared_geometry_t> &_query) {
+    query = _query;
+    geo_index_traversal_helper_t::init_query(query->get_grid_keys());
+}
+
+bool geo_intersecting_cb_t::may_intersect_cell(const geo::S2CellId &key_cell) {
+    // Every entry in the index is stored under one of the cells covering its
+    // geometry. If the document intersects with the query, the entry for the cell
+    // containing an intersection point passes this test, so we don't miss it by
+    // skipping the others without loading the document.
+    return query->may_intersect(geo::S2Cell(key_cell));
 }
 
 continue_bool_t geo_intersecting_cb_t::on_candidate(scoped_key_value_t &&keyvalue,
         concurrent_traversal_fifo_enforcer_signal_t waiter)
         THROWS_ONLY(interrupted_exc_t) {
-    guarantee(query_geometry.has());
+    guarantee(query.has());
     sampler->new_sample();
 
     store_key_t store_key(keyvalue.key());
@@ -145,9 +141,7 @@ continue_bool_t geo_intersecting_cb_t::on_candidate(scoped_key_value_t &&keyvalu
             sindex_val = sindex_val.get(*tag, ql::NOTHROW);
             guarantee(sindex_val.has());
         }
-        // TODO (daniel): This is a little inefficient because we re-parse
-        //   the query_geometry for each test.
-        if (geo_does_intersect(query_geometry, sindex_val)
+        if (query->intersects(sindex_val)
             && post_filter(sindex_val, val)) {
             if (distinct_emitted->size() >= env->limits().array_size_limit()) {
                 emit_error(ql::exc_t(ql::base_exc_t::GENERIC,
@@ -186,14 +180,14 @@ collect_all_geo_intersecting_cb_t::collect_all_geo_intersecting_cb_t(
         btree_slice_t *_slice,
         geo_job_data_t &&_job,
         geo_sindex_data_t &&_sindex,
-        const ql::datum_t &_query_geometry,
+        const counted_t<const prepared_geometry_t> &_query,
         const key_range_t &_sindex_range,
         rget_read_response_t *_resp_out)
     : geo_intersecting_cb_t(_slice, std::move(_sindex), _job.env, &distinct_emitted),
       job(std::move(_job)), response(_resp_out) {
     guarantee(response != NULL);
     response->last_key = _sindex_range.left;
-    init_query(_query_geometry);
+    init_query(_query);
 }
 
 void collect_all_geo_intersecting_cb_t::finish() THROWS_ONLY(interrupted_exc_t) {
@@ -239,165 +233,211 @@ void collect_all_geo_intersecting_cb_t::emit_error(
 
 
 /* ----------- nearest traversal -----------*/
-nearest_traversal_state_t::nearest_traversal_state_t(
-        const lon_lat_point_t &_center,
-        uint64_t _max_results,
-        double _max_radius,
-        const ellipsoid_spec_t &_reference_ellipsoid) :
-    previous_size(0),
-    processed_inradius(0.0),
-    current_inradius(std::min(_max_radius,
-            NEAREST_INITIAL_RADIUS_FRACTION * _reference_ellipsoid.equator_radius())),
-    center(_center),
-    max_results(_max_results),
-    max_radius(_max_radius),
-    reference_ellipsoid(_reference_ellipsoid) { }
-
-continue_bool_t nearest_traversal_state_t::proceed_to_next_batch() {
-    // Estimate the result density based on the previous batch
-    const size_t previous_num_results = distinct_emitted.size() - previous_size;
-    const double previous_area = M_PI *
-        (current_inradius * current_inradius - processed_inradius * processed_inradius);
-    const double previous_density =
-        static_cast<double>(previous_num_results) / previous_area;
-
-    processed_inradius = current_inradius;
-    previous_size = distinct_emitted.size();
-
-    // Adapt the radius based on the density of the previous batch.
-    // Solve for current_inradius: NEAREST_GOAL_BATCH_SIZE =
-    //   M_PI * (current_inradius^2 - processed_inradius^2) * previous_density
-    // <=> current_inradius^2 =
-    //   NEAREST_GOAL_BATCH_SIZE / M_PI / previous_density + processed_inradius^2
-    if (previous_density != 0.0) {
-        current_inradius = sqrt((NEAREST_GOAL_BATCH_SIZE / M_PI / previous_density)
-                                + (processed_inradius * processed_inradius));
-    } else {
-        current_inradius = processed_inradius * NEAREST_MAX_GROWTH_FACTOR;
-    }
+/* Loads the documents of the index entries in a range of cells, or just counts the
+entries if `parent` is `NULL`. */
+class nearest_cell_scan_cb_t : public concurrent_traversal_callback_t {
+public:
+    nearest_cell_scan_cb_t(nearest_traversal_t *_parent, size_t _max_entries)
+        : parent(_parent), max_entries(_max_entries), num_entries(0) { }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue,
+                                concurrent_traversal_fifo_enforcer_signal_t waiter)
+            THROWS_ONLY(interrupted_exc_t) {
+        if (parent == NULL) {
+            ++num_entries;
+            return num_entries > max_entries
+                ? continue_bool_t::ABORT
+                : continue_bool_t::CONTINUE;
+        }
+        parent->sampler->new_sample();
+
+        store_key_t store_key(keyvalue.key());
+        store_key_t primary_key(ql::datum_t::extract_primary(store_key));
+        if (!parent->sindex.pkey_range.contains_key(primary_key)
+            || parent->loaded.count(primary_key) > 0) {
+            return continue_bool_t::CONTINUE;
+        }
 
-    // In addition, put a limit on how fast the radius can grow, so we don't
-    // increase it to ridiculous sizes just to encounter some cluster of results
-    // later.
-    current_inradius =
-        std::min(current_inradius,
-                 std::min(current_inradius * NEAREST_MAX_GROWTH_FACTOR, max_radius));
+        lazy_json_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
+                        keyvalue.expose_buf());
+        ql::datum_t val = row.get();
+        parent->slice->stats.pm_keys_read.record();
+        parent->slice->stats.pm_total_keys_read += 1;
+        guarantee(!row.references_parent());
+        keyvalue.reset();
 
-    if (processed_inradius >= max_radius || distinct_emitted.size() >= max_results) {
+        waiter.wait_interruptible();
+
+        // Another coroutine could have loaded the same document in the meantime.
+        if (parent->loaded.count(primary_key) > 0) {
+            return continue_bool_t::CONTINUE;
+        }
+        parent->loaded.insert(primary_key);
+
+        try {
+            ql::env_t sindex_env(parent->env->interruptor,
+                                 ql::return_empty_normal_batches_t::NO,
+                                 parent->sindex.func_reql_version);
+            ql::datum_t sindex_val =
+                parent->sindex.func->call(&sindex_env, val)->as_datum();
+            double dist;
+            if (parent->sindex.multi == sindex_multi_bool_t::MULTI
+                && sindex_val.get_type() == ql::datum_t::R_ARRAY) {
+                // The document is only loaded for the first of its index entries
+                // that we come across, but it's as near as its nearest element.
+                dist = std::numeric_limits<double>::infinity();
+                for (size_t i = 0; i < sindex_val.arr_size(); ++i) {
+                    dist = std::min(dist, geodesic_distance(
+                        parent->center, sindex_val.get(i),
+                        parent->reference_ellipsoid));
+                }
+            } else {
+                dist = geodesic_distance(
+                    parent->center, sindex_val, parent->reference_ellipsoid);
+            }
+            if (dist <= parent->max_dist) {
+                nearest_traversal_t::queue_entry_t entry;
+                entry.dist = dist;
+                entry.doc = std::move(val);
+                parent->queue.push(std::move(entry));
+            }
+            return continue_bool_t::CONTINUE;
+        } catch (const ql::exc_t &e) {
+            parent->error = e;
+        } catch (const geo_exception_t &e) {
+            parent->error = ql::exc_t(ql::base_exc_t::GENERIC, e.what(),
+                                      ql::backtrace_id_t::empty());
+        } catch (const ql::base_exc_t &e) {
+            parent->error = ql::exc_t(e, ql::backtrace_id_t::empty());
+        }
         return continue_bool_t::ABORT;
-    } else {
-        return continue_bool_t::CONTINUE;
     }
-}
 
-nearest_traversal_cb_t::nearest_traversal_cb_t(
+private:
+    nearest_traversal_t *parent;
+    const size_t max_entries;
+    size_t num_entries;
+};
+
+nearest_traversal_t::nearest_traversal_t(
         btree_slice_t *_slice,
         geo_sindex_data_t &&_sindex,
         ql::env_t *_env,
-        nearest_traversal_state_t *_state) :
-    geo_intersecting_cb_t(_slice, std::move(_sindex), _env, &_state->distinct_emitted),
-    state(_state) {
-    init_query_geometry();
+        const lon_lat_point_t &_center,
+        uint64_t _max_results,
+        double _max_dist,
+        const ellipsoid_spec_t &_reference_ellipsoid)
+    : slice(_slice),
+      sindex(std::move(_sindex)),
+      env(_env),
+      center(S2LatLng::FromDegrees(_center.latitude, _center.longitude).ToPoint()),
+      max_results(_max_results),
+      max_dist(_max_dist),
+      reference_ellipsoid(_reference_ellipsoid),
+      /* In geodetic coordinates, a path on the ellipsoid is at least
+      `equator_radius * min((1 - f)^2, 1 / (1 - f))` times as long as the same path
+      on the unit sphere, where `f` is the flattening. We leave some room for
+      rounding errors on top of that. */
+      distance_per_radian(
+          0.99 * _reference_ellipsoid.equator_radius()
+          * std::min((1.0 - _reference_ellipsoid.flattening())
+                     * (1.0 - _reference_ellipsoid.flattening()),
+                     1.0 / (1.0 - _reference_ellipsoid.flattening()))) {
+    disabler.init(new profile::disabler_t(env->trace));
+    sampler.init(new profile::sampler_t("Geospatial nearest traversal.",
+                                        env->trace));
 }
 
-void nearest_traversal_cb_t::init_query_geometry() {
-    /*
-    Note that S2 performs intersection tests on a sphere, while our distance
-    metric is defined on an ellipsoid.
-
-    The following must hold for this to work:
-
-     A polygon constructed through build_polygon_with_exradius_at_most(center, r),
-     must *not* intersect (using spherical geometry) with any point x that has
-     a distance (on any given oblate ellipsoid) dist(center, x) > r.
-
-     Similarly, a polygon constructed through
-     build_polygon_with_inradius_at_least(center, r) must intersect (using
-     spherical geometry) with *every* point x that has a distance (on any given
-     ellipsoid) dist(center, x) <= r.
-
-    There is a unit test in geo_primitives.cc to verify this numerically.
-    */
-
-    try {
-        // 1. Construct a shape with an exradius of no more than state->processed_inradius.
-        //    This is what we don't have to process again.
-        std::vector<lon_lat_line_t> holes;
-        if (state->processed_inradius > 0.0) {
-            holes.push_back(build_polygon_with_exradius_at_most(
-                state->center, state->processed_inradius,
-                NEAREST_NUM_VERTICES, state->reference_ellipsoid));
-        }
-
-        // 2. Construct the outer shell, a shape with an inradius of at least
-        //    state->current_inradius.
-        lon_lat_line_t shell = build_polygon_with_inradius_at_least(
-            state->center, state->current_inradius,
-            NEAREST_NUM_VERTICES, state->reference_ellipsoid);
-
-        ql::datum_t query_geometry =
-            construct_geo_polygon(shell, holes, ql::configured_limits_t::unlimited);
-        init_query(query_geometry);
-    } catch (const geo_range_exception_t &e) {
-        // The radius has become too large for constructing the query geometry.
-        // Abort.
-        throw geo_range_exception_t(strprintf(
-            "The distance has become too large for continuing the indexed nearest "
-            "traversal.  Consider specifying a smaller `max_dist` parameter.  "
-            "(%s)", e.what()));
-    } catch (const geo_exception_t &e) {
-        crash("Geo exception thrown while initializing nearest query geometry: %s",
-              e.what());
+double nearest_traversal_t::min_distance(const S2CellId &cell_id) const {
+    const S2Cell cell(cell_id);
+    if (cell.Contains(center)) {
+        return 0.0;
     }
+    // Cell edges are geodesics on the sphere, so the closest point of the cell is on
+    // one of them.
+    double min_angle = M_PI;
+    for (int i = 0; i < 4; ++i) {
+        min_angle = std::min(
+            min_angle,
+            S2EdgeUtil::GetDistance(
+                center, cell.GetVertex(i), cell.GetVertex((i + 1) % 4)).radians());
+    }
+    return min_angle * distance_per_radian;
 }
 
-bool nearest_traversal_cb_t::post_filter(
-        const ql::datum_t &sindex_val,
-        UNUSED const ql::datum_t &val)
-        THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
-
-    // Filter out results that are outside of the current inradius
-    const S2Point s2center =
-        S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    return dist <= state->current_inradius;
+void nearest_traversal_t::push_cell(const S2CellId &cell) {
+    queue_entry_t entry;
+    entry.dist = min_distance(cell);
+    if (entry.dist <= max_dist) {
+        entry.cell = cell;
+        queue.push(std::move(entry));
+    }
 }
 
-continue_bool_t nearest_traversal_cb_t::emit_result(
-        ql::datum_t &&sindex_val,
-        UNUSED store_key_t &&key,
-        ql::datum_t &&val)
-        THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
-    // TODO (daniel): Could we avoid re-computing the distance? We have already
-    //   done it in post_filter().
-    const S2Point s2center =
-        S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    result_acc.push_back(std::make_pair(dist, std::move(val)));
-
-    return continue_bool_t::CONTINUE;
+bool nearest_traversal_t::scan_cells(
+        superblock_t *superblock,
+        const S2CellId &first,
+        const S2CellId &last,
+        size_t max_entries)
+        THROWS_ONLY(interrupted_exc_t) {
+    const key_range_t range = s2cellid_range_to_key_range(
+        first, last, ql::skey_version_from_reql_version(sindex.func_reql_version));
+    if (max_entries != std::numeric_limits<size_t>::max()) {
+        // Count the entries before loading anything, so that we don't load
+        // documents from all over a large cell.
+        nearest_cell_scan_cb_t counter(NULL, max_entries);
+        if (btree_concurrent_traversal(
+                superblock, range, &counter, direction_t::FORWARD,
+                release_superblock_t::KEEP) == continue_bool_t::ABORT) {
+            return false;
+        }
+    }
+    nearest_cell_scan_cb_t loader(this, std::numeric_limits<size_t>::max());
+    btree_concurrent_traversal(
+        superblock, range, &loader, direction_t::FORWARD, release_superblock_t::KEEP);
+    return true;
 }
 
-void nearest_traversal_cb_t::emit_error(
-        const ql::exc_t &_error)
+void nearest_traversal_t::run(
+        superblock_t *superblock,
+        nearest_geo_read_response_t *resp_out)
         THROWS_ONLY(interrupted_exc_t) {
-    error = _error;
-}
+    guarantee(resp_out != NULL);
+    for (int face = 0; face < 6; ++face) {
+        push_cell(S2CellId::FromFacePosLevel(face, 0, 0));
+    }
 
-bool nearest_pairs_less(
-        const std::pair<double, ql::datum_t> &p1,
-        const std::pair<double, ql::datum_t> &p2) {
-    // We only care about the distance, don't compare the actual data.
-    return p1.first < p2.first;
-}
+    nearest_geo_read_response_t::result_t results;
+    while (!queue.empty() && results.size() < max_results && !error) {
+        if (env->interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        queue_entry_t entry = queue.top();
+        queue.pop();
+        if (entry.doc.has()) {
+            results.push_back(std::make_pair(entry.dist, std::move(entry.doc)));
+            continue;
+        }
+
+        const S2CellId &cell = entry.cell;
+        if (cell.is_leaf()) {
+            scan_cells(superblock, cell, cell, std::numeric_limits<size_t>::max());
+        } else if (!scan_cells(superblock, cell.range_min(), cell.range_max(),
+                               NEAREST_MAX_CELL_ENTRIES)) {
+            // Too many entries to load them all. Take the ones stored under the cell
+            // itself, which none of the children cover.
+            scan_cells(superblock, cell, cell, std::numeric_limits<size_t>::max());
+            for (S2CellId child = cell.child_begin();
+                 child != cell.child_end();
+                 child = child.next()) {
+                push_cell(child);
+            }
+        }
+    }
 
-void nearest_traversal_cb_t::finish(
-        nearest_geo_read_response_t *resp_out) {
-    guarantee(resp_out != NULL);
     if (error) {
         resp_out->results_or_error = error.get();
     } else {
-        std::sort(result_acc.begin(), result_acc.end(), &nearest_pairs_less);
-        resp_out->results_or_error = std::move(result_acc);
+        resp_out->results_or_error = std::move(results);
     }
 }
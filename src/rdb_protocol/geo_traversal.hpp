@@ -2,6 +2,7 @@
 #ifndef RDB_PROTOCOL_GEO_TRAVERSAL_HPP_
 #define RDB_PROTOCOL_GEO_TRAVERSAL_HPP_
 
+#include <queue>
 #include <set>
 #include <utility>
 #include <vector>
@@ -20,6 +21,8 @@
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
+#include "rdb_protocol/geo/prepared_geometry.hpp"
+#include "rdb_protocol/geo/s2/s2cellid.h"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/shards.hpp"
 
@@ -67,6 +70,8 @@ public:
         multi(_multi) { }
 private:
     friend class geo_intersecting_cb_t;
+    friend class nearest_cell_scan_cb_t;
+    friend class nearest_traversal_t;
     const key_range_t pkey_range;
     const counted_t<const ql::func_t> func;
     const reql_version_t func_reql_version;
@@ -84,7 +89,7 @@ public:
             std::set<store_key_t> *_distinct_emitted_in_out);
     virtual ~geo_intersecting_cb_t() { }
 
-    void init_query(const ql::datum_t &_query_geometry);
+    void init_query(const counted_t<const prepared_geometry_t> &_query);
 
     continue_bool_t on_candidate(scoped_key_value_t &&keyvalue,
                                    concurrent_traversal_fifo_enforcer_signal_t waiter)
@@ -106,10 +111,12 @@ protected:
             const ql::exc_t &error)
             THROWS_ONLY(interrupted_exc_t) = 0;
 
+    bool may_intersect_cell(const geo::S2CellId &key_cell);
+
 private:
     btree_slice_t *slice;
     geo_sindex_data_t sindex;
-    ql::datum_t query_geometry;
+    counted_t<const prepared_geometry_t> query;
 
     ql::env_t *env;
 
@@ -133,7 +140,7 @@ public:
             btree_slice_t *_slice,
             geo_job_data_t &&_job,
             geo_sindex_data_t &&_sindex,
-            const ql::datum_t &_query_geometry,
+            const counted_t<const prepared_geometry_t> &_query,
             const key_range_t &_sindex_range,
             rget_read_response_t *_resp_out);
 
@@ -163,69 +170,85 @@ private:
 };
 
 
-class nearest_traversal_state_t {
+/* Finds the documents closest to `center` with a best-first search over the grid
+cells of a geospatial index, and returns them in order of increasing distance.
+
+The search keeps a priority queue of cells and documents. Documents are ordered by
+their distance from `center`, and cells by a lower bound on the distance of anything
+inside of them. When a cell comes out of the queue and it holds only a few index
+entries, we load all of their documents. Otherwise we load the documents that are
+stored under the cell itself and queue its four children. One of the cells covering
+a document always contains its closest point, so by the time a document comes out of
+the queue, every closer document has already been queued. The search stops as soon
+as `max_results` documents have come out of the queue. */
+class nearest_traversal_t {
 public:
-    nearest_traversal_state_t(
+    nearest_traversal_t(
+            btree_slice_t *_slice,
+            geo_sindex_data_t &&_sindex,
+            ql::env_t *_env,
             const lon_lat_point_t &_center,
             uint64_t _max_results,
-            double _max_radius,
+            double _max_dist,
             const ellipsoid_spec_t &_reference_ellipsoid);
 
-    // Modifies the state such that the next batch will be generated the next
-    // time this state is used.
-    continue_bool_t proceed_to_next_batch();
+    void run(superblock_t *superblock, nearest_geo_read_response_t *resp_out)
+            THROWS_ONLY(interrupted_exc_t);
+
 private:
-    friend class nearest_traversal_cb_t;
+    friend class nearest_cell_scan_cb_t;
+
+    class queue_entry_t {
+    public:
+        // The top of a `std::priority_queue` is its largest element, so this orders
+        // entries by decreasing distance. At the same distance, documents come first.
+        bool operator<(const queue_entry_t &other) const {
+            if (dist != other.dist) {
+                return dist > other.dist;
+            }
+            return !doc.has() && other.doc.has();
+        }
+
+        double dist;
+        // For cells, `doc` is empty.
+        geo::S2CellId cell;
+        ql::datum_t doc;
+    };
+
+    double min_distance(const geo::S2CellId &cell) const;
+    void push_cell(const geo::S2CellId &cell);
+
+    /* Loads the documents in the index entries of the cells from `first` to `last`
+    that we haven't seen yet, and queues them. If the range holds more than
+    `max_entries` entries, it returns `false` without loading any of them. Errors
+    are stored in `error`. */
+    bool scan_cells(
+            superblock_t *superblock,
+            const geo::S2CellId &first,
+            const geo::S2CellId &last,
+            size_t max_entries)
+            THROWS_ONLY(interrupted_exc_t);
 
-    /* State that changes over time */
-    std::set<store_key_t> distinct_emitted;
-    size_t previous_size;
-    // Which radius around `center` has been previously processed?
-    double processed_inradius;
-    double current_inradius;
+    btree_slice_t *slice;
+    geo_sindex_data_t sindex;
+    ql::env_t *env;
 
-    /* Constant data, initialized by the constructor */
-    const lon_lat_point_t center;
+    const geo::S2Point center;
     const uint64_t max_results;
-    const double max_radius;
+    const double max_dist;
     const ellipsoid_spec_t reference_ellipsoid;
-};
-
-// Generates a batch of results, sorted by increasing distance.
-class nearest_traversal_cb_t : public geo_intersecting_cb_t {
-public:
-    nearest_traversal_cb_t(
-            btree_slice_t *_slice,
-            geo_sindex_data_t &&_sindex,
-            ql::env_t *_env,
-            nearest_traversal_state_t *_state);
-
-    void finish(nearest_geo_read_response_t *resp_out);
-
-protected:
-    bool post_filter(
-            const ql::datum_t &sindex_val,
-            const ql::datum_t &val)
-            THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t);
-
-    continue_bool_t emit_result(
-            ql::datum_t &&sindex_val,
-            store_key_t &&key,
-            ql::datum_t &&val)
-            THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t);
-
-    void emit_error(
-            const ql::exc_t &error)
-            THROWS_ONLY(interrupted_exc_t);
+    // Multiplying an angle on the unit sphere by this gives a lower bound on the
+    // distance of two points on `reference_ellipsoid`.
+    const double distance_per_radian;
 
-private:
-    void init_query_geometry();
-
-    // Accumulate results for the current batch until finish() is called
-    std::vector<std::pair<double, ql::datum_t> > result_acc;
+    std::priority_queue<queue_entry_t> queue;
+    // The primary keys of the documents we have already loaded.
+    std::set<store_key_t> loaded;
     boost::optional<ql::exc_t> error;
 
-    nearest_traversal_state_t *state;
+    // State for profiling.
+    scoped_ptr_t<profile::disabler_t> disabler;
+    scoped_ptr_t<profile::sampler_t> sampler;
 };
 
 #endif  // RDB_PROTOCOL_GEO_TRAVERSAL_HPP_
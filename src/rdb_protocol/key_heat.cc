@@ -0,0 +1,68 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/key_heat.hpp"
+
+key_heat_sampler_t::key_heat_sampler_t()
+    : accesses_until_sample_(SAMPLE_INTERVAL), last_decay_(get_ticks()) { }
+
+void key_heat_sampler_t::record(const store_key_t &key) {
+    assert_thread();
+    if (--accesses_until_sample_ > 0) {
+        return;
+    }
+    accesses_until_sample_ = SAMPLE_INTERVAL;
+    decay(get_ticks());
+
+    auto it = heat_.find(key);
+    if (it == heat_.end()) {
+        while (heat_.size() >= MAX_SAMPLED_KEYS) {
+            halve();
+        }
+        heat_.insert(std::make_pair(key, 1.0));
+    } else {
+        it->second += 1.0;
+    }
+}
+
+void key_heat_sampler_t::get_heat(
+        const key_range_t &range,
+        std::map<store_key_t, int64_t> *heat_out) {
+    assert_thread();
+    decay(get_ticks());
+    heat_out->clear();
+    for (auto it = heat_.lower_bound(range.left); it != heat_.end(); ++it) {
+        if (!range.contains_key(it->first)) {
+            break;
+        }
+        /* Scale back up by the sampling interval so the values are comparable to
+        actual numbers of accesses. */
+        int64_t heat = static_cast<int64_t>(it->second * SAMPLE_INTERVAL);
+        if (heat > 0) {
+            heat_out->insert(std::make_pair(it->first, heat));
+        }
+    }
+}
+
+void key_heat_sampler_t::decay(ticks_t now) {
+    const ticks_t half_life = secs_to_ticks(HALF_LIFE_SECS);
+    while (now - last_decay_ >= half_life) {
+        if (heat_.empty()) {
+            last_decay_ = now;
+            break;
+        }
+        halve();
+        last_decay_ += half_life;
+    }
+}
+
+void key_heat_sampler_t::halve() {
+    for (auto it = heat_.begin(); it != heat_.end();) {
+        it->second /= 2;
+        /* Keys that were only sampled once drop out on the first halving. This
+        guarantees that `record()` can always make room for a new key. */
+        if (it->second < 1.0) {
+            heat_.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
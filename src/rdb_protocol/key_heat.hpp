@@ -0,0 +1,45 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_KEY_HEAT_HPP_
+#define RDB_PROTOCOL_KEY_HEAT_HPP_
+
+#include <map>
+
+#include "btree/keys.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+
+/* `key_heat_sampler_t` keeps a small sample of the keys that a store has recently read
+and written. The distribution read reports it alongside the key counts, so that shard
+boundaries can be chosen by load and not just by data size.
+
+Only one in `SAMPLE_INTERVAL` accesses is recorded, and all counts are halved every
+`HALF_LIFE_SECS` seconds so that old hot spots fade away. If the sample gets full, the
+counts are halved early until there's room again. */
+class key_heat_sampler_t : public home_thread_mixin_debug_only_t {
+public:
+    key_heat_sampler_t();
+
+    void record(const store_key_t &key);
+
+    /* Fills `heat_out` with the sampled keys in `range` and their estimated recent
+    access counts. */
+    void get_heat(
+        const key_range_t &range,
+        std::map<store_key_t, int64_t> *heat_out);
+
+private:
+    static const int SAMPLE_INTERVAL = 16;
+    static const size_t MAX_SAMPLED_KEYS = 512;
+    static const int HALF_LIFE_SECS = 60;
+
+    void decay(ticks_t now);
+    void halve();
+
+    std::map<store_key_t, double> heat_;
+    int accesses_until_sample_;
+    ticks_t last_decay_;
+
+    DISABLE_COPYING(key_heat_sampler_t);
+};
+
+#endif /* RDB_PROTOCOL_KEY_HEAT_HPP_ */
@@ -141,7 +141,11 @@ size_t args_t::num_args() const {
 
 scoped_ptr_t<val_t> args_t::arg(scope_env_t *env, size_t i,
                              eval_flags_t flags) {
-    if (i == 0 && arg0.has()) {
+    if (i == 0 && arg0_exc) {
+        std::exception_ptr exc = arg0_exc;
+        arg0_exc = std::exception_ptr();
+        std::rethrow_exception(exc);
+    } else if (i == 0 && arg0.has()) {
         scoped_ptr_t<val_t> v = std::move(arg0);
         arg0.reset();
         return v;
@@ -160,6 +164,10 @@ args_t::args_t(const op_term_t *_op_term,
                argvec_t _argv,
                scoped_ptr_t<val_t> _arg0)
     : op_term(_op_term), argv(std::move(_argv)), arg0(std::move(_arg0)) { }
+args_t::args_t(const op_term_t *_op_term,
+               argvec_t _argv,
+               std::exception_ptr _arg0_exc)
+    : op_term(_op_term), argv(std::move(_argv)), arg0_exc(std::move(_arg0_exc)) { }
 
 
 op_term_t::op_term_t(compile_env_t *env, const protob_t<const Term> term,
@@ -197,17 +205,7 @@ scoped_ptr_t<val_t> op_term_t::term_eval(scope_env_t *env,
         scoped_ptr_t<val_t> arg0;
         maybe_grouped_data(env, &argv, eval_flags, &gd, &arg0);
         if (gd.has()) {
-            // (arg0 is empty, because maybe_grouped_data sets at most one of gd and
-            // arg0, so we don't have to worry about re-evaluating it.
-            counted_t<grouped_data_t> out(new grouped_data_t());
-            // We're processing gd into another grouped_data_t -- so gd's order
-            // doesn't matter.
-            for (auto kv = gd->begin(); kv != gd->end(); ++kv) {
-                arg_terms->start_eval(env, eval_flags);
-                args_t args(this, argv, make_scoped<val_t>(kv->second, backtrace()));
-                (*out)[kv->first] = eval_impl(env, &args, eval_flags)->as_datum();
-            }
-            return make_scoped<val_t>(out, backtrace());
+            return eval_grouped(env, argv, eval_flags, gd);
         } else {
             args_t args(this, std::move(argv), std::move(arg0));
             return eval_impl(env, &args, eval_flags);
@@ -218,6 +216,91 @@ scoped_ptr_t<val_t> op_term_t::term_eval(scope_env_t *env,
     }
 }
 
+scoped_ptr_t<val_t> op_term_t::eval_grouped(scope_env_t *env,
+                                            const argvec_t &argv,
+                                            eval_flags_t eval_flags,
+                                            const counted_t<grouped_data_t> &gd) const {
+    // (arg0 is empty, because maybe_grouped_data sets at most one of gd and
+    // arg0, so we don't have to worry about re-evaluating it.
+    counted_t<grouped_data_t> out(new grouped_data_t());
+    // We're processing gd into another grouped_data_t -- so gd's order
+    // doesn't matter.
+    for (auto kv = gd->begin(); kv != gd->end(); ++kv) {
+        arg_terms->start_eval(env, eval_flags);
+        args_t args(this, argv, make_scoped<val_t>(kv->second, backtrace()));
+        (*out)[kv->first] = eval_impl(env, &args, eval_flags)->as_datum();
+    }
+    return make_scoped<val_t>(out, backtrace());
+}
+
+scoped_ptr_t<args_t> op_term_t::make_args(scope_env_t *env,
+                                          eval_flags_t eval_flags,
+                                          scoped_ptr_t<val_t> *grouped_out) const {
+    argvec_t argv = arg_terms->start_eval(env, eval_flags);
+    if (can_be_grouped()) {
+        counted_t<grouped_data_t> gd;
+        scoped_ptr_t<val_t> arg0;
+        maybe_grouped_data(env, &argv, eval_flags, &gd, &arg0);
+        if (gd.has()) {
+            *grouped_out = eval_grouped(env, argv, eval_flags, gd);
+            return scoped_ptr_t<args_t>();
+        } else {
+            return make_scoped<args_t>(this, std::move(argv), std::move(arg0));
+        }
+    } else {
+        return make_scoped<args_t>(this, std::move(argv));
+    }
+}
+
+bool op_term_t::can_eval_batch() const {
+    if (!batches_first_arg()) {
+        return false;
+    }
+    const std::vector<counted_t<const term_t> > &original_args
+        = arg_terms->get_original_args();
+    if (original_args.empty() || !original_args[0]->can_eval_batch()) {
+        return false;
+    }
+    for (size_t i = 0; i < original_args.size(); ++i) {
+        if (original_args[i]->get_src()->type() == Term::ARGS) {
+            return false;
+        }
+    }
+    for (size_t i = 1; i < original_args.size(); ++i) {
+        if (!original_args[i]->is_deterministic()) {
+            return false;
+        }
+    }
+    return all_are_deterministic(optargs);
+}
+
+void op_term_t::eval_batch_impl(const std::vector<scope_env_t *> &envs,
+                                std::vector<eval_batch_result_t> *results_out) const {
+    const counted_t<const term_t> &arg0_term = arg_terms->get_original_args()[0];
+    std::vector<eval_batch_result_t> arg0s;
+    arg0_term->eval_batch(envs, &arg0s);
+
+    // The rest of the term has no side effects, so a row's error doesn't stop the
+    // rows after it.  We evaluate exactly the rows the first argument was
+    // evaluated for.
+    for (size_t row = 0; row < arg0s.size(); ++row) {
+        scope_env_t *env = envs[row];
+        eval_batch_result_t res;
+        try {
+            argvec_t argv = arg_terms->start_eval(env, NO_FLAGS);
+            scoped_ptr_t<args_t> args = arg0s[row].exc
+                ? make_scoped<args_t>(this, std::move(argv), arg0s[row].exc)
+                : make_scoped<args_t>(this, std::move(argv),
+                                      make_scoped<val_t>(std::move(arg0s[row].datum),
+                                                         arg0_term->backtrace()));
+            res.datum = eval_impl(env, args.get(), NO_FLAGS)->as_datum();
+        } catch (const base_exc_t &) {
+            res.exc = std::current_exception();
+        }
+        results_out->push_back(std::move(res));
+    }
+}
+
 bool op_term_t::can_be_grouped() const { return true; }
 bool op_term_t::is_grouped_seq_op() const { return false; }
 
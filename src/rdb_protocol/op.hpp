@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_OP_HPP_
 
 #include <algorithm>
+#include <exception>
 #include <initializer_list>
 #include <map>
 #include <string>
@@ -85,14 +86,17 @@ public:
 
     args_t(const op_term_t *op_term, argvec_t argv);
     args_t(const op_term_t *op_term, argvec_t argv, scoped_ptr_t<val_t> arg0);
+    args_t(const op_term_t *op_term, argvec_t argv, std::exception_ptr arg0_exc);
 
 private:
     const op_term_t *const op_term;
 
     argvec_t argv;
     // Sometimes the 0'th argument has already been evaluated, to see if we are doing
-    // a grouped operation.
+    // a grouped operation, or because it was evaluated in a batch.  In the latter
+    // case it may have failed, and `arg0_exc` is rethrown when it's retrieved.
     scoped_ptr_t<val_t> arg0;
+    std::exception_ptr arg0_exc;
 
     DISABLE_COPYING(args_t);
 };
@@ -128,6 +132,21 @@ protected:
     // a subclass).
     virtual void accumulate_captures(var_captures_t *captures) const;
 
+    // Does the first half of `term_eval`: evaluates any `r.args` arguments and
+    // returns the argument list that `eval_impl` would get in `env`.  If the first
+    // argument turns out to be grouped data, the term is evaluated over each group
+    // instead; the result goes to `*grouped_out` and an empty pointer is returned.
+    scoped_ptr_t<args_t> make_args(scope_env_t *env,
+                                   eval_flags_t eval_flags,
+                                   scoped_ptr_t<val_t> *grouped_out) const;
+
+    // Terms that just compute something from their first argument (e.g. `bracket`
+    // or `default`) return true, so that a batchable first argument (e.g.
+    // `r.http`) is still evaluated in a batch when they are mapped over a sequence.
+    // The term itself is then evaluated for each row in turn, which is only done
+    // if its other arguments have no side effects.
+    virtual bool batches_first_arg() const { return false; }
+
 private:
     friend class args_t;
     // Tries to get an optional argument, returns `scoped_ptr_t<val_t>()` if not found.
@@ -142,6 +161,11 @@ private:
                             counted_t<grouped_data_t> *grouped_data_out,
                             scoped_ptr_t<val_t> *arg0_out) const;
 
+    scoped_ptr_t<val_t> eval_grouped(scope_env_t *env,
+                                     const argvec_t &argv,
+                                     eval_flags_t eval_flags,
+                                     const counted_t<grouped_data_t> &gd) const;
+
     virtual scoped_ptr_t<val_t> term_eval(scope_env_t *env,
                                           eval_flags_t eval_flags) const;
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env,
@@ -152,6 +176,10 @@ private:
 
     virtual bool is_deterministic() const;
 
+    virtual bool can_eval_batch() const;
+    virtual void eval_batch_impl(const std::vector<scope_env_t *> &envs,
+                                 std::vector<eval_batch_result_t> *results_out) const;
+
     scoped_ptr_t<const arg_terms_t> arg_terms;
 
     std::map<std::string, counted_t<const term_t> > optargs;
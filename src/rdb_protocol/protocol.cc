@@ -378,6 +378,10 @@ struct rdb_r_get_region_visitor : public boost::static_visitor<region_t> {
     region_t operator()(const dummy_read_t &d) const {
         return d.region;
     }
+
+    region_t operator()(const get_all_read_t &ga) const {
+        return ga.region;
+    }
 };
 
 region_t read_t::get_region() const THROWS_NOTHING {
@@ -459,6 +463,43 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
         return rangey_read(d);
     }
 
+    bool operator()(const get_all_read_t &ga) const {
+        const hash_region_t<key_range_t> intersection
+            = region_intersection(*region, ga.region);
+        if (region_is_empty(intersection)) {
+            return false;
+        }
+        std::map<ql::datum_t, uint64_t> keys;
+        if (ga.sindex_id) {
+            // Any shard can have rows for any secondary index key.
+            keys = ga.keys;
+        } else {
+            // The keys were checked when the read was created, so `print_primary`
+            // can't throw here.
+            for (const auto &pair : ga.keys) {
+                if (region_contains_key(intersection,
+                                        store_key_t(pair.first.print_primary()))) {
+                    keys.insert(pair);
+                }
+            }
+            if (keys.empty()) {
+                return false;
+            }
+        }
+        get_all_read_t tmp(
+            intersection,
+            std::move(keys),
+            ga.optargs,
+            ga.table_name,
+            ga.batchspec.scale_down(CPU_SHARDING_FACTOR),
+            ga.transforms,
+            boost::optional<ql::terminal_variant_t>(ga.terminal),
+            boost::optional<std::string>(ga.sindex_id),
+            boost::optional<region_t>(ga.sindex_region));
+        *payload_out = std::move(tmp);
+        return true;
+    }
+
     const hash_region_t<key_range_t> *region;
     read_t::variant_t *payload_out;
 };
@@ -502,6 +543,16 @@ void scale_down_distribution(size_t result_limit, std::map<store_key_t, int64_t>
     }
 }
 
+template <class query_t>
+static bool is_stamped(const query_t &q) {
+    return static_cast<bool>(q.stamp);
+}
+
+// Changefeeds on a `get_all` stamp the reads for each key instead.
+static bool is_stamped(const get_all_read_t &) {
+    return false;
+}
+
 class rdb_r_unshard_visitor_t : public boost::static_visitor<void> {
 public:
     rdb_r_unshard_visitor_t(profile_bool_t _profile,
@@ -525,9 +576,10 @@ public:
     void operator()(const changefeed_stamp_t &);
     void operator()(const changefeed_point_stamp_t &);
     void operator()(const dummy_read_t &);
+    void operator()(const get_all_read_t &ga);
 
 private:
-    // Shared by rget_read_t and intersecting_geo_read_t operators
+    // Shared by rget_read_t, intersecting_geo_read_t and get_all_read_t operators
     template<class query_response_t, class query_t>
     void unshard_range_batch(const query_t &q, sorting_t sorting);
 
@@ -619,6 +671,10 @@ void rdb_r_unshard_visitor_t::operator()(const intersecting_geo_read_t &query) {
     unshard_range_batch<rget_read_response_t>(query, sorting_t::UNORDERED);
 }
 
+void rdb_r_unshard_visitor_t::operator()(const get_all_read_t &query) {
+    unshard_range_batch<rget_read_response_t>(query, sorting_t::UNORDERED);
+}
+
 void rdb_r_unshard_visitor_t::operator()(const nearest_geo_read_t &query) {
     // Merge the different results together while preserving ordering.
     struct iter_range_t {
@@ -736,13 +792,15 @@ void rdb_r_unshard_visitor_t::unshard_range_batch(const query_t &q, sorting_t so
             }
         }
         results[i] = &resp->result;
-        if (q.stamp) {
+        out->rows_scanned += resp->rows_scanned;
+        out->bytes_read += resp->bytes_read;
+        if (is_stamped(q)) {
             guarantee(resp->stamp_response);
             stamp_resps[i] = &*resp->stamp_response;
         }
     }
     out->last_key = (best != NULL) ? std::move(*best) : key_max(sorting);
-    if (q.stamp) {
+    if (is_stamped(q)) {
         out->stamp_response = changefeed_stamp_response_t();
         unshard_stamps(stamp_resps, &*out->stamp_response);
     }
@@ -774,6 +832,15 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
     std::sort(results.begin(), results.end(), distribution_read_response_less_t());
 
     distribution_read_response_t res;
+
+    // Unlike the key counts, each hash shard samples the heat of its own keys, so we
+    // simply add them all up.
+    for (const auto &result : results) {
+        for (const auto &pair : result.key_heat) {
+            res.key_heat[pair.first] += pair.second;
+        }
+    }
+
     size_t i = 0;
     while (i < results.size()) {
         // Find the largest hash shard for this key range
@@ -869,6 +936,7 @@ struct use_snapshot_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const changefeed_stamp_t &) const {           return false; }
     bool operator()(const changefeed_point_stamp_t &) const {     return false; }
     bool operator()(const distribution_read_t &) const {          return true;  }
+    bool operator()(const get_all_read_t &) const {               return true;  }
 };
 
 // Only use snapshotting if we're doing a range get.
@@ -889,6 +957,7 @@ struct route_to_primary_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const changefeed_stamp_t &) const {           return true;  }
     bool operator()(const changefeed_point_stamp_t &) const {     return true;  }
     bool operator()(const distribution_read_t &) const {          return false; }
+    bool operator()(const get_all_read_t &) const {               return false; }
 };
 
 // Route changefeed reads to the primary replica. For other reads we don't care.
@@ -1171,10 +1240,12 @@ RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_read_response_t, data);
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
     ql::skey_version_t, int8_t,
     ql::skey_version_t::pre_1_16, ql::skey_version_t::post_1_16);
-RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(
-    rget_read_response_t, stamp_response, result, skey_version, truncated, last_key);
+RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
+    rget_read_response_t, stamp_response, result, skey_version, truncated, last_key,
+    rows_scanned, bytes_read);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(nearest_geo_read_response_t, results_or_error);
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(distribution_read_response_t, region, key_counts);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(distribution_read_response_t,
+                                   region, key_counts, key_heat);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
     changefeed_subscribe_response_t, server_uuids, addrs);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
@@ -1198,6 +1269,9 @@ RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(rget_read_t,
 RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
         intersecting_geo_read_t, region, optargs, table_name, batchspec, transforms,
         terminal, sindex, query_geometry);
+RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
+        get_all_read_t, region, keys, optargs, table_name, batchspec, transforms,
+        terminal, sindex_id, sindex_region);
 RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
         nearest_geo_read_t, optargs, center, max_dist, max_results, geo_system,
         region, table_name, sindex_id);
@@ -128,11 +128,16 @@ struct rget_read_response_t {
     ql::skey_version_t skey_version;
     bool truncated;
     store_key_t last_key;
+    // What the shards had to read to produce `result`, for the query's accounting.
+    uint64_t rows_scanned;
+    uint64_t bytes_read;
 
     rget_read_response_t()
-        : skey_version(ql::skey_version_t::pre_1_16), truncated(false) { }
+        : skey_version(ql::skey_version_t::pre_1_16), truncated(false),
+          rows_scanned(0), bytes_read(0) { }
     explicit rget_read_response_t(const ql::exc_t &ex)
-        : result(ex), skey_version(ql::skey_version_t::pre_1_16), truncated(false) { }
+        : result(ex), skey_version(ql::skey_version_t::pre_1_16), truncated(false),
+          rows_scanned(0), bytes_read(0) { }
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(rget_read_response_t);
 
@@ -177,6 +182,9 @@ struct distribution_read_response_t {
     // key_counts[kn] = the number of keys in [kn, right_key)
     region_t region;
     std::map<store_key_t, int64_t> key_counts;
+    // A sample of recently read or written keys, each with an estimate of how often
+    // it was accessed. Unlike `key_counts` these are individual keys, not ranges.
+    std::map<store_key_t, int64_t> key_heat;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_response_t);
 
@@ -364,6 +372,57 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(intersecting_geo_read_t);
 
+/* `get_all_read_t` reads the rows with any of several keys, for a `get_all` with more
+than one key. Each shard reads its keys in key order under one superblock, with one
+traversal per key that all fill the same batch, so a `get_all` with many keys costs one
+read per shard rather than one read per key. */
+class get_all_read_t {
+public:
+    get_all_read_t() : batchspec(ql::batchspec_t::empty()) { }
+
+    get_all_read_t(
+        region_t _region,
+        std::map<ql::datum_t, uint64_t> _keys,
+        std::map<std::string, ql::wire_func_t> _optargs,
+        std::string _table_name,
+        ql::batchspec_t _batchspec,
+        std::vector<ql::transform_variant_t> _transforms,
+        boost::optional<ql::terminal_variant_t> &&_terminal,
+        boost::optional<std::string> &&_sindex_id,
+        boost::optional<region_t> &&_sindex_region)
+        : region(std::move(_region)),
+          keys(std::move(_keys)),
+          optargs(std::move(_optargs)),
+          table_name(std::move(_table_name)),
+          batchspec(std::move(_batchspec)),
+          transforms(std::move(_transforms)),
+          terminal(std::move(_terminal)),
+          sindex_id(std::move(_sindex_id)),
+          sindex_region(std::move(_sindex_region)) { }
+
+    // For primary key reads this is the part of the key space that's left to read,
+    // and sharding drops the keys outside of it.  Secondary index reads use the whole
+    // primary key range.
+    region_t region;
+    // Each key maps to the number of times it was given, because `get_all` returns
+    // a key's rows once for every time the key appears.
+    std::map<ql::datum_t, uint64_t> keys;
+    std::map<std::string, ql::wire_func_t> optargs;
+    std::string table_name;
+    ql::batchspec_t batchspec; // used to size batches
+
+    // We use these two for lazy maps, reductions, etc.
+    std::vector<ql::transform_variant_t> transforms;
+    boost::optional<ql::terminal_variant_t> terminal;
+
+    // This is non-empty if we're reading a secondary index.
+    boost::optional<std::string> sindex_id;
+    // The part of the secondary index that's left to read.  If empty, the shard reads
+    // the ranges of all of the keys.
+    boost::optional<region_t> sindex_region;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(get_all_read_t);
+
 class nearest_geo_read_t {
 public:
     nearest_geo_read_t() { }
@@ -459,7 +518,8 @@ struct read_t {
                            changefeed_limit_subscribe_t,
                            changefeed_point_stamp_t,
                            distribution_read_t,
-                           dummy_read_t> variant_t;
+                           dummy_read_t,
+                           get_all_read_t> variant_t;
     variant_t read;
     profile_bool_t profile;
     read_mode_t read_mode;
@@ -0,0 +1,158 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_admission.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/interruptor.hpp"
+
+const char *query_priority_to_string(query_priority_t priority) {
+    switch (priority) {
+    case query_priority_t::HIGH: return "high";
+    case query_priority_t::NORMAL: return "normal";
+    case query_priority_t::LOW: return "low";
+    default: unreachable();
+    }
+}
+
+bool query_priority_from_string(const std::string &str, query_priority_t *out) {
+    if (str == "high") {
+        *out = query_priority_t::HIGH;
+    } else if (str == "normal") {
+        *out = query_priority_t::NORMAL;
+    } else if (str == "low") {
+        *out = query_priority_t::LOW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const uint64_t query_admission_controller_t::weights[NUM_QUERY_PRIORITIES] =
+    { 8, 4, 1 };
+const uint64_t query_admission_controller_t::stride_scale = 1 << 20;
+
+static uint64_t per_thread_share(uint64_t total) {
+    const uint64_t threads = get_num_threads();
+    return (total + threads - 1) / threads;
+}
+
+query_admission_controller_t::query_admission_controller_t(
+        const query_admission_config_t &config)
+    : max_running(per_thread_share(config.max_running_queries)),
+      max_queued(per_thread_share(config.max_queued_queries)),
+      running(0),
+      queued(0),
+      global_pass(0) {
+    for (int i = 0; i < NUM_QUERY_PRIORITIES; ++i) {
+        pass[i] = 0;
+    }
+}
+
+query_admission_controller_t::~query_admission_controller_t() {
+    assert_thread();
+    guarantee(running == 0);
+    guarantee(queued == 0);
+}
+
+query_admission_controller_t::admission_t::admission_t(
+        query_admission_controller_t *_parent,
+        query_priority_t _priority,
+        bool _may_reject,
+        signal_t *interruptor)
+    : parent(_parent),
+      priority(_priority),
+      may_reject(_may_reject),
+      running(false),
+      rejected(false) {
+    parent->assert_thread();
+    if (parent->max_running == 0
+        || (parent->running < parent->max_running && parent->queued == 0)) {
+        running = true;
+        ++parent->running;
+        return;
+    }
+
+    if (may_reject
+        && parent->queued >= parent->max_queued
+        && !parent->try_make_room_for(priority)) {
+        rejected = true;
+        return;
+    }
+
+    parent->enqueue(this);
+    try {
+        wait_interruptible(&done_waiting, interruptor);
+    } catch (const interrupted_exc_t &) {
+        if (in_a_list()) {
+            parent->dequeue(this);
+        } else if (running) {
+            running = false;
+            --parent->running;
+            parent->admit_next();
+        }
+        throw;
+    }
+}
+
+query_admission_controller_t::admission_t::~admission_t() {
+    parent->assert_thread();
+    guarantee(!in_a_list());
+    if (running) {
+        --parent->running;
+        parent->admit_next();
+    }
+}
+
+bool query_admission_controller_t::try_make_room_for(query_priority_t priority) {
+    // Reject the most recent query that is waiting with the lowest priority.
+    for (int p = NUM_QUERY_PRIORITIES - 1; p > static_cast<int>(priority); --p) {
+        for (admission_t *victim = queues[p].tail();
+             victim != NULL;
+             victim = queues[p].prev(victim)) {
+            if (victim->may_reject) {
+                dequeue(victim);
+                victim->rejected = true;
+                victim->done_waiting.pulse();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void query_admission_controller_t::admit_next() {
+    while (queued > 0 && running < max_running) {
+        int next = -1;
+        for (int p = 0; p < NUM_QUERY_PRIORITIES; ++p) {
+            if (!queues[p].empty() && (next == -1 || pass[p] < pass[next])) {
+                next = p;
+            }
+        }
+        guarantee(next != -1);
+        admission_t *admission = queues[next].head();
+        dequeue(admission);
+        global_pass = pass[next];
+        pass[next] += stride_scale / weights[next];
+
+        admission->running = true;
+        ++running;
+        admission->done_waiting.pulse();
+    }
+}
+
+void query_admission_controller_t::enqueue(admission_t *admission) {
+    const int p = static_cast<int>(admission->priority);
+    if (queues[p].empty()) {
+        // A priority that had nothing waiting doesn't get to catch up on the turns it
+        // didn't need.
+        pass[p] = std::max(pass[p], global_pass);
+    }
+    queues[p].push_back(admission);
+    ++queued;
+}
+
+void query_admission_controller_t::dequeue(admission_t *admission) {
+    queues[static_cast<int>(admission->priority)].remove(admission);
+    --queued;
+}
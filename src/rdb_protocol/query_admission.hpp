@@ -0,0 +1,108 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_ADMISSION_HPP_
+#define RDB_PROTOCOL_QUERY_ADMISSION_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "concurrency/cond_var.hpp"
+#include "containers/intrusive_list.hpp"
+#include "threading.hpp"
+
+/* Every query runs with one of these priorities, chosen with the `priority` global
+optarg. When the server is overloaded, waiting queries are admitted in proportion to
+the weights of their priorities, and the lowest-priority queries are rejected first. */
+enum class query_priority_t {
+    HIGH = 0,
+    NORMAL = 1,
+    LOW = 2
+};
+static const int NUM_QUERY_PRIORITIES = 3;
+
+const char *query_priority_to_string(query_priority_t priority);
+bool query_priority_from_string(const std::string &str, query_priority_t *out);
+
+class query_admission_config_t {
+public:
+    query_admission_config_t() : max_running_queries(0), max_queued_queries(1024) { }
+
+    /* The maximum number of queries the server runs at the same time, or zero for no
+    limit. The limit is split evenly over the threads. */
+    uint64_t max_running_queries;
+    /* New queries are rejected once this many queries are waiting to run. */
+    uint64_t max_queued_queries;
+};
+
+/* `query_admission_controller_t` limits how many queries run at the same time on a
+thread. There is one per thread in the `rdb_context_t`, so admitting a query never
+requires a thread switch.
+
+A query holds an `admission_t` while it's running a batch, except for batches of
+changefeeds, which may wait for changes indefinitely. If the thread is at its
+limit, the `admission_t` waits in the queue for its priority. Whenever a query
+finishes, the next one is picked with stride scheduling: each priority is admitted in
+proportion to its weight, as long as it has queries waiting.
+
+If the queue is full, a new query displaces the most recent queued query of a lower
+priority if there is one, and is rejected otherwise. Queries that are continuing a
+stream are never rejected, since that would break their cursors. */
+class query_admission_controller_t : public home_thread_mixin_t {
+public:
+    explicit query_admission_controller_t(const query_admission_config_t &config);
+    ~query_admission_controller_t();
+
+    class admission_t : public intrusive_list_node_t<admission_t> {
+    public:
+        // Waits until the query may run or is rejected. Throws `interrupted_exc_t`
+        // if `interruptor` is pulsed first. New queries should set `may_reject`.
+        admission_t(query_admission_controller_t *parent,
+                    query_priority_t priority,
+                    bool may_reject,
+                    signal_t *interruptor);
+        ~admission_t();
+
+        bool is_rejected() const { return rejected; }
+
+    private:
+        friend class query_admission_controller_t;
+
+        query_admission_controller_t *const parent;
+        const query_priority_t priority;
+        const bool may_reject;
+        bool running;
+        bool rejected;
+        cond_t done_waiting;
+
+        DISABLE_COPYING(admission_t);
+    };
+
+    uint64_t num_running() const { return running; }
+    uint64_t num_queued() const { return queued; }
+
+private:
+    bool try_make_room_for(query_priority_t priority);
+    void admit_next();
+    void enqueue(admission_t *admission);
+    void dequeue(admission_t *admission);
+
+    static const uint64_t weights[NUM_QUERY_PRIORITIES];
+    static const uint64_t stride_scale;
+
+    const uint64_t max_running;
+    const uint64_t max_queued;
+
+    uint64_t running;
+    uint64_t queued;
+    intrusive_list_t<admission_t> queues[NUM_QUERY_PRIORITIES];
+
+    // Stride scheduling state: the priority with waiting queries and the lowest pass
+    // goes next, and each admission advances its priority's pass by
+    // `stride_scale / weight`.
+    uint64_t pass[NUM_QUERY_PRIORITIES];
+    uint64_t global_pass;
+
+    DISABLE_COPYING(query_admission_controller_t);
+};
+
+#endif  // RDB_PROTOCOL_QUERY_ADMISSION_HPP_
@@ -93,9 +93,11 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(
     counted_t<const term_t> root_term;
     backtrace_registry_t bt_reg;
     std::map<std::string, wire_func_t> global_optargs;
+    query_priority_t priority;
     try {
         preprocess_term(original_query->mutable_query(), &bt_reg);
         global_optargs = parse_global_optargs(original_query);
+        priority = query_priority_optarg(original_query);
 
         Term *t = original_query->mutable_query();
         compile_env_t compile_env((var_visibility_t()));
@@ -111,7 +113,8 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(
     scoped_ptr_t<entry_t> entry(new entry_t(original_query,
                                             std::move(bt_reg),
                                             std::move(global_optargs),
-                                            std::move(root_term)));
+                                            std::move(root_term),
+                                            priority));
     scoped_ptr_t<ref_t> ref(new ref_t(this,
                                       token,
                                       entry.get(),
@@ -212,6 +215,13 @@ query_cache_t::ref_t::~ref_t() {
     }
 }
 
+/* Changefeeds can block for as long as nothing changes, so they (and other infinite
+streams, which may be unioned with them) mustn't hold an `admission_t` while they're
+being served. */
+static bool may_wait_for_changes(const counted_t<datum_stream_t> &stream) {
+    return stream->cfeed_type() != feed_type_t::not_feed || stream->is_infinite();
+}
+
 void query_cache_t::ref_t::fill_response(Response *res) {
     query_cache->assert_thread();
     if (entry->state != entry_t::state_t::START &&
@@ -225,11 +235,32 @@ void query_cache_t::ref_t::fill_response(Response *res) {
     }
 
     try {
+        // New queries can be rejected if the server is overloaded, but we always let
+        // an existing stream continue (after waiting for our turn). Streams that wait
+        // for changes don't take a turn at all, since they can wait indefinitely.
+        const bool is_new = entry->state == entry_t::state_t::START;
+        scoped_ptr_t<query_admission_controller_t::admission_t> admission;
+        if (is_new || !may_wait_for_changes(entry->stream)) {
+            admission.init(new query_admission_controller_t::admission_t(
+                query_cache->rdb_ctx->get_admission_controller_for_this_thread(),
+                entry->priority,
+                is_new,
+                &combined_interruptor));
+            if (admission->is_rejected()) {
+                ++query_cache->rdb_ctx->stats.queries_rejected;
+                rfail_toplevel(base_exc_t::GENERIC,
+                               "Query rejected because the server is overloaded. "
+                               "Retry later or run it with a higher `priority`.");
+            }
+        }
+
+        coro_t::running_time_counter_t cpu_counter(&entry->resources->cpu_ticks);
         env_t env(query_cache->rdb_ctx,
                   query_cache->return_empty_normal_batches,
                   &combined_interruptor,
                   entry->global_optargs,
                   trace.get_or_null());
+        env.set_query_resources(entry->resources.get());
 
         if (entry->state == entry_t::state_t::START) {
             run(&env, res);
@@ -237,6 +268,9 @@ void query_cache_t::ref_t::fill_response(Response *res) {
         }
 
         if (entry->state == entry_t::state_t::STREAM) {
+            if (may_wait_for_changes(entry->stream)) {
+                admission.reset();
+            }
             serve(&env, res);
         }
 
@@ -354,7 +388,8 @@ void query_cache_t::ref_t::serve(env_t *env, Response *res) {
 query_cache_t::entry_t::entry_t(protob_t<Query> _original_query,
                                 backtrace_registry_t &&_bt_reg,
                                 std::map<std::string, wire_func_t> &&_global_optargs,
-                                counted_t<const term_t> _root_term) :
+                                counted_t<const term_t> _root_term,
+                                query_priority_t _priority) :
         state(state_t::START),
         job_id(generate_uuid()),
         original_query(_original_query),
@@ -362,6 +397,8 @@ query_cache_t::entry_t::entry_t(protob_t<Query> _original_query,
         global_optargs(std::move(_global_optargs)),
         profile(profile_bool_optarg(original_query)),
         start_time(current_microtime()),
+        priority(_priority),
+        resources(make_counted<query_resources_t>()),
         root_term(_root_term),
         has_sent_batch(false) { }
 
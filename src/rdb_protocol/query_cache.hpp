@@ -23,6 +23,8 @@
 #include "rdb_protocol/backtrace.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/query_admission.hpp"
+#include "rdb_protocol/query_resources.hpp"
 #include "rdb_protocol/term.hpp"
 
 namespace ql {
@@ -115,7 +117,8 @@ private:
         entry_t(protob_t<Query> _original_query,
                 backtrace_registry_t &&_bt_reg,
                 std::map<std::string, wire_func_t> &&_global_optargs,
-                counted_t<const term_t> _root_term);
+                counted_t<const term_t> _root_term,
+                query_priority_t _priority);
         ~entry_t();
 
         enum class state_t { START, STREAM, DONE, DELETING } state;
@@ -126,6 +129,10 @@ private:
         const std::map<std::string, wire_func_t> global_optargs;
         const profile_bool_t profile;
         const microtime_t start_time;
+        const query_priority_t priority;
+
+        // What the query has used so far, for the jobs table.
+        const counted_t<query_resources_t> resources;
 
         cond_t persistent_interruptor;
 
@@ -0,0 +1,36 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_RESOURCES_HPP_
+#define RDB_PROTOCOL_QUERY_RESOURCES_HPP_
+
+#include <stdint.h>
+
+#include "containers/counted.hpp"
+#include "time.hpp"
+
+namespace ql {
+
+/* `query_resources_t` accumulates what a single query has used so far. It belongs to
+the query's entry in the `query_cache_t` and is shown in the `rethinkdb.jobs` table.
+Readers that buffer rows hold a reference to it so that they can give back the memory
+they account for even if they outlive a batch. */
+class query_resources_t : public single_threaded_countable_t<query_resources_t> {
+public:
+    query_resources_t()
+        : cpu_ticks(0), rows_scanned(0), bytes_read(0), bytes_held(0) { }
+
+    // Time the query's coroutine spent running on the server that parsed it. Work
+    // done by the shards on other threads or servers is not included.
+    ticks_t cpu_ticks;
+    // Rows visited by range scans on the shards, including rows that were filtered
+    // out there.
+    uint64_t rows_scanned;
+    // The serialized size of the rows the shards loaded, from the cache or from disk.
+    uint64_t bytes_read;
+    // The serialized size of the rows that were read to fill the batches the query
+    // currently has buffered.
+    uint64_t bytes_held;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_QUERY_RESOURCES_HPP_
@@ -106,6 +106,35 @@ counted_t<ql::datum_stream_t> real_table_t::read_all(
     }
 }
 
+counted_t<ql::datum_stream_t> real_table_t::read_all_keys(
+        ql::env_t *env,
+        const std::string &sindex,
+        ql::backtrace_id_t bt,
+        const std::string &table_name,
+        const std::vector<ql::datum_t> &keys,
+        read_mode_t read_mode) {
+    // The streams for the individual keys are only read if the query turns into a
+    // changefeed; otherwise all of the keys are read together.
+    std::vector<counted_t<ql::datum_stream_t> > key_streams;
+    key_streams.reserve(keys.size());
+    for (const auto &key : keys) {
+        key_streams.push_back(read_all(env, sindex, bt, table_name,
+                                       ql::datum_range_t(key), sorting_t::UNORDERED,
+                                       read_mode));
+    }
+    return make_counted<ql::get_all_datum_stream_t>(
+        make_scoped<ql::get_all_reader_t>(
+            counted_t<real_table_t>(this),
+            ql::get_all_readgen_t::make(
+                env, table_name, read_mode,
+                sindex == get_pkey()
+                    ? boost::optional<std::string>()
+                    : boost::optional<std::string>(sindex),
+                keys)),
+        std::move(key_streams),
+        bt);
+}
+
 counted_t<ql::datum_stream_t> real_table_t::read_changes(
     ql::env_t *env,
     counted_t<ql::datum_stream_t> maybe_src,
@@ -74,6 +74,13 @@ public:
         const ql::datum_range_t &range,
         sorting_t sorting,
         read_mode_t read_mode);
+    counted_t<ql::datum_stream_t> read_all_keys(
+        ql::env_t *env,
+        const std::string &sindex,
+        ql::backtrace_id_t bt,
+        const std::string &table_name,
+        const std::vector<ql::datum_t> &keys,
+        read_mode_t read_mode);
     counted_t<ql::datum_stream_t> read_changes(
         ql::env_t *env,
         counted_t<ql::datum_stream_t> maybe_src,
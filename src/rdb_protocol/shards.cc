@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/shards.hpp"
 
+#include <algorithm>
 #include <utility>
 
 #include "errors.hpp"
@@ -490,6 +491,14 @@ public:
         : terminal_t<uint64_t>(0) { }
 private:
     virtual bool uses_val() { return false; }
+    virtual bool accepts_row_counts() { return true; }
+    virtual void add_row_count(uint64_t n) {
+        if (n == 0) {
+            return;
+        }
+        grouped_t<uint64_t> *acc = get_acc();
+        acc->insert(std::make_pair(datum_t(), *get_default_val())).first->second += n;
+    }
     virtual bool accumulate(env_t *,
                             const datum_t &,
                             uint64_t *out) {
@@ -692,6 +701,71 @@ private:
     counted_t<const func_t> f;
 };
 
+// Each shard keeps a reservoir of up to `n` rows, and the reservoirs are merged by
+// drawing from them in proportion to the number of rows each one hasn't given up
+// yet, so only `n` rows per shard are sent back instead of the whole table.
+class sample_terminal_t : public terminal_t<reservoir_t> {
+public:
+    explicit sample_terminal_t(const sample_wire_func_t &f)
+        : terminal_t<reservoir_t>(reservoir_t()), n(f.n) { }
+private:
+    virtual bool accumulate(env_t *,
+                            const datum_t &el,
+                            reservoir_t *out) {
+        out->seen += 1;
+        if (out->rows.size() < n) {
+            out->rows.push_back(el);
+        } else {
+            uint64_t i = randuint64(out->seen);
+            if (i < n) {
+                out->rows[i] = el;
+            }
+        }
+        return true;
+    }
+    virtual datum_t unpack(reservoir_t *r) {
+        std::random_shuffle(r->rows.begin(), r->rows.end());
+        return datum_t(std::move(r->rows),
+                       datum_t::no_array_size_limit_check_t());
+    }
+    virtual void unshard_impl(env_t *, reservoir_t *out, reservoir_t *el) {
+        // The reservoirs' rows aren't in random order, so we shuffle them before
+        // drawing from their fronts.
+        std::random_shuffle(out->rows.begin(), out->rows.end());
+        std::random_shuffle(el->rows.begin(), el->rows.end());
+        const uint64_t total = out->seen + el->seen;
+        const size_t k = std::min<uint64_t>(n, total);
+        datums_t rows;
+        rows.reserve(k);
+        uint64_t out_left = out->seen, el_left = el->seen;
+        size_t out_i = 0, el_i = 0;
+        while (rows.size() < k) {
+            // Approximate reservoirs may have fewer rows than their estimated
+            // count accounts for.
+            if (out_i == out->rows.size()) {
+                out_left = 0;
+            }
+            if (el_i == el->rows.size()) {
+                el_left = 0;
+            }
+            if (out_left + el_left == 0) {
+                break;
+            }
+            if (randuint64(out_left + el_left) < out_left) {
+                rows.push_back(std::move(out->rows[out_i++]));
+                out_left -= 1;
+            } else {
+                rows.push_back(std::move(el->rows[el_i++]));
+                el_left -= 1;
+            }
+        }
+        out->seen = total;
+        out->rows = std::move(rows);
+    }
+
+    const uint64_t n;
+};
+
 template<class T>
 class terminal_visitor_t : public boost::static_visitor<T *> {
 public:
@@ -713,6 +787,9 @@ public:
     T *operator()(const reduce_wire_func_t &f) const {
         return new reduce_terminal_t(f);
     }
+    T *operator()(const sample_wire_func_t &f) const {
+        return new sample_terminal_t(f);
+    }
     T *operator()(const limit_read_t &lr) const {
         return new limit_append_t(
             lr.is_primary, lr.n, lr.sorting, lr.ops);
@@ -868,9 +945,7 @@ private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const datum_t &) {
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                *it = f->call(env, *it)->as_datum();
-            }
+            *lst = f->call_batch(env, *lst);
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace(), 1);
         }
@@ -919,18 +994,20 @@ public:
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const datum_t &) {
-        auto it = lst->begin();
-        auto loc = it;
+        std::vector<bool> keep;
         try {
-            for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
-                    std::swap(*loc, *it);
-                    ++loc;
-                }
-            }
+            keep = f->filter_call_batch(env, *lst, default_val);
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace(), 1);
         }
+        r_sanity_check(keep.size() == lst->size());
+        auto loc = lst->begin();
+        for (size_t i = 0; i < keep.size(); ++i) {
+            if (keep[i]) {
+                std::swap(*loc, (*lst)[i]);
+                ++loc;
+            }
+        }
         lst->erase(loc, lst->end());
     }
     counted_t<const func_t> f, default_val;
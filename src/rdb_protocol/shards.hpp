@@ -92,6 +92,27 @@ archive_result_t deserialize_grouped(read_stream_t *s, optimizer_t *o) {
     return archive_result_t::SUCCESS;
 }
 
+// A uniform random sample of `rows`, without replacement, out of the `seen` rows a
+// `sample` terminal has been passed.  Approximate samples only estimate `seen`.
+class reservoir_t {
+public:
+    reservoir_t() : seen(0) { }
+    uint64_t seen;
+    datums_t rows;
+};
+
+template <cluster_version_t W>
+void serialize_grouped(write_message_t *wm, const reservoir_t &r) {
+    serialize_varint_uint64(wm, r.seen);
+    serialize<W>(wm, r.rows);
+}
+template <cluster_version_t W>
+archive_result_t deserialize_grouped(read_stream_t *s, reservoir_t *r) {
+    archive_result_t res = deserialize_varint_uint64(s, &r->seen);
+    if (bad(res)) { return res; }
+    return deserialize<W>(s, &r->rows);
+}
+
 // We write all of these serializations and deserializations explicitly because:
 // * It stops people from inadvertently using a new `grouped_t<T>` without thinking.
 // * Some grouped elements need specialized serialization.
@@ -284,6 +305,7 @@ typedef boost::variant<
     grouped_t<ql::datum_t>, // Reduce (may be NULL)
     grouped_t<optimizer_t>, // min, max
     grouped_t<stream_t>, // No terminal.
+    grouped_t<reservoir_t>, // Sample.
     exc_t // Don't re-order (we don't want this to initialize to an error.)
     > result_t;
 
@@ -321,6 +343,7 @@ typedef boost::variant<count_wire_func_t,
                        min_wire_func_t,
                        max_wire_func_t,
                        reduce_wire_func_t,
+                       sample_wire_func_t,
                        limit_read_t
                        > terminal_variant_t;
 
@@ -330,6 +353,11 @@ public:
     virtual ~accumulator_t();
     // May be overridden as an optimization (currently is for `count`).
     virtual bool uses_val() { return true; }
+    // May be overridden as an optimization (currently is for `count`). If this
+    // returns true, the traversal may call `add_row_count(n)` instead of passing `n`
+    // untransformed rows to `operator()` one at a time.
+    virtual bool accepts_row_counts() { return false; }
+    virtual void add_row_count(UNUSED uint64_t n) { unreachable(); }
     virtual bool should_send_batch() = 0;
     virtual continue_bool_t operator()(env_t *env,
                                        groups_t *groups,
@@ -13,6 +13,7 @@
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/erase_range.hpp"
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
 
@@ -383,9 +384,11 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const point_read_t &get) {
+        store->key_heat.record(get.key);
         response->response = point_read_response_t();
         point_read_response_t *res =
             boost::get<point_read_response_t>(&response->response);
+        store->maybe_rebuild_key_filter(boost::none);
         rdb_get(get.key, btree, superblock, res, trace);
     }
 
@@ -427,7 +430,8 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         guarantee(geo_read.sindex.region);
         rdb_get_intersecting_slice(
             store->get_sindex_slice(sindex_uuid),
-            geo_read.query_geometry,
+            store->geo_query_cache.get(
+                geo_read.query_geometry, QUERYING_GOAL_GRID_CELLS),
             *geo_read.sindex.region,
             sindex_sb.get(),
             &ql_env,
@@ -516,6 +520,77 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
                 release_superblock_t::RELEASE);
     }
 
+    void operator()(const get_all_read_t &get_all) {
+        response->response = rget_read_response_t();
+        auto *res = boost::get<rget_read_response_t>(&response->response);
+
+        if (get_all.transforms.size() != 0 || get_all.terminal) {
+            // This asserts that the optargs have been initialized.  (There is always
+            // a 'db' optarg.)  We have the same assertion in
+            // rdb_r_unshard_visitor_t.
+            rassert(get_all.optargs.size() != 0);
+        }
+        ql::env_t ql_env(ctx, ql::return_empty_normal_batches_t::NO,
+                         interruptor, get_all.optargs, trace);
+
+        if (!get_all.sindex_id) {
+            for (const auto &pair : get_all.keys) {
+                store->key_heat.record(store_key_t(pair.first.print_primary()));
+            }
+            store->maybe_rebuild_key_filter(boost::none);
+            rdb_get_all_slice(
+                btree, get_all.region.inner, get_all.keys, superblock, &ql_env,
+                get_all.batchspec, get_all.transforms, get_all.terminal, res);
+            return;
+        }
+
+        sindex_disk_info_t sindex_info;
+        uuid_u sindex_uuid;
+        scoped_ptr_t<sindex_superblock_t> sindex_sb;
+        try {
+            sindex_sb =
+                acquire_sindex_for_read(
+                    store,
+                    superblock,
+                    get_all.table_name,
+                    *get_all.sindex_id,
+                    &sindex_info,
+                    &sindex_uuid);
+        } catch (const ql::exc_t &e) {
+            res->result = e;
+            return;
+        }
+        res->skey_version = ql::skey_version_from_reql_version(
+            sindex_info.mapping_version_info.latest_compatible_reql_version);
+
+        if (sindex_info.geo == sindex_geo_bool_t::GEO) {
+            res->result = ql::exc_t(
+                ql::base_exc_t::GENERIC,
+                strprintf(
+                    "Index `%s` is a geospatial index.  Only get_nearest and "
+                    "get_intersecting can use a geospatial index.",
+                    get_all.sindex_id->c_str()),
+                ql::backtrace_id_t::empty());
+            return;
+        }
+
+        store->maybe_rebuild_key_filter(sindex_uuid);
+        rdb_get_all_secondary_slice(
+            store->get_sindex_slice(sindex_uuid),
+            get_all.keys,
+            get_all.sindex_region
+                ? get_all.sindex_region->inner
+                : key_range_t::universe(),
+            sindex_sb.get(),
+            &ql_env,
+            get_all.batchspec,
+            get_all.transforms,
+            get_all.terminal,
+            get_all.region.inner,
+            sindex_info,
+            res);
+    }
+
     void operator()(const distribution_read_t &dg) {
         response->response = distribution_read_response_t();
         distribution_read_response_t *res = boost::get<distribution_read_response_t>(&response->response);
@@ -536,6 +611,8 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
             scale_down_distribution(dg.result_limit, &res->key_counts);
         }
 
+        store->key_heat.get_heat(dg.region.inner, &res->key_heat);
+
         res->region = dg.region;
     }
 
@@ -638,6 +715,9 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
             store, &sindex_block,
             auto_drainer_t::lock_t(&store->drainer));
         func_replacer_t replacer(&ql_env, br.f, br.return_changes);
+        for (const auto &key : br.keys) {
+            store->key_heat.record(key);
+        }
 
         response->response =
             rdb_batched_replace(
@@ -660,6 +740,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         keys.reserve(bi.inserts.size());
         for (auto it = bi.inserts.begin(); it != bi.inserts.end(); ++it) {
             keys.emplace_back(it->get_field(datum_string_t(bi.pkey)).print_primary());
+            store->key_heat.record(keys.back());
         }
         response->response =
             rdb_batched_replace(
@@ -675,6 +756,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
     void operator()(const point_write_t &w) {
         sampler->new_sample();
+        store->key_heat.record(w.key);
         response->response = point_write_response_t();
         point_write_response_t *res =
             boost::get<point_write_response_t>(&response->response);
@@ -689,6 +771,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
     void operator()(const point_delete_t &d) {
         sampler->new_sample();
+        store->key_heat.record(d.key);
         response->response = point_delete_response_t();
         point_delete_response_t *res =
             boost::get<point_delete_response_t>(&response->response);
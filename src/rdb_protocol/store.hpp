@@ -23,6 +23,8 @@
 #include "perfmon/perfmon.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/geo/prepared_geometry.hpp"
+#include "rdb_protocol/key_heat.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/store_metainfo.hpp"
 #include "rpc/mailbox/typed.hpp"
@@ -302,6 +304,12 @@ public:
         return secondary_index_slices.at(id).get();
     }
 
+    /* Starts building the key filter of the primary index, or of the given secondary
+    index, in the background if it's enabled and missing or full. Lookups call this, so
+    filters are only kept for indexes that are used for lookups. Geospatial indexes
+    don't have filters. */
+    void maybe_rebuild_key_filter(const boost::optional<uuid_u> &sindex_id);
+
     void protocol_read(const read_t &read,
                        read_response_t *response,
                        real_superblock_t *superblock,
@@ -347,6 +355,12 @@ private:
 
     void help_construct_bring_sindexes_up_to_date();
 
+    // Scans the index for `maybe_rebuild_key_filter()`. To be run in a coroutine.
+    void rebuild_key_filter(
+            boost::optional<uuid_u> sindex_id,
+            auto_drainer_t::lock_t store_keepalive)
+            THROWS_NOTHING;
+
     MUST_USE bool mark_secondary_index_deleted(
             buf_lock_t *sindex_block,
             const sindex_name_t &name);
@@ -374,6 +388,10 @@ public:
     io_backender_t *io_backender_;
     base_path_t base_path_;
     perfmon_membership_t perfmon_collection_membership;
+    // How long reads and writes take on this shard, including the time spent waiting
+    // for the superblock.
+    perfmon_latency_histogram_t read_latency, write_latency;
+    perfmon_multi_membership_t latency_membership;
     scoped_ptr_t<store_metainfo_manager_t> metainfo;
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
@@ -388,6 +406,13 @@ public:
     // any time the set of outdated indexes for this table changes
     scoped_ptr_t<outdated_index_report_t> index_report;
 
+    // A sample of recently accessed keys, reported by distribution reads so that
+    // shards can be split by load.
+    key_heat_sampler_t key_heat;
+
+    // Recently used `get_intersecting` query geometries, already parsed and covered.
+    geo_query_cache_t geo_query_cache;
+
 private:
     namespace_id_t table_id;
 
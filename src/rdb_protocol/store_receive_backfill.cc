@@ -14,6 +14,14 @@ backfill faster, but it will also cause the backfill-related transactions to hol
 superblock for a longer time. */
 static const int MAX_CHANGES_PER_TXN = 16;
 
+/* `MAX_INSERTS_PER_TXN` is the maximum number of pairs we'll apply in a single
+transaction after the previous chunk of a multi-key backfill item's range turned out to
+be empty on our side. Then we expect to make almost no deletions, and every change is a
+plain insert into an empty part of the key-space, so we can afford to batch much more
+aggressively. This is what makes backfilling onto a new, empty replica reasonably
+fast. */
+static const int MAX_INSERTS_PER_TXN = 128;
+
 /* `MAX_UNSAVED_CHANGES` is the maximum number of keys we'll modify or delete before
 flushing our changes out to disk. This prevents the backfill from using too much of the
 cache's unsaved data limit, which would slow down queries on other shards. */
@@ -184,10 +192,18 @@ It doesn't call `on_commit()` or modify the metainfo. */
 void apply_item_pair(
         btree_slice_t *slice,
         real_superblock_t *superblock,
+        bool recency_only,
         backfill_item_t::pair_t &&pair,
         std::vector<rdb_modification_report_t> *mod_reports_out,
         promise_t<superblock_t *> *pass_back_superblock) {
     rdb_live_deletion_context_t deletion_context;
+    if (recency_only && static_cast<bool>(pair.value)) {
+        /* We already have the value; see `backfill_item_t::recency_only`. Since the
+        value doesn't change, there's nothing to report to the sindexes. */
+        rdb_set_recency(pair.key, pair.recency, superblock, &deletion_context,
+            pass_back_superblock);
+        return;
+    }
     mod_reports_out->resize(mod_reports_out->size() + 1);
     mod_reports_out->back().primary_key = pair.key;
     if (static_cast<bool>(pair.value)) {
@@ -248,7 +264,7 @@ void apply_single_key_item(
 
         /* Actually apply the change, releasing the superblock in the process. */
         std::vector<rdb_modification_report_t> mod_reports;
-        apply_item_pair(tokens.info->slice, superblock.get(),
+        apply_item_pair(tokens.info->slice, superblock.get(), item.recency_only,
             std::move(item.pairs[0]), &mod_reports, nullptr);
 
         /* Notify that we're done and update the sindexes */
@@ -267,7 +283,8 @@ void apply_single_key_item(
 
 /* `apply_multi_key_item()` is for items that apply to a range of keys. We must first
 delete any existing values or deletion entries in that range, and then apply the contents
-of `item.pairs`. */
+of `item.pairs`. If the item is `recency_only`, we skip the deletion and only update the
+recency of the keys that we already have. */
 void apply_multi_key_item(
         const receive_backfill_tokens_t &tokens,
         /* `item` is conceptually passed by move, but `std::bind()` isn't smart enough to
@@ -286,17 +303,28 @@ void apply_multi_key_item(
         wait_interruptible(&exiter2, tokens.keepalive.get_drain_signal());
 
         /* It's possible that there are a lot of keys to be deleted, so we might do the
-        backfill item in several chunks. */
+        backfill item in several chunks. `threshold` is the point up to which we've
+        committed our changes. We never delete anything to the right of the range that
+        we commit in the same transaction: if we were interrupted after that, the
+        deleted keys would still be labelled with the old version in the metainfo. */
         bool is_first = true;
         size_t next_pair = 0;
         key_range_t::right_bound_t threshold(item.range.left);
+        /* Set once a chunk turned out to be empty on our side, which is always the case
+        when backfilling onto a new replica. The rest of the range is then likely to be
+        empty too, so we take larger chunks. */
+        bool inserts_only = false;
         while (threshold != item.range.right) {
             std::vector<rdb_modification_report_t> mod_reports;
 
-            /* Block until there's not too much unsaved data. Note that
-            `MAX_CHANGES_PER_TXN` might be an overestimate, but that's OK. */
+            const int max_pairs = (inserts_only || item.recency_only)
+                ? MAX_INSERTS_PER_TXN : MAX_CHANGES_PER_TXN / 2;
+
+            /* Block until there's not too much unsaved data. Note that this might be an
+            overestimate, but that's OK. */
             tokens.info->limiter->prepare_for_changes(
-                MAX_CHANGES_PER_TXN, tokens.keepalive.get_drain_signal());
+                max_pairs + 1 + MAX_CHANGES_PER_TXN / 2,
+                tokens.keepalive.get_drain_signal());
 
             /* Acquire the superblock. */
             scoped_ptr_t<txn_t> txn;
@@ -320,34 +348,41 @@ void apply_multi_key_item(
 
             /* Establish an upper limit on how much of the range we're willing to delete
             in this cycle. We choose the upper limit such that it contains no more than
-            `MAX_CHANGES_PER_TXN / 2` of the pairs in the backfill item. */
+            `max_pairs + 1` of the pairs in the backfill item. */
             key_range_t range_to_delete;
             range_to_delete.left = threshold.key();
-            if (next_pair + MAX_CHANGES_PER_TXN / 2 + 1 < item.pairs.size()) {
+            if (next_pair + max_pairs + 1 < item.pairs.size()) {
                 range_to_delete.right = key_range_t::right_bound_t(
-                    item.pairs[next_pair + MAX_CHANGES_PER_TXN / 2 + 1].key);
+                    item.pairs[next_pair + max_pairs + 1].key);
             } else {
                 range_to_delete.right = item.range.right;
             }
 
             /* Delete a chunk of the range, making sure to do no more than
-            `MAX_CHANGES_PER_TXN / 2` changes at once. */
-            always_true_key_tester_t key_tester;
+            `MAX_CHANGES_PER_TXN / 2` deletions at once. For a `recency_only` item we
+            already have the right live keys and values, so there's nothing to delete. */
             key_range_t range_deleted;
-            rdb_live_deletion_context_t deletion_context;
-            continue_bool_t res = rdb_erase_small_range(tokens.info->slice, &key_tester,
-                range_to_delete, superblock.get(), &deletion_context,
-                tokens.keepalive.get_drain_signal(), MAX_CHANGES_PER_TXN / 2,
-                &mod_reports, &range_deleted);
-            guarantee(range_deleted.right == range_to_delete.right
-                || res == continue_bool_t::CONTINUE);
+            if (item.recency_only) {
+                range_deleted = range_to_delete;
+            } else {
+                always_true_key_tester_t key_tester;
+                rdb_live_deletion_context_t deletion_context;
+                continue_bool_t res = rdb_erase_small_range(tokens.info->slice,
+                    &key_tester, range_to_delete, superblock.get(), &deletion_context,
+                    tokens.keepalive.get_drain_signal(), MAX_CHANGES_PER_TXN / 2,
+                    &mod_reports, &range_deleted);
+                guarantee(range_deleted.right == range_to_delete.right
+                    || res == continue_bool_t::CONTINUE);
+                inserts_only = mod_reports.empty()
+                    && range_deleted.right == range_to_delete.right;
+            }
 
             /* Apply any pairs from the item that fall within the deleted region */
             while (next_pair < item.pairs.size() &&
                     range_deleted.contains_key(item.pairs[next_pair].key)) {
                 promise_t<superblock_t *> pass_back_superblock;
                 apply_item_pair(tokens.info->slice, superblock.get(),
-                    std::move(item.pairs[next_pair]), &mod_reports,
+                    item.recency_only, std::move(item.pairs[next_pair]), &mod_reports,
                     &pass_back_superblock);
                 guarantee(superblock.get() == pass_back_superblock.assert_get_value());
                 ++next_pair;
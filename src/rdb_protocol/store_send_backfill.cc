@@ -5,12 +5,39 @@
 #include "btree/operations.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
 #include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/context.hpp"
 #include "rdb_protocol/lazy_json.hpp"
 
 /* After every `MAX_BACKFILL_ITEMS_PER_TXN` backfill items or backfill pre-items, we'll
 release the superblock and start a new transaction. */
 static const int MAX_BACKFILL_ITEMS_PER_TXN = 100;
 
+/* `copy_rdb_value()` implements `copy_value()` for both of the B-tree backfill consumer
+types in this file. It reads the entire blob for the given leaf node value. */
+void copy_rdb_value(
+        buf_parent_t parent,
+        const void *value_in_leaf_node,
+        std::vector<char> *value_out) {
+    const rdb_value_t *v =
+        static_cast<const rdb_value_t *>(value_in_leaf_node);
+    rdb_blob_wrapper_t blob_wrapper(
+        parent.cache()->max_block_size(),
+        const_cast<rdb_value_t *>(v)->value_ref(),
+        blob::btree_maxreflen);
+    blob_acq_t acq_group;
+    buffer_group_t buffer_group;
+    blob_wrapper.expose_all(
+        parent, access_t::read, &buffer_group, &acq_group);
+    value_out->resize(buffer_group.get_size());
+    size_t offset = 0;
+    for (size_t i = 0; i < buffer_group.num_buffers(); ++i) {
+        buffer_group_t::buffer_t b = buffer_group.get_buffer(i);
+        memcpy(value_out->data() + offset, b.data, b.size);
+        offset += b.size;
+    }
+    guarantee(offset == value_out->size());
+}
+
 /* `limiting_btree_backfill_pre_item_consumer_t` accepts `backfill_pre_item_t`s from
 `btree_send_backfill_pre()` and forwards them to the given
 `store_view_t::backfill_pre_item_consumer_t`, but it aborts after it receives a certain
@@ -48,6 +75,13 @@ public:
         return (inner_aborted || remaining == 0)
             ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
     }
+    void copy_value(
+            buf_parent_t parent,
+            const void *value_in_leaf_node,
+            UNUSED signal_t *interruptor2,
+            std::vector<char> *value_out) {
+        copy_rdb_value(parent, value_in_leaf_node, value_out);
+    }
     bool inner_aborted;
 private:
     store_view_t::backfill_pre_item_consumer_t *inner;
@@ -98,8 +132,8 @@ continue_bool_t store_t::send_backfill_pre(
             key_range_t to_do = pair.first;
             to_do.left = threshold.key();
             continue_bool_t cont = btree_send_backfill_pre(sb.get(),
-                release_superblock_t::RELEASE, &sizer, to_do, pair.second, &limiter,
-                interruptor);
+                release_superblock_t::RELEASE, &sizer, to_do, pair.second,
+                ctx != nullptr && ctx->backfill_content_hashes, &limiter, interruptor);
             guarantee(threshold <= pair.first.right);
             if (limiter.inner_aborted) {
                 guarantee(cont == continue_bool_t::ABORT);
@@ -178,24 +212,7 @@ public:
             const void *value_in_leaf_node,
             UNUSED signal_t *interruptor2,
             std::vector<char> *value_out) {
-        const rdb_value_t *v =
-            static_cast<const rdb_value_t *>(value_in_leaf_node);
-        rdb_blob_wrapper_t blob_wrapper(
-            parent.cache()->max_block_size(),
-            const_cast<rdb_value_t *>(v)->value_ref(),
-            blob::btree_maxreflen);
-        blob_acq_t acq_group;
-        buffer_group_t buffer_group;
-        blob_wrapper.expose_all(
-            parent, access_t::read, &buffer_group, &acq_group);
-        value_out->resize(buffer_group.get_size());
-        size_t offset = 0;
-        for (size_t i = 0; i < buffer_group.num_buffers(); ++i) {
-            buffer_group_t::buffer_t b = buffer_group.get_buffer(i);
-            memcpy(value_out->data() + offset, b.data, b.size);
-            offset += b.size;
-        }
-        guarantee(offset == value_out->size());
+        copy_rdb_value(parent, value_in_leaf_node, value_out);
     }
     bool inner_aborted;
     size_t remaining;
@@ -318,6 +318,71 @@ protob_t<const Term> term_t::get_src() const {
     return src;
 }
 
+void term_t::eval_batch(const std::vector<scope_env_t *> &envs,
+                        std::vector<eval_batch_result_t> *results_out) const {
+    if (envs.empty()) {
+        return;
+    } else if (!can_eval_batch()) {
+        eval_batch_impl(envs, results_out);
+        return;
+    }
+    env_t *env = envs[0]->env;
+    profile::starter_t starter(strprintf("Evaluating %s (batched).", name()),
+                               env->trace);
+    env->do_eval_callback();
+    if (env->interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    env->maybe_yield();
+    rcheck(
+        has_n_bytes_free_stack_space(MIN_EVAL_STACK_SPACE),
+        base_exc_t::GENERIC,
+        strprintf(
+            "Insufficient stack space available to evaluate `%s`.  This is usually "
+            "caused by running a very deeply-nested query.",
+            name()));
+
+    size_t first_row = results_out->size();
+    try {
+        eval_batch_impl(envs, results_out);
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+    }
+    r_sanity_check(results_out->size() > first_row
+                   && results_out->size() - first_row <= envs.size());
+
+    // Like `eval`, report datum errors as errors in this term.
+    for (size_t i = first_row; i < results_out->size(); ++i) {
+        eval_batch_result_t *res = &(*results_out)[i];
+        if (res->exc) {
+            try {
+                std::rethrow_exception(res->exc);
+            } catch (const datum_exc_t &e) {
+                res->exc = std::make_exception_ptr(
+                    exc_t(e.get_type(), e.what(), backtrace()));
+            } catch (const base_exc_t &) {
+            }
+        }
+    }
+}
+
+void term_t::eval_batch_impl(const std::vector<scope_env_t *> &envs,
+                             std::vector<eval_batch_result_t> *results_out) const {
+    for (auto it = envs.begin(); it != envs.end(); ++it) {
+        eval_batch_result_t res;
+        try {
+            res.datum = eval(*it)->as_datum();
+        } catch (const base_exc_t &) {
+            res.exc = std::current_exception();
+        }
+        results_out->push_back(std::move(res));
+        if (results_out->back().exc) {
+            // We don't know whether evaluating the next row has side effects.
+            break;
+        }
+    }
+}
+
 scoped_ptr_t<val_t> runtime_term_t::eval(scope_env_t *env, eval_flags_t eval_flags) const {
     // This is basically a hook for unit tests to change things mid-query
     profile::starter_t starter(strprintf("Evaluating %s.", name()), env->env->trace);
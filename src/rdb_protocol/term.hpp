@@ -2,6 +2,9 @@
 #ifndef RDB_PROTOCOL_TERM_HPP_
 #define RDB_PROTOCOL_TERM_HPP_
 
+#include <exception>
+#include <vector>
+
 #include "containers/counted.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/error.hpp"
@@ -51,6 +54,13 @@ private:
     virtual scoped_ptr_t<val_t> term_eval(scope_env_t *env, eval_flags_t) const = 0;
 };
 
+// The outcome of evaluating a term for one row of a batch: either `datum`, or the
+// error the evaluation threw in `exc`.
+struct eval_batch_result_t {
+    datum_t datum;
+    std::exception_ptr exc;
+};
+
 class term_t : public runtime_term_t {
 public:
     explicit term_t(protob_t<const Term> _src);
@@ -63,7 +73,23 @@ public:
 
     virtual void accumulate_captures(var_captures_t *captures) const = 0;
 
+    // Terms that are cheaper to evaluate many times at once than one at a time
+    // (e.g. `r.http`, whose requests can then run concurrently) override these.
+    // `eval_batch` calls `eval(...)->as_datum()` in each of `envs` in turn and
+    // appends the outcome for each row to `*results_out`.  A row's error doesn't
+    // stop the rows after it, unless evaluating them could have side effects; in
+    // that case only the rows up to the failed one are evaluated, and the caller
+    // decides whether to go on with the rest.  At least one row is evaluated.
+    virtual bool can_eval_batch() const { return false; }
+    void eval_batch(const std::vector<scope_env_t *> &envs,
+                    std::vector<eval_batch_result_t> *results_out) const;
+
 private:
+    // Does the work of `eval_batch`, which does the same checks and profiling as
+    // `eval` around it.
+    virtual void eval_batch_impl(const std::vector<scope_env_t *> &envs,
+                                 std::vector<eval_batch_result_t> *results_out) const;
+
     protob_t<const Term> src;
 
     DISABLE_COPYING(term_t);
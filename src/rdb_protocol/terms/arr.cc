@@ -176,6 +176,7 @@ private:
         return nth_term_impl(this, env, args->arg(env, 0), args->arg(env, 1));
     }
     virtual const char *name() const { return "nth"; }
+    virtual bool batches_first_arg() const { return true; }
     virtual bool is_grouped_seq_op() const { return true; }
 };
 
@@ -81,6 +81,7 @@ private:
     }
     virtual const char *name() const { return "error"; }
     virtual bool can_be_grouped() const { return false; }
+    virtual bool batches_first_arg() const { return true; }
 };
 
 counted_t<term_t> make_error_term(
@@ -40,6 +40,23 @@ private:
 
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const;
 
+    // Idempotent requests made by a function mapped over a sequence are sent to
+    // the worker together, so they run concurrently.
+    virtual bool can_eval_batch() const { return true; }
+    virtual void eval_batch_impl(const std::vector<scope_env_t *> &envs,
+                                 std::vector<eval_batch_result_t> *results_out) const;
+
+    void get_all_opts(scope_env_t *env,
+                      args_t *args,
+                      http_opts_t *opts_out,
+                      counted_t<const func_t> *depaginate_fn_out,
+                      int64_t *depaginate_limit_out) const;
+
+    scoped_ptr_t<val_t> perform(env_t *env,
+                                http_opts_t &&opts,
+                                counted_t<const func_t> &&depaginate_fn,
+                                int64_t depaginate_limit) const;
+
     // Functions to get optargs into the http_opts_t
     void get_optargs(scope_env_t *env, args_t *args, http_opts_t *opts_out) const;
 
@@ -220,19 +237,53 @@ void dispatch_http(env_t *env,
     check_error_result(*res_out, opts, parent);
 }
 
-scoped_ptr_t<val_t> http_term_t::eval_impl(scope_env_t *env, args_t *args,
-                                           eval_flags_t) const {
-    http_opts_t opts;
-    opts.limits = env->env->limits();
-    opts.version = env->env->reql_version();
-    opts.url.assign(args->arg(env, 0)->as_str().to_std());
-    opts.proxy.assign(env->env->get_reql_http_proxy());
-    get_optargs(env, args, &opts);
+// Unlike `dispatch_http`, this doesn't check the results for errors; each request
+// has its own.
+void dispatch_http_batch(env_t *env,
+                         const std::vector<http_opts_t> &opts,
+                         http_runner_t *runner,
+                         std::vector<http_result_t> *res_out) {
+    std::string error;
+    try {
+        runner->http_batch(opts, res_out, env->interruptor);
+    } catch (const extproc_worker_exc_t &ex) {
+        error.assign("crash in a worker process");
+    } catch (const interrupted_exc_t &ex) {
+        error.assign("interrupted");
+    } catch (const std::exception &ex) {
+        error = std::string("encounted an exception - ") + ex.what();
+    } catch (...) {
+        error.assign("encountered an unknown exception");
+    }
 
-    counted_t<const func_t> depaginate_fn;
-    int64_t depaginate_limit(0);
-    get_page_and_limit(env, args, &depaginate_fn, &depaginate_limit);
+    if (!error.empty()) {
+        res_out->clear();
+        res_out->resize(opts.size());
+        for (auto it = res_out->begin(); it != res_out->end(); ++it) {
+            it->error = error;
+        }
+    }
+}
+
+void http_term_t::get_all_opts(scope_env_t *env,
+                               args_t *args,
+                               http_opts_t *opts_out,
+                               counted_t<const func_t> *depaginate_fn_out,
+                               int64_t *depaginate_limit_out) const {
+    opts_out->limits = env->env->limits();
+    opts_out->version = env->env->reql_version();
+    opts_out->url.assign(args->arg(env, 0)->as_str().to_std());
+    opts_out->proxy.assign(env->env->get_reql_http_proxy());
+    get_optargs(env, args, opts_out);
+
+    *depaginate_limit_out = 0;
+    get_page_and_limit(env, args, depaginate_fn_out, depaginate_limit_out);
+}
 
+scoped_ptr_t<val_t> http_term_t::perform(env_t *env,
+                                         http_opts_t &&opts,
+                                         counted_t<const func_t> &&depaginate_fn,
+                                         int64_t depaginate_limit) const {
     // If we're depaginating, return a stream that will be evaluated automatically
     if (depaginate_fn.has()) {
         counted_t<datum_stream_t> http_stream = counted_t<datum_stream_t>(
@@ -240,17 +291,113 @@ scoped_ptr_t<val_t> http_term_t::eval_impl(scope_env_t *env, args_t *args,
                                     std::move(depaginate_fn),
                                     depaginate_limit,
                                     backtrace()));
-        return new_val(env->env, http_stream);
+        return new_val(env, http_stream);
     }
 
     // Otherwise, just run the http operation and return the datum
     http_result_t res;
-    http_runner_t runner(env->env->get_extproc_pool());
-    dispatch_http(env->env, opts, &runner, &res, this);
+    http_runner_t runner(env->get_extproc_pool());
+    dispatch_http(env, opts, &runner, &res, this);
 
     return new_val(res.body);
 }
 
+scoped_ptr_t<val_t> http_term_t::eval_impl(scope_env_t *env, args_t *args,
+                                           eval_flags_t) const {
+    http_opts_t opts;
+    counted_t<const func_t> depaginate_fn;
+    int64_t depaginate_limit;
+    get_all_opts(env, args, &opts, &depaginate_fn, &depaginate_limit);
+    return perform(env->env, std::move(opts), std::move(depaginate_fn),
+                   depaginate_limit);
+}
+
+void http_term_t::eval_batch_impl(const std::vector<scope_env_t *> &envs,
+                                  std::vector<eval_batch_result_t> *results_out) const {
+    env_t *env = envs[0]->env;
+    http_runner_t runner(env->get_extproc_pool());
+
+    // Requests are queued up until we reach one that must be made on its own: a
+    // paginated one, or one with side effects.  The queue is flushed before that
+    // one is made, so requests are still made in the original order.  If a row
+    // has failed by then, we stop there, because that request must not be made if
+    // the caller reports the error.
+    std::vector<eval_batch_result_t> results;
+    std::vector<size_t> pending_rows;
+    std::vector<http_opts_t> pending_opts;
+    bool failed = false;
+    auto flush_pending = [&]() {
+        if (pending_opts.empty()) {
+            return;
+        }
+        std::vector<http_result_t> res;
+        dispatch_http_batch(env, pending_opts, &runner, &res);
+        for (size_t i = 0; i < pending_rows.size(); ++i) {
+            eval_batch_result_t *row_res = &results[pending_rows[i]];
+            try {
+                check_error_result(res[i], pending_opts[i], this);
+                row_res->datum = std::move(res[i].body);
+            } catch (const base_exc_t &) {
+                row_res->exc = std::current_exception();
+                failed = true;
+            }
+        }
+        pending_rows.clear();
+        pending_opts.clear();
+    };
+
+    for (size_t row = 0; row < envs.size(); ++row) {
+        scope_env_t *scope_env = envs[row];
+        http_opts_t opts;
+        counted_t<const func_t> depaginate_fn;
+        int64_t depaginate_limit;
+        scoped_ptr_t<val_t> grouped;
+        results.push_back(eval_batch_result_t());
+        try {
+            if (scope_env->env->interruptor->is_pulsed()) {
+                throw interrupted_exc_t();
+            }
+            scoped_ptr_t<args_t> args = make_args(scope_env, NO_FLAGS, &grouped);
+            if (args.has()) {
+                get_all_opts(scope_env, args.get(), &opts,
+                             &depaginate_fn, &depaginate_limit);
+            }
+        } catch (const base_exc_t &) {
+            // Evaluating the next row's arguments could have side effects.
+            results.back().exc = std::current_exception();
+            break;
+        }
+
+        if (grouped.has()) {
+            results.back().datum = grouped->as_datum();
+        } else if (!depaginate_fn.has() &&
+                   (opts.method == http_method_t::GET ||
+                    opts.method == http_method_t::HEAD)) {
+            pending_rows.push_back(row);
+            pending_opts.push_back(std::move(opts));
+        } else {
+            flush_pending();
+            if (failed) {
+                results.pop_back();
+                break;
+            }
+            try {
+                results.back().datum = perform(scope_env->env, std::move(opts),
+                                               std::move(depaginate_fn),
+                                               depaginate_limit)->as_datum();
+            } catch (const base_exc_t &) {
+                results.back().exc = std::current_exception();
+                failed = true;
+            }
+        }
+    }
+    flush_pending();
+
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        results_out->push_back(std::move(*it));
+    }
+}
+
 std::vector<datum_t>
 http_datum_stream_t::next_page(env_t *env) {
     profile::sampler_t sampler(strprintf("Performing HTTP %s of `%s`",
@@ -301,6 +301,7 @@ private:
         return new_val(d.get_field(args->arg(env, 1)->as_str()));
     }
     virtual const char *name() const { return "get_field"; }
+    virtual bool batches_first_arg() const { return true; }
 };
 
 class bracket_term_t : public grouped_seq_op_term_t {
@@ -347,6 +348,7 @@ private:
         }
     }
     virtual const char *name() const { return "bracket"; }
+    virtual bool batches_first_arg() const { return true; }
     // obj_or_seq_op_term_t already does this, but because nth_term wasn't grouped,
     // I reimplement it here for clarity.
     virtual bool is_grouped_seq_op() const { return true; }
@@ -14,7 +14,7 @@ namespace ql {
 class sample_term_t : public op_term_t {
 public:
     sample_term_t(compile_env_t *env, const protob_t<const Term> &term)
-        : op_term_t(env, term, argspec_t(2)) { }
+        : op_term_t(env, term, argspec_t(2), optargspec_t({"approximate"})) { }
 
     scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         int64_t num_int = args->arg(env, 1)->as_int();
@@ -35,30 +35,24 @@ public:
             seq = v->as_seq(env->env);
         }
 
-        std::vector<datum_t> result;
-        result.reserve(num);
-        size_t element_number = 0;
-        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
-        {
-            profile::sampler_t sampler("Sampling elements.", env->env->trace);
-            datum_t row;
-            while (row = seq->next(env->env, batchspec), row.has()) {
-                element_number++;
-                if (result.size() < num) {
-                    result.push_back(row);
-                } else {
-                    /* We have a limitation on the size of arrays that makes
-                     * sure they are less than the size of an integer. */
-                    size_t new_index = randint(element_number);
-                    if (new_index < num) {
-                        result[new_index] = row;
-                    }
-                }
-                sampler.new_sample();
-            }
+        rcheck(!seq->is_grouped(), base_exc_t::GENERIC,
+               "Cannot treat the output of `group` as a stream "
+               "(did you mean to `ungroup`?).");
+        bool approximate = false;
+        if (scoped_ptr_t<val_t> approx = args->optarg(env, "approximate")) {
+            approximate = approx->as_bool();
         }
 
-        std::random_shuffle(result.begin(), result.end());
+        // The sample is taken on the shards, which send back at most `num` rows each.
+        // Its rows are already in random order.
+        datum_t sample =
+            seq->run_terminal(env->env, sample_wire_func_t(num, approximate))
+                ->as_datum();
+        std::vector<datum_t> result;
+        result.reserve(sample.arr_size());
+        for (size_t i = 0; i < sample.arr_size(); ++i) {
+            result.push_back(sample.get(i));
+        }
 
         counted_t<datum_stream_t> new_ds(
             new array_datum_stream_t(datum_t(std::move(result), env->env->limits()),
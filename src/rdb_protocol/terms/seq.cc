@@ -1,14 +1,18 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/math_utils.hpp"
 #include "rdb_protocol/op.hpp"
+#include "rdb_protocol/profile.hpp"
 
 namespace ql {
 
@@ -263,6 +267,286 @@ private:
     virtual const char *name() const { return "group"; }
 };
 
+/* A `filter` on a whole table can often read an index instead of the whole table.  We
+look for comparisons between a field of the row and a constant at the start of the
+predicate: an equality becomes a `get_all`, and a lower and an upper bound of the same
+type become a `between`.  The predicate still runs on the rows that come back, so the
+result is the same as for the table scan.
+
+Only the leading comparisons of a conjunction are used.  `and` stops at the first one
+that fails, so later terms are never evaluated for the rows the index skips, and they
+can't throw errors for them either.  One-sided comparisons aren't used, because they
+also match values of other types (like `null` or objects) that aren't in any index. */
+
+// What the leading comparisons of a predicate say about one field.
+struct field_constraint_t {
+    field_constraint_t()
+        : lower_type(key_range_t::open), upper_type(key_range_t::open) { }
+    datum_t equal;
+    datum_t lower, upper;
+    key_range_t::bound_t lower_type, upper_type;
+};
+
+// Sets `*out` if `term` is a constant.
+static bool constant_term(env_t *env, const Term &term, datum_t *out) {
+    if (term.type() != Term::DATUM) {
+        return false;
+    }
+    *out = to_datum(&term.datum(), env->limits(), env->reql_version());
+    return true;
+}
+
+// Sets `*field_out` if `term` is `var(field)` or `var.get_field(field)`.
+static bool field_term(
+        env_t *env, const Term &term, sym_t var, std::string *field_out) {
+    if ((term.type() != Term::BRACKET && term.type() != Term::GET_FIELD)
+        || term.args_size() != 2
+        || term.optargs_size() != 0) {
+        return false;
+    }
+    const Term &obj = term.args(0);
+    datum_t var_num, field;
+    if (obj.type() != Term::VAR
+        || obj.args_size() != 1
+        || !constant_term(env, obj.args(0), &var_num)
+        || var_num.get_type() != datum_t::R_NUM
+        || var_num.as_num() != var.value
+        || !constant_term(env, term.args(1), &field)
+        || field.get_type() != datum_t::R_STR) {
+        return false;
+    }
+    *field_out = field.as_str().to_std();
+    return true;
+}
+
+// Only these types are compared the same way by the predicate and by an index.
+static bool indexable_constant(const datum_t &d) {
+    return d.get_type() == datum_t::R_NUM
+        || d.get_type() == datum_t::R_STR
+        || d.get_type() == datum_t::R_BOOL;
+}
+
+// Adds what the leading comparisons in `term` say about the fields of `var` to
+// `constraints_out`.  Returns false at the first term that isn't a comparison, after
+// which nothing more may be added.
+static bool add_field_constraints(
+        env_t *env, const Term &term, sym_t var,
+        std::map<std::string, field_constraint_t> *constraints_out) {
+    Term::TermType type = term.type();
+    if (type == Term::AND) {
+        if (term.optargs_size() != 0) {
+            return false;
+        }
+        for (int i = 0; i < term.args_size(); ++i) {
+            if (!add_field_constraints(env, term.args(i), var, constraints_out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if ((type != Term::EQ && type != Term::LT && type != Term::LE
+         && type != Term::GT && type != Term::GE)
+        || term.args_size() != 2
+        || term.optargs_size() != 0) {
+        return false;
+    }
+
+    std::string field;
+    datum_t value;
+    if (field_term(env, term.args(0), var, &field)
+        && constant_term(env, term.args(1), &value)) {
+    } else if (field_term(env, term.args(1), var, &field)
+               && constant_term(env, term.args(0), &value)) {
+        // Turn `value < row(field)` into `row(field) > value`.
+        switch (type) {
+        case Term::LT: type = Term::GT; break;
+        case Term::LE: type = Term::GE; break;
+        case Term::GT: type = Term::LT; break;
+        case Term::GE: type = Term::LE; break;
+        default: break;
+        }
+    } else {
+        return false;
+    }
+    // Comparisons don't throw, so we can look past the ones we can't use.
+    if (!indexable_constant(value)) {
+        return true;
+    }
+
+    field_constraint_t *c = &(*constraints_out)[field];
+    switch (type) {
+    case Term::EQ:
+        if (!c->equal.has()) {
+            c->equal = value;
+        }
+        break;
+    case Term::GT: // fallthru
+    case Term::GE:
+        if (!c->lower.has()) {
+            c->lower = value;
+            c->lower_type = type == Term::GT ? key_range_t::open : key_range_t::closed;
+        }
+        break;
+    case Term::LT: // fallthru
+    case Term::LE:
+        if (!c->upper.has()) {
+            c->upper = value;
+            c->upper_type = type == Term::LT ? key_range_t::open : key_range_t::closed;
+        }
+        break;
+    default: unreachable();
+    }
+    return true;
+}
+
+class reql_func_finder_t : public func_visitor_t {
+public:
+    reql_func_finder_t() : reql_func(nullptr) { }
+    void on_reql_func(const reql_func_t *f) { reql_func = f; }
+    void on_js_func(const js_func_t *) { }
+    const reql_func_t *reql_func;
+};
+
+// Returns the ReQL function behind `f` if it has exactly one argument.
+static const reql_func_t *unary_reql_func(const counted_t<const func_t> &f) {
+    reql_func_finder_t finder;
+    f->visit(&finder);
+    if (finder.reql_func == nullptr || finder.reql_func->get_arg_names().size() != 1) {
+        return nullptr;
+    }
+    return finder.reql_func;
+}
+
+// Returns which of `table`'s secondary indexes can serve as an index on each field:
+// the ready, up-to-date, single, non-geospatial indexes whose function just gets the
+// field.
+static std::map<std::string, std::string> get_field_indexes(
+        env_t *env, const counted_t<table_t> &table) {
+    std::map<std::string, std::string> res;
+    std::map<std::string, sindex_config_t> configs;
+    std::string error;
+    if (!env->reql_cluster_interface()->sindex_list_ready(
+            table->db, name_string_t::guarantee_valid(table->name.c_str()),
+            env->interruptor, &error, &configs)) {
+        // We'll scan the table, which reports the error if it's still there.
+        return res;
+    }
+    for (const auto &pair : configs) {
+        const sindex_config_t &config = pair.second;
+        if (config.multi != sindex_multi_bool_t::SINGLE
+            || config.geo != sindex_geo_bool_t::REGULAR) {
+            continue;
+        }
+        const reql_func_t *f = unary_reql_func(config.func.compile_wire_func());
+        std::string field;
+        if (f != nullptr
+            && field_term(env, *f->get_body()->get_src(), f->get_arg_names()[0],
+                          &field)) {
+            res.insert(std::make_pair(field, pair.first));
+        }
+    }
+    return res;
+}
+
+// Returns a stream of the rows of `table` that may match the predicate, if an index
+// can narrow them down.  `predicate` is the object or function passed to `filter`.
+static counted_t<datum_stream_t> filter_index_stream(
+        env_t *env, const counted_t<table_t> &table, const scoped_ptr_t<val_t> &predicate,
+        backtrace_id_t bt) {
+    std::map<std::string, field_constraint_t> constraints;
+    if (predicate->get_type().is_convertible(val_t::type_t::DATUM)) {
+        // Objects match rows that have the same values in their fields.
+        datum_t obj = predicate->as_datum();
+        if (obj.get_type() == datum_t::R_OBJECT && !obj.is_ptype()) {
+            for (size_t i = 0; i < obj.obj_size(); ++i) {
+                std::pair<datum_string_t, datum_t> pair = obj.get_pair(i);
+                if (indexable_constant(pair.second)) {
+                    constraints[pair.first.to_std()].equal = pair.second;
+                }
+            }
+        }
+    } else if (predicate->get_type().is_convertible(val_t::type_t::FUNC)) {
+        const reql_func_t *f = unary_reql_func(predicate->as_func());
+        if (f != nullptr) {
+            add_field_constraints(env, *f->get_body()->get_src(),
+                                  f->get_arg_names()[0], &constraints);
+        }
+    }
+    if (constraints.empty()) {
+        return counted_t<datum_stream_t>();
+    }
+
+    const std::string &pkey = table->get_pkey();
+    boost::optional<std::string> index;
+    datum_t equal;
+    boost::optional<datum_range_t> range;
+    auto use_equal = [&](const std::string &idx, const field_constraint_t &c) {
+        index = idx;
+        equal = c.equal;
+    };
+    auto usable_range = [](const field_constraint_t &c) {
+        return c.lower.has() && c.upper.has()
+            && c.lower.get_type() == c.upper.get_type()
+            && c.lower.get_type() != datum_t::R_BOOL;
+    };
+    auto use_range = [&](const std::string &idx, const field_constraint_t &c) {
+        index = idx;
+        range = datum_range_t(c.lower, c.lower_type, c.upper, c.upper_type);
+    };
+
+    auto pkey_it = constraints.find(pkey);
+    if (pkey_it != constraints.end() && pkey_it->second.equal.has()
+        && pkey_it->second.equal.print_primary_internal().size()
+           <= rdb_protocol::MAX_PRIMARY_KEY_SIZE) {
+        // Too long a key would make `get_all` fail rather than find nothing.
+        use_equal(pkey, pkey_it->second);
+    } else {
+        std::map<std::string, std::string> field_indexes = get_field_indexes(env, table);
+        for (const auto &pair : constraints) {
+            auto it = field_indexes.find(pair.first);
+            if (it != field_indexes.end() && pair.second.equal.has()) {
+                use_equal(it->second, pair.second);
+                break;
+            }
+        }
+        if (!index && pkey_it != constraints.end() && usable_range(pkey_it->second)) {
+            use_range(pkey, pkey_it->second);
+        }
+        if (!index) {
+            for (const auto &pair : constraints) {
+                auto it = field_indexes.find(pair.first);
+                if (it != field_indexes.end() && usable_range(pair.second)) {
+                    use_range(it->second, pair.second);
+                    break;
+                }
+            }
+        }
+    }
+    if (!index) {
+        return counted_t<datum_stream_t>();
+    }
+
+    profile::starter_t starter(
+        strprintf("Use index `%s` for filter.", index->c_str()), env->trace);
+    counted_t<datum_stream_t> stream;
+    if (equal.has()) {
+        std::vector<counted_t<datum_stream_t> > streams{
+            table->get_all(env, equal, *index, bt)};
+        stream = make_counted<union_datum_stream_t>(env, std::move(streams), bt);
+    } else {
+        stream = make_counted<table_slice_t>(table)->with_bounds(*index, *range)
+            ->as_seq(env, bt);
+    }
+    // The index's readiness may be out of date, so we scan the table if reading
+    // the index fails.
+    return make_counted<fallback_datum_stream_t>(
+        stream,
+        [table, bt](env_t *fallback_env) {
+            return make_counted<table_slice_t>(table)->as_seq(fallback_env, bt);
+        },
+        bt);
+}
+
 class filter_term_t : public grouped_seq_op_term_t {
 public:
     filter_term_t(compile_env_t *env, const protob_t<const Term> &term)
@@ -281,7 +565,22 @@ private:
         }
 
         if (v0->get_type().is_convertible(val_t::type_t::SELECTION)) {
-            counted_t<selection_t> ts = v0->as_selection(env->env);
+            counted_t<selection_t> ts;
+            // With a default value, rows without the fields can match too.  And a
+            // changefeed on an index read would be a range changefeed, with initial
+            // values, rather than one on the table.
+            if (v0->get_type().is_convertible(val_t::type_t::TABLE) && !defval
+                && !env->env->evaluating_changes_source()) {
+                counted_t<table_t> table = v0->as_table();
+                counted_t<datum_stream_t> stream =
+                    filter_index_stream(env->env, table, v1, backtrace());
+                if (stream.has()) {
+                    ts = make_counted<selection_t>(table, stream);
+                }
+            }
+            if (!ts.has()) {
+                ts = v0->as_selection(env->env);
+            }
             ts->seq->add_transformation(filter_wire_func_t(f, defval), backtrace());
             return new_val(ts);
         } else {
@@ -404,7 +703,11 @@ private:
         scoped_ptr_t<val_t> include_initial_vals_val =
             args->optarg(env, "include_initial_vals");
 
-        scoped_ptr_t<val_t> v = args->arg(env, 0);
+        scoped_ptr_t<val_t> v;
+        {
+            env_t::changes_source_t changes_source(env->env);
+            v = args->arg(env, 0);
+        }
         if (v->get_type().is_convertible(val_t::type_t::SEQUENCE)) {
             counted_t<datum_stream_t> seq = v->as_seq(env->env);
             std::vector<counted_t<datum_stream_t> > streams;
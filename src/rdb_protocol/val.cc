@@ -356,6 +356,20 @@ counted_t<datum_stream_t> table_t::get_all(
         read_mode);
 }
 
+counted_t<datum_stream_t> table_t::get_all(
+        env_t *env,
+        const std::vector<datum_t> &values,
+        const std::string &get_all_sindex_id,
+        backtrace_id_t bt) {
+    return tbl->read_all_keys(
+        env,
+        get_all_sindex_id,
+        bt,
+        display_name(),
+        values,
+        read_mode);
+}
+
 counted_t<datum_stream_t> table_t::get_intersecting(
         env_t *env,
         const datum_t &query_geometry,
@@ -42,6 +42,12 @@ public:
             datum_t value,
             const std::string &sindex_id,
             backtrace_id_t bt);
+    // Reads all of the keys at once, rather than one read per key.
+    counted_t<datum_stream_t> get_all(
+            env_t *env,
+            const std::vector<datum_t> &values,
+            const std::string &sindex_id,
+            backtrace_id_t bt);
     counted_t<datum_stream_t> get_intersecting(
             env_t *env,
             const datum_t &query_geometry,
@@ -222,6 +222,7 @@ static std::set<std::string> acceptable_keys = {
     "params",
     "primary_key",
     "primary_replica_tag",
+    "priority",
     "profile",
     "read_mode",
     "redirects",
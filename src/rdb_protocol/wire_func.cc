@@ -280,6 +280,8 @@ RDB_IMPL_SERIALIZABLE_0_SINCE_v1_13(count_wire_func_t);
 
 RDB_IMPL_SERIALIZABLE_0_FOR_CLUSTER(zip_wire_func_t);
 
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(sample_wire_func_t, n, approximate);
+
 RDB_IMPL_SERIALIZABLE_2_SINCE_v1_13(filter_wire_func_t, filter_func, default_filter_val);
 
 RDB_MAKE_SERIALIZABLE_1_FOR_CLUSTER(distinct_wire_func_t, use_index);
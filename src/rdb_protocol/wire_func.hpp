@@ -119,6 +119,18 @@ class zip_wire_func_t {
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(zip_wire_func_t);
 
+// `sample` picks `n` rows uniformly at random.  If `approximate` is set, the shards
+// may pick rows by descending their B-trees at random instead of reading every row.
+class sample_wire_func_t {
+public:
+    sample_wire_func_t() : n(0), approximate(false) { }
+    sample_wire_func_t(uint64_t _n, bool _approximate)
+        : n(_n), approximate(_approximate) { }
+    uint64_t n;
+    bool approximate;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sample_wire_func_t);
+
 class group_wire_func_t {
 public:
     group_wire_func_t() : bt(backtrace_id_t::empty()) { }
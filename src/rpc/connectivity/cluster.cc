@@ -26,11 +26,15 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           16
 
-// The cluster communication protocol version.
+// The cluster communication protocol version. We only talk to peers with exactly
+// the same version string, so it also has to change when the cluster serialization
+// of some type changes without a new `cluster_version_t`. "2.2.0" added content
+// hashes to backfill pre-items, `recency_only` to backfill items, and the encoding
+// byte to mailbox message headers.
 static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_1_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
-#define CLUSTER_VERSION_STRING "2.1.0"
+#define CLUSTER_VERSION_STRING "2.2.0"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
@@ -0,0 +1,130 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rpc/mailbox/compression.hpp"
+
+#include <zlib.h>
+
+#include <limits>
+
+#include "perfmon/perfmon.hpp"
+#include "time.hpp"
+
+/* The stats are visible under `cluster_compression` in the perfmon tree and in the
+server rows of the `stats` system table. `uncompressed_bytes` and `compressed_bytes`
+only count messages that were actually sent compressed, so their ratio is the
+compression ratio. The `_usecs` counters measure the CPU time spent in zlib. */
+class mailbox_compression_stats_t {
+public:
+    mailbox_compression_stats_t() :
+        membership(&get_global_perfmon_collection(), &collection,
+            "cluster_compression"),
+        multi_membership(&collection,
+            &uncompressed_bytes, "uncompressed_bytes",
+            &compressed_bytes, "compressed_bytes",
+            &compress_usecs, "compress_usecs",
+            &decompress_usecs, "decompress_usecs") { }
+
+    static mailbox_compression_stats_t *get() {
+        static mailbox_compression_stats_t stats;
+        return &stats;
+    }
+
+    perfmon_collection_t collection;
+    perfmon_counter_t uncompressed_bytes;
+    perfmon_counter_t compressed_bytes;
+    perfmon_counter_t compress_usecs;
+    perfmon_counter_t decompress_usecs;
+
+private:
+    perfmon_membership_t membership;
+    perfmon_multi_membership_t multi_membership;
+};
+
+void register_mailbox_compression_stats() {
+    mailbox_compression_stats_t::get();
+}
+
+bool compress_mailbox_payload(write_message_t *payload, std::vector<char> *out) {
+    ticks_t start = get_ticks();
+    uint64_t uncompressed_size = payload->size();
+    if (uncompressed_size > std::numeric_limits<uInt>::max() / 2) {
+        /* zlib can't handle buffers this large in a single call */
+        return false;
+    }
+
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    /* Replication traffic is latency-sensitive, so we favor speed over ratio */
+    if (deflateInit(&zstream, Z_BEST_SPEED) != Z_OK) {
+        return false;
+    }
+
+    /* The compressed payload starts with the uncompressed size so the receiver can
+    allocate the output buffer in one go. */
+    out->resize(sizeof(uint64_t) + deflateBound(&zstream, uncompressed_size));
+    memcpy(out->data(), &uncompressed_size, sizeof(uint64_t));
+    zstream.next_out = reinterpret_cast<Bytef *>(out->data() + sizeof(uint64_t));
+    zstream.avail_out = out->size() - sizeof(uint64_t);
+
+    intrusive_list_t<write_buffer_t> *buffers = payload->unsafe_expose_buffers();
+    int zres = Z_OK;
+    for (write_buffer_t *b = buffers->head(); b != nullptr; b = buffers->next(b)) {
+        zstream.next_in = reinterpret_cast<Bytef *>(b->data);
+        zstream.avail_in = b->size;
+        zres = deflate(&zstream, buffers->next(b) == nullptr ? Z_FINISH : Z_NO_FLUSH);
+        if (zres != Z_OK && zres != Z_STREAM_END) {
+            break;
+        }
+    }
+    size_t compressed_size = zstream.total_out;
+    deflateEnd(&zstream);
+    if (zres != Z_STREAM_END
+            || compressed_size + sizeof(uint64_t) >= uncompressed_size) {
+        return false;
+    }
+    out->resize(sizeof(uint64_t) + compressed_size);
+
+    mailbox_compression_stats_t *stats = mailbox_compression_stats_t::get();
+    stats->uncompressed_bytes += uncompressed_size;
+    stats->compressed_bytes += out->size();
+    stats->compress_usecs += (get_ticks() - start) / 1000;
+    return true;
+}
+
+bool decompress_mailbox_payload(
+        const std::vector<char> &data, int64_t offset, std::vector<char> *out) {
+    ticks_t start = get_ticks();
+    if (data.size() < offset + sizeof(uint64_t)) {
+        return false;
+    }
+    uint64_t uncompressed_size;
+    memcpy(&uncompressed_size, data.data() + offset, sizeof(uint64_t));
+    if (uncompressed_size > std::numeric_limits<uInt>::max()) {
+        /* We never compress messages this large, so the data must be corrupt */
+        return false;
+    }
+    out->resize(uncompressed_size);
+
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    zstream.next_in = reinterpret_cast<Bytef *>(
+        const_cast<char *>(data.data() + offset + sizeof(uint64_t)));
+    zstream.avail_in = data.size() - offset - sizeof(uint64_t);
+    if (inflateInit(&zstream) != Z_OK) {
+        return false;
+    }
+    zstream.next_out = reinterpret_cast<Bytef *>(out->data());
+    zstream.avail_out = uncompressed_size;
+    int zres = inflate(&zstream, Z_FINISH);
+    bool ok = zres == Z_STREAM_END
+        && zstream.total_out == uncompressed_size
+        && zstream.avail_in == 0;
+    inflateEnd(&zstream);
+
+    mailbox_compression_stats_t::get()->decompress_usecs +=
+        (get_ticks() - start) / 1000;
+    return ok;
+}
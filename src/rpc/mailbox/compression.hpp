@@ -0,0 +1,39 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RPC_MAILBOX_COMPRESSION_HPP_
+#define RPC_MAILBOX_COMPRESSION_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+
+/* Large mailbox messages, such as chunks of backfill items, are compressed with zlib
+before they're sent to another server. Small messages are always sent raw because the
+CPU cost of compressing them isn't worth the few bytes it would save. */
+
+/* Messages whose payload is smaller than this aren't compressed. */
+const size_t MAILBOX_COMPRESSION_THRESHOLD = 16 * 1024;
+
+/* `mailbox_encoding_t` is sent in the header of every mailbox message that goes over
+the network. */
+enum class mailbox_encoding_t : uint8_t {
+    RAW = 0,
+    DEFLATE = 1
+};
+
+/* `compress_mailbox_payload()` deflates the contents of `payload` into `out`. It
+returns `false` if compression failed or didn't make the message any smaller, in which
+case the caller should send the payload raw. */
+bool compress_mailbox_payload(write_message_t *payload, std::vector<char> *out);
+
+/* `decompress_mailbox_payload()` reverses `compress_mailbox_payload()`. It returns
+`false` if the data is corrupt. */
+bool decompress_mailbox_payload(
+    const std::vector<char> &data, int64_t offset, std::vector<char> *out);
+
+/* `register_mailbox_compression_stats()` makes sure the compression stats appear in
+the perfmon tree, even before any message has been compressed. */
+void register_mailbox_compression_stats();
+
+#endif  // RPC_MAILBOX_COMPRESSION_HPP_
@@ -11,6 +11,7 @@
 #include "containers/archive/versioned.hpp"
 #include "concurrency/pmap.hpp"
 #include "logger.hpp"
+#include "rpc/mailbox/compression.hpp"
 
 /* raw_mailbox_t */
 
@@ -68,40 +69,58 @@ class raw_mailbox_writer_t :
 {
 public:
     raw_mailbox_writer_t(int32_t _dest_thread, raw_mailbox_t::id_t _dest_mailbox_id,
-            mailbox_write_callback_t *_subwriter) :
+            bool _allow_compression, mailbox_write_callback_t *_subwriter) :
         dest_thread(_dest_thread),
         dest_mailbox_id(_dest_mailbox_id),
+        allow_compression(_allow_compression),
         subwriter(_subwriter) { }
     virtual ~raw_mailbox_writer_t() { }
 
     void write(write_stream_t *stream) {
-        write_message_t wm;
+        write_message_t payload;
+        subwriter->write(cluster_version_t::CLUSTER, &payload);
+
+        /* Large messages are compressed if the connection allows it. If compression
+        doesn't help, we fall back to sending the payload raw. */
+        mailbox_encoding_t encoding = mailbox_encoding_t::RAW;
+        std::vector<char> compressed;
+        if (allow_compression
+                && payload.size() >= MAILBOX_COMPRESSION_THRESHOLD
+                && compress_mailbox_payload(&payload, &compressed)) {
+            encoding = mailbox_encoding_t::DEFLATE;
+        }
+        uint64_t data_length = encoding == mailbox_encoding_t::RAW
+            ? static_cast<uint64_t>(payload.size())
+            : static_cast<uint64_t>(compressed.size());
+
+        write_message_t header;
         // Right now, we serialize this length/thread/mailbox information the same
         // way irrespective of version. (Serialization methods for primitive types
         // all behave the same way anyway -- this is just for performance, avoiding
         // unnecessary branching on cluster_version.)  See read_mailbox_header for
-        // the deserialization.
-        serialize_universal(&wm, dest_thread);
-        serialize_universal(&wm, dest_mailbox_id);
-        uint64_t prefix_length = static_cast<uint64_t>(wm.size());
-
-        subwriter->write(cluster_version_t::CLUSTER, &wm);
-
-        // Prepend the message length.
-        // TODO: It would be more efficient if we could make this part of `msg`.
-        //  e.g. with a `prepend()` method on write_message_t.
-        write_message_t length_msg;
-        serialize_universal(&length_msg,
-                            static_cast<uint64_t>(wm.size()) - prefix_length);
-
-        int res = send_write_message(stream, &length_msg);
-        if (res) { throw fake_archive_exc_t(); }
-        res = send_write_message(stream, &wm);
+        // the deserialization. The encoding byte is new in cluster version 2.2.0;
+        // the handshake refuses peers with older versions, so every peer reads it.
+        serialize_universal(&header, data_length);
+        serialize_universal(&header, dest_thread);
+        serialize_universal(&header, dest_mailbox_id);
+        serialize_universal(&header, static_cast<uint8_t>(encoding));
+
+        int res = send_write_message(stream, &header);
         if (res) { throw fake_archive_exc_t(); }
+        if (encoding == mailbox_encoding_t::RAW) {
+            res = send_write_message(stream, &payload);
+            if (res) { throw fake_archive_exc_t(); }
+        } else {
+            int64_t written = stream->write(compressed.data(), compressed.size());
+            if (written != static_cast<int64_t>(compressed.size())) {
+                throw fake_archive_exc_t();
+            }
+        }
     }
 private:
     int32_t dest_thread;
     raw_mailbox_t::id_t dest_mailbox_id;
+    bool allow_compression;
     mailbox_write_callback_t *subwriter;
 };
 
@@ -117,7 +136,9 @@ void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
             dest.peer, &connection_keepalive))) {
         return;
     }
-    raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, callback);
+    /* There's no point in compressing messages that never leave this process */
+    raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id,
+        src->compress_messages && !connection->is_loopback(), callback);
     src->get_connectivity_cluster()->send_message(connection, connection_keepalive,
         src->get_message_tag(), &writer);
 }
@@ -125,10 +146,13 @@ void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
 static const int MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD = 4;
 
 mailbox_manager_t::mailbox_manager_t(connectivity_cluster_t *connectivity_cluster,
-        connectivity_cluster_t::message_tag_t message_tag) :
+        connectivity_cluster_t::message_tag_t message_tag,
+        bool _compress_messages) :
     cluster_message_handler_t(connectivity_cluster, message_tag),
-    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD)
-    { }
+    compress_messages(_compress_messages),
+    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD) {
+    register_mailbox_compression_stats();
+}
 
 mailbox_manager_t::mailbox_table_t::mailbox_table_t() {
     next_mailbox_id = (UINT64_MAX / get_num_threads()) * get_thread_id().threadnum;
@@ -159,6 +183,7 @@ struct mailbox_header_t {
     uint64_t data_length;
     int32_t dest_thread;
     raw_mailbox_t::id_t dest_mailbox_id;
+    mailbox_encoding_t encoding;
 };
 
 // Helper function for on_local_message and on_message
@@ -177,6 +202,14 @@ void read_mailbox_header(read_stream_t *stream,
     if (bad(res)) { throw fake_archive_exc_t(); }
     res = deserialize_universal(stream, &header_out->dest_mailbox_id);
     if (bad(res)) { throw fake_archive_exc_t(); }
+    uint8_t encoding;
+    res = deserialize_universal(stream, &encoding);
+    if (bad(res)
+        || (encoding != static_cast<uint8_t>(mailbox_encoding_t::RAW)
+            && encoding != static_cast<uint8_t>(mailbox_encoding_t::DEFLATE))) {
+        throw fake_archive_exc_t();
+    }
+    header_out->encoding = static_cast<mailbox_encoding_t>(encoding);
 }
 
 void mailbox_manager_t::on_local_message(
@@ -207,7 +240,7 @@ void mailbox_manager_t::on_local_message(
                 mbox_header, &stream_data, stream_data_offset]() {
             mailbox_read_coroutine(connection, connection_keepalive,
                 threadnum_t(mbox_header.dest_thread), mbox_header.dest_mailbox_id,
-                &stream_data, stream_data_offset, FORCE_YIELD);
+                mbox_header.encoding, &stream_data, stream_data_offset, FORCE_YIELD);
         });
 }
 
@@ -234,7 +267,7 @@ void mailbox_manager_t::on_message(connectivity_cluster_t::connection_t *connect
                 mbox_header, &stream_data]() {
             mailbox_read_coroutine(connection, connection_keepalive,
                 threadnum_t(mbox_header.dest_thread), mbox_header.dest_mailbox_id,
-                &stream_data, 0, MAYBE_YIELD);
+                mbox_header.encoding, &stream_data, 0, MAYBE_YIELD);
         });
 }
 
@@ -244,6 +277,7 @@ void mailbox_manager_t::mailbox_read_coroutine(
         UNUSED auto_drainer_t::lock_t connection_keepalive,
         threadnum_t dest_thread,
         raw_mailbox_t::id_t dest_mailbox_id,
+        mailbox_encoding_t encoding,
         std::vector<char> *stream_data,
         int64_t stream_data_offset,
         force_yield_t force_yield) {
@@ -263,6 +297,20 @@ void mailbox_manager_t::mailbox_read_coroutine(
         }
 
         try {
+            if (encoding == mailbox_encoding_t::DEFLATE) {
+                /* We decompress on the destination thread so that the work is spread
+                out in the same way as the deserialization itself. */
+                std::vector<char> data;
+                int64_t offset = 0;
+                stream.swap(&data, &offset);
+                std::vector<char> decompressed;
+                if (!decompress_mailbox_payload(data, offset, &decompressed)) {
+                    throw fake_archive_exc_t();
+                }
+                int64_t decompressed_offset = 0;
+                stream.swap(&decompressed, &decompressed_offset);
+            }
+
             raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
             if (mbox != NULL) {
                 try {
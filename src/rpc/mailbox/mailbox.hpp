@@ -11,6 +11,7 @@
 #include "containers/archive/archive.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "rpc/connectivity/cluster.hpp"
+#include "rpc/mailbox/compression.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 
 class mailbox_manager_t;
@@ -135,8 +136,11 @@ of actually routing messages to mailboxes. */
 
 class mailbox_manager_t : public cluster_message_handler_t {
 public:
+    /* If `compress_messages` is `false`, we never compress the messages we send. We
+    can still receive compressed messages from other servers. */
     mailbox_manager_t(connectivity_cluster_t *connectivity_cluster,
-                      connectivity_cluster_t::message_tag_t message_tag);
+                      connectivity_cluster_t::message_tag_t message_tag,
+                      bool compress_messages = true);
 
 private:
     friend struct raw_mailbox_t;
@@ -152,6 +156,8 @@ private:
     };
     one_per_thread_t<mailbox_table_t> mailbox_tables;
 
+    const bool compress_messages;
+
     /* We must acquire one of these semaphores whenever we want to send a message over a
     mailbox. This prevents mailbox messages from starving directory and semilattice
     messages. */
@@ -179,6 +185,7 @@ private:
                                 auto_drainer_t::lock_t connection_keepalive,
                                 threadnum_t dest_thread,
                                 raw_mailbox_t::id_t dest_mailbox_id,
+                                mailbox_encoding_t encoding,
                                 std::vector<char> *stream_data,
                                 int64_t stream_data_offset,
                                 force_yield_t force_yield);
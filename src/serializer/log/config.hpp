@@ -15,6 +15,8 @@ struct log_serializer_dynamic_config_t {
     log_serializer_dynamic_config_t() {
         read_ahead = true;
         io_batch_factor = DEFAULT_IO_BATCH_FACTOR;
+        punch_holes = false;
+        compact_file = true;
     }
 
     /* The (minimal) batch size of i/o requests being taken from a single i/o account.
@@ -24,6 +26,16 @@ struct log_serializer_dynamic_config_t {
 
     /* Enable reading more data than requested to let the cache warmup more quickly esp. on rotational drives */
     bool read_ahead;
+
+    /* Give the space of free extents that are likely to stay free back to the
+    filesystem (and, through it, to the device) by punching holes into the file. Off by
+    default, because the filesystem has to allocate the space again if the extent is
+    reused, and that fragments the file. */
+    bool punch_holes;
+
+    /* When a large part of the file is free, have the GC move live blocks out of the
+    extents at the end of the file so that the file can be truncated. */
+    bool compact_file;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
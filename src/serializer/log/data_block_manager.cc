@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include <sys/uio.h>
 
+#include <algorithm>
 #include <functional>
 
 #include "arch/arch.hpp"
@@ -46,6 +47,12 @@ constexpr double GC_STOP_RATIO = 0.1;
 // rate down.
 constexpr double GC_HIGH_RATIO = 0.5;
 
+// Once at least this fraction of the file (and at least FILE_COMPACTION_MIN_FREE_EXTENTS
+// extents) is free, the GC starts moving blocks out of the extents at the end of the file
+// so that the file can shrink.
+constexpr double FILE_COMPACTION_FREE_RATIO = 0.25;
+const size_t FILE_COMPACTION_MIN_FREE_EXTENTS = 16;
+
 // What's the maximum number of "young" extents we can have?
 const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
 // What's the definition of a "young" extent in microseconds?
@@ -380,14 +387,20 @@ private:
 data_block_manager_t::data_block_manager_t(
         extent_manager_t *em, log_serializer_t *_serializer,
         const log_serializer_on_disk_static_config_t *_static_config,
+        const log_serializer_dynamic_config_t *_dynamic_config,
         log_serializer_stats_t *_stats)
     : stats(_stats), shutdown_callback(NULL), state(state_unstarted),
-      static_config(_static_config), extent_manager(em), serializer(_serializer),
+      static_config(_static_config), dynamic_config(_dynamic_config),
+      extent_manager(em), serializer(_serializer),
+      no_old_extents_from(SIZE_MAX),
       gc_stats(stats)
 {
     rassert(static_config != NULL);
     rassert(extent_manager != NULL);
     rassert(serializer != NULL);
+    for (size_t i = 0; i < NUM_WRITE_STREAMS; ++i) {
+        active_extents[i] = NULL;
+    }
 }
 
 data_block_manager_t::~data_block_manager_t() {
@@ -443,7 +456,7 @@ void data_block_manager_t::start_existing(file_t *file,
             reconstructed_extents.push_back(e);
         }
 
-        active_extent = entries.get(offset / extent_manager->extent_size);
+        gc_entry_t *active_extent = entries.get(offset / extent_manager->extent_size);
         guarantee(active_extent != NULL);
 
         /* Turn the extent from a reconstructing extent into an active extent */
@@ -451,8 +464,7 @@ void data_block_manager_t::start_existing(file_t *file,
         reconstructed_extents.remove(active_extent);
 
         active_extent->make_active();
-    } else {
-        active_extent = NULL;
+        active_extents[USER_WRITE_STREAM] = active_extent;
     }
 
     /* Convert any extents that we found live blocks in, but that are not active
@@ -461,12 +473,7 @@ void data_block_manager_t::start_existing(file_t *file,
         reconstructed_extents.remove(entry);
 
         guarantee(entry->state == gc_entry_t::state_reconstructing);
-        entry->state = gc_entry_t::state_old;
-
-        entry->our_pq_entry = gc_pq.push(entry);
-
-        gc_stats.old_total_block_bytes += static_config->extent_size();
-        gc_stats.old_garbage_block_bytes += entry->garbage_bytes();
+        make_entry_old(entry);
     }
 
     state = state_ready;
@@ -718,10 +725,18 @@ std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
+    return many_writes(writes, USER_WRITE_STREAM, io_account, cb);
+}
+
+std::vector<counted_t<ls_block_token_pointee_t> >
+data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
+                                  write_stream_t stream,
+                                  file_account_t *io_account,
+                                  iocallback_t *cb) {
     // These tokens are grouped by extent.  You can do a contiguous write in each
     // extent.
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
-        = gimme_some_new_offsets(writes);
+        = gimme_some_new_offsets(writes, stream);
 
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         it->buf->ser_header.block_id = it->block_id;
@@ -787,6 +802,11 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                              std::move(iovecs), io_account, intermediate_cb);
 
         stats->bytes_written(total_aligned_size);
+        if (stream == GC_WRITE_STREAM) {
+            stats->pm_serializer_data_gc_bytes_written += total_aligned_size;
+        } else {
+            stats->pm_serializer_data_user_bytes_written += total_aligned_size;
+        }
     }
 
     // Call on_io_complete for degenerate case (we added 1 to ops_remaining
@@ -994,9 +1014,14 @@ struct block_write_cond_t : public cond_t, public iocallback_t {
 };
 
 void data_block_manager_t::run_gc(gc_state_t *gc_state) {
-    while (!gc_pq.empty()
-           && should_we_keep_gcing()
-           && !should_terminate_one_gc_thread()) {
+    while (!should_terminate_one_gc_thread()) {
+        {
+            ASSERT_NO_CORO_WAITING;
+            gc_state->current_entry = pick_gc_entry();
+        }
+        if (gc_state->current_entry == NULL) {
+            break;
+        }
         gc_one_extent(gc_state);
 
         if (state == state_shutting_down) {
@@ -1039,12 +1064,8 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
         ++stats->pm_serializer_data_extents_gced;
 
-        /* grab the entry */
-        guarantee (!gc_pq.empty());
-        guarantee(gc_state->current_entry == NULL);
-        gc_state->current_entry = gc_pq.pop();
-        gc_state->current_entry->our_pq_entry = NULL;
-
+        /* `run_gc()` has already grabbed the entry for us */
+        guarantee(gc_state->current_entry != NULL);
         guarantee(gc_state->current_entry->state == gc_entry_t::state_old);
         gc_state->current_entry->state = gc_entry_t::state_in_gc;
         gc_stats.old_garbage_block_bytes -= gc_state->current_entry->garbage_bytes();
@@ -1210,8 +1231,8 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
                                                   writes[i].buf->ser_header.block_id));
         }
 
-        new_block_tokens = many_writes(the_writes, choose_gc_io_account(),
-                                       &block_write_cond);
+        new_block_tokens = many_writes(the_writes, GC_WRITE_STREAM,
+                                       choose_gc_io_account(), &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1280,8 +1301,9 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
 void data_block_manager_t::prepare_metablock(data_block_manager::metablock_mixin_t *metablock) {
     guarantee(state == state_ready || state == state_shutting_down);
 
-    if (active_extent != NULL) {
-        metablock->active_extent = active_extent->extent_ref.offset();
+    if (active_extents[USER_WRITE_STREAM] != NULL) {
+        metablock->active_extent =
+            active_extents[USER_WRITE_STREAM]->extent_ref.offset();
     } else {
         metablock->active_extent = NULL_OFFSET;
     }
@@ -1308,10 +1330,12 @@ void data_block_manager_t::actually_shutdown() {
 
     guarantee(reconstructed_extents.head() == NULL);
 
-    if (active_extent != NULL) {
-        UNUSED int64_t extent = active_extent->extent_ref.release();
-        delete active_extent;
-        active_extent = NULL;
+    for (size_t i = 0; i < NUM_WRITE_STREAMS; ++i) {
+        if (active_extents[i] != NULL) {
+            UNUSED int64_t extent = active_extents[i]->extent_ref.release();
+            delete active_extents[i];
+            active_extents[i] = NULL;
+        }
     }
 
     while (gc_entry_t *entry = young_extent_queue.head()) {
@@ -1332,8 +1356,10 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes,
+                                             write_stream_t stream) {
     ASSERT_NO_CORO_WAITING;
+    gc_entry_t *&active_extent = active_extents[stream];
 
     // Start a new extent if necessary.
     if (active_extent == NULL) {
@@ -1392,6 +1418,67 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
     return ret;
 }
 
+gc_entry_t *data_block_manager_t::pick_gc_entry() {
+    ASSERT_NO_CORO_WAITING;
+    gc_entry_t *entry;
+    if (!gc_pq.empty() && should_we_keep_gcing()) {
+        entry = gc_pq.pop();
+    } else {
+        entry = pick_compaction_entry();
+        if (entry == NULL) {
+            return NULL;
+        }
+        gc_pq.remove(entry->our_pq_entry);
+    }
+    entry->our_pq_entry = NULL;
+    return entry;
+}
+
+gc_entry_t *data_block_manager_t::pick_compaction_entry() const {
+    if (!dynamic_config->compact_file) {
+        return NULL;
+    }
+    const size_t num_extents = extent_manager->num_extents();
+    const size_t held_extents = extent_manager->held_extents();
+    if (held_extents < FILE_COMPACTION_MIN_FREE_EXTENTS
+        || held_extents < num_extents * FILE_COMPACTION_FREE_RATIO) {
+        return NULL;
+    }
+
+    /* If all the extents that are in use were packed at the beginning of the file, it
+    would be `num_extents - held_extents` extents long. Anything we move out of the
+    extents beyond that point gets written to a free extent closer to the beginning of
+    the file, because the extent manager hands out the lowest free extent first. We
+    can't move active or young extents, but they'll become old soon enough.
+    This is called whenever we consider starting the GC, so we don't scan the extents
+    that we already know to have no old extents after them again. */
+    const size_t first_extent_id = num_extents - held_extents;
+    for (size_t extent_id = std::min(num_extents, no_old_extents_from);
+         extent_id > first_extent_id;) {
+        --extent_id;
+        gc_entry_t *entry = entries.get(extent_id);
+        if (entry != NULL && entry->state == gc_entry_t::state_old) {
+            no_old_extents_from = extent_id + 1;
+            return entry;
+        }
+    }
+    no_old_extents_from = std::min(no_old_extents_from, first_extent_id);
+    return NULL;
+}
+
+void data_block_manager_t::make_entry_old(gc_entry_t *entry) {
+    entry->state = gc_entry_t::state_old;
+    const size_t extent_id = entry->extent_ref.offset() / static_config->extent_size();
+    if (no_old_extents_from <= extent_id) {
+        no_old_extents_from = extent_id + 1;
+    }
+
+    entry->our_pq_entry = gc_pq.push(entry);
+
+    gc_stats.old_total_block_bytes += static_config->extent_size();
+    gc_stats.old_garbage_block_bytes += entry->garbage_bytes();
+}
+
 bool data_block_manager_t::is_gc_active() const {
     return !active_gcs.empty();
 }
@@ -1420,12 +1507,7 @@ void data_block_manager_t::remove_last_unyoung_entry() {
     young_extent_queue.remove(entry);
 
     guarantee(entry->state == gc_entry_t::state_young);
-    entry->state = gc_entry_t::state_old;
-
-    entry->our_pq_entry = gc_pq.push(entry);
-
-    gc_stats.old_total_block_bytes += static_config->extent_size();
-    gc_stats.old_garbage_block_bytes += entry->garbage_bytes();
+    make_entry_old(entry);
 }
 
 /* functions for gc structures */
@@ -1444,9 +1526,9 @@ bool data_block_manager_t::should_terminate_one_gc_thread() const {
 
 // Answers the following question: Do we want to bother gc'ing?
 // Returns true when our garbage_ratio is greater than
-// GC_THRESHOLD_RATIO_*.
+// GC_THRESHOLD_RATIO_*, or when enough of the file is free that we could shrink it.
 bool data_block_manager_t::do_we_want_to_start_gcing() const {
-    return garbage_ratio() > GC_START_RATIO;
+    return garbage_ratio() > GC_START_RATIO || pick_compaction_entry() != NULL;
 }
 
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
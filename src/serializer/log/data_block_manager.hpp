@@ -35,6 +35,7 @@ class data_block_manager_t {
 public:
     data_block_manager_t(extent_manager_t *em, log_serializer_t *serializer,
                          const log_serializer_on_disk_static_config_t *static_config,
+                         const log_serializer_dynamic_config_t *dynamic_config,
                          log_serializer_stats_t *parent);
     ~data_block_manager_t();
 
@@ -80,12 +81,32 @@ public:
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
-
     bool is_gc_active() const;
 
 private:
+    /* Blocks are appended to one of several active extents, depending on how long we
+    expect them to stay live. Blocks written by users include the ones that are
+    rewritten over and over, such as the upper levels of the btree. Blocks that the GC
+    relocates have already outlived the rest of their extent, so they are likely to stay
+    live for a long time. Keeping the two apart means that the extents the GC produces
+    stay mostly live, instead of being mixed with hot blocks that soon become garbage and
+    force the GC to copy the same cold blocks again. */
+    enum write_stream_t {
+        USER_WRITE_STREAM = 0,
+        GC_WRITE_STREAM,
+        NUM_WRITE_STREAMS
+    };
+
+    std::vector<counted_t<ls_block_token_pointee_t> >
+    many_writes(const std::vector<buf_write_info_t> &writes,
+                write_stream_t stream,
+                file_account_t *io_account,
+                iocallback_t *cb);
+
+    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
+    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes,
+                           write_stream_t stream);
+
     void actually_shutdown();
 
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
@@ -116,6 +137,15 @@ private:
 
     void gc_one_extent(gc_state_t *gc_state);
 
+    // Picks the next extent to GC and takes it out of `gc_pq`. Returns NULL if there's
+    // nothing that we want to GC right now.
+    gc_entry_t *pick_gc_entry();
+
+    // Returns the old extent closest to the end of the file if enough of the file is
+    // free that moving its blocks towards the beginning of the file will let us shrink
+    // the file. Returns NULL otherwise.
+    gc_entry_t *pick_compaction_entry() const;
+
     void write_gcs(const std::vector<gc_write_t> &writes, gc_state_t *gc_state);
 
     // Determine how many GC processes should run concurrently at the moment.
@@ -143,6 +173,9 @@ private:
     // to be not young.
     void remove_last_unyoung_entry();
 
+    // Puts a young or reconstructed entry into the old state and onto `gc_pq`.
+    void make_entry_old(gc_entry_t *entry);
+
     void destroy_entry(gc_entry_t *entry);
 
     bool should_perform_read_ahead(int64_t offset);
@@ -162,6 +195,7 @@ private:
     state_t state;
 
     const log_serializer_on_disk_static_config_t* const static_config;
+    const log_serializer_dynamic_config_t *const dynamic_config;
 
     extent_manager_t *const extent_manager;
     log_serializer_t *const serializer;
@@ -177,8 +211,10 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
-    gc_entry_t *active_extent;
+    /* Contains the extents in the gc_entry_t::state_active state, one per write stream
+    (or NULL). Only the user stream's active extent is recorded in the metablock; after
+    a restart, the GC stream's extent is treated like any other old extent. */
+    gc_entry_t *active_extents[NUM_WRITE_STREAMS];
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
@@ -186,6 +222,10 @@ private:
     /* Contains every extent in the gc_entry_t::state_old state */
     priority_queue_t<gc_entry_t *, gc_entry_less_t> gc_pq;
 
+    /* None of the extents from this one on are in the gc_entry_t::state_old state, as
+    far as `pick_compaction_entry()` has looked. SIZE_MAX if it hasn't looked yet. */
+    mutable size_t no_old_extents_from;
+
     /* \brief structure to keep track of global stats about the data blocks
      */
     class gc_stat_t {
@@ -66,6 +66,9 @@ class extent_zone_t {
 
     file_t *const dbfile;
 
+    // Whether to punch holes into the file where extents become free.
+    const bool punch_holes;
+
     // The number of free extents in the file.
     size_t held_extents_;
 
@@ -74,8 +77,13 @@ public:
         return held_extents_;
     }
 
-    extent_zone_t(file_t *_dbfile, uint64_t _extent_size)
-        : extent_size(_extent_size), dbfile(_dbfile), held_extents_(0) {
+    size_t num_extents() const {
+        return extents.size();
+    }
+
+    extent_zone_t(file_t *_dbfile, uint64_t _extent_size, bool _punch_holes)
+        : extent_size(_extent_size), dbfile(_dbfile), punch_holes(_punch_holes),
+          held_extents_(0) {
         // (Avoid a bunch of reallocations by resize calls (avoiding O(n log n)
         // work on average).)
         extents.reserve(dbfile->get_file_size() / extent_size);
@@ -188,18 +196,34 @@ public:
             free_queue.push(offset_to_id(extent));
             ++held_extents_;
             try_shrink_file();
+
+            /* If the extent wasn't at the end of the file, the file didn't shrink. We
+            give its space back anyway if it's likely to stay free. We hand out the
+            lowest free extent first, so an extent past the point where the file would
+            end if the extents in use were packed at its beginning is only handed out
+            again after all the free extents before that point. Those are also the
+            extents that the GC's compaction is emptying. Extents before that point are
+            usually handed out again soon, and the filesystem would just have to
+            allocate their space again. The disk manager orders the discard before any
+            later writes to the extent. */
+            const size_t id = offset_to_id(extent);
+            if (punch_holes && id < extents.size()
+                && id >= extents.size() - held_extents_) {
+                dbfile->discard(extent, extent_size);
+            }
         }
     }
 };
 
 extent_manager_t::extent_manager_t(file_t *file,
                                    const log_serializer_on_disk_static_config_t *static_config,
+                                   const log_serializer_dynamic_config_t *dynamic_config,
                                    log_serializer_stats_t *_stats)
     : stats(_stats), extent_size(static_config->extent_size()),
       state(state_reserving_extents) {
     guarantee(divides(DEVICE_BLOCK_SIZE, extent_size));
 
-    zone.init(new extent_zone_t(file, extent_size));
+    zone.init(new extent_zone_t(file, extent_size, dynamic_config->punch_holes));
 }
 
 extent_manager_t::~extent_manager_t() {
@@ -301,3 +325,8 @@ size_t extent_manager_t::held_extents() {
     assert_thread();
     return zone->held_extents();
 }
+
+size_t extent_manager_t::num_extents() {
+    assert_thread();
+    return zone->num_extents();
+}
@@ -98,6 +98,7 @@ public:
 
     extent_manager_t(file_t *file,
                      const log_serializer_on_disk_static_config_t *static_config,
+                     const log_serializer_dynamic_config_t *dynamic_config,
                      log_serializer_stats_t *);
     ~extent_manager_t();
 
@@ -133,6 +134,9 @@ public:
     /* Number of extents that have been released but not handed back out again. */
     size_t held_extents();
 
+    /* Number of extents that the file currently spans, whether they're in use or not. */
+    size_t num_extents();
+
     log_serializer_stats_t *const stats;
     const uint64_t extent_size;   /* Same as static_config->extent_size */
 
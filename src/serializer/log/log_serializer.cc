@@ -7,6 +7,8 @@
 #include <unistd.h>
 
 #include <functional>
+#include <memory>
+#include <utility>
 
 #include "arch/io/disk.hpp"
 #include "arch/runtime/runtime.hpp"
@@ -135,6 +137,10 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_data_user_bytes_written(),
+      pm_serializer_data_gc_bytes_written(),
+      pm_serializer_gc_write_amplification(&pm_serializer_data_user_bytes_written,
+                                           &pm_serializer_data_gc_bytes_written),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
@@ -155,9 +161,31 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
+          &pm_serializer_data_user_bytes_written, "serializer_data_user_bytes_written",
+          &pm_serializer_data_gc_bytes_written, "serializer_data_gc_bytes_written",
+          &pm_serializer_gc_write_amplification, "serializer_gc_write_amplification",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
+void *gc_write_amplification_perfmon_t::begin_stats() {
+    return new std::pair<void *, void *>(user_bytes->begin_stats(),
+                                         gc_bytes->begin_stats());
+}
+
+void gc_write_amplification_perfmon_t::visit_stats(void *ctx) {
+    std::pair<void *, void *> *ctxs = static_cast<std::pair<void *, void *> *>(ctx);
+    user_bytes->visit_stats(ctxs->first);
+    gc_bytes->visit_stats(ctxs->second);
+}
+
+ql::datum_t gc_write_amplification_perfmon_t::end_stats(void *ctx) {
+    std::unique_ptr<std::pair<void *, void *> > ctxs(
+        static_cast<std::pair<void *, void *> *>(ctx));
+    double user = user_bytes->end_stats(ctxs->first).as_num();
+    double gc = gc_bytes->end_stats(ctxs->second).as_num();
+    return ql::datum_t(user == 0 ? 0.0 : gc / user);
+}
+
 void log_serializer_stats_t::bytes_read(size_t count) {
     pm_serializer_read_bytes_per_sec.record(count);
     pm_serializer_read_bytes_total += count;
@@ -250,6 +278,7 @@ struct ls_start_existing_fsm_t :
         if (start_existing_state == state_find_metablock) {
             // STATE D
             ser->extent_manager = new extent_manager_t(ser->dbfile, &ser->static_config,
+                                                       &ser->dynamic_config,
                                                        ser->stats.get());
             {
                 // We never end up releasing the static header extent reference.  Nobody says we
@@ -265,7 +294,8 @@ struct ls_start_existing_fsm_t :
                               ser, ph::_1, ph::_2));
             ser->data_block_manager
                 = new data_block_manager_t(ser->extent_manager, ser,
-                                           &ser->static_config, ser->stats.get());
+                                           &ser->static_config, &ser->dynamic_config,
+                                           ser->stats.get());
 
             // STATE E
             if (ser->metablock_manager->start_existing(ser->dbfile, &metablock_found, &metablock_buffer, this)) {
@@ -4,6 +4,23 @@
 
 #include "perfmon/perfmon.hpp"
 
+/* Reports how many bytes of data blocks the GC has written for every byte of data blocks
+written by users. */
+class gc_write_amplification_perfmon_t : public perfmon_t {
+public:
+    gc_write_amplification_perfmon_t(perfmon_counter_t *_user_bytes,
+                                     perfmon_counter_t *_gc_bytes)
+        : user_bytes(_user_bytes), gc_bytes(_gc_bytes) { }
+
+    void *begin_stats();
+    void visit_stats(void *ctx);
+    ql::datum_t end_stats(void *ctx);
+
+private:
+    perfmon_counter_t *const user_bytes;
+    perfmon_counter_t *const gc_bytes;
+};
+
 struct log_serializer_stats_t {
     perfmon_collection_t serializer_collection;
     explicit log_serializer_stats_t(perfmon_collection_t *perfmon_collection);
@@ -35,6 +52,9 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_data_user_bytes_written;
+    perfmon_counter_t pm_serializer_data_gc_bytes_written;
+    gc_write_amplification_perfmon_t pm_serializer_gc_write_amplification;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
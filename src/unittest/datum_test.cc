@@ -205,4 +205,45 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+TEST(DatumTest, InnerSindexKeyrange) {
+    const ql::skey_version_t skey_version = ql::skey_version_t::post_1_16;
+    const std::string long_prefix(300, 'a');
+    std::vector<ql::datum_t> values;
+    for (double d : { -2.0, 0.0, 1.0, 1.5, 2.0, 3.0, 10.0 }) {
+        values.push_back(ql::datum_t(d));
+    }
+    for (const std::string &str : { std::string("a"), std::string("ab"),
+                                    long_prefix, long_prefix + "a",
+                                    long_prefix + "b", std::string("b") }) {
+        values.push_back(ql::datum_t(datum_string_t(str)));
+    }
+
+    for (const ql::datum_t &left : values) {
+        for (const ql::datum_t &right : values) {
+            for (auto left_type : { key_range_t::open, key_range_t::closed }) {
+                for (auto right_type : { key_range_t::open, key_range_t::closed }) {
+                    ql::datum_range_t range(left, left_type, right, right_type);
+                    key_range_t outer = range.to_sindex_keyrange(skey_version);
+                    key_range_t inner = range.to_inner_sindex_keyrange(skey_version);
+                    for (const ql::datum_t &val : values) {
+                        store_key_t key(val.print_secondary(
+                            skey_version, store_key_t("id"), boost::none));
+                        // Keys in the inner range are always in the datum range, and
+                        // short keys strictly between the bounds are in the inner
+                        // range.
+                        if (inner.contains_key(key)) {
+                            EXPECT_TRUE(range.contains(val));
+                            EXPECT_TRUE(outer.contains_key(key));
+                        } else if (val.get_type() == ql::datum_t::R_NUM
+                                   && left.get_type() == ql::datum_t::R_NUM
+                                   && right.get_type() == ql::datum_t::R_NUM) {
+                            EXPECT_FALSE(left < val && val < right);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
 }  // namespace unittest
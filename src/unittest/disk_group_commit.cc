@@ -0,0 +1,54 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include "arch/arch.hpp"
+#include "arch/io/disk.hpp"
+#include "concurrency/pmap.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* Many commits to several files at once should all go through the disk manager's group
+commit, and each of them should end up on disk. */
+TPTEST(DiskGroupCommit, ConcurrentCommits) {
+    static const int NUM_FILES = 4;
+    static const int WRITES_PER_FILE = 8;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    temp_file_t temp_files[NUM_FILES];
+    scoped_ptr_t<file_t> files[NUM_FILES];
+    for (int i = 0; i < NUM_FILES; ++i) {
+        file_open_result_t res = open_file(
+            temp_files[i].name().permanent_path().c_str(),
+            linux_file_t::mode_read | linux_file_t::mode_write | linux_file_t::mode_create,
+            &io_backender,
+            &files[i]);
+        ASSERT_NE(file_open_result_t::ERROR, res.outcome);
+        files[i]->set_file_size(WRITES_PER_FILE * DEVICE_BLOCK_SIZE);
+    }
+
+    pmap(NUM_FILES * WRITES_PER_FILE, [&](int n) {
+        file_t *file = files[n % NUM_FILES].get();
+        int block = n / NUM_FILES;
+        char *buf = static_cast<char *>(
+            malloc_aligned(DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE));
+        memset(buf, 'A' + n, DEVICE_BLOCK_SIZE);
+        co_write(file, block * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE, buf,
+                 DEFAULT_DISK_ACCOUNT, file_t::WRAP_IN_DATASYNCS);
+        free(buf);
+    });
+
+    char *buf = static_cast<char *>(malloc_aligned(DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE));
+    for (int n = 0; n < NUM_FILES * WRITES_PER_FILE; ++n) {
+        co_read(files[n % NUM_FILES].get(), (n / NUM_FILES) * DEVICE_BLOCK_SIZE,
+                DEVICE_BLOCK_SIZE, buf, DEFAULT_DISK_ACCOUNT);
+        for (int j = 0; j < DEVICE_BLOCK_SIZE; ++j) {
+            ASSERT_EQ('A' + n, buf[j]);
+        }
+    }
+    free(buf);
+}
+
+}  // namespace unittest
@@ -0,0 +1,32 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <unistd.h>
+
+#include <string>
+
+#include "buffer_cache/hot_page_manifest.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(HotPageManifest, RoundTrip) {
+    temp_file_t temp_file;
+    const std::string path = hot_page_manifest_path(temp_file.name().permanent_path());
+
+    hot_page_manifest_t manifest;
+    ASSERT_FALSE(read_hot_page_manifest(path, &manifest));
+
+    hot_page_manifest_t written = { { 7, 3, 1000000 }, { }, { 42 } };
+    ASSERT_TRUE(write_hot_page_manifest(path, written));
+    ASSERT_TRUE(read_hot_page_manifest(path, &manifest));
+    ASSERT_EQ(written, manifest);
+
+    // A manifest that was cut off is ignored.
+    ASSERT_EQ(0, truncate(path.c_str(), 30));
+    ASSERT_FALSE(read_hot_page_manifest(path, &manifest));
+    ASSERT_EQ(written, manifest);
+
+    ASSERT_EQ(0, unlink(path.c_str()));
+}
+
+}  // namespace unittest
@@ -117,6 +117,74 @@ SPAWNER_TEST(JSProc, EvalAndCall) {
     ASSERT_EQ(res_datum->as_int(), 10337);
 }
 
+SPAWNER_TEST(JSProc, CallBatch) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, NULL, limits);
+
+    const std::string source_code =
+        "(function (x) { if (x == 2) { throw 'two'; } return x * 10; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    std::vector<std::vector<ql::datum_t> > args_list;
+    for (int i = 0; i < 4; ++i) {
+        args_list.push_back(std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+
+    std::vector<js_result_t> results = js_runner.call_batch(source_code, args_list, config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(4u, results.size());
+
+    // An error in one row doesn't affect the others
+    for (int i = 0; i < 4; ++i) {
+        if (i == 2) {
+            ASSERT_TRUE(boost::get<std::string>(&results[i]) != NULL);
+        } else {
+            ql::datum_t *res_datum = boost::get<ql::datum_t>(&results[i]);
+            ASSERT_TRUE(res_datum != NULL);
+            ASSERT_EQ(i * 10, res_datum->as_int());
+        }
+    }
+}
+
+SPAWNER_TEST(JSProc, CallBatchTimeout) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, NULL, limits);
+
+    const std::string source_code =
+        "(function (x) { if (x == 1) { for (var y = 0; y < 4e10; y++) {} } return x; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    js_result_t result = js_runner.eval(source_code, config);
+    ASSERT_TRUE(boost::get<js_id_t>(&result) != NULL);
+
+    config.timeout_ms = 10;
+
+    std::vector<std::vector<ql::datum_t> > args_list;
+    for (int i = 0; i < 3; ++i) {
+        args_list.push_back(std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+
+    // The timeout applies per row, so the first row succeeds and the second
+    // one ends the batch.
+    std::vector<js_result_t> results = js_runner.call_batch(source_code, args_list, config);
+    ASSERT_EQ(2u, results.size());
+    ASSERT_TRUE(boost::get<ql::datum_t>(&results[0]) != NULL);
+    std::string *error = boost::get<std::string>(&results[1]);
+    ASSERT_TRUE(error != NULL);
+    ASSERT_EQ(strprintf("JavaScript query `%s` timed out after 0.010 seconds.", source_code.c_str()), *error);
+    ASSERT_FALSE(js_runner.connected());
+}
+
 SPAWNER_TEST(JSProc, BrokenFunction) {
     extproc_pool_t extproc_pool(1);
     js_runner_t js_runner;
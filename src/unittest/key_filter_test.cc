@@ -0,0 +1,111 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
+#include "btree/key_filter.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static store_key_t test_key(const std::string &prefix, int i) {
+    return store_key_t(strprintf("%s%d", prefix.c_str(), i));
+}
+
+TEST(KeyFilterTest, BloomFilter) {
+    const int num_keys = 1000;
+    bloom_filter_t filter(num_keys, 10);
+    for (int i = 0; i < num_keys; ++i) {
+        filter.insert(test_key("in", i).btree_key());
+    }
+    // Keys that set no new bits aren't counted, so this can be a bit short.
+    EXPECT_LE(filter.num_keys(), static_cast<size_t>(num_keys));
+    EXPECT_GE(filter.num_keys(), static_cast<size_t>(num_keys * 0.99));
+    EXPECT_FALSE(filter.insert(test_key("in", 0).btree_key()));
+
+    for (int i = 0; i < num_keys; ++i) {
+        EXPECT_TRUE(filter.may_contain(test_key("in", i).btree_key()));
+    }
+    // Ten bits per key should give about 1% false positives.
+    int false_positives = 0;
+    for (int i = 0; i < 10 * num_keys; ++i) {
+        if (filter.may_contain(test_key("out", i).btree_key())) {
+            ++false_positives;
+        }
+    }
+    EXPECT_LT(false_positives, 3 * num_keys / 10);
+}
+
+TPTEST(KeyFilterTest, Rebuild) {
+    btree_key_filter_t filter;
+    EXPECT_TRUE(filter.may_contain(test_key("out", 0).btree_key()));
+    EXPECT_TRUE(filter.needs_rebuild());
+
+    // Keys found by the scan and keys written during it both end up in the filter.
+    filter.insert(test_key("in", 0).btree_key());
+    filter.start_rebuild(10);
+    EXPECT_FALSE(filter.needs_rebuild());
+    filter.insert(test_key("in", 1).btree_key());
+    filter.insert_rebuilt(test_key("in", 2).btree_key());
+    EXPECT_TRUE(filter.may_contain(test_key("out", 0).btree_key()));
+    filter.finish_rebuild();
+    EXPECT_FALSE(filter.needs_rebuild());
+    EXPECT_TRUE(filter.may_contain(test_key("in", 1).btree_key()));
+    EXPECT_TRUE(filter.may_contain(test_key("in", 2).btree_key()));
+    int false_positives = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (filter.may_contain(test_key("out", i).btree_key())) {
+            ++false_positives;
+        }
+    }
+    EXPECT_LT(false_positives, 30);
+
+    // Once it's full, the filter asks to be rebuilt, but stays in use until then.
+    for (int i = 3; !filter.needs_rebuild(); ++i) {
+        ASSERT_LT(i, 100000);
+        filter.insert(test_key("in", i).btree_key());
+    }
+    filter.start_rebuild(10);
+    EXPECT_TRUE(filter.may_contain(test_key("in", 1).btree_key()));
+    filter.abort_rebuild();
+    EXPECT_TRUE(filter.needs_rebuild());
+}
+
+TEST(KeyFilterTest, SindexKeys) {
+    const std::string long_str(300, 'a');
+    std::vector<ql::datum_t> values;
+    for (double d : { -2.0, 0.0, 1.5 }) {
+        values.push_back(ql::datum_t(d));
+    }
+    // Index keys of the long string are truncated, and those of the one just short
+    // of the truncation limit only lose their terminating null byte.
+    for (const std::string &str : { std::string("a"), long_str.substr(0, 109),
+                                    long_str }) {
+        values.push_back(ql::datum_t(datum_string_t(str)));
+    }
+    values.push_back(ql::datum_t::boolean(true));
+
+    // Whatever the primary key, every index key of a value has the filter key that
+    // lookups of the value use, and other values have different ones.
+    for (auto skey_version : { ql::skey_version_t::pre_1_16,
+                               ql::skey_version_t::post_1_16 }) {
+        for (const std::string &pkey : { std::string("id"), std::string(100, 'k') }) {
+            for (auto tag : { boost::optional<uint64_t>(),
+                              boost::optional<uint64_t>(3) }) {
+                for (const ql::datum_t &value : values) {
+                    store_key_t index_key(value.print_secondary(
+                        skey_version, store_key_t(pkey), tag));
+                    for (const ql::datum_t &other : values) {
+                        store_key_t lookup_key =
+                            sindex_key_filter_key(other, skey_version);
+                        EXPECT_EQ(value == other,
+                                  sindex_key_filter_key(index_key) == lookup_key);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}  // namespace unittest
@@ -240,6 +240,21 @@ public:
         ASSERT_EQ(key_to_unescaped_str(p->first), key_to_unescaped_str(median));
     }
 
+    void SplitForAppend(LeafNodeTracker *right, const store_key_t &key) {
+        ASSERT_TRUE(leaf::is_empty(right->node()));
+        ASSERT_TRUE(leaf::is_append(node(), key.btree_key()));
+
+        store_key_t median;
+        leaf::split_for_append(&sizer_, node(), right->node(), median.btree_key());
+
+        // Nothing moves, and `key` sorts after the median.
+        ASSERT_TRUE(leaf::is_empty(right->node()));
+        ASSERT_EQ(key_to_unescaped_str(kv_.rbegin()->first),
+                  key_to_unescaped_str(median));
+        ASSERT_LT(median, key);
+        Verify();
+    }
+
     bool IsFull(const store_key_t& key, const std::string& value) {
         short_value_buffer_t value_buf(value);
         return leaf::is_full(&sizer_, node(), key.btree_key(), value_buf.data());
@@ -650,6 +665,39 @@ TEST(LeafNodeTest, Splitting) {
     left.Split(&right);
 }
 
+TEST(LeafNodeTest, AppendSplitting) {
+    LeafNodeTracker left;
+    int i;
+    for (i = 0; !left.IsFull(store_key_t(strprintf("a%04d", i)), "A"); ++i) {
+        left.Insert(store_key_t(strprintf("a%04d", i)), "A");
+    }
+    ASSERT_FALSE(leaf::is_append(left.node(), store_key_t("a0000").btree_key()));
+    ASSERT_FALSE(leaf::is_append(left.node(), store_key_t("a0001x").btree_key()));
+
+    LeafNodeTracker right;
+    const store_key_t next(strprintf("a%04d", i));
+    left.SplitForAppend(&right, next);
+    right.Insert(next, "A");
+}
+
+TEST(LeafNodeTest, ShortenSeparator) {
+    auto shorten = [](const std::string &left, const std::string &right) {
+        store_key_t l(left);
+        store_key_t r(right);
+        shorten_separator(l.btree_key(), r.btree_key());
+        EXPECT_LE(store_key_t(left), l);
+        EXPECT_LT(l, r);
+        return key_to_unescaped_str(l);
+    };
+    EXPECT_EQ("b", shorten("abcdef", "bcd"));
+    EXPECT_EQ("devA\x01t5", shorten("devA\x01t41234", "devA\x01t61234"));
+    // The next byte value would be `right` itself, so we have to go further.
+    EXPECT_EQ("abd", shorten("abcd", "ac"));
+    // No shorter key fits between these.
+    EXPECT_EQ("ab", shorten("ab", "abc"));
+    EXPECT_EQ("ab\xff\xff", shorten("ab\xff\xff", "ac"));
+}
+
 TEST(LeafNodeTest, Fullness) {
     LeafNodeTracker node;
     int i;
@@ -23,6 +23,7 @@ public:
     int64_t get_file_size();
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size);
+    void discard(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf,
                     file_account_t *account, linux_iocallback_t *cb);
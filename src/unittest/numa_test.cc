@@ -0,0 +1,50 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "arch/runtime/numa.hpp"
+
+namespace unittest {
+
+TEST(NumaTest, ParseCpuList) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(parse_cpu_list("0-3,8,10-11\n", &cpus));
+    std::vector<int> expected = {0, 1, 2, 3, 8, 10, 11};
+    EXPECT_EQ(expected, cpus);
+
+    ASSERT_TRUE(parse_cpu_list("", &cpus));
+    EXPECT_TRUE(cpus.empty());
+
+    EXPECT_FALSE(parse_cpu_list("3-1", &cpus));
+    EXPECT_FALSE(parse_cpu_list("1,,2", &cpus));
+    EXPECT_FALSE(parse_cpu_list("a", &cpus));
+}
+
+TEST(NumaTest, AssignThreads) {
+    // Two nodes of equal size get contiguous blocks of (almost) equal size.
+    numa_topology_t two_sockets(
+        std::vector<std::vector<int> >{{0, 1, 2, 3}, {4, 5, 6, 7}});
+    std::vector<size_t> expected = {0, 0, 0, 0, 0, 1, 1, 1, 1};
+    EXPECT_EQ(expected, two_sockets.assign_threads(9));
+
+    // Nodes without CPUs are ignored, and larger nodes get more threads.
+    numa_topology_t uneven(
+        std::vector<std::vector<int> >{{0, 1, 2, 3, 4, 5}, {}, {6, 7}});
+    ASSERT_EQ(2u, uneven.num_nodes());
+    expected = {0, 0, 0, 1};
+    EXPECT_EQ(expected, uneven.assign_threads(4));
+
+    // More threads than CPUs still fill every node.
+    numa_topology_t single(std::vector<std::vector<int> >{{0}});
+    expected = {0, 0, 0};
+    EXPECT_EQ(expected, single.assign_threads(3));
+}
+
+TEST(NumaTest, Detect) {
+    numa_topology_t topology = numa_topology_t::detect();
+    ASSERT_GE(topology.num_nodes(), 1u);
+    for (size_t node = 0; node < topology.num_nodes(); ++node) {
+        EXPECT_FALSE(topology.cpus_of_node(node).empty());
+    }
+}
+
+}  // namespace unittest
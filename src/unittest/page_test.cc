@@ -312,6 +312,53 @@ TPTEST(PageTest, WriteWaitForFlush, 4) {
     pmap(2, std::bind(&WriteWaitForFlush_cases, &s, &page_cache, ph::_1));
 }
 
+TPTEST(PageTest, HotBlockIdsAndWarmUp, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    std::vector<block_id_t> block_ids;
+    std::vector<block_id_t> hot;
+    {
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (char c = 'a'; c < 'e'; ++c) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            memset(page_acq.get_buf_write(), c, page_cache.max_block_size().value());
+        }
+        page_cache.flush(std::move(txn));
+
+        // Reading the first block makes it the most recently used one.
+        current_test_acq_t acq(&page_cache, block_ids[0], read_access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), &page_cache);
+        page_acq.get_buf_read();
+
+        hot = page_cache.hot_block_ids(3);
+        ASSERT_EQ(3u, hot.size());
+        ASSERT_EQ(block_ids[0], hot[0]);
+    }
+
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    ASSERT_EQ(0u, page_cache.evicter().in_memory_size());
+    hot.push_back(block_ids.back() + 100);  // Doesn't exist, and gets skipped.
+    page_cache.start_warm_up(hot);
+    const uint64_t expected_size
+        = 3 * buf_ptr_t::compute_aligned_block_size(page_cache.max_block_size());
+    for (int i = 0; i < 1000 && page_cache.evicter().in_memory_size() < expected_size;
+         ++i) {
+        nap(1);
+    }
+    ASSERT_EQ(expected_size, page_cache.evicter().in_memory_size());
+
+    current_test_acq_t acq(&page_cache, block_ids[0], read_access_t::read);
+    test_acq_t page_acq;
+    page_acq.init(acq.current_page_for_read(), &page_cache);
+    ASSERT_TRUE(page_acq.buf_ready_signal()->is_pulsed());
+    ASSERT_EQ('a', *static_cast<const char *>(page_acq.get_buf_read()));
+}
+
 class bigger_test_t {
 public:
     explicit bigger_test_t(uint64_t _memory_limit)
@@ -6,7 +6,9 @@
 #include <cmath>  // for std::isnan -- read the comment below.
 
 #include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
 #include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -57,4 +59,59 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TPTEST(PerfmonTest, ThreadMax) {
+    perfmon_thread_max_t pm(secs_to_ticks(60));
+    pm.record(5.0, get_ticks());
+    pm.record(20.0, get_ticks());
+    pm.record(7.0, get_ticks());
+
+    void *data = pm.begin_stats();
+    pm.visit_stats(data);
+    ql::datum_t stats = pm.end_stats(data);
+
+    ASSERT_EQ(ql::datum_t::R_ARRAY, stats.get_type());
+    ASSERT_EQ(static_cast<size_t>(get_num_threads()), stats.arr_size());
+    EXPECT_EQ(20.0, stats.get(get_thread_id().threadnum).as_num());
+}
+
+TEST(PerfmonTest, LatencyHistogramBuckets) {
+    // Every value falls into a bucket whose upper bound is within 1/SUB_BUCKETS of it
+    for (uint64_t v = 0; v < (static_cast<uint64_t>(1) << 20); v = v * 17 / 16 + 1) {
+        size_t bucket = latency_histogram_t::bucket_for_value(v);
+        ASSERT_LT(bucket, latency_histogram_t::NUM_BUCKETS);
+        uint64_t max_value = latency_histogram_t::bucket_max_value(bucket);
+        EXPECT_LE(v, max_value);
+        EXPECT_LE(max_value - v, v / latency_histogram_t::SUB_BUCKETS);
+        if (bucket > 0) {
+            EXPECT_LT(latency_histogram_t::bucket_max_value(bucket - 1), v);
+        }
+    }
+    EXPECT_EQ(latency_histogram_t::NUM_BUCKETS - 1,
+              latency_histogram_t::bucket_for_value(UINT64_MAX));
+}
+
+TEST(PerfmonTest, LatencyHistogramMerge) {
+    latency_histogram_t a, b;
+    EXPECT_EQ(0u, a.percentile(0.5));
+    for (uint64_t i = 1; i <= 990; ++i) {
+        a.record(100);
+    }
+    for (uint64_t i = 1; i <= 10; ++i) {
+        b.record(50000);
+    }
+
+    // Merging through the datum representation is what the stats table does
+    latency_histogram_t merged;
+    merged.merge_buckets_datum(a.buckets_to_datum());
+    merged.merge_buckets_datum(b.buckets_to_datum());
+    EXPECT_EQ(1000u, merged.count());
+    EXPECT_NEAR(100.0, merged.percentile(0.5), 100.0 / latency_histogram_t::SUB_BUCKETS);
+    EXPECT_NEAR(100.0, merged.percentile(0.99), 100.0 / latency_histogram_t::SUB_BUCKETS);
+    EXPECT_NEAR(50000.0, merged.percentile(0.999),
+                50000.0 / latency_histogram_t::SUB_BUCKETS);
+
+    a.merge(b);
+    EXPECT_EQ(merged.percentile(0.999), a.percentile(0.999));
+}
+
 }  // namespace unittest
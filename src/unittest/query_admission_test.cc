@@ -0,0 +1,127 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "rdb_protocol/query_admission.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+typedef query_admission_controller_t::admission_t admission_t;
+
+/* Runs a query in its own coroutine that holds its admission until `release` is
+pulsed, and logs when it was admitted or rejected. */
+class test_query_t {
+public:
+    test_query_t(query_admission_controller_t *controller,
+                 query_priority_t priority,
+                 const std::string &_name,
+                 std::vector<std::string> *_log)
+        : name(_name), log(_log) {
+        coro_t::spawn_now_dangerously([this, controller, priority]() {
+            cond_t never;
+            admission_t admission(controller, priority, true, &never);
+            if (admission.is_rejected()) {
+                log->push_back(name + " rejected");
+            } else {
+                log->push_back(name);
+                release.wait();
+            }
+            done.pulse();
+        });
+    }
+    ~test_query_t() {
+        release.pulse_if_not_already_pulsed();
+        done.wait();
+    }
+
+    cond_t release;
+
+private:
+    const std::string name;
+    std::vector<std::string> *const log;
+    cond_t done;
+};
+
+TPTEST(QueryAdmission, Unlimited) {
+    query_admission_controller_t controller((query_admission_config_t()));
+    cond_t never;
+    admission_t a(&controller, query_priority_t::LOW, true, &never);
+    admission_t b(&controller, query_priority_t::LOW, true, &never);
+    EXPECT_FALSE(a.is_rejected());
+    EXPECT_FALSE(b.is_rejected());
+    EXPECT_EQ(2u, controller.num_running());
+    EXPECT_EQ(0u, controller.num_queued());
+}
+
+TPTEST(QueryAdmission, PriorityAndShedding) {
+    // One running and two queued queries per thread.
+    query_admission_config_t config;
+    config.max_running_queries = get_num_threads();
+    config.max_queued_queries = 2 * get_num_threads();
+    query_admission_controller_t controller(config);
+    std::vector<std::string> log;
+
+    {
+        scoped_ptr_t<test_query_t> running(
+            new test_query_t(&controller, query_priority_t::NORMAL, "running", &log));
+        test_query_t low(&controller, query_priority_t::LOW, "low", &log);
+        test_query_t high(&controller, query_priority_t::HIGH, "high", &log);
+        EXPECT_EQ(1u, controller.num_running());
+        EXPECT_EQ(2u, controller.num_queued());
+
+        // The queue is full. Another low-priority query is turned away, but a normal
+        // one takes the place of the queued low-priority query.
+        test_query_t low2(&controller, query_priority_t::LOW, "low2", &log);
+        test_query_t normal(&controller, query_priority_t::NORMAL, "normal", &log);
+        EXPECT_EQ(2u, controller.num_queued());
+
+        // The high-priority query goes before the normal one.
+        running.reset();
+        high.release.pulse();
+    }
+
+    std::vector<std::string> expected =
+        { "running", "low2 rejected", "low rejected", "high", "normal" };
+    EXPECT_EQ(expected, log);
+    EXPECT_EQ(0u, controller.num_running());
+    EXPECT_EQ(0u, controller.num_queued());
+}
+
+TPTEST(QueryAdmission, WeightedFairness) {
+    query_admission_config_t config;
+    config.max_running_queries = get_num_threads();
+    config.max_queued_queries = 100 * get_num_threads();
+    query_admission_controller_t controller(config);
+    std::vector<std::string> log;
+
+    scoped_ptr_t<test_query_t> running(
+        new test_query_t(&controller, query_priority_t::NORMAL, "running", &log));
+    std::vector<scoped_ptr_t<test_query_t> > queries;
+    for (int i = 0; i < 8; ++i) {
+        queries.emplace_back(
+            new test_query_t(&controller, query_priority_t::LOW, "low", &log));
+        queries.emplace_back(
+            new test_query_t(&controller, query_priority_t::HIGH, "high", &log));
+    }
+    running.reset();
+    for (auto &&query : queries) {
+        query->release.pulse();
+        coro_t::yield();
+    }
+    queries.clear();
+
+    // Low-priority queries aren't starved: one of the first nine admissions goes to
+    // them, since high priority has eight times the weight.
+    ASSERT_EQ(17u, log.size());
+    int low_in_first_nine = 0;
+    for (size_t i = 1; i < 10; ++i) {
+        low_in_first_nine += log[i] == "low" ? 1 : 0;
+    }
+    EXPECT_EQ(1, low_in_first_nine);
+}
+
+}  // namespace unittest
@@ -115,6 +115,11 @@ void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(
     throw cannot_perform_query_exc_t("unimplemented");
 }
 
+void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(
+        UNUSED const get_all_read_t &ga) {
+    throw cannot_perform_query_exc_t("unimplemented");
+}
+
 mock_namespace_interface_t::read_visitor_t::read_visitor_t(
         mock_namespace_interface_t *_parent,
         read_response_t *_response) :
@@ -594,4 +599,14 @@ bool test_rdb_env_t::instance_t::sindex_list(
     return false;
 }
 
+bool test_rdb_env_t::instance_t::sindex_list_ready(
+        UNUSED counted_t<const ql::db_t> db,
+        UNUSED const name_string_t &table,
+        UNUSED signal_t *local_interruptor,
+        std::string *error_out,
+        UNUSED std::map<std::string, sindex_config_t> *configs_out) {
+    *error_out = "test_rdb_env_t::instance_t doesn't support sindex_list_ready()";
+    return false;
+}
+
 }  // namespace unittest
@@ -75,6 +75,7 @@ private:
         void NORETURN operator()(UNUSED const intersecting_geo_read_t &gr);
         void NORETURN operator()(UNUSED const nearest_geo_read_t &gr);
         void NORETURN operator()(UNUSED const distribution_read_t &dg);
+        void NORETURN operator()(UNUSED const get_all_read_t &ga);
 
         read_visitor_t(mock_namespace_interface_t *parent, read_response_t *_response);
 
@@ -279,6 +280,12 @@ public:
                 std::string *error_out,
                 std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
                     *configs_and_statuses_out);
+        bool sindex_list_ready(
+                counted_t<const ql::db_t> db,
+                const name_string_t &table,
+                signal_t *interruptor,
+                std::string *error_out,
+                std::map<std::string, sindex_config_t> *configs_out);
 
     private:
         extproc_pool_t extproc_pool;
@@ -74,4 +74,37 @@ TEST(Rebalance, MaxKeyLength) {
     do_rebalance(distribution, 3);
 }
 
+TEST(Rebalance, LoadAware) {
+    std::map<store_key_t, int64_t> counts, heat;
+    for (char c = 'A'; c <= 'H'; ++c) {
+        counts[store_key_t(std::string(1, c))] = 100;
+    }
+    /* Almost all of the accesses go to the first half of the key space. */
+    heat[store_key_t("A")] = 450;
+    heat[store_key_t("B")] = 450;
+    heat[store_key_t("C")] = 450;
+    heat[store_key_t("D")] = 450;
+    heat[store_key_t("F")] = 100;
+    heat[store_key_t("G")] = 100;
+
+    table_shard_scheme_t by_count = do_rebalance(counts, 2);
+    ASSERT_EQ(1u, by_count.split_points.size());
+    double count_imbalance = calculate_shard_load_imbalance(heat, by_count);
+    EXPECT_GT(count_imbalance, 1.5);
+
+    table_shard_scheme_t by_load;
+    ASSERT_TRUE(calculate_split_points_with_load(counts, heat, 2, 1.0, &by_load));
+    ASSERT_EQ(1u, by_load.split_points.size());
+    EXPECT_LT(by_load.split_points[0], by_count.split_points[0]);
+    EXPECT_LT(calculate_shard_load_imbalance(heat, by_load), count_imbalance);
+
+    /* Without any heat, it falls back to splitting by document count. */
+    table_shard_scheme_t no_heat;
+    ASSERT_TRUE(calculate_split_points_with_load(
+        counts, std::map<store_key_t, int64_t>(), 2, 1.0, &no_heat));
+    EXPECT_EQ(by_count.split_points, no_heat.split_points);
+    EXPECT_EQ(1.0, calculate_shard_load_imbalance(
+        std::map<store_key_t, int64_t>(), by_count));
+}
+
 }  // namespace unittest
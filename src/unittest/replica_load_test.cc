@@ -0,0 +1,61 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "clustering/query_routing/replica_load.hpp"
+
+namespace unittest {
+
+TEST(ReplicaLoad, CostFollowsLatencyAndLoad) {
+    replica_load_t fast, slow;
+    // A replica we haven't heard from yet is tried before any other.
+    EXPECT_EQ(0.0, fast.cost());
+
+    for (int i = 0; i < 10; ++i) {
+        fast.start_read();
+        fast.finish_read(1000);
+        slow.start_read();
+        slow.finish_read(5000);
+    }
+    EXPECT_EQ(0u, fast.num_in_flight());
+    EXPECT_LT(fast.cost(), slow.cost());
+
+    // Reads that are still outstanding make a replica more expensive.
+    for (int i = 0; i < 10; ++i) {
+        fast.start_read();
+    }
+    EXPECT_EQ(10u, fast.num_in_flight());
+    EXPECT_GT(fast.cost(), slow.cost());
+
+    // The latency average moves towards new samples.
+    for (int i = 0; i < 10; ++i) {
+        fast.abandon_read(100000);
+    }
+    EXPECT_EQ(0u, fast.num_in_flight());
+    EXPECT_GT(fast.cost(), slow.cost());
+}
+
+TEST(ReplicaLoad, HedgeDelay) {
+    replica_load_t load;
+    ticks_t delay;
+    load.start_read();
+    load.finish_read(1000);
+    EXPECT_FALSE(load.get_hedge_delay(&delay));
+
+    // One in ten reads is slow, so the 95th percentile is a slow read.
+    for (int i = 1; i < 100; ++i) {
+        load.start_read();
+        load.finish_read(i % 10 == 0 ? 50000 : 1000);
+    }
+    ASSERT_TRUE(load.get_hedge_delay(&delay));
+    EXPECT_EQ(50000u, delay);
+
+    // Only recent reads count.
+    for (int i = 0; i < 100; ++i) {
+        load.start_read();
+        load.finish_read(2000);
+    }
+    ASSERT_TRUE(load.get_hedge_delay(&delay));
+    EXPECT_EQ(2000u, delay);
+}
+
+}  // namespace unittest
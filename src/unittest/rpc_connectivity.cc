@@ -621,6 +621,58 @@ TPTEST(RPCConnectivityTest, DifferentVersion) {
     check_tcp_closed(&stream);
 }
 
+/* Servers that only know the 2.1 cluster protocol can't read the 2.2 mailbox header,
+so they must be refused even though the version looks compatible. */
+TPTEST(RPCConnectivityTest, PreviousVersion) {
+    // Set up a cluster node.
+    connectivity_cluster_t c1;
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+
+    // Manually connect to the cluster.
+    peer_address_t addr = get_cluster_local_address(&c1);
+    scoped_fd_t sock(connect_to_node(*addr.ips().begin()));
+    socket_stream_t stream(sock.get());
+
+    // Read & check its header.
+    const int64_t len = connectivity_cluster_t::cluster_proto_header.length();
+    {
+        scoped_array_t<char> data(len + 1);
+        int64_t read = force_read(&stream, data.data(), len);
+        ASSERT_GE(read, 0);
+        data[read] = 0;         // null-terminate
+        ASSERT_STREQ(connectivity_cluster_t::cluster_proto_header.c_str(), data.data());
+    }
+
+    // Send the base header
+    ASSERT_EQ(len,
+              stream.write(connectivity_cluster_t::cluster_proto_header.c_str(),
+                           connectivity_cluster_t::cluster_proto_header.length()));
+    let_stuff_happen();
+    ASSERT_TRUE(stream.is_read_open() && stream.is_write_open());
+
+    // Send the previous version
+    std::string bad_version_str("2.1.0");
+    write_message_t bad_version_msg;
+    serialize<cluster_version_t::CLUSTER>(&bad_version_msg,
+                                         bad_version_str.length());
+    bad_version_msg.append(bad_version_str.data(), bad_version_str.length());
+    serialize<cluster_version_t::CLUSTER>(
+            &bad_version_msg,
+            connectivity_cluster_t::cluster_arch_bitsize.length());
+    bad_version_msg.append(connectivity_cluster_t::cluster_arch_bitsize.data(),
+                           connectivity_cluster_t::cluster_arch_bitsize.length());
+    serialize<cluster_version_t::CLUSTER>(
+            &bad_version_msg,
+            connectivity_cluster_t::cluster_build_mode.length());
+    bad_version_msg.append(connectivity_cluster_t::cluster_build_mode.data(),
+                           connectivity_cluster_t::cluster_build_mode.length());
+    ASSERT_FALSE(send_write_message(&stream, &bad_version_msg));
+    let_stuff_happen();
+
+    check_tcp_closed(&stream);
+}
+
 TPTEST(RPCConnectivityTest, DifferentArch) {
     // Set up a cluster node.
     connectivity_cluster_t c1;
@@ -178,4 +178,43 @@ TPTEST_MULTITHREAD(RPCMailboxTest, TypedMailbox, 3) {
     }
 }
 
+/* `LargeMessages` sends messages that are big enough to be compressed over a real
+connection. It also sends a random message that compresses poorly, and a message from
+a server that has compression disabled. */
+TPTEST_MULTITHREAD(RPCMailboxTest, LargeMessages, 3) {
+    connectivity_cluster_t c1, c2, c3;
+    mailbox_manager_t m1(&c1, 'M'), m2(&c2, 'M'), m3(&c3, 'M', false);
+    connectivity_cluster_t::run_t r1(&c1, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    connectivity_cluster_t::run_t r2(&c2, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    connectivity_cluster_t::run_t r3(&c3, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    r2.join(get_cluster_local_address(&c1));
+    r3.join(get_cluster_local_address(&c1));
+    let_stuff_happen();
+
+    std::vector<std::string> inbox;
+    mailbox_t<void(std::string)> mbox(&m1,
+        [&](signal_t *, const std::string &str) {
+            inbox.push_back(str);
+        });
+    mailbox_addr_t<void(std::string)> addr = mbox.get_address();
+
+    std::string compressible(MAILBOX_COMPRESSION_THRESHOLD * 8, 'x');
+    std::string random = rand_string(MAILBOX_COMPRESSION_THRESHOLD * 2);
+
+    send(&m2, addr, compressible);
+    let_stuff_happen();
+    send(&m2, addr, random);
+    let_stuff_happen();
+    send(&m3, addr, compressible);
+    let_stuff_happen();
+
+    ASSERT_EQ(3u, inbox.size());
+    EXPECT_EQ(compressible, inbox[0]);
+    EXPECT_EQ(random, inbox[1]);
+    EXPECT_EQ(compressible, inbox[2]);
+}
+
 }   /* namespace unittest */
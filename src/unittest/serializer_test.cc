@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/config.hpp"
@@ -90,5 +93,123 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+// The contents of the blocks written by `write_test_blocks()`.
+char test_block_byte(block_id_t block_id) {
+    return static_cast<char>(block_id % 251 + 1);
+}
+
+void write_test_blocks(standard_serializer_t *ser, file_account_t *account,
+                       block_id_t first_id, block_id_t count) {
+    const block_id_t batch_size = 64;
+    for (block_id_t batch = first_id; batch < first_id + count; batch += batch_size) {
+        std::vector<buf_ptr_t> bufs;
+        std::vector<buf_write_info_t> infos;
+        for (block_id_t id = batch; id < std::min(batch + batch_size, first_id + count);
+             ++id) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser->max_block_size());
+            memset(buf.cache_data(), test_block_byte(id), buf.block_size().value());
+            infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), id));
+            bufs.push_back(std::move(buf));
+        }
+
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        std::vector<counted_t<standard_block_token_t> > tokens
+            = ser->block_writes(infos, account, &cb);
+        cb.wait();
+
+        std::vector<index_write_op_t> write_ops;
+        for (size_t i = 0; i < infos.size(); ++i) {
+            write_ops.push_back(index_write_op_t(infos[i].block_id, tokens[i],
+                                                 repli_timestamp_t::distant_past));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser->index_write(&dummy_acq, write_ops);
+    }
+}
+
+void delete_test_blocks(standard_serializer_t *ser, const std::vector<block_id_t> &ids) {
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t id : ids) {
+        write_ops.push_back(index_write_op_t(id, counted_t<standard_block_token_t>()));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, write_ops);
+}
+
+void check_test_blocks(standard_serializer_t *ser, file_account_t *account,
+                       block_id_t count, block_id_t keep_every) {
+    for (block_id_t id = 0; id < count; ++id) {
+        counted_t<standard_block_token_t> token = ser->index_read(id);
+        if (id % keep_every != 0) {
+            EXPECT_FALSE(token.has());
+            continue;
+        }
+        ASSERT_TRUE(token.has());
+        buf_ptr_t buf = ser->block_read(token, account);
+        const char *data = static_cast<const char *>(buf.cache_data());
+        const uint32_t size = buf.block_size().value();
+        ASSERT_EQ(static_cast<ptrdiff_t>(size),
+                  std::count(data, data + size, test_block_byte(id)))
+            << "block " << id;
+    }
+}
+
+/* Fills the file, deletes most of the blocks so that the GC moves the rest and frees
+the extents (punching holes into them or compacting the file, depending on the config),
+and checks that the remaining blocks survive that and reopening the file. */
+void run_GarbageCollectionRoundTrip(bool punch_holes, bool compact_file) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.punch_holes = punch_holes;
+    dynamic_config.compact_file = compact_file;
+
+    // 64 MB of blocks, so enough extents become free to compact the file.
+    const block_id_t num_blocks = 16384;
+    const block_id_t keep_every = 16;
+    {
+        standard_serializer_t ser(dynamic_config,
+                                  &file_opener,
+                                  &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_test_blocks(&ser, account.get(), 0, num_blocks);
+
+        std::vector<block_id_t> deleted;
+        for (block_id_t id = 0; id < num_blocks; ++id) {
+            if (id % keep_every != 0) {
+                deleted.push_back(id);
+            }
+        }
+        delete_test_blocks(&ser, deleted);
+
+        // The GC only looks at extents once they're no longer young, and only when
+        // there's an index write; rewriting a block gives it both.
+        for (int i = 0; i < 20; ++i) {
+            nap(100);
+            write_test_blocks(&ser, account.get(), 0, 1);
+        }
+        check_test_blocks(&ser, account.get(), num_blocks, keep_every);
+    }
+    {
+        standard_serializer_t ser(dynamic_config,
+                                  &file_opener,
+                                  &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        check_test_blocks(&ser, account.get(), num_blocks, keep_every);
+    }
+}
+
+TEST(SerializerTest, PunchHolesRoundTrip) {
+    run_in_thread_pool(std::bind(run_GarbageCollectionRoundTrip, true, false), 4);
+}
+
+TEST(SerializerTest, CompactFileRoundTrip) {
+    run_in_thread_pool(std::bind(run_GarbageCollectionRoundTrip, true, true), 4);
+}
+
 
 }  // namespace unittest
@@ -0,0 +1,49 @@
+#!/usr/bin/env python
+# Copyright 2010-2015 RethinkDB, all rights reserved.
+
+import os, sys, threading
+
+sys.path.append(os.path.join(os.path.dirname(__file__), os.path.pardir, 'common'))
+import rdb_unittest
+
+class QueryAdmissionTests(rdb_unittest.RdbTestCase):
+    '''Tests that `--max-running-queries` only limits queries that are running'''
+
+    # One running query per thread
+    server_extra_options = ['--max-running-queries', '1']
+
+    feeds = 16
+
+    timeout = 10
+
+    def test_idle_changefeeds(self):
+        server = self.cluster[0]
+
+        # - open changefeeds that won't see any changes, each on its own connection so
+        # that they are spread over the threads
+
+        feedConns = []
+        for _ in range(self.feeds):
+            conn = self.r.connect(host=server.host, port=server.driver_port)
+            feedConns.append((conn, self.table.changes().run(conn)))
+
+        # - the idle feeds must not keep new queries from running; the cursors have
+        # already sent their CONTINUE requests, which now wait for changes
+
+        for _ in range(self.feeds):
+            conn = self.r.connect(host=server.host, port=server.driver_port)
+            results = []
+            query = threading.Thread(target=lambda: results.append(self.table.count().run(conn)))
+            query.daemon = True
+            query.start()
+            query.join(self.timeout)
+            self.assertFalse(query.is_alive(), 'A new query did not run within %.1f seconds of %d idle changefeeds' % (self.timeout, self.feeds))
+            self.assertEqual(results, [0])
+            conn.close()
+
+        for conn, _ in feedConns:
+            conn.close()
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
@@ -40,6 +40,9 @@ class JobsTableTests(rdb_unittest.RdbTestCase):
                 self.assertTrue(0 < response[0]["duration_sec"] <= taskLength)
                 self.assertEqual(response[0]["id"][0], "query")
                 self.assertEqual(response[0]["servers"], [server.name])
+                self.assertEqual(response[0]["info"]["priority"], "normal")
+                for field in ["cpu_sec", "rows_scanned", "bytes_read", "bytes_held"]:
+                    self.assertTrue(response[0]["info"][field] >= 0, response[0])
                 
                 break # break if sucessfull, leaving query running
             except Exception as e:
@@ -79,6 +79,21 @@ def check_sum_stat(path, iterable, expected):
         assert fuzzy_compare(total, walk_object(path, expected)), \
            "Stats (%s) did not add up, expected %f, got %f" % (repr(path), total, walk_object(expected))
 
+# Percentiles don't add up, but a percentile of merged histograms has to lie between
+# the percentiles of the histograms that went into it
+def check_latency_stat(path, iterable, expected):
+    if 'error' in expected:
+        return
+    for p in ['p50', 'p99', 'p999']:
+        parts = [item['query_engine'][path][p] for item in iterable if 'error' not in item]
+        parts = [x for x in parts if x is not None]
+        merged = expected['query_engine'][path][p]
+        if len(parts) == 0:
+            assert merged is None, "Latency stat (%s) has no samples but got %r" % (path, merged)
+        elif merged is not None:
+            assert min(parts) <= merged <= max(parts), \
+                "Latency stat (%s.%s) out of range: %r not in %r" % (path, p, merged, parts)
+
 # Verifies that the table_server stats add up to the table stats
 def check_table_stats(table_id, global_stats):
     table_row = find_rows(global_stats, lambda row_id: row_id == ['table', table_id])
@@ -91,6 +106,8 @@ def check_table_stats(table_id, global_stats):
                                                  row_id[1] == table_id)
     check_sum_stat(['query_engine', 'read_docs_per_sec'], table_server_rows, table_row)
     check_sum_stat(['query_engine', 'written_docs_per_sec'], table_server_rows, table_row)
+    check_latency_stat('read_latency_ms', table_server_rows, table_row)
+    check_latency_stat('write_latency_ms', table_server_rows, table_row)
 
 # Verifies that the table_server stats add up to the server stats
 def check_server_stats(server_id, global_stats):
@@ -106,6 +123,18 @@ def check_server_stats(server_id, global_stats):
     check_sum_stat(['query_engine', 'written_docs_per_sec'], table_server_rows, server_row)
     check_sum_stat(['query_engine', 'read_docs_total'], table_server_rows, server_row)
     check_sum_stat(['query_engine', 'written_docs_total'], table_server_rows, server_row)
+    check_latency_stat('read_latency_ms', table_server_rows, server_row)
+    check_latency_stat('write_latency_ms', table_server_rows, server_row)
+
+    if 'error' not in server_row:
+        cc = server_row['cluster_compression']
+        for field in ['uncompressed_bytes_total', 'compressed_bytes_total',
+                      'compress_cpu_usecs_total', 'decompress_cpu_usecs_total']:
+            assert cc[field] >= 0, "Bad cluster_compression stat %s" % field
+        if cc['compressed_bytes_total'] > 0:
+            assert cc['compression_ratio'] > 0
+        else:
+            assert cc['compression_ratio'] is None
 
 # Verifies that table and server stats add up to the cluster stats
 def check_cluster_stats(global_stats):
@@ -126,6 +155,7 @@ def check_cluster_stats(global_stats):
     check_sum_stat(['query_engine', 'written_docs_per_sec'], server_rows, cluster_row)
     check_sum_stat(['query_engine', 'client_connections'], server_rows, cluster_row)
     check_sum_stat(['query_engine', 'clients_active'], server_rows, cluster_row)
+    check_latency_stat('query_latency_ms', server_rows, cluster_row)
 
 def get_and_check_global_stats(tables, servers, conn):
     global_stats = list(r.db('rethinkdb').table('stats').run(conn))
@@ -284,6 +314,13 @@ with driver.Metacluster() as metacluster:
         assert debug_stats_0["stats"]["eventloop"]["total"] > 0
         assert debug_stats_1 is None
 
+        # The coroutine sampler is off unless the server was started with
+        # `--coro-sample-rate`, but the `_debug_profile` table still has a row for it
+        debug_profile_0 = r.db('rethinkdb').table('_debug_profile') \
+                           .get(servers[0]["id"]).run(conn)
+        assert debug_profile_0["profile"]["enabled"] is False
+        assert debug_profile_0["profile"]["sites"] == []
+
         # Restart server
         print("Restarting second server...")
         servers[1]['process'] = driver.Process(cluster, servers[1]['files'],
@@ -274,6 +274,47 @@ class TestHttpTerm(WithServer):
         res = r.http(url, method='HEAD', verify=False, redirects=5).run(self.conn)
         self.assertEqual(res, None)
     
+    def test_map(self):
+        url = self.getHttpBinURL('get')
+        
+        # requests made from within a `map` are batched, even under a bracket, but results must come back in order
+        res = r.range(20).map(lambda i: r.http(url, params={'row':i})['args']['row']).run(self.conn)
+        self.assertEqual(res, [str(i) for i in range(20)])
+    
+    def test_map_concurrent(self):
+        url = self.getHttpBinURL('delay', '1')
+        
+        # with bounded concurrency, eight one-second requests should take far less than eight seconds
+        start = time.time()
+        res = r.range(8).map(lambda i: r.http(url)).run(self.conn)
+        self.assertEqual(len(res), 8)
+        self.assertLess(time.time() - start, 6)
+        
+        # the same goes for a request under a bracket and a default
+        start = time.time()
+        res = r.range(8).map(lambda i: r.http(url)['args'].default(None)).run(self.conn)
+        self.assertEqual(res, [{}] * 8)
+        self.assertLess(time.time() - start, 6)
+    
+    def test_map_error(self):
+        good_url = self.getHttpBinURL('get')
+        bad_url = self.getHttpBinURL('status', '404')
+        
+        self.assertRaisesRegex(
+            r.RqlRuntimeError, self.err_string('GET', bad_url, 'status code 404'),
+            r.expr([good_url, bad_url, good_url]).map(lambda url: r.http(url)).run, self.conn
+        )
+        res = r.expr([good_url, bad_url, good_url]).map(lambda url: r.http(url).default(None)).run(self.conn)
+        self.assertEqual(res[1], None)
+        res = r.expr([good_url, bad_url, good_url]).map(lambda url: r.http(url)['args'].default(None)).run(self.conn)
+        self.assertEqual(res, [{}, None, {}])
+    
+    def test_cookies_not_shared(self):
+        # connections are reused across queries, cookies must not be
+        r.http(self.getHttpBinURL('cookies', 'set', 'leaked', 'yes'), redirects=1).run(self.conn)
+        res = r.http(self.getHttpBinURL('cookies')).run(self.conn)
+        self.assertEqual(res['cookies'], {})
+    
     def test_redirect_http_to_bad_https(self):
         self.bad_https_helper('http://%s:%d/redirect' % (self.host, self.targetServer.httpPort)) # 302 redirection to https port
     